@@ -30,6 +30,35 @@
 #endif
 #include <wolfssl/wolfcrypt/wc_port.h>
 
+/* AES-XTS is only registered when wolfCrypt has support for it. */
+#if !defined(WOLFSSL_AES_XTS) && defined(WE_HAVE_AESXTS)
+#undef WE_HAVE_AESXTS
+#endif
+/* Likewise SHAKE128 and SHAKE256. */
+#if !defined(WOLFSSL_SHAKE128) && defined(WE_HAVE_SHAKE128)
+#undef WE_HAVE_SHAKE128
+#endif
+#if !defined(WOLFSSL_SHAKE256) && defined(WE_HAVE_SHAKE256)
+#undef WE_HAVE_SHAKE256
+#endif
+/* Likewise BLAKE2b and BLAKE2s. */
+#if !defined(HAVE_BLAKE2) && !defined(HAVE_BLAKE2B) && \
+    defined(WE_HAVE_BLAKE2B)
+#undef WE_HAVE_BLAKE2B
+#endif
+#if !defined(HAVE_BLAKE2S) && defined(WE_HAVE_BLAKE2S)
+#undef WE_HAVE_BLAKE2S
+#endif
+/* Likewise SHA-512/224 and SHA-512/256. */
+#if (!defined(WOLFSSL_SHA512) || defined(WOLFSSL_NOSHA512_224)) && \
+    defined(WE_HAVE_SHA512_224)
+#undef WE_HAVE_SHA512_224
+#endif
+#if (!defined(WOLFSSL_SHA512) || defined(WOLFSSL_NOSHA512_256)) && \
+    defined(WE_HAVE_SHA512_256)
+#undef WE_HAVE_SHA512_256
+#endif
+
 #include <wolfengine/we_wolfengine.h>
 #include <wolfengine/we_openssl_bc.h>
 
@@ -38,6 +67,7 @@
 #include <openssl/ec.h>
 #include <openssl/ssl.h>
 #include <openssl/aes.h>
+#include <openssl/rand.h>
 
 
 #define BENCH_DECL(alg, func)        { alg, func, 0 }
@@ -57,7 +87,8 @@ typedef struct BENCH_ALG {
 #define BENCH_SECS()    end.tv_sec - start.tv_sec + \
                         (end.tv_usec - start.tv_usec) / 1000000.0;
 
-#if defined(WE_HAVE_DIGEST) || defined(WE_HAVE_AESGCM)
+#if defined(WE_HAVE_DIGEST) || defined(WE_HAVE_AESGCM) || \
+    defined(WE_HAVE_CHACHA)
 static unsigned char data[16384];
 #endif
 
@@ -92,6 +123,50 @@ static int digest_bench(ENGINE *e, const char *alg, const EVP_MD *md,
     return err;
 }
 
+#if defined(WE_HAVE_SHA256) || defined(WE_HAVE_SHA512)
+/* Maximum number of messages digested with one batch call. */
+#define DGST_BATCH_MSGS     256
+
+/* Digest independent messages in one call - reports messages per second. */
+static int digest_batch_bench(ENGINE *e, const char *alg, int nid, size_t len)
+{
+    int err = 0;
+    unsigned int i;
+    unsigned int max = 16384 / len;
+    static unsigned char digest[DGST_BATCH_MSGS][64];
+    static wolfEngine_DigestJob jobs[DGST_BATCH_MSGS];
+    wolfEngine_DigestBatch batch;
+    unsigned int cnt = 0;
+    double secs;
+    BENCH_DECLS;
+
+    if (max > DGST_BATCH_MSGS) {
+        max = DGST_BATCH_MSGS;
+    }
+    for (i = 0; i < max; i++) {
+        jobs[i].data = data + i * len;
+        jobs[i].len = len;
+        jobs[i].out = digest[i];
+    }
+    batch.nid = nid;
+    batch.jobs = jobs;
+    batch.cnt = (int)max;
+
+    BENCH_START();
+    do {
+        err |= ENGINE_ctrl_cmd(e, "digest_batch", 0, &batch, NULL, 0) != 1;
+        cnt += max;
+    }
+    while (BENCH_COND(1));
+
+    secs = BENCH_SECS();
+    printf("%-10s bat %5ld B/op  %10.2f kB/sec %12.0f msg/sec\n", alg,
+           (long)len, (len * cnt) / secs / 1000.0, cnt / secs);
+
+    return err;
+}
+#endif
+
 #ifdef WE_HAVE_SHA256
 static int sha256_bench(ENGINE *e)
 {
@@ -101,6 +176,12 @@ static int sha256_bench(ENGINE *e)
     for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
         err = digest_bench(e, "SHA256", EVP_sha256(), dgst_len[i]);
     }
+    if (e != NULL) {
+        /* Batching is a wolfEngine control command. */
+        for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+            err = digest_batch_bench(e, "SHA256", NID_sha256, dgst_len[i]);
+        }
+    }
 
     return err;
 }
@@ -129,6 +210,40 @@ static int sha512_bench(ENGINE *e)
     for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
         err = digest_bench(e, "SHA512", EVP_sha512(), dgst_len[i]);
     }
+    if (e != NULL) {
+        /* Batching is a wolfEngine control command. */
+        for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+            err = digest_batch_bench(e, "SHA512", NID_sha512, dgst_len[i]);
+        }
+    }
+
+    return err;
+}
+#endif
+
+#ifdef WE_HAVE_SHA512_224
+static int sha512_224_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+
+    for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+        err = digest_bench(e, "SHA512/224", EVP_sha512_224(), dgst_len[i]);
+    }
+
+    return err;
+}
+#endif
+
+#ifdef WE_HAVE_SHA512_256
+static int sha512_256_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+
+    for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+        err = digest_bench(e, "SHA512/256", EVP_sha512_256(), dgst_len[i]);
+    }
 
     return err;
 }
@@ -190,6 +305,62 @@ static int sha3_512_bench(ENGINE *e)
 }
 #endif
 
+#ifdef WE_HAVE_SHAKE128
+static int shake128_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+
+    for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+        err = digest_bench(e, "SHAKE128", EVP_shake128(), dgst_len[i]);
+    }
+
+    return err;
+}
+#endif
+
+#ifdef WE_HAVE_SHAKE256
+static int shake256_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+
+    for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+        err = digest_bench(e, "SHAKE256", EVP_shake256(), dgst_len[i]);
+    }
+
+    return err;
+}
+#endif
+
+#ifdef WE_HAVE_BLAKE2B
+static int blake2b512_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+
+    for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+        err = digest_bench(e, "BLAKE2b-512", EVP_blake2b512(), dgst_len[i]);
+    }
+
+    return err;
+}
+#endif
+
+#ifdef WE_HAVE_BLAKE2S
+static int blake2s256_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+
+    for (i = 0; err == 0 && i < DGST_LEN_SIZE; i++) {
+        err = digest_bench(e, "BLAKE2s-256", EVP_blake2s256(), dgst_len[i]);
+    }
+
+    return err;
+}
+#endif
+
 #endif /* WE_HAVE_DIGEST */
 
 #ifdef WE_HAVE_AESCBC
@@ -329,7 +500,8 @@ static int aes256_cbc_bench(ENGINE *e)
 }
 #endif
 
-#ifdef WE_HAVE_AESGCM
+#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_CHACHA)
+/* AEAD ciphers with a 12 byte nonce and 16 byte tag. */
 static size_t aesgcm_len[] = { 2, 31, 136, 1024, 8192, 16384 };
 #define AEGCM_LEN_SIZE    (sizeof(aesgcm_len) / sizeof(*aesgcm_len))
 
@@ -411,6 +583,58 @@ static int aesgcm_dec_bench(const char *alg, EVP_CIPHER_CTX *ctx, size_t len)
 
     return err;
 }
+#endif
+
+#ifdef WE_HAVE_AESGCM
+/* Maximum number of packets sealed with one batch call. */
+#define AESGCM_BATCH_PKTS   64
+
+/* Seal independent packets, each with own nonce and tag, in one call. */
+static int aesgcm_batch_bench(const char *alg, EVP_CIPHER_CTX *ctx,
+                              size_t len)
+{
+    int err = 0;
+    unsigned int i;
+    unsigned int max = 16384 / len;
+    unsigned char aad[13];
+    static unsigned char iv[AESGCM_BATCH_PKTS][12];
+    static unsigned char tag[AESGCM_BATCH_PKTS][16];
+    static wolfEngine_AeadPacket pkts[AESGCM_BATCH_PKTS];
+    unsigned int cnt = 0;
+    double secs;
+    BENCH_DECLS;
+
+    if (max > AESGCM_BATCH_PKTS) {
+        max = AESGCM_BATCH_PKTS;
+    }
+    RAND_bytes(aad, sizeof(aad));
+    RAND_bytes((unsigned char *)iv, sizeof(iv));
+    for (i = 0; i < max; i++) {
+        pkts[i].nonce = iv[i];
+        pkts[i].nonceLen = sizeof(iv[i]);
+        pkts[i].aad = aad;
+        pkts[i].aadLen = sizeof(aad);
+        pkts[i].in = data + i * len;
+        pkts[i].out = data + i * len;
+        pkts[i].len = (unsigned int)len;
+        pkts[i].tag = tag[i];
+        pkts[i].tagLen = sizeof(tag[i]);
+    }
+
+    BENCH_START();
+    do {
+        err |= EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_AEAD_BATCH, (int)max,
+                                   pkts) != 1;
+        cnt += max;
+    }
+    while (BENCH_COND(1));
+
+    secs = BENCH_SECS();
+    printf("%-8s bat %5ld B/op  %10.2f kB/sec %14.6f us/B\n", alg, (long)len,
+           (len * cnt) / secs / 1000.0, secs * 1000000.0 / (len * cnt));
+
+    return err;
+}
 
 static int aes128_gcm_bench(ENGINE *e)
 {
@@ -432,6 +656,12 @@ static int aes128_gcm_bench(ENGINE *e)
             err = aesgcm_enc_bench("AES128-GCM", ctx, aesgcm_len[i]);
         }
     }
+    if (e != NULL) {
+        /* Batching is a wolfEngine cipher control. */
+        for (i = 0; err == 0 && i < AEGCM_LEN_SIZE; i++) {
+            err = aesgcm_batch_bench("AES128-GCM", ctx, aesgcm_len[i]);
+        }
+    }
     if (err == 0) {
         err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), e, key, NULL, 0) != 1;
     }
@@ -466,6 +696,12 @@ static int aes256_gcm_bench(ENGINE *e)
             err = aesgcm_enc_bench("AES256-GCM", ctx, aesgcm_len[i]);
         }
     }
+    if (e != NULL) {
+        /* Batching is a wolfEngine cipher control. */
+        for (i = 0; err == 0 && i < AEGCM_LEN_SIZE; i++) {
+            err = aesgcm_batch_bench("AES256-GCM", ctx, aesgcm_len[i]);
+        }
+    }
     if (err == 0) {
         err = EVP_CipherInit_ex(ctx, EVP_aes_256_gcm(), e, key, NULL, 0) != 1;
     }
@@ -481,6 +717,383 @@ static int aes256_gcm_bench(ENGINE *e)
 }
 #endif
 
+#ifdef WE_HAVE_AESXTS
+/* Storage sector sizes - one data unit per operation. */
+static size_t xts_len[] = { 512, 4096, 65536 };
+#define XTS_LEN_SIZE    (sizeof(xts_len) / sizeof(*xts_len))
+static unsigned char xts_data[65536];
+
+static int xts_bench(const char *alg, EVP_CIPHER_CTX *ctx, int enc,
+                     size_t len, int sectorSz)
+{
+    int err = 0;
+    unsigned int i;
+    unsigned int max = sizeof(xts_data) / len;
+    unsigned char iv[16];
+    int outLen;
+    unsigned int cnt = 0;
+    double secs;
+    BENCH_DECLS;
+
+    RAND_bytes(iv, sizeof(iv));
+
+    BENCH_START();
+    do {
+        for (i = 0; i < max; i++) {
+            err |= EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, enc) != 1;
+            if (sectorSz > 0) {
+                err |= EVP_CIPHER_CTX_ctrl(ctx,
+                    WOLFENGINE_CTRL_XTS_SECTOR_SIZE, sectorSz, NULL) != 1;
+            }
+            err |= EVP_CipherUpdate(ctx, xts_data, &outLen, xts_data,
+                                    (int)len) != 1;
+        }
+        cnt += i;
+    }
+    while (BENCH_COND(1));
+
+    secs = BENCH_SECS();
+    if (sectorSz > 0) {
+        printf("%-8s %s %5ld B/op  %10.2f MB/sec  (%d B sectors)\n", alg,
+               enc ? "enc" : "dec", (long)len,
+               (len * cnt) / secs / 1000000.0, sectorSz);
+    }
+    else {
+        printf("%-8s %s %5ld B/op  %10.2f MB/sec\n", alg, enc ? "enc" : "dec",
+               (long)len, (len * cnt) / secs / 1000000.0);
+    }
+
+    return err;
+}
+
+static int aes_xts_bench(ENGINE *e, const char *alg, const EVP_CIPHER *cipher,
+                         size_t keyLen)
+{
+    int err = 0;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key[64] = {0,};
+    size_t i;
+    int enc;
+
+    err = RAND_bytes(key, (int)keyLen) == 0;
+    /* Data and tweak keys must differ. */
+    key[0] = (unsigned char)~key[keyLen / 2];
+
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    for (enc = 1; err == 0 && enc >= 0; enc--) {
+        err = EVP_CipherInit_ex(ctx, cipher, e, key, NULL, enc) != 1;
+        for (i = 0; err == 0 && i < XTS_LEN_SIZE; i++) {
+            err = xts_bench(alg, ctx, enc, xts_len[i], 0);
+        }
+        /* Many 512 byte sectors in one call. */
+        if (err == 0 && e != NULL) {
+            err = xts_bench(alg, ctx, enc, sizeof(xts_data), 512);
+        }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+static int aes128_xts_bench(ENGINE *e)
+{
+    return aes_xts_bench(e, "AES128-XTS", EVP_aes_128_xts(), 32);
+}
+
+static int aes256_xts_bench(ENGINE *e)
+{
+    return aes_xts_bench(e, "AES256-XTS", EVP_aes_256_xts(), 64);
+}
+#endif
+
+#ifdef WE_HAVE_CHACHA
+static int chacha20_poly1305_bench(ENGINE *e)
+{
+    int err = 0;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key[32] = {0,};
+    size_t i;
+
+    err = RAND_bytes(key, sizeof(key)) == 0;
+
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_chacha20_poly1305(), e, key, NULL,
+                                1) != 1;
+    }
+    if (err == 0) {
+        for (i = 0; err == 0 && i < AEGCM_LEN_SIZE; i++) {
+            err = aesgcm_enc_bench("CHAPOLY", ctx, aesgcm_len[i]);
+        }
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_chacha20_poly1305(), e, key, NULL,
+                                0) != 1;
+    }
+    if (err == 0) {
+        for (i = 0; err == 0 && i < AEGCM_LEN_SIZE; i++) {
+            err = aesgcm_dec_bench("CHAPOLY", ctx, aesgcm_len[i]);
+        }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+#endif
+
+#if defined(EVP_CIPH_FLAG_PIPELINE) && \
+    (defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESCBC) || \
+     defined(WE_HAVE_CHACHA))
+/* TLS records are pipelined through a BIO pair in memory. */
+#define WE_HAVE_TLS_PIPE_BENCH
+
+#define TLS_PIPE_MAX        32
+#define TLS_PIPE_FRAG_SZ    1024
+#define TLS_PIPE_BIO_SZ     (64 * 1024)
+static size_t tls_pipes[] = { 1, 4, 16, 32 };
+#define TLS_PIPES_SIZE      (sizeof(tls_pipes) / sizeof(*tls_pipes))
+
+static unsigned char tls_data[TLS_PIPE_MAX * TLS_PIPE_FRAG_SZ];
+static unsigned char tls_recv[TLS_PIPE_MAX * TLS_PIPE_FRAG_SZ];
+
+static SSL_CTX* tls_pipe_ctx_new(int server, const char *suite, size_t pipes)
+{
+    int err;
+    SSL_CTX *ctx;
+
+    ctx = SSL_CTX_new(server ? TLS_server_method() : TLS_client_method());
+    err = ctx == NULL;
+    if (err == 0) {
+        /* Pipelining needs an explicit IV - TLS 1.1 or 1.2. */
+        err = SSL_CTX_set_max_proto_version(ctx, TLS1_2_VERSION) != 1;
+    }
+    if (err == 0) {
+        err = SSL_CTX_set_cipher_list(ctx, suite) != 1;
+    }
+    if ((err == 0) && server) {
+        err = SSL_CTX_use_certificate_file(ctx, "certs/server-cert.pem",
+                                           SSL_FILETYPE_PEM) != 1;
+    }
+    if ((err == 0) && server) {
+        err = SSL_CTX_use_PrivateKey_file(ctx, "certs/server-key.pem",
+                                          SSL_FILETYPE_PEM) != 1;
+    }
+    if (err == 0) {
+        /* Stitched AES-CBC HMAC ciphers not used with encrypt-then-MAC. */
+        SSL_CTX_set_options(ctx, SSL_OP_NO_ENCRYPT_THEN_MAC);
+        SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+        /* Read all records available so they can be decrypted together. */
+        SSL_CTX_set_read_ahead(ctx, 1);
+        SSL_CTX_set_default_read_buffer_len(ctx, TLS_PIPE_BIO_SZ);
+        /* Write is split into records of fragment size. */
+        err = SSL_CTX_set_split_send_fragment(ctx, TLS_PIPE_FRAG_SZ) != 1;
+    }
+    if (err == 0) {
+        err = SSL_CTX_set_max_pipelines(ctx, pipes) != 1;
+    }
+
+    if ((err != 0) && (ctx != NULL)) {
+        SSL_CTX_free(ctx);
+        ctx = NULL;
+    }
+
+    return ctx;
+}
+
+static int tls_pipe_handshake(SSL *client, SSL *server)
+{
+    int err = 0;
+    int i;
+    int rc;
+    int clientDone = 0;
+    int serverDone = 0;
+
+    for (i = 0; (err == 0) && (i < 100) && (!clientDone || !serverDone);
+         i++) {
+        if (!clientDone) {
+            rc = SSL_do_handshake(client);
+            if (rc == 1) {
+                clientDone = 1;
+            }
+            else {
+                rc = SSL_get_error(client, rc);
+                err = (rc != SSL_ERROR_WANT_READ) &&
+                      (rc != SSL_ERROR_WANT_WRITE);
+            }
+        }
+        if ((err == 0) && !serverDone) {
+            rc = SSL_do_handshake(server);
+            if (rc == 1) {
+                serverDone = 1;
+            }
+            else {
+                rc = SSL_get_error(server, rc);
+                err = (rc != SSL_ERROR_WANT_READ) &&
+                      (rc != SSL_ERROR_WANT_WRITE);
+            }
+        }
+    }
+    if (!clientDone || !serverDone) {
+        err = 1;
+    }
+
+    return err;
+}
+
+static int tls_pipe_run(const char *alg, const char *suite, size_t pipes)
+{
+    int err = 0;
+    SSL_CTX *clientCtx = NULL;
+    SSL_CTX *serverCtx = NULL;
+    SSL *client = NULL;
+    SSL *server = NULL;
+    BIO *clientBio = NULL;
+    BIO *serverBio = NULL;
+    int len = (int)sizeof(tls_data);
+    int got;
+    int rc;
+    unsigned int cnt = 0;
+    double secs;
+    BENCH_DECLS;
+
+    err = (clientCtx = tls_pipe_ctx_new(0, suite, pipes)) == NULL;
+    if (err == 0) {
+        err = (serverCtx = tls_pipe_ctx_new(1, suite, pipes)) == NULL;
+    }
+    if (err == 0) {
+        err = (client = SSL_new(clientCtx)) == NULL;
+    }
+    if (err == 0) {
+        err = (server = SSL_new(serverCtx)) == NULL;
+    }
+    if (err == 0) {
+        err = BIO_new_bio_pair(&clientBio, TLS_PIPE_BIO_SZ, &serverBio,
+                               TLS_PIPE_BIO_SZ) != 1;
+    }
+    if (err == 0) {
+        /* SSL objects own the BIOs. */
+        SSL_set_bio(client, clientBio, clientBio);
+        SSL_set_bio(server, serverBio, serverBio);
+        SSL_set_connect_state(client);
+        SSL_set_accept_state(server);
+        err = tls_pipe_handshake(client, server);
+    }
+
+    if (err == 0) {
+        BENCH_START();
+        do {
+            /* Client seals all records, server opens them. */
+            err |= SSL_write(client, tls_data, len) != len;
+            for (got = 0; (err == 0) && (got < len); got += rc) {
+                rc = SSL_read(server, tls_recv + got, len - got);
+                err = rc <= 0;
+            }
+            cnt++;
+        }
+        while ((err == 0) && BENCH_COND(1));
+    }
+    if (err == 0) {
+        secs = BENCH_SECS();
+        printf("%-14s %2d pipes %10.2f kB/sec %14.6f us/B\n", alg,
+               (int)pipes, ((double)len * cnt) / secs / 1000.0,
+               secs * 1000000.0 / ((double)len * cnt));
+    }
+
+    SSL_free(server);
+    SSL_free(client);
+    SSL_CTX_free(serverCtx);
+    SSL_CTX_free(clientCtx);
+
+    return err;
+}
+
+static int tls_pipe_bench(ENGINE *e, const char *alg, const char *suite)
+{
+    int err = 0;
+    size_t i;
+
+    /* libssl gets ciphers by NID - use engine's when available. */
+    if (e != NULL) {
+        err = ENGINE_set_default_ciphers(e) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(tls_data, sizeof(tls_data)) != 1;
+    }
+    for (i = 0; (err == 0) && (i < TLS_PIPES_SIZE); i++) {
+        err = tls_pipe_run(alg, suite, tls_pipes[i]);
+    }
+    if (e != NULL) {
+        ENGINE_unregister_ciphers(e);
+    }
+
+    return err;
+}
+
+#ifdef WE_HAVE_AESGCM
+static int tls_pipe_aes128_gcm_bench(ENGINE *e)
+{
+    return tls_pipe_bench(e, "TLS-AES128-GCM", "AES128-GCM-SHA256");
+}
+#endif
+
+#ifdef WE_HAVE_AESCBC
+static int tls_pipe_aes128_cbc_hmac_bench(ENGINE *e)
+{
+    return tls_pipe_bench(e, "TLS-AES128-CBC", "AES128-SHA256");
+}
+#endif
+
+#ifdef WE_HAVE_CHACHA
+static int tls_pipe_chacha20_poly1305_bench(ENGINE *e)
+{
+    return tls_pipe_bench(e, "TLS-CHAPOLY", "ECDHE-RSA-CHACHA20-POLY1305");
+}
+#endif
+#endif
+
+#ifdef WE_HAVE_RANDOM
+static size_t rand_len[] = { 16, 32, 64, 256 };
+#define RAND_LEN_SIZE    (sizeof(rand_len) / sizeof(*rand_len))
+
+static int rand_bench(ENGINE *e)
+{
+    int err = 0;
+    size_t i;
+    unsigned char buf[256];
+    unsigned int cnt;
+    double secs;
+    BENCH_DECLS;
+
+    if (e != NULL) {
+        err = RAND_set_rand_engine(e) != 1;
+    }
+    for (i = 0; (err == 0) && (i < RAND_LEN_SIZE); i++) {
+        cnt = 0;
+        BENCH_START();
+        do {
+            err |= RAND_bytes(buf, (int)rand_len[i]) != 1;
+            cnt++;
+        }
+        while (BENCH_COND(1));
+
+        secs = BENCH_SECS();
+        printf("RAND_bytes %5ld B/op %10.2f ops/sec %12.3f us/op\n",
+               (long)rand_len[i], cnt / secs, secs / cnt * 1000000);
+    }
+    if (e != NULL) {
+        RAND_set_rand_engine(NULL);
+    }
+
+    return err;
+}
+#endif
+
 #ifdef WE_HAVE_EVP_PKEY
 
 #ifdef WE_HAVE_ECKEYGEN
@@ -1067,6 +1680,12 @@ BENCH_ALG bench_alg[] = {
 #ifdef WE_HAVE_SHA512
     BENCH_DECL("SHA512", sha512_bench),
 #endif
+#ifdef WE_HAVE_SHA512_224
+    BENCH_DECL("SHA512_224", sha512_224_bench),
+#endif
+#ifdef WE_HAVE_SHA512_256
+    BENCH_DECL("SHA512_256", sha512_256_bench),
+#endif
 #ifdef WE_HAVE_SHA3_224
     BENCH_DECL("SHA3_224", sha3_224_bench),
 #endif
@@ -1079,6 +1698,18 @@ BENCH_ALG bench_alg[] = {
 #ifdef WE_HAVE_SHA3_512
     BENCH_DECL("SHA3_512", sha3_512_bench),
 #endif
+#ifdef WE_HAVE_SHAKE128
+    BENCH_DECL("SHAKE128", shake128_bench),
+#endif
+#ifdef WE_HAVE_SHAKE256
+    BENCH_DECL("SHAKE256", shake256_bench),
+#endif
+#ifdef WE_HAVE_BLAKE2B
+    BENCH_DECL("BLAKE2B512", blake2b512_bench),
+#endif
+#ifdef WE_HAVE_BLAKE2S
+    BENCH_DECL("BLAKE2S256", blake2s256_bench),
+#endif
 #ifdef WE_HAVE_AESCBC
     BENCH_DECL("AES128-CBC", aes128_cbc_bench),
     BENCH_DECL("AES256-CBC", aes256_cbc_bench),
@@ -1087,6 +1718,27 @@ BENCH_ALG bench_alg[] = {
     BENCH_DECL("AES128-GCM", aes128_gcm_bench),
     BENCH_DECL("AES256-GCM", aes256_gcm_bench),
 #endif
+#ifdef WE_HAVE_AESXTS
+    BENCH_DECL("AES128-XTS", aes128_xts_bench),
+    BENCH_DECL("AES256-XTS", aes256_xts_bench),
+#endif
+#ifdef WE_HAVE_CHACHA
+    BENCH_DECL("CHACHA20-POLY1305", chacha20_poly1305_bench),
+#endif
+#ifdef WE_HAVE_TLS_PIPE_BENCH
+    #ifdef WE_HAVE_AESGCM
+        BENCH_DECL("TLS-AES128-GCM", tls_pipe_aes128_gcm_bench),
+    #endif
+    #ifdef WE_HAVE_AESCBC
+        BENCH_DECL("TLS-AES128-CBC-HMAC", tls_pipe_aes128_cbc_hmac_bench),
+    #endif
+    #ifdef WE_HAVE_CHACHA
+        BENCH_DECL("TLS-CHACHA20-POLY1305", tls_pipe_chacha20_poly1305_bench),
+    #endif
+#endif
+#ifdef WE_HAVE_RANDOM
+    BENCH_DECL("RAND", rand_bench),
+#endif
 #ifdef WE_HAVE_EVP_PKEY
 #ifdef WE_HAVE_EC_P256
     #ifdef WE_HAVE_ECKEYGEN
@@ -71,8 +71,15 @@
 #include <wolfssl/wolfcrypt/cmac.h>
 #include <wolfssl/wolfcrypt/sha.h>
 #include <wolfssl/wolfcrypt/sha256.h>
+#if defined(HAVE_BLAKE2) || defined(HAVE_BLAKE2B) || defined(HAVE_BLAKE2S)
+#include <wolfssl/wolfcrypt/blake2.h>
+#endif
 #include <wolfssl/wolfcrypt/aes.h>
 #include <wolfssl/wolfcrypt/des3.h>
+#if defined(HAVE_CHACHA) && defined(HAVE_POLY1305)
+#include <wolfssl/wolfcrypt/chacha.h>
+#include <wolfssl/wolfcrypt/chacha20_poly1305.h>
+#endif
 #include <wolfssl/wolfcrypt/rsa.h>
 #include <wolfssl/wolfcrypt/dh.h>
 #include <wolfssl/wolfcrypt/error-crypt.h>
@@ -94,10 +101,50 @@
 #undef WE_HAVE_DES3CBC
 #endif
 
+/* The AES-XTS code won't compile unless wolfCrypt has support for it. */
+#if !defined(WOLFSSL_AES_XTS) && defined(WE_HAVE_AESXTS)
+#undef WE_HAVE_AESXTS
+#endif
+
+/* The ChaCha20 code won't compile unless wolfCrypt has ChaCha20 and
+ * Poly1305. */
+#if (!defined(HAVE_CHACHA) || !defined(HAVE_POLY1305)) && \
+    defined(WE_HAVE_CHACHA)
+#undef WE_HAVE_CHACHA
+#endif
+
+/* The SHAKE code won't compile unless wolfCrypt has support for it. */
+#if !defined(WOLFSSL_SHAKE128) && defined(WE_HAVE_SHAKE128)
+#undef WE_HAVE_SHAKE128
+#endif
+#if !defined(WOLFSSL_SHAKE256) && defined(WE_HAVE_SHAKE256)
+#undef WE_HAVE_SHAKE256
+#endif
+
+/* The BLAKE2 code won't compile unless wolfCrypt has support for it. */
+#if !defined(HAVE_BLAKE2) && !defined(HAVE_BLAKE2B) && \
+    defined(WE_HAVE_BLAKE2B)
+#undef WE_HAVE_BLAKE2B
+#endif
+#if !defined(HAVE_BLAKE2S) && defined(WE_HAVE_BLAKE2S)
+#undef WE_HAVE_BLAKE2S
+#endif
+
+/* The truncated SHA-512 code won't compile unless wolfCrypt has support. */
+#if (!defined(WOLFSSL_SHA512) || defined(WOLFSSL_NOSHA512_224)) && \
+    defined(WE_HAVE_SHA512_224)
+#undef WE_HAVE_SHA512_224
+#endif
+#if (!defined(WOLFSSL_SHA512) || defined(WOLFSSL_NOSHA512_256)) && \
+    defined(WE_HAVE_SHA512_256)
+#undef WE_HAVE_SHA512_256
+#endif
+
 #include <wolfengine/we_openssl_bc.h>
 #include <wolfengine/we_logging.h>
 #include <wolfengine/we_fips.h>
 #include <wolfengine/we_visibility.h>
+#include <wolfengine/we_wolfengine.h>
 
 /* Defining WE_NO_OPENSSL_MALLOC will cause wolfEngine to not use the OpenSSL
  * memory management functions (e.g. OPENSSL_malloc, OPENSSL_free, etc.).
@@ -140,9 +187,96 @@ WOLFENGINE_LOCAL void *we_memdup(const void *data, size_t siz);
  * Global random
  */
 
-extern WC_RNG* we_rng;
+/* Number of shards the global random is split into. Each shard has its own
+ * DRBG and lock. */
+#ifndef WE_RNG_SHARDS
+    #ifdef WE_SINGLE_THREADED
+        #define WE_RNG_SHARDS    1
+    #else
+        #define WE_RNG_SHARDS    16
+    #endif
+#endif
+
+/**
+ * Shard of the global random number generator.
+ */
+typedef struct we_RngShard {
+    /** wolfSSL random number generator. */
+    WC_RNG rng;
+#ifndef WE_SINGLE_THREADED
+    /** Mutex for protecting use of the random number generator. */
+    wolfSSL_Mutex mutex;
+#endif
+#ifndef WE_STATIC_WOLFSSL
+    /** Hash of all the seed data added so far. */
+    unsigned char seed[WC_SHA256_DIGEST_SIZE];
+    /** Seed data has been added. */
+    int haveSeed;
+#endif
+    /** Fork generation the random number generator was instantiated in. */
+    int forkGen;
+} we_RngShard;
+
+extern we_RngShard we_rngShards[WE_RNG_SHARDS];
+
+WOLFENGINE_LOCAL we_RngShard* we_rng_shard(void);
 #ifndef WE_SINGLE_THREADED
-extern wolfSSL_Mutex* we_rng_mutex;
+WOLFENGINE_LOCAL int we_rng_shard_lock(we_RngShard *shard);
+#endif
+
+/* Per-thread DRBGs need thread-specific data that is released on thread exit.
+ */
+#if defined(WE_SINGLE_THREADED) || defined(HAVE_PTHREAD)
+#define WE_HAVE_THREAD_RNG
+#endif
+
+#ifdef WE_HAVE_THREAD_RNG
+WOLFENGINE_LOCAL WC_RNG* we_thread_rng(void);
+#endif
+
+/* Very large buffers of block-parallel AES modes, and large batches of
+ * digests, can be split across an engine-owned pool of worker threads. */
+#if defined(HAVE_PTHREAD) && !defined(WE_SINGLE_THREADED) && \
+    (defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+     defined(WE_HAVE_AESCBC) || defined(WE_HAVE_DIGEST))
+#define WE_HAVE_BULK_THREADS
+#endif
+/* Maximum number of worker threads in the bulk pool. Bounds the control
+ * command in all builds. */
+#ifndef WE_BULK_MAX_THREADS
+#define WE_BULK_MAX_THREADS         64
+#endif
+
+/* Forked children re-instantiate cached random state using fork handlers. */
+#if defined(HAVE_PTHREAD) && !defined(WE_SINGLE_THREADED) && \
+    (defined(WE_HAVE_ECC) || defined(WE_HAVE_AESGCM) || \
+     defined(WE_HAVE_RSA) || defined(WE_HAVE_RANDOM) || \
+     defined(WE_HAVE_DH) || defined(WE_HAVE_BULK_THREADS))
+#define WE_HAVE_FORK_CHECK
+#endif
+
+#ifdef WE_HAVE_FORK_CHECK
+extern volatile int we_forkGen;
+WOLFENGINE_LOCAL int we_rng_fork_check(WC_RNG *rng, int *forkGen);
+#endif
+
+/* Engine-owned worker that reseeds long-lived DRBGs off the request path.
+ * Relies on the fork handlers to mark it for restart in forked children. */
+#ifdef WE_HAVE_FORK_CHECK
+#define WE_HAVE_RESEED_THREAD
+#endif
+
+#ifdef WE_HAVE_RESEED_THREAD
+/* Reseed worker is to be started again, in a forked child, on next use of a
+ * DRBG. */
+extern volatile int we_reseedRestart;
+WOLFENGINE_LOCAL void we_reseed_thread_restart(void);
+#endif
+
+#ifdef WE_STATIC_WOLFSSL
+/* Not part of the wolfCrypt API - only available when statically linked. */
+extern int wc_RNG_DRBG_Reseed(WC_RNG* rng, const byte* seed, word32 seedSz);
+extern int wc_GenerateSeed(OS_Seed* os, byte* seed, int sz);
 #endif
 
 WOLFENGINE_LOCAL int we_pkey_get_nids(const int** nids);
@@ -170,6 +304,12 @@ WOLFENGINE_LOCAL int we_init_sha384_meth(void);
 extern EVP_MD *we_sha512_md;
 WOLFENGINE_LOCAL int we_init_sha512_meth(void);
 
+extern EVP_MD *we_sha512_224_md;
+WOLFENGINE_LOCAL int we_init_sha512_224_meth(void);
+
+extern EVP_MD *we_sha512_256_md;
+WOLFENGINE_LOCAL int we_init_sha512_256_meth(void);
+
 extern EVP_MD *we_sha3_224_md;
 WOLFENGINE_LOCAL int we_init_sha3_224_meth(void);
 
@@ -182,6 +322,22 @@ WOLFENGINE_LOCAL int we_init_sha3_384_meth(void);
 extern EVP_MD *we_sha3_512_md;
 WOLFENGINE_LOCAL int we_init_sha3_512_meth(void);
 
+extern EVP_MD *we_shake128_md;
+WOLFENGINE_LOCAL int we_init_shake128_meth(void);
+
+extern EVP_MD *we_shake256_md;
+WOLFENGINE_LOCAL int we_init_shake256_meth(void);
+
+extern EVP_MD *we_blake2b512_md;
+WOLFENGINE_LOCAL int we_init_blake2b512_meth(void);
+
+extern EVP_MD *we_blake2s256_md;
+WOLFENGINE_LOCAL int we_init_blake2s256_meth(void);
+
+#ifdef WE_HAVE_DIGEST
+WOLFENGINE_LOCAL int we_digest_batch(wolfEngine_DigestBatch *batch);
+#endif
+
 WOLFENGINE_LOCAL enum wc_HashType we_nid_to_wc_hash_type(int nid);
 WOLFENGINE_LOCAL int we_nid_to_wc_hash_oid(int nid);
 
@@ -189,6 +345,101 @@ WOLFENGINE_LOCAL int we_nid_to_wc_hash_oid(int nid);
  * Cipher methods.
  */
 
+/* Cipher pipelining - OpenSSL passes several TLS records to one cipher call.
+ */
+#ifdef EVP_CIPH_FLAG_PIPELINE
+#define WE_HAVE_PIPELINE
+#endif
+
+#ifdef WE_HAVE_PIPELINE
+/* Maximum number of records in one cipher call - SSL_MAX_PIPELINES. */
+#define WE_MAX_PIPELINES        32
+/* Flag for ciphers that support pipelining. */
+#define WE_CIPH_FLAG_PIPELINE   EVP_CIPH_FLAG_PIPELINE
+
+/**
+ * Records passed to a cipher with the pipeline ctrl commands.
+ */
+typedef struct we_Pipeline {
+    /** Output buffer of each record. */
+    unsigned char **out;
+    /** Input buffer of each record. */
+    unsigned char **in;
+    /** Length of each record. */
+    size_t *lens;
+    /** Number of records. 0 when not pipelining. */
+    int num;
+    /** Number of TLS AADs set - one per record. */
+    int aadCnt;
+    /** TLS AAD of each record, as modified by cipher's ctrl. */
+    unsigned char aad[WE_MAX_PIPELINES][EVP_AEAD_TLS1_AAD_LEN];
+} we_Pipeline;
+
+WOLFENGINE_LOCAL void we_pipeline_reset(we_Pipeline *pipe);
+WOLFENGINE_LOCAL int we_pipeline_ctrl(we_Pipeline *pipe, int type, int arg,
+                                      void *ptr);
+WOLFENGINE_LOCAL int we_pipeline_add_aad(we_Pipeline *pipe,
+                                         const unsigned char *aad);
+WOLFENGINE_LOCAL int we_pipeline_check(we_Pipeline *pipe);
+#else
+#define WE_CIPH_FLAG_PIPELINE   0
+#endif
+
+/* AES contexts re-initialized with the key already expanded skip the key
+ * expansion. */
+#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESCCM) || \
+    defined(WE_HAVE_AESCBC) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCTR)
+#define WE_HAVE_AES_KEY_CACHE
+
+/**
+ * Key expanded into a wolfSSL AES object.
+ */
+typedef struct we_AesKeyCache {
+    /** Key bytes - the key schedule holds these already. */
+    unsigned char key[AES_256_KEY_SIZE];
+    /** Length of key in bytes. 0 when no key expanded. */
+    int keyLen;
+    /** Direction key expanded for - AES_ENCRYPTION or AES_DECRYPTION. */
+    int dir;
+} we_AesKeyCache;
+
+WOLFENGINE_LOCAL int we_aes_key_cache_match(const we_AesKeyCache *cache,
+                                            const unsigned char *key,
+                                            int keyLen, int dir);
+WOLFENGINE_LOCAL void we_aes_key_cache_set(we_AesKeyCache *cache,
+                                           const unsigned char *key,
+                                           int keyLen, int dir);
+#endif
+
+#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESXTS)
+WOLFENGINE_LOCAL int we_aes_copy_fixup(Aes *aes);
+#endif
+
+#ifdef WE_ALIGNMENT_SAFETY
+/* Alignment, in bytes, of data that wolfCrypt SHA-384/512 processes. */
+#define WE_ALIGNMENT_REQ            8
+/* Number of SHA-512 blocks copied through the aligned bounce buffer at once.
+ */
+#ifndef WE_ALIGNED_BOUNCE_BLOCKS
+#define WE_ALIGNED_BOUNCE_BLOCKS    8
+#endif
+
+/**
+ * Update function of a wolfSSL hash or HMAC object.
+ *
+ * @param  obj   [in,out]  wolfSSL hash or HMAC object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data in bytes.
+ * @returns  0 on success and wolfCrypt error code on failure.
+ */
+typedef int (*we_HashUpdateFunc)(void *obj, const byte *data, word32 len);
+
+WOLFENGINE_LOCAL int we_aligned_update(void *obj, we_HashUpdateFunc update,
+                                       word32 buffLen, const byte *data,
+                                       size_t len);
+#endif
+
 extern EVP_CIPHER* we_des3_cbc_ciph;
 WOLFENGINE_LOCAL int we_init_des3cbc_meths(void);
 
@@ -204,7 +455,12 @@ WOLFENGINE_LOCAL int we_init_aescbc_meths(void);
 
 extern EVP_CIPHER* we_aes128_cbc_hmac_ciph;
 extern EVP_CIPHER* we_aes256_cbc_hmac_ciph;
+#ifdef WE_HAVE_SHA1
+extern EVP_CIPHER* we_aes128_cbc_hmac_sha1_ciph;
+extern EVP_CIPHER* we_aes256_cbc_hmac_sha1_ciph;
+#endif
 WOLFENGINE_LOCAL int we_init_aescbc_hmac_meths(void);
+WOLFENGINE_LOCAL void we_aes_cbc_hmac_get_stats(wolfEngine_Stats *stats);
 
 extern EVP_CIPHER* we_aes128_ctr_ciph;
 extern EVP_CIPHER* we_aes192_ctr_ciph;
@@ -215,12 +471,59 @@ extern EVP_CIPHER* we_aes128_gcm_ciph;
 extern EVP_CIPHER* we_aes192_gcm_ciph;
 extern EVP_CIPHER* we_aes256_gcm_ciph;
 WOLFENGINE_LOCAL int we_init_aesgcm_meths(void);
+WOLFENGINE_LOCAL void we_aes_gcm_get_stats(wolfEngine_Stats *stats);
 
 extern EVP_CIPHER* we_aes128_ccm_ciph;
 extern EVP_CIPHER* we_aes192_ccm_ciph;
 extern EVP_CIPHER* we_aes256_ccm_ciph;
 WOLFENGINE_LOCAL int we_init_aesccm_meths(void);
 
+extern EVP_CIPHER* we_aes128_xts_ciph;
+extern EVP_CIPHER* we_aes256_xts_ciph;
+WOLFENGINE_LOCAL int we_init_aesxts_meths(void);
+
+extern EVP_CIPHER* we_chacha20_ciph;
+extern EVP_CIPHER* we_chacha20_poly1305_ciph;
+WOLFENGINE_LOCAL int we_init_chacha_meths(void);
+
+#ifdef WE_HAVE_BULK_THREADS
+/* Number of worker threads in the bulk pool. 0 when not splitting. */
+extern volatile int we_bulkWorkers;
+/* Minimum length of data, in bytes, to split across the bulk pool. */
+extern volatile size_t we_bulkThreshold;
+
+/* Whether a buffer is to be split across the bulk pool - cheap check so that
+ * small calls don't pay for the pool. */
+#define WE_BULK_SPLIT(len) \
+    ((we_bulkWorkers > 0) && ((size_t)(len) >= we_bulkThreshold))
+
+/* Block-parallel AES operations that can be split. */
+#define WE_BULK_AES_CTR         0
+#define WE_BULK_AES_ECB_ENC     1
+#define WE_BULK_AES_ECB_DEC     2
+#define WE_BULK_AES_CBC_DEC     3
+
+/**
+ * Function that performs one job of a batch.
+ *
+ * @param  job  [in,out]  Job to perform.
+ * @returns  1 on success and 0 on failure.
+ */
+typedef int (*we_BulkFunc)(void *job);
+
+WOLFENGINE_LOCAL int we_bulk_run(we_BulkFunc func, void *jobs, size_t jobSz,
+                                 int cnt);
+WOLFENGINE_LOCAL int we_aes_bulk(Aes *aes, int mode, unsigned char *out,
+                                 const unsigned char *in, size_t len);
+WOLFENGINE_LOCAL int we_bulk_set_threads(long cnt);
+WOLFENGINE_LOCAL int we_bulk_set_threshold(long threshold);
+WOLFENGINE_LOCAL void we_bulk_get_stats(wolfEngine_Stats *stats);
+WOLFENGINE_LOCAL void we_final_bulk(void);
+WOLFENGINE_LOCAL void we_bulk_fork_prepare(void);
+WOLFENGINE_LOCAL void we_bulk_fork_parent(void);
+WOLFENGINE_LOCAL void we_bulk_fork_child(void);
+#endif /* WE_HAVE_BULK_THREADS */
+
 
 /*
  * Random method.
@@ -228,6 +531,36 @@ WOLFENGINE_LOCAL int we_init_aesccm_meths(void);
 
 extern RAND_METHOD* we_random_method;
 
+/* Entropy read directly from the entropy source is only available when
+ * statically linked against wolfSSL. */
+#if defined(WE_HAVE_RANDOM) && defined(WE_STATIC_WOLFSSL)
+#define WE_HAVE_ENTROPY_POOL
+#endif
+
+/* Size of entropy pool - filled with one read of the entropy source. Bounds
+ * the entropy watermark in all builds. */
+#ifndef WE_ENTROPY_POOL_SZ
+#define WE_ENTROPY_POOL_SZ    4096
+#endif
+
+#ifdef WE_HAVE_ENTROPY_POOL
+WOLFENGINE_LOCAL int we_init_entropy_pool(void);
+WOLFENGINE_LOCAL void we_final_entropy_pool(void);
+WOLFENGINE_LOCAL int we_entropy_get(unsigned char *buf, int num);
+#ifdef WE_HAVE_RESEED_THREAD
+WOLFENGINE_LOCAL int we_entropy_prefetch(void);
+#endif
+#ifdef WE_HAVE_FORK_CHECK
+WOLFENGINE_LOCAL void we_entropy_fork_prepare(void);
+WOLFENGINE_LOCAL void we_entropy_fork_parent(void);
+WOLFENGINE_LOCAL void we_entropy_fork_child(void);
+#endif
+#endif
+#ifdef WE_HAVE_RANDOM
+WOLFENGINE_LOCAL int we_entropy_set_watermark(long watermark);
+WOLFENGINE_LOCAL void we_entropy_get_stats(wolfEngine_Stats *stats);
+#endif
+
 /*
  * HMAC methods.
  */
@@ -26,6 +26,8 @@
 #include "user_settings.h"
 #endif
 
+#include <stddef.h>
+
 #include <wolfengine/we_visibility.h>
 
 /* OpenSSL 3.0.0 has deprecated the ENGINE API. */
@@ -42,4 +44,98 @@ WOLFENGINE_API extern const char *wolfengine_name;
 
 WOLFENGINE_API void ENGINE_load_wolfengine(void);
 
+/* Cipher control to have one AES-XTS call cover consecutive sectors of the
+ * given size in bytes. The IV is the tweak of the first sector and is
+ * incremented, as a little-endian number, for each following sector. A size
+ * of 0, the default, makes the whole call one data unit:
+ *   EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_XTS_SECTOR_SIZE, 512, NULL);
+ */
+#define WOLFENGINE_CTRL_XTS_SECTOR_SIZE     0x1000
+
+/* Cipher control to seal or open many independent packets with the key of an
+ * AES-GCM or AES-CCM context in one call. Direction is that of the context.
+ * arg is the number of packets and ptr the array of packets:
+ *   EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_AEAD_BATCH, cnt, pkts);
+ * Returns 1 when all packets succeeded and 0 otherwise - see each status.
+ */
+#define WOLFENGINE_CTRL_AEAD_BATCH          0x1001
+
+/* One packet of a batched AEAD operation. */
+typedef struct wolfEngine_AeadPacket {
+    /* Nonce of packet. */
+    const unsigned char *nonce;
+    /* Length of nonce in bytes. */
+    unsigned int nonceLen;
+    /* Additional authenticated data. May be NULL when aadLen is 0. */
+    const unsigned char *aad;
+    /* Length of AAD in bytes. */
+    unsigned int aadLen;
+    /* Plaintext when sealing and ciphertext when opening. */
+    const unsigned char *in;
+    /* Ciphertext when sealing and plaintext when opening. May be in. */
+    unsigned char *out;
+    /* Length of in and out in bytes. */
+    unsigned int len;
+    /* Tag - generated when sealing and checked when opening. */
+    unsigned char *tag;
+    /* Length of tag in bytes. */
+    unsigned int tagLen;
+    /* Set by the call: 1 on success and 0 on failure. */
+    int status;
+} wolfEngine_AeadPacket;
+
+/* One message of a batched digest operation. */
+typedef struct wolfEngine_DigestJob {
+    /* Message to digest. May be NULL when len is 0. */
+    const unsigned char *data;
+    /* Length of message in bytes. */
+    size_t len;
+    /* Buffer to hold digest - at least the digest size of the algorithm. */
+    unsigned char *out;
+    /* Set by the call: 1 on success and 0 on failure. */
+    int status;
+} wolfEngine_DigestJob;
+
+/* Independent messages to digest with one algorithm in one call. Batches at
+ * least "bulk_threshold" bytes long are split across the bulk worker threads:
+ *   ENGINE_ctrl_cmd(e, "digest_batch", 0, &batch, NULL, 0);
+ * Returns 1 when all messages succeeded and 0 otherwise - see each status.
+ */
+typedef struct wolfEngine_DigestBatch {
+    /* NID of digest algorithm - e.g. NID_sha256 or NID_sha512. */
+    int nid;
+    /* Messages to digest. */
+    wolfEngine_DigestJob *jobs;
+    /* Number of messages. */
+    int cnt;
+} wolfEngine_DigestBatch;
+
+/* Statistics of the engine. Retrieve with the control command "get_stats":
+ *   ENGINE_ctrl_cmd(e, "get_stats", 0, &stats, NULL, 0);
+ */
+typedef struct wolfEngine_Stats {
+    /* Number of requests for true random served by the entropy pool. */
+    unsigned long entropyRequests;
+    /* Number of reads of the entropy source (system calls). */
+    unsigned long entropyReads;
+    /* Number of bytes read from the entropy source. */
+    unsigned long entropyBytes;
+    /* Number of DRBGs reseeded or instantiated by the reseed worker. */
+    unsigned long drbgReseeds;
+    /* Number of cipher calls split across the bulk worker pool. */
+    unsigned long bulkSplits;
+    /* Bytes of cipher data in each AES-GCM context. */
+    unsigned long aesGcmCtxBytes;
+    /* Bytes of cipher data in each AES-CBC-HMAC context. */
+    unsigned long aesCbcHmacCtxBytes;
+    /* Number of AES-GCM key schedules shared by lean contexts. */
+    unsigned long sharedKeys;
+    /* Bytes of AES-GCM key schedules shared by lean contexts. */
+    unsigned long sharedKeyBytes;
+    /* Number of per-thread DRBGs allocated. */
+    unsigned long threadRngs;
+    /* Number of per-thread DRBG instantiations by threads using them. */
+    unsigned long threadRngInits;
+} wolfEngine_Stats;
+
 #endif /* WOLFENGINE_H */
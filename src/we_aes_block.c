@@ -30,6 +30,8 @@ typedef struct we_AesBlock
 {
     /** The wolfSSL AES data object. */
     Aes            aes;
+    /** Key expanded into wolfSSL object. */
+    we_AesKeyCache keyCache;
     /** Buffer for streaming. */
     unsigned char  lastBlock[AES_BLOCK_SIZE];
     /** Number of buffered bytes.  */
@@ -62,6 +64,9 @@ static int we_aes_cbc_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     int ret = 1;
     int rc;
     we_AesBlock *aes;
+    int keyLen = 0;
+    int dir = enc ? AES_ENCRYPTION : AES_DECRYPTION;
+    int newKey = 0;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_init");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, "
@@ -77,6 +82,14 @@ static int we_aes_cbc_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     }
 
     if ((ret == 1) && (key != NULL)) {
+        keyLen = EVP_CIPHER_CTX_key_length(ctx);
+        /* IV is set on each cipher call - only key schedule in object. */
+        newKey = !we_aes_key_cache_match(&aes->keyCache, key, keyLen, dir);
+        if (!newKey) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES key unchanged");
+        }
+    }
+    if ((ret == 1) && newKey) {
         WOLFENGINE_MSG(WE_LOG_CIPHER,
                        "Initializing wolfCrypt Aes structure: %p", &aes->aes);
         rc = wc_AesInit(&aes->aes, NULL, INVALID_DEVID);
@@ -86,14 +99,15 @@ static int we_aes_cbc_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
         }
         if (ret == 1) {
             WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES key (%d bytes)",
-                           EVP_CIPHER_CTX_key_length(ctx));
-            rc = wc_AesSetKey(&aes->aes, key, EVP_CIPHER_CTX_key_length(ctx),
-                              iv, enc ? AES_ENCRYPTION : AES_DECRYPTION);
+                           keyLen);
+            rc = wc_AesSetKey(&aes->aes, key, keyLen, iv, dir);
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesSetKey", rc);
                 ret = 0;
             }
         }
+        we_aes_key_cache_set(&aes->keyCache, (ret == 1) ? key : NULL, keyLen,
+                             dir);
     }
 
     if (ret == 1) {
@@ -158,7 +172,16 @@ static int we_aes_cbc_decrypt(we_AesBlock* aes, unsigned char *out,
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_decrypt");
 
     /* padding is handled by OpenSSL before passed to we_aes_cbc_decrypt */
-    rc = wc_AesCbcDecrypt(&aes->aes, out, in, (unsigned int)len);
+#ifdef WE_HAVE_BULK_THREADS
+    if (WE_BULK_SPLIT(len)) {
+        /* Blocks decrypt independently - split across worker threads. */
+        rc = we_aes_bulk(&aes->aes, WE_BULK_AES_CBC_DEC, out, in, len);
+    }
+    else
+#endif
+    {
+        rc = wc_AesCbcDecrypt(&aes->aes, out, in, (unsigned int)len);
+    }
     if (rc == 0) {
         ret = (int)len;
     }
@@ -226,8 +249,8 @@ static int we_aes_cbc_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
 
 /**
  * Extra operations for AES-CBC.
- *
- * No supported operations yet.
+ * Supported operations include:
+ *  - EVP_CTRL_COPY: copy of context made - nothing more to copy
  *
  * @param  ctx   [in]  EVP cipher context of operation.
  * @param  type  [in]  Type of operation to perform.
@@ -248,13 +271,20 @@ static int we_aes_cbc_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 
     /* Get the AES-CBC data to work with. */
     aes = (we_AesBlock *)EVP_CIPHER_CTX_get_cipher_data(ctx);
-    if (aes != NULL) {
+    if (aes == NULL) {
         WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
                                    "EVP_CIPHER_CTX_get_cipher_data", aes);
         ret = 0;
     }
     if (ret == 1) {
         switch (type) {
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Cipher data copied byte-wise - holds no pointers.
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                break;
+
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -273,7 +303,8 @@ static int we_aes_cbc_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 #define AES_CBC_FLAGS              \
     (EVP_CIPH_FLAG_DEFAULT_ASN1  | \
      EVP_CIPH_CBC_MODE           | \
-     EVP_CIPH_ALWAYS_CALL_INIT)
+     EVP_CIPH_ALWAYS_CALL_INIT   | \
+     EVP_CIPH_CUSTOM_COPY)
 
 /** AES128-CBC EVP cipher method. */
 EVP_CIPHER* we_aes128_cbc_ciph = NULL;
@@ -414,6 +445,8 @@ static int we_aes_ecb_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     int ret = 1;
     int rc;
     we_AesBlock *aes;
+    int keyLen;
+    int dir = enc ? AES_ENCRYPTION : AES_DECRYPTION;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ecb_init");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, iv = %p, "
@@ -436,6 +469,7 @@ static int we_aes_ecb_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesInit", rc);
             ret = 0;
         }
+        we_aes_key_cache_set(&aes->keyCache, NULL, 0, 0);
     }
 
     if (ret == 1) {
@@ -445,13 +479,20 @@ static int we_aes_ecb_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     }
 
     if ((ret == 1) && (key != NULL)) {
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES key (%d bytes)",
-                       EVP_CIPHER_CTX_key_length(ctx));
-        rc = wc_AesSetKey(&aes->aes, key, EVP_CIPHER_CTX_key_length(ctx),
-                          NULL, enc ? AES_ENCRYPTION : AES_DECRYPTION);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesSetKey", rc);
-            ret = 0;
+        keyLen = EVP_CIPHER_CTX_key_length(ctx);
+        if (we_aes_key_cache_match(&aes->keyCache, key, keyLen, dir)) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES key unchanged");
+        }
+        else {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES key (%d bytes)",
+                           keyLen);
+            rc = wc_AesSetKey(&aes->aes, key, keyLen, NULL, dir);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesSetKey", rc);
+                ret = 0;
+            }
+            we_aes_key_cache_set(&aes->keyCache, (ret == 1) ? key : NULL,
+                                 keyLen, dir);
         }
     }
 
@@ -537,7 +578,15 @@ static int we_aes_ecb_encrypt(we_AesBlock* aes, unsigned char *out,
             /* Calculate full blocks. */
             l = (int)len & (~(AES_BLOCK_SIZE - 1));
 
-            rc = wc_AesEcbEncrypt(&aes->aes, out, in, l);
+        #ifdef WE_HAVE_BULK_THREADS
+            if (WE_BULK_SPLIT(l)) {
+                rc = we_aes_bulk(&aes->aes, WE_BULK_AES_ECB_ENC, out, in, l);
+            }
+            else
+        #endif
+            {
+                rc = wc_AesEcbEncrypt(&aes->aes, out, in, l);
+            }
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesEcbEncrypt", rc);
                 ret = 0;
@@ -639,7 +688,16 @@ static int we_aes_ecb_decrypt(we_AesBlock* aes, unsigned char *out,
             l = (int)len & (~(AES_BLOCK_SIZE - 1));
 
             if (l > 0) {
-                rc = wc_AesEcbDecrypt(&aes->aes, out, in, l);
+            #ifdef WE_HAVE_BULK_THREADS
+                if (WE_BULK_SPLIT(l)) {
+                    rc = we_aes_bulk(&aes->aes, WE_BULK_AES_ECB_DEC, out, in,
+                                     l);
+                }
+                else
+            #endif
+                {
+                    rc = wc_AesEcbDecrypt(&aes->aes, out, in, l);
+                }
                 if (rc != 0) {
                     WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
                                           "wc_AesEcbDecrypt", rc);
@@ -710,8 +768,8 @@ static int we_aes_ecb_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
 
 /**
  * Extra operations for AES-ECB.
- *
- * No supported operations yet.
+ * Supported operations include:
+ *  - EVP_CTRL_COPY: copy of context made - nothing more to copy
  *
  * @param  ctx   [in]  EVP cipher context of operation.
  * @param  type  [in]  Type of operation to perform.
@@ -732,13 +790,20 @@ static int we_aes_ecb_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 
     /* Get the AES-ECB data to work with. */
     aes = (we_AesBlock *)EVP_CIPHER_CTX_get_cipher_data(ctx);
-    if (aes != NULL) {
+    if (aes == NULL) {
         WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
                                    "EVP_CIPHER_CTX_get_cipher_data", aes);
         ret = 0;
     }
     if (ret == 1) {
         switch (type) {
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Cipher data copied byte-wise - holds no pointers.
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                break;
+
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -757,6 +822,7 @@ static int we_aes_ecb_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 #define AES_ECB_FLAGS              \
     (EVP_CIPH_ALWAYS_CALL_INIT   | \
      EVP_CIPH_FLAG_DEFAULT_ASN1  | \
+     EVP_CIPH_CUSTOM_COPY        | \
      EVP_CIPH_ECB_MODE)
 
 /** AES128-ECB EVP cipher method. */
@@ -23,6 +23,28 @@
 
 #ifdef WE_HAVE_AESCBC
 
+/* Multiple TLS records encrypted in one ctrl call - TLS v1.1 and above. */
+#ifdef EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK
+#define WE_HAVE_MULTIBLOCK
+#define WE_CIPH_FLAG_MULTIBLOCK     EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK
+#else
+#define WE_CIPH_FLAG_MULTIBLOCK     0
+#endif
+
+/** Size of TLS record header: type, version and length. */
+#define WE_TLS_HDR_SZ               5
+/** Minimum data length for multi-block encryption. */
+#define WE_MULTIBLOCK_MIN_SZ        4096
+#ifndef WE_CBC_HMAC_CHUNK_SZ
+/** Size of TLS record data MACed and enciphered at a time - whole blocks.
+ * Small enough that the chunk is still in the L1 cache for the second pass. */
+#define WE_CBC_HMAC_CHUNK_SZ        4096
+#endif
+/** Block size of hash - same for SHA-1 and SHA-256. */
+#define WE_CBC_HMAC_HASH_BLOCK_SZ   WC_SHA256_BLOCK_SIZE
+/** Size of length encoded in last block of hash. */
+#define WE_CBC_HMAC_HASH_LEN_SZ     8
+
 /**
  * Data required to complete an AES CBC HMAC encrypt/decrypt operation.
  */
@@ -32,10 +54,22 @@ typedef struct we_AesCbcHmac
     Aes            aes;
     /** HMAC object. */
     Hmac           hmac;
+    /** wolfCrypt hash type of HMAC - SHA-256 or SHA-1. */
+    int            macType;
+    /** Size of MAC in bytes. */
+    int            macSz;
     /** TLS AAD */
     unsigned char  tlsAAD[16];
     /** Payload len */
     int            pLen;
+#ifdef WE_HAVE_PIPELINE
+    /** TLS records passed in for one cipher call. */
+    we_Pipeline    pipe;
+#endif
+#ifdef WE_HAVE_MULTIBLOCK
+    /** Sequence number, type and version of first multi-block record. */
+    unsigned char  mbHdr[EVP_AEAD_TLS1_AAD_LEN];
+#endif
     /** Flag to indicate whether wolfSSL AES object initialized. */
     unsigned int   init:1;
     /** Flag to indicate whether we are doing encrypt (1) or decrpyt (0). */
@@ -44,10 +78,44 @@ typedef struct we_AesCbcHmac
     unsigned int   tls11:1;
 } we_AesCbcHmac;
 
+/** Hash of the HMAC - used directly when MACing TLS records on decrypt. */
+typedef union we_CbcHmacHash {
+#ifdef WE_HAVE_SHA1
+    /** SHA-1 hash object. */
+    wc_Sha    sha;
+#endif
+    /** SHA-256 hash object. */
+    wc_Sha256 sha256;
+} we_CbcHmacHash;
+
 /*
  * AES-CBC HMAC
  */
 
+/**
+ * Set the hash of the HMAC based on the cipher.
+ *
+ * @param  aes  [in,out]  Internal AES object.
+ * @param  nid  [in]      NID of cipher.
+ */
+static void we_aes_cbc_hmac_set_mac(we_AesCbcHmac *aes, int nid)
+{
+#ifdef WE_HAVE_SHA1
+    if ((nid == NID_aes_128_cbc_hmac_sha1) ||
+            (nid == NID_aes_256_cbc_hmac_sha1)) {
+        aes->macType = WC_SHA;
+        aes->macSz = WC_SHA_DIGEST_SIZE;
+    }
+    else
+#else
+    (void)nid;
+#endif
+    {
+        aes->macType = WC_SHA256;
+        aes->macSz = WC_SHA256_DIGEST_SIZE;
+    }
+}
+
 /**
  * Initialize the AES-CBC HMAC encrypt/decrypt operation using wolfSSL.
  *
@@ -110,6 +178,12 @@ static int we_aes_cbc_hmac_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
         aes->enc = enc;
         /* No payload yet. */
         aes->pLen = 0;
+        /* Hash of HMAC depends on cipher. */
+        we_aes_cbc_hmac_set_mac(aes, EVP_CIPHER_CTX_nid(ctx));
+    #ifdef WE_HAVE_PIPELINE
+        /* No records yet. */
+        we_pipeline_reset(&aes->pipe);
+    #endif
 
         if (key != NULL) {
             /* Set the key into wolfSSL AES object. */
@@ -141,6 +215,11 @@ static int we_aes_cbc_hmac_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
 /**
  * Encrypt and MAC using wolfSSL.
  *
+ * The data is MACed and encrypted a chunk at a time so that each chunk is
+ * still in cache when it is enciphered. The data is never copied to the
+ * output buffer - only the explicit IV and the trailing partial block are
+ * copied, and only when not encrypting in place.
+ *
  * @param  aes  [in]      Internal AES object.
  * @param  out  [out]     Buffer to store enciphered result.
  * @param  in   [in]      Data to encrypt/decrypt.
@@ -157,6 +236,9 @@ static int we_aes_cbc_hmac_enc(we_AesCbcHmac* aes, unsigned char *out,
     unsigned char pb;
     int pLen;
     int tls;
+    int end;
+    int sz;
+    int i;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_hmac_enc");
 
@@ -178,20 +260,55 @@ static int we_aes_cbc_hmac_enc(we_AesCbcHmac* aes, unsigned char *out,
             ret = -1;
         }
     }
+    if ((ret != -1) && tls) {
+        /* MAC the record header stored in ctrl function. */
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Updating MAC with record header");
+        rc = we_hmac_update(&aes->hmac, aes->tlsAAD, EVP_AEAD_TLS1_AAD_LEN);
+        if (rc != 1) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
+            ret = -1;
+        }
+    }
+
+    /* With TLS, only whole blocks of data can be encrypted before the MAC is
+     * calculated. Otherwise, all the data is MACed and encrypted. */
+    end = tls ? off + ((pLen - off) & ~(AES_BLOCK_SIZE - 1)) : pLen;
     if (ret != -1) {
-        /* Record layer MACed in ctrl function. */
-        /* MAC the handshake message/data. */
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "MAC handshake message/data: len = %d",
-                       pLen - off);
-        rc = we_hmac_update(&aes->hmac, in + off, pLen - off);
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "MAC and encrypt handshake message/data: "
+                       "len = %d", end - off);
+    }
+    for (i = off; (ret != -1) && (i < end); i += sz) {
+        sz = end - i;
+        if (sz > WE_CBC_HMAC_CHUNK_SZ) {
+            sz = WE_CBC_HMAC_CHUNK_SZ;
+        }
+        rc = we_hmac_update(&aes->hmac, in + i, sz);
         if (rc != 1) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
             ret = -1;
         }
+        else {
+            rc = wc_AesCbcEncrypt(&aes->aes, out + i, in + i, sz);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCbcEncrypt", rc);
+                ret = -1;
+            }
+        }
     }
     if ((ret != -1) && tls) {
-        /* Copy input to output buffer to encrypt contiguous memory. */
-        XMEMCPY(out, in, pLen);
+        /* MAC the trailing partial block of data. */
+        rc = we_hmac_update(&aes->hmac, in + end, pLen - end);
+        if (rc != 1) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
+            ret = -1;
+        }
+    }
+    if ((ret != -1) && tls) {
+        if (out != in) {
+            /* Copy explicit IV and data not yet encrypted to output buffer. */
+            XMEMCPY(out, in, off);
+            XMEMCPY(out + end, in + end, pLen - end);
+        }
 
         /* Put the MAC after data. */
         WOLFENGINE_MSG(WE_LOG_CIPHER,
@@ -203,37 +320,334 @@ static int we_aes_cbc_hmac_enc(we_AesCbcHmac* aes, unsigned char *out,
         }
     }
     if ((ret != -1) && tls) {
-        in = out;
         /* Put padding after MAC. */
         WOLFENGINE_MSG(WE_LOG_CIPHER, "Adding padding after MAC");
-        pLen += SHA256_DIGEST_LENGTH;
+        pLen += aes->macSz;
         pb = (unsigned char)(len - pLen - 1);
         for (; pLen < (int)len; pLen++) {
             out[pLen] = pb;
         }
-    }
-    if (ret != -1) {
-        /* Encrypt the msg and MAC but not IV. */
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "Encrypting message and MAC");
-        rc = wc_AesCbcEncrypt(&aes->aes, out + off, in + off, (int)len - off);
+
+        /* Encrypt the last of the msg, MAC and padding in place. */
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Encrypting end of message and MAC");
+        rc = wc_AesCbcEncrypt(&aes->aes, out + end, out + end,
+                              (int)len - end);
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCbcEncrypt", rc);
-            ret = 0;
-        }
-        else {
-            ret = (int)len;
-            WOLFENGINE_BUFFER(WE_LOG_CIPHER, out + off, (int)(len - off));
+            ret = -1;
         }
     }
+    if (ret != -1) {
+        ret = (int)len;
+        WOLFENGINE_BUFFER(WE_LOG_CIPHER, out + off, (int)(len - off));
+    }
 
     WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_enc", ret);
 
     return ret;
 }
 
+/**
+ * Constant time mask of whether a is greater than or equal to b.
+ *
+ * Values must be non-negative and less than 2^30.
+ *
+ * @param  a  [in]  First value.
+ * @param  b  [in]  Second value.
+ * @return  All bits set when a >= b and 0 otherwise.
+ */
+static unsigned int we_ct_mask_ge(int a, int b)
+{
+    return (unsigned int)0 -
+           ((unsigned int)(b - a - 1) >> (sizeof(unsigned int) * 8 - 1));
+}
+
+/**
+ * Constant time mask of whether a is equal to b.
+ *
+ * Values must be non-negative and less than 2^30.
+ *
+ * @param  a  [in]  First value.
+ * @param  b  [in]  Second value.
+ * @return  All bits set when a == b and 0 otherwise.
+ */
+static unsigned int we_ct_mask_eq(int a, int b)
+{
+    return we_ct_mask_ge(a, b) & we_ct_mask_ge(b, a);
+}
+
+/**
+ * Constant time mask of whether a byte is zero.
+ *
+ * @param  a  [in]  Byte value.
+ * @return  All bits set when a is 0 and 0 otherwise.
+ */
+static unsigned int we_ct_mask_zero(unsigned char a)
+{
+    return we_ct_mask_ge(0, a);
+}
+
+/**
+ * Initialize the hash of the HMAC.
+ *
+ * @param  hash     [out]  Hash object.
+ * @param  macType  [in]   wolfCrypt hash type - WC_SHA or WC_SHA256.
+ * @return  0 on success and wolfCrypt error code on failure.
+ */
+static int we_cbc_hmac_hash_init(we_CbcHmacHash *hash, int macType)
+{
+#ifdef WE_HAVE_SHA1
+    if (macType == WC_SHA) {
+        return wc_InitSha_ex(&hash->sha, NULL, INVALID_DEVID);
+    }
+#else
+    (void)macType;
+#endif
+    return wc_InitSha256_ex(&hash->sha256, NULL, INVALID_DEVID);
+}
+
+/**
+ * Update the hash of the HMAC with data.
+ *
+ * @param  hash     [in,out]  Hash object.
+ * @param  macType  [in]      wolfCrypt hash type - WC_SHA or WC_SHA256.
+ * @param  data     [in]      Data to hash.
+ * @param  len      [in]      Length of data in bytes.
+ * @return  0 on success and wolfCrypt error code on failure.
+ */
+static int we_cbc_hmac_hash_update(we_CbcHmacHash *hash, int macType,
+                                   const unsigned char *data, int len)
+{
+#ifdef WE_HAVE_SHA1
+    if (macType == WC_SHA) {
+        return wc_ShaUpdate(&hash->sha, data, (word32)len);
+    }
+#else
+    (void)macType;
+#endif
+    return wc_Sha256Update(&hash->sha256, data, (word32)len);
+}
+
+/**
+ * Get the output of the hash of the HMAC.
+ *
+ * The raw output is the current state without padding - the hash can still
+ * be updated afterwards.
+ *
+ * @param  hash     [in,out]  Hash object.
+ * @param  macType  [in]      wolfCrypt hash type - WC_SHA or WC_SHA256.
+ * @param  out      [out]     Buffer to hold digest.
+ * @param  raw      [in]      Whether to output the state without padding.
+ * @return  0 on success and wolfCrypt error code on failure.
+ */
+static int we_cbc_hmac_hash_final(we_CbcHmacHash *hash, int macType,
+                                  unsigned char *out, int raw)
+{
+#ifdef WE_HAVE_SHA1
+    if (macType == WC_SHA) {
+        return raw ? wc_ShaFinalRaw(&hash->sha, out) :
+                     wc_ShaFinal(&hash->sha, out);
+    }
+#else
+    (void)macType;
+#endif
+    return raw ? wc_Sha256FinalRaw(&hash->sha256, out) :
+                 wc_Sha256Final(&hash->sha256, out);
+}
+
+/**
+ * Dispose of the hash of the HMAC.
+ *
+ * @param  hash     [in,out]  Hash object.
+ * @param  macType  [in]      wolfCrypt hash type - WC_SHA or WC_SHA256.
+ */
+static void we_cbc_hmac_hash_free(we_CbcHmacHash *hash, int macType)
+{
+#ifdef WE_HAVE_SHA1
+    if (macType == WC_SHA) {
+        wc_ShaFree(&hash->sha);
+    }
+    else
+#else
+    (void)macType;
+#endif
+    {
+        wc_Sha256Free(&hash->sha256);
+    }
+}
+
+/**
+ * Calculate the HMAC of a decrypted TLS record in constant time.
+ *
+ * The inner hash always processes the number of blocks needed for the
+ * longest possible data length. Padding of the hash is built into the blocks
+ * with masks and the state after the block holding the real end of the data
+ * is kept. The data length is only used in masks.
+ *
+ * @param  aes     [in]   Internal AES object.
+ * @param  data    [in]   Decrypted record - data, MAC and padding.
+ * @param  dataSz  [in]   Length of decrypted record in bytes.
+ * @param  macLen  [in]   Length of data - secret.
+ * @param  mac     [out]  Buffer to hold MAC.
+ * @return  0 on success and wolfCrypt error code on failure.
+ */
+static int we_aes_cbc_hmac_ct_mac(we_AesCbcHmac *aes,
+                                  const unsigned char *data, int dataSz,
+                                  int macLen, unsigned char *mac)
+{
+    int rc;
+    we_CbcHmacHash hash;
+    unsigned char block[WE_CBC_HMAC_HASH_BLOCK_SZ];
+    unsigned char digest[WC_MAX_DIGEST_SIZE];
+    unsigned char bits[WE_CBC_HMAC_HASH_LEN_SZ];
+    unsigned int isEnd;
+    unsigned int b;
+    int maxLen = dataSz - aes->macSz - 1;
+    int hashLen = aes->pLen + macLen;
+    int endBlock = (hashLen + WE_CBC_HMAC_HASH_LEN_SZ) /
+                   WE_CBC_HMAC_HASH_BLOCK_SZ;
+    int blocks = (aes->pLen + maxLen + WE_CBC_HMAC_HASH_LEN_SZ) /
+                 WE_CBC_HMAC_HASH_BLOCK_SZ + 1;
+    int pos;
+    int i;
+    int j;
+
+    /* Length in bits of inner hash input - key block, header and data. */
+    XMEMSET(bits, 0, sizeof(bits));
+    b = (unsigned int)(WE_CBC_HMAC_HASH_BLOCK_SZ + hashLen) * 8;
+    bits[WE_CBC_HMAC_HASH_LEN_SZ - 4] = (unsigned char)(b >> 24);
+    bits[WE_CBC_HMAC_HASH_LEN_SZ - 3] = (unsigned char)(b >> 16);
+    bits[WE_CBC_HMAC_HASH_LEN_SZ - 2] = (unsigned char)(b >>  8);
+    bits[WE_CBC_HMAC_HASH_LEN_SZ - 1] = (unsigned char)b;
+    XMEMSET(mac, 0, aes->macSz);
+
+    rc = we_cbc_hmac_hash_init(&hash, aes->macType);
+    if (rc == 0) {
+        rc = we_cbc_hmac_hash_update(&hash, aes->macType,
+                                     (unsigned char*)aes->hmac.ipad,
+                                     WE_CBC_HMAC_HASH_BLOCK_SZ);
+    }
+    for (i = 0; (rc == 0) && (i < blocks); i++) {
+        isEnd = we_ct_mask_eq(i, endBlock);
+        for (j = 0; j < WE_CBC_HMAC_HASH_BLOCK_SZ; j++) {
+            /* Which byte is read depends only on the public maximum. */
+            pos = i * WE_CBC_HMAC_HASH_BLOCK_SZ + j;
+            if (pos < aes->pLen) {
+                b = aes->tlsAAD[pos];
+            }
+            else if (pos - aes->pLen < dataSz) {
+                b = data[pos - aes->pLen];
+            }
+            else {
+                b = 0;
+            }
+            /* Keep data, put in padding byte and zero the rest. */
+            b &= ~we_ct_mask_ge(pos, hashLen);
+            b |= 0x80 & we_ct_mask_eq(pos, hashLen);
+            if (j >= WE_CBC_HMAC_HASH_BLOCK_SZ - WE_CBC_HMAC_HASH_LEN_SZ) {
+                b |= bits[j - (WE_CBC_HMAC_HASH_BLOCK_SZ -
+                               WE_CBC_HMAC_HASH_LEN_SZ)] & isEnd;
+            }
+            block[j] = (unsigned char)b;
+        }
+        /* Full block - exactly one compression. */
+        rc = we_cbc_hmac_hash_update(&hash, aes->macType, block,
+                                     WE_CBC_HMAC_HASH_BLOCK_SZ);
+        if (rc == 0) {
+            rc = we_cbc_hmac_hash_final(&hash, aes->macType, digest, 1);
+        }
+        for (j = 0; (rc == 0) && (j < aes->macSz); j++) {
+            mac[j] |= digest[j] & isEnd;
+        }
+    }
+    we_cbc_hmac_hash_free(&hash, aes->macType);
+
+    /* Outer hash is over fixed length data. */
+    if (rc == 0) {
+        rc = we_cbc_hmac_hash_init(&hash, aes->macType);
+        if (rc == 0) {
+            rc = we_cbc_hmac_hash_update(&hash, aes->macType,
+                                         (unsigned char*)aes->hmac.opad,
+                                         WE_CBC_HMAC_HASH_BLOCK_SZ);
+        }
+        if (rc == 0) {
+            rc = we_cbc_hmac_hash_update(&hash, aes->macType, mac,
+                                         aes->macSz);
+        }
+        if (rc == 0) {
+            rc = we_cbc_hmac_hash_final(&hash, aes->macType, mac, 0);
+        }
+        we_cbc_hmac_hash_free(&hash, aes->macType);
+    }
+
+    OPENSSL_cleanse(block, sizeof(block));
+    OPENSSL_cleanse(digest, sizeof(digest));
+
+    return rc;
+}
+
+/**
+ * Copy the MAC out of a decrypted TLS record in constant time.
+ *
+ * Every byte that could be part of the MAC is read. The MAC is copied rotated
+ * and then rotated back without indexing by the secret offset.
+ *
+ * @param  aes     [in]   Internal AES object.
+ * @param  data    [in]   Decrypted record - data, MAC and padding.
+ * @param  dataSz  [in]   Length of decrypted record in bytes.
+ * @param  macLen  [in]   Length of data - secret.
+ * @param  mac     [out]  Buffer to hold MAC from record.
+ */
+static void we_aes_cbc_hmac_ct_get_mac(we_AesCbcHmac *aes,
+                                       const unsigned char *data, int dataSz,
+                                       int macLen, unsigned char *mac)
+{
+    unsigned char rotated[WC_MAX_DIGEST_SIZE];
+    unsigned int inMac = 0;
+    unsigned int started;
+    int rotateOff = 0;
+    int macEnd = macLen + aes->macSz;
+    /* Data length is at least maximum less largest padding length. */
+    int start = dataSz - (aes->macSz + 256);
+    int i;
+    int j;
+    int k;
+
+    if (start < 0) {
+        start = 0;
+    }
+    XMEMSET(rotated, 0, sizeof(rotated));
+    for (i = start, j = 0; i < dataSz; i++) {
+        started = we_ct_mask_eq(i, macLen);
+        inMac |= started;
+        inMac &= ~we_ct_mask_ge(i, macEnd);
+        rotateOff |= j & (int)started;
+        rotated[j] |= data[i] & (unsigned char)inMac;
+        j++;
+        j &= ~(int)we_ct_mask_ge(j, aes->macSz);
+    }
+    for (i = 0; i < aes->macSz; i++) {
+        k = rotateOff + i;
+        k -= aes->macSz & (int)we_ct_mask_ge(k, aes->macSz);
+        mac[i] = 0;
+        for (j = 0; j < aes->macSz; j++) {
+            mac[i] |= rotated[j] & (unsigned char)we_ct_mask_eq(j, k);
+        }
+    }
+}
+
 /**
  * Decrypt and verify MAC using wolfSSL.
  *
+ * The data is decrypted a chunk at a time. Without TLS, each chunk is MACed
+ * while it is still in cache.
+ *
+ * With TLS, the record length is checked before decrypting. The padding is
+ * checked, the HMAC calculated and the MAC taken out of the record in
+ * constant time - the number of hash compressions and the
+ * memory accessed don't depend on the padding length. Bad padding and a bad
+ * MAC can't be told apart (Lucky Thirteen).
+ *
  * @param  aes  [in]      Internal AES object.
  * @param  out  [out]     Buffer to store enciphered result.
  * @param  in   [in]      Data to encrypt/decrypt.
@@ -245,12 +659,20 @@ static int we_aes_cbc_hmac_dec(we_AesCbcHmac* aes, unsigned char *out,
                                const unsigned char *in, size_t len)
 {
     int ret = 0;
-    int rc;
+    int rc = 0;
     int off = 0;
-    unsigned char pb;
+    unsigned char pb = 0;
+    unsigned char diff = 0;
+    unsigned int good = ~0U;
+    unsigned int mask;
     int pLen;
     int tls;
-    unsigned char mac[SHA256_DIGEST_LENGTH];
+    unsigned char mac[WC_MAX_DIGEST_SIZE];
+    unsigned char recMac[WC_MAX_DIGEST_SIZE];
+    int macLen = 0;
+    int maxLen = 0;
+    int padMax;
+    int sz;
     int i;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_hmac_dec");
@@ -269,83 +691,108 @@ static int we_aes_cbc_hmac_dec(we_AesCbcHmac* aes, unsigned char *out,
             ret = -1;
        }
     }
+    if ((ret != -1) && tls) {
+        /* Record length is public - checked before decrypting. */
+        if ((((int)len - off) < AES_BLOCK_SIZE) ||
+                ((((int)len - off) % AES_BLOCK_SIZE) != 0) ||
+                (((int)len - off) < aes->macSz + 1)) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid TLS record length");
+            ret = -1;
+        }
+    }
+    if (!tls) {
+        macLen = (int)len - off;
+    }
+    /* Decrypt all but IV and MAC the message/input when not TLS. */
     if (ret != -1) {
-        /* Decrypt all but IV. */
-        rc = wc_AesCbcDecrypt(&aes->aes, out + off, in + off, (int)len - off);
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Decrypt message/input");
+    }
+    for (i = 0; (ret != -1) && (i < (int)len - off); i += sz) {
+        sz = (int)len - off - i;
+        if (sz > WE_CBC_HMAC_CHUNK_SZ) {
+            sz = WE_CBC_HMAC_CHUNK_SZ;
+        }
+        rc = wc_AesCbcDecrypt(&aes->aes, out + off + i, in + off + i, sz);
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCbcDecrypt", rc);
             ret = -1;
         }
-        else {
-            /* Calculate decrypted data length. */
-            ret = (int)len - off;
-
-            WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "Decrypted %d bytes "
-                                   "(AES-CBC-HMAC)", (int)len - off);
-            WOLFENGINE_BUFFER(WE_LOG_CIPHER, out + off, (int)len - off);
+        else if (!tls) {
+            rc = we_hmac_update(&aes->hmac, out + off + i, sz);
+            if (rc != 1) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
+                ret = -1;
+            }
         }
     }
     if ((ret != -1) && tls) {
-        /* TODO: not constant time. */
-        /* Remove padding. */
-        pb = out[off + ret - 1];
-        if (pb >= AES_BLOCK_SIZE) {
-            ret = -1;
-        }
-        for (i = 1; (ret != -1) && (i <= pb); i++) {
-            if (out[off + ret - 1 - i] != pb)
-                ret = -1;
-        }
-        if (ret != -1) {
-            /* Remove padding and MAC length. */
-            ret -= pb + 1 + SHA256_DIGEST_LENGTH;
+        /* Data length when no padding. */
+        maxLen = (int)len - off - aes->macSz - 1;
+        /* Padding length byte must leave room for the MAC - when not, MAC as
+         * if there is no padding and fail later. */
+        pb = out[len - 1];
+        good = we_ct_mask_ge(maxLen, pb);
+        pb &= (unsigned char)good;
+        macLen = maxLen - pb;
+
+        /* Check every byte that could be padding - only those within the
+         * padding length must match it. */
+        padMax = (maxLen < 255) ? maxLen : 255;
+        for (i = 1; i <= padMax; i++) {
+            mask = we_ct_mask_ge(pb, i);
+            diff |= (unsigned char)(mask & (out[len - 1 - i] ^ pb));
         }
+        good &= we_ct_mask_zero(diff);
 
         /* Update record header to have correct message length. */
-        aes->tlsAAD[aes->pLen - 2] = ret >> 8;
-        aes->tlsAAD[aes->pLen - 1] = ret;
+        aes->tlsAAD[aes->pLen - 2] = (unsigned char)(macLen >> 8);
+        aes->tlsAAD[aes->pLen - 1] = (unsigned char)macLen;
 
-        /* MAC the record header. */
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "Generate MAC over record header: "
-                       "len = %d", aes->pLen);
-        rc = we_hmac_update(&aes->hmac, aes->tlsAAD, aes->pLen);
-        if (rc != 1) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Generate MAC over record header and "
+                       "message");
+        rc = we_aes_cbc_hmac_ct_mac(aes, out + off, (int)len - off, macLen,
+                                    mac);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_aes_cbc_hmac_ct_mac",
+                                  rc);
             ret = -1;
         }
-    }
-    /* TODO: not constant time. */
-    if (ret != -1) {
-        /* MAC the message/input. */
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "Generate MAC over message/input, "
-                       "len = %d", ret);
-        rc = we_hmac_update(&aes->hmac, out + off, ret);
-        if (rc != 1) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
-            ret = -1;
+        else {
+            we_aes_cbc_hmac_ct_get_mac(aes, out + off, (int)len - off, macLen,
+                                       recMac);
         }
     }
-    if (ret != -1) {
+    if ((ret != -1) && (!tls)) {
         /* Calculate MAC. */
         rc = wc_HmacFinal(&aes->hmac, mac);
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_HmacFinal", rc);
             ret = -1;
         }
+        else {
+            XMEMCPY(recMac, out + off + macLen, aes->macSz);
+        }
     }
     if (ret != -1) {
+        WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "Decrypted %d bytes "
+                               "(AES-CBC-HMAC)", (int)len - off);
+        WOLFENGINE_BUFFER(WE_LOG_CIPHER, out + off, (int)len - off);
         WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "Generated MAC:");
-        WOLFENGINE_BUFFER(WE_LOG_CIPHER, mac, SHA256_DIGEST_LENGTH);
+        WOLFENGINE_BUFFER(WE_LOG_CIPHER, mac, aes->macSz);
 
-        /* Check MAC. */
-        pb = 0;
-        for (i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-            pb |= mac[i] ^ out[off + ret + i];
+        /* Check MAC and padding together. */
+        diff = 0;
+        for (i = 0; i < aes->macSz; i++) {
+            diff |= mac[i] ^ recMac[i];
         }
-        if (pb != 0) {
+        good &= we_ct_mask_zero(diff);
+        if (good == 0) {
             WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "MAC check failed");
             ret = -1;
         }
+        else {
+            ret = macLen;
+        }
     }
 
     WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_dec", ret);
@@ -353,6 +800,68 @@ static int we_aes_cbc_hmac_dec(we_AesCbcHmac* aes, unsigned char *out,
     return ret;
 }
 
+#ifdef WE_HAVE_PIPELINE
+/**
+ * Encrypt/decrypt the TLS records set with the pipeline ctrl commands.
+ *
+ * Each record is processed with its own record header.
+ *
+ * @param  aes  [in,out]  Internal AES object.
+ * @return  -1 on failure.
+ * @return  Total number of bytes put in output buffers on success.
+ */
+static int we_aes_cbc_hmac_pipeline(we_AesCbcHmac* aes)
+{
+    int ret = 0;
+    int rc;
+    int i;
+    unsigned char *hdr;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_hmac_pipeline");
+
+    if ((!we_pipeline_check(&aes->pipe)) || (aes->pipe.aadCnt == 0)) {
+        ret = -1;
+    }
+    if (ret != -1) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Pipelining %d TLS records",
+                       aes->pipe.num);
+    }
+    for (i = 0; (ret != -1) && (i < aes->pipe.num); i++) {
+        /* Record header and payload length as set by ctrl function. */
+        hdr = aes->pipe.aad[i];
+        XMEMCPY(aes->tlsAAD, hdr, EVP_AEAD_TLS1_AAD_LEN);
+        if (aes->enc) {
+            aes->pLen = (hdr[EVP_AEAD_TLS1_AAD_LEN - 2] << 8) |
+                         hdr[EVP_AEAD_TLS1_AAD_LEN - 1];
+            if (aes->tls11) {
+                /* IV removed from length in record header. */
+                aes->pLen += AES_BLOCK_SIZE;
+            }
+            rc = we_aes_cbc_hmac_enc(aes, aes->pipe.out[i], aes->pipe.in[i],
+                                     aes->pipe.lens[i]);
+        }
+        else {
+            aes->pLen = EVP_AEAD_TLS1_AAD_LEN;
+            rc = we_aes_cbc_hmac_dec(aes, aes->pipe.out[i], aes->pipe.in[i],
+                                     aes->pipe.lens[i]);
+        }
+        if (rc == -1) {
+            ret = -1;
+        }
+        else {
+            ret += rc;
+        }
+    }
+
+    /* Records are only good for one call. */
+    we_pipeline_reset(&aes->pipe);
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_pipeline", ret);
+
+    return ret;
+}
+#endif
+
 /**
  * Encrypt/decrypt the data using wolfSSL.
  *
@@ -383,20 +892,314 @@ static int we_aes_cbc_hmac_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                                    "EVP_CIPHER_CTX_get_cipher_data", aes);
         ret = -1;
     }
+#ifdef WE_HAVE_PIPELINE
+    else if (aes->pipe.num > 0) {
+        ret = we_aes_cbc_hmac_pipeline(aes);
+    }
+#endif
     else if (aes->enc) {
         ret = we_aes_cbc_hmac_enc(aes, out, in, len);
     }
     else {
         ret = we_aes_cbc_hmac_dec(aes, out, in, len);
     }
+#ifdef WE_HAVE_PIPELINE
+    if (aes != NULL) {
+        /* Record headers and buffers only good for one call. */
+        we_pipeline_reset(&aes->pipe);
+    }
+#endif
 
     WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_cipher", ret);
 
     return ret;
 }
 
+#ifdef WE_HAVE_MULTIBLOCK
+/**
+ * Get the size of a TLS record when encrypted.
+ *
+ * Header, explicit IV, data, MAC and at least one byte of padding.
+ *
+ * @param  len    [in]  Length of data in record.
+ * @param  macSz  [in]  Size of MAC in bytes.
+ * @return  Size of record in bytes.
+ */
+static size_t we_aes_cbc_hmac_mb_rec_sz(size_t len, int macSz)
+{
+    return WE_TLS_HDR_SZ + AES_BLOCK_SIZE +
+           ((len + macSz + AES_BLOCK_SIZE) & ~(size_t)(AES_BLOCK_SIZE - 1));
+}
+
+/**
+ * Split the data into records - all but last have the same length.
+ *
+ * @param  len    [in]   Length of data to split.
+ * @param  lanes  [in]   Number of records.
+ * @param  macSz  [in]   Size of MAC in bytes.
+ * @param  frag   [out]  Length of data in all but last record.
+ * @param  last   [out]  Length of data in last record.
+ * @return  Size of all records when encrypted.
+ */
+static size_t we_aes_cbc_hmac_mb_split(size_t len, int lanes, int macSz,
+                                       size_t *frag, size_t *last)
+{
+    *frag = len / lanes;
+    *last = len - *frag * (lanes - 1);
+
+    return we_aes_cbc_hmac_mb_rec_sz(*frag, macSz) * (lanes - 1) +
+           we_aes_cbc_hmac_mb_rec_sz(*last, macSz);
+}
+
+/**
+ * Set the record header for multi-block encryption.
+ *
+ * When no length is in the header, the number of records and length of data
+ * comes from the parameters.
+ *
+ * @param  aes    [in,out]  Internal AES object.
+ * @param  param  [in,out]  Multi-block parameters. Number of records set on
+ *                          return.
+ * @return  Size of output of multi-block encryption on success.
+ * @return  0 when data too short and -1 on failure.
+ */
+static int we_aes_cbc_hmac_mb_aad(we_AesCbcHmac *aes,
+                                  EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM *param)
+{
+    int ret = 1;
+    const unsigned char *hdr = param->inp;
+    size_t len;
+    int lanes = 0;
+    size_t frag;
+    size_t last;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_hmac_mb_aad");
+
+    len = (hdr[EVP_AEAD_TLS1_AAD_LEN - 2] << 8) |
+           hdr[EVP_AEAD_TLS1_AAD_LEN - 1];
+    if (((hdr[9] << 8) | hdr[10]) < TLS1_1_VERSION) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Multi-block needs TLS v1.1+");
+        ret = -1;
+    }
+    else if (len != 0) {
+        if (len < WE_MULTIBLOCK_MIN_SZ) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "Too short for multi-block");
+            ret = 0;
+        }
+        else {
+            lanes = (len >= 2 * WE_MULTIBLOCK_MIN_SZ) ? 8 : 4;
+        }
+    }
+    else if ((param->interleave == 4) || (param->interleave == 8)) {
+        lanes = param->interleave;
+        len = param->len;
+    }
+    else {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid multi-block interleave");
+        ret = -1;
+    }
+
+    if (ret == 1) {
+        XMEMCPY(aes->mbHdr, hdr, EVP_AEAD_TLS1_AAD_LEN);
+        param->interleave = lanes;
+        ret = (int)we_aes_cbc_hmac_mb_split(len, lanes, aes->macSz, &frag,
+                                            &last);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_mb_aad", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt data into multiple TLS records.
+ *
+ * Each record has its own random explicit IV, CBC chain and MAC. The records
+ * are placed one after another in the output buffer, each with a header.
+ *
+ * @param  aes    [in,out]  Internal AES object.
+ * @param  param  [in]      Multi-block parameters.
+ * @return  Number of bytes put in output buffer on success and -1 on failure.
+ */
+static int we_aes_cbc_hmac_mb_enc(we_AesCbcHmac *aes,
+                                  EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM *param)
+{
+    int ret = 0;
+    int rc;
+    int lanes = (int)param->interleave;
+    unsigned char ivs[8 * AES_BLOCK_SIZE];
+    unsigned char hdr[EVP_AEAD_TLS1_AAD_LEN];
+    unsigned char *out = param->out;
+    const unsigned char *in = param->inp;
+    size_t frag;
+    size_t last;
+    size_t len;
+    size_t encLen;
+    size_t j;
+    we_RngShard *shard;
+    int i;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_hmac_mb_enc");
+
+    if ((lanes != 4) && (lanes != 8)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid multi-block interleave");
+        ret = -1;
+    }
+    if (ret != -1) {
+        /* Explicit IVs must be unpredictable. */
+        shard = we_rng_shard();
+    #ifndef WE_SINGLE_THREADED
+        rc = we_rng_shard_lock(shard);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_rng_shard_lock", rc);
+            ret = -1;
+        }
+        else
+    #endif
+        {
+            rc = wc_RNG_GenerateBlock(&shard->rng, ivs,
+                                      lanes * AES_BLOCK_SIZE);
+        #ifndef WE_SINGLE_THREADED
+            wc_UnLockMutex(&shard->mutex);
+        #endif
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_RNG_GenerateBlock",
+                                      rc);
+                ret = -1;
+            }
+        }
+    }
+    if (ret != -1) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Multi-block encrypt of %d records",
+                       lanes);
+        (void)we_aes_cbc_hmac_mb_split(param->len, lanes, aes->macSz, &frag,
+                                       &last);
+        XMEMCPY(hdr, aes->mbHdr, EVP_AEAD_TLS1_AAD_LEN);
+    }
+    for (i = 0; (ret != -1) && (i < lanes); i++) {
+        len = (i == lanes - 1) ? last : frag;
+        encLen = we_aes_cbc_hmac_mb_rec_sz(len, aes->macSz) - WE_TLS_HDR_SZ -
+                 AES_BLOCK_SIZE;
+
+        /* MAC sequence number, type, version, data length and data. */
+        hdr[EVP_AEAD_TLS1_AAD_LEN - 2] = (unsigned char)(len >> 8);
+        hdr[EVP_AEAD_TLS1_AAD_LEN - 1] = (unsigned char)len;
+        rc = we_hmac_update(&aes->hmac, hdr, EVP_AEAD_TLS1_AAD_LEN);
+        if (rc == 1) {
+            rc = we_hmac_update(&aes->hmac, in, len);
+        }
+        if (rc != 1) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_hmac_update", rc);
+            ret = -1;
+            break;
+        }
+
+        /* Record header - length includes explicit IV. */
+        out[0] = hdr[8];
+        out[1] = hdr[9];
+        out[2] = hdr[10];
+        out[3] = (unsigned char)((AES_BLOCK_SIZE + encLen) >> 8);
+        out[4] = (unsigned char)(AES_BLOCK_SIZE + encLen);
+        out += WE_TLS_HDR_SZ;
+        /* Explicit IV then data, MAC and padding. */
+        XMEMCPY(out, ivs + i * AES_BLOCK_SIZE, AES_BLOCK_SIZE);
+        XMEMCPY(out + AES_BLOCK_SIZE, in, len);
+        rc = wc_HmacFinal(&aes->hmac, out + AES_BLOCK_SIZE + len);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_HmacFinal", rc);
+            ret = -1;
+            break;
+        }
+        for (j = len + aes->macSz; j < encLen; j++) {
+            out[AES_BLOCK_SIZE + j] = (unsigned char)(encLen - len -
+                                                      aes->macSz - 1);
+        }
+
+        /* CBC chain starts with explicit IV. */
+        rc = wc_AesSetIV(&aes->aes, out);
+        if (rc == 0) {
+            rc = wc_AesCbcEncrypt(&aes->aes, out + AES_BLOCK_SIZE,
+                                  out + AES_BLOCK_SIZE, (word32)encLen);
+        }
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCbcEncrypt", rc);
+            ret = -1;
+            break;
+        }
+
+        out += AES_BLOCK_SIZE + encLen;
+        in += len;
+        ret += (int)(WE_TLS_HDR_SZ + AES_BLOCK_SIZE + encLen);
+
+        /* Next record has next sequence number. */
+        for (j = 8; j > 0; j--) {
+            if ((++hdr[j - 1]) != 0) {
+                break;
+            }
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_mb_enc", ret);
+
+    return ret;
+}
+#endif /* WE_HAVE_MULTIBLOCK */
+
+/**
+ * Give the copy of an AES-CBC HMAC context its own copy of the HMAC hash.
+ *
+ * OpenSSL has already copied the cipher data byte-wise - key schedule, IV and
+ * HMAC pads need nothing more. The hash object is copied with wolfSSL as it
+ * may hold wolfSSL allocated data.
+ *
+ * @param  aes     [in]  Internal AES object copied from.
+ * @param  dstCtx  [in]  EVP cipher context copied into.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_cbc_hmac_copy(we_AesCbcHmac *aes, EVP_CIPHER_CTX *dstCtx)
+{
+    int ret = 1;
+    int rc;
+    we_AesCbcHmac *dst;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_cbc_hmac_copy");
+
+    dst = (we_AesCbcHmac *)EVP_CIPHER_CTX_get_cipher_data(dstCtx);
+    if (dst == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", dst);
+        ret = 0;
+    }
+    if ((ret == 1) && aes->init) {
+    #ifdef WE_HAVE_SHA1
+        if (aes->macType == WC_SHA) {
+            rc = wc_ShaCopy(&aes->hmac.hash.sha, &dst->hmac.hash.sha);
+        }
+        else
+    #endif
+        {
+            rc = wc_Sha256Copy(&aes->hmac.hash.sha256,
+                               &dst->hmac.hash.sha256);
+        }
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_Sha*Copy", rc);
+            ret = 0;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_cbc_hmac_copy", ret);
+
+    return ret;
+}
+
 /**
  * Extra operations for AES-CBC HMAC.
+ * Supported operations include:
+ *  - EVP_CTRL_COPY: give copy of context its own HMAC hash state
+ *  - EVP_CTRL_AEAD_SET_MAC_KEY: set the HMAC key
+ *  - EVP_CTRL_AEAD_TLS1_AAD: set record header for TLS
+ *  - EVP_CTRL_SET_PIPELINE_*: set TLS records to process in one call
+ *  - EVP_CTRL_TLS1_1_MULTIBLOCK_*: encrypt records in one call
  *
  * @param  ctx   [in]  EVP cipher context of operation.
  * @param  type  [in]  Type of operation to perform.
@@ -431,10 +1234,18 @@ static int we_aes_cbc_hmac_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg,
     }
     if (ret == 1) {
         switch (type) {
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Give copy its own HMAC hash state
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                ret = we_aes_cbc_hmac_copy(aes, (EVP_CIPHER_CTX *)ptr);
+                break;
             case EVP_CTRL_AEAD_SET_MAC_KEY:
                 WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_AEAD_SET_MAC_KEY");
                 /* Set the HMAC key. */
-                rc = wc_HmacSetKey(&aes->hmac, WC_SHA256, (const byte*)ptr,
+                we_aes_cbc_hmac_set_mac(aes, EVP_CIPHER_CTX_nid(ctx));
+                rc = wc_HmacSetKey(&aes->hmac, aes->macType, (const byte*)ptr,
                         arg);
                 if (rc != 0) {
                     WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_HmacSetKey", rc);
@@ -475,19 +1286,17 @@ static int we_aes_cbc_hmac_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg,
                             }
                         }
                         if (ret == 1) {
-                            /* MAC the record header. */
-                            WOLFENGINE_MSG(WE_LOG_CIPHER,
-                                           "Updating MAC with record header");
-                            rc = we_hmac_update(&aes->hmac, tls, arg);
-                            if (rc != 1) {
-                                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
-                                                      "we_hmac_update", rc);
+                            /* Store record header to MAC with payload. */
+                            XMEMCPY(aes->tlsAAD, tls, arg);
+                        #ifdef WE_HAVE_PIPELINE
+                            if (!we_pipeline_add_aad(&aes->pipe, tls)) {
                                 ret = -1;
                             }
                         }
                         if (ret == 1) {
+                        #endif
                             /* Calculate length with padding. */
-                            ret = ((len + SHA256_DIGEST_LENGTH +
+                            ret = ((len + aes->macSz +
                                     AES_BLOCK_SIZE) & -AES_BLOCK_SIZE) - len;
                         }
                     }
@@ -498,10 +1307,58 @@ static int we_aes_cbc_hmac_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg,
                         aes->pLen = arg;
                         XMEMCPY(aes->tlsAAD, ptr, arg);
                         /* MAC size. */
-                        ret = SHA256_DIGEST_LENGTH;
+                        ret = aes->macSz;
+                    #ifdef WE_HAVE_PIPELINE
+                        if (!we_pipeline_add_aad(&aes->pipe, tls)) {
+                            ret = -1;
+                        }
+                    #endif
                     }
                 }
                 break;
+        #ifdef WE_HAVE_PIPELINE
+            case EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS:
+            case EVP_CTRL_SET_PIPELINE_INPUT_BUFS:
+            case EVP_CTRL_SET_PIPELINE_INPUT_LENS:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_SET_PIPELINE_*");
+                /* Set TLS records to process in next cipher call
+                 *   arg [in] number of records
+                 *   ptr [in] array of buffers or lengths
+                 */
+                ret = we_pipeline_ctrl(&aes->pipe, type, arg, ptr);
+                break;
+        #endif
+        #ifdef WE_HAVE_MULTIBLOCK
+            case EVP_CTRL_TLS1_1_MULTIBLOCK_MAX_BUFSIZE:
+                WOLFENGINE_MSG(WE_LOG_CIPHER,
+                               "EVP_CTRL_TLS1_1_MULTIBLOCK_MAX_BUFSIZE");
+                /* Size of encrypted record with arg bytes of data. */
+                ret = (int)we_aes_cbc_hmac_mb_rec_sz(arg, aes->macSz);
+                break;
+            case EVP_CTRL_TLS1_1_MULTIBLOCK_AAD:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_TLS1_1_MULTIBLOCK_AAD");
+                if ((!aes->enc) ||
+                        (arg < (int)sizeof(EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM))) {
+                    ret = -1;
+                }
+                else {
+                    ret = we_aes_cbc_hmac_mb_aad(aes,
+                              (EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM *)ptr);
+                }
+                break;
+            case EVP_CTRL_TLS1_1_MULTIBLOCK_ENCRYPT:
+                WOLFENGINE_MSG(WE_LOG_CIPHER,
+                               "EVP_CTRL_TLS1_1_MULTIBLOCK_ENCRYPT");
+                if ((!aes->enc) ||
+                        (arg < (int)sizeof(EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM))) {
+                    ret = -1;
+                }
+                else {
+                    ret = we_aes_cbc_hmac_mb_enc(aes,
+                              (EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM *)ptr);
+                }
+                break;
+        #endif
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -516,18 +1373,27 @@ static int we_aes_cbc_hmac_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg,
     return ret;
 }
 
-/** Flags for AES-CBC HMAC-SHA256 method. */
+/** Flags for AES-CBC HMAC methods. */
 #define AES_CBC_HMAC_FLAGS                \
     (EVP_CIPH_FLAG_CUSTOM_CIPHER        | \
      EVP_CIPH_ALWAYS_CALL_INIT          | \
      EVP_CIPH_CBC_MODE                  | \
      EVP_CIPH_FLAG_DEFAULT_ASN1         | \
+     EVP_CIPH_CUSTOM_COPY               | \
+     WE_CIPH_FLAG_PIPELINE              | \
+     WE_CIPH_FLAG_MULTIBLOCK            | \
      EVP_CIPH_FLAG_AEAD_CIPHER)
 
 /** AES128-CBC HMAC SHA256 EVP cipher method. */
 EVP_CIPHER* we_aes128_cbc_hmac_ciph = NULL;
 /** AES256-CBC HMAC SHA256 EVP cipher method. */
 EVP_CIPHER* we_aes256_cbc_hmac_ciph = NULL;
+#ifdef WE_HAVE_SHA1
+/** AES128-CBC HMAC SHA1 EVP cipher method. */
+EVP_CIPHER* we_aes128_cbc_hmac_sha1_ciph = NULL;
+/** AES256-CBC HMAC SHA1 EVP cipher method. */
+EVP_CIPHER* we_aes256_cbc_hmac_sha1_ciph = NULL;
+#endif
 
 
 /**
@@ -563,6 +1429,31 @@ static int we_init_aescbc_hmac_meth(EVP_CIPHER *cipher)
     return ret;
 }
 
+/**
+ * Create and initialize an AES-CBC HMAC method.
+ *
+ * @param  nid     [in]  NID of cipher.
+ * @param  keyLen  [in]  Length of AES key in bytes.
+ * @param  name    [in]  Name of cipher for logging.
+ * @return  Cipher method on success and NULL on failure.
+ */
+static EVP_CIPHER* we_new_aescbc_hmac_meth(int nid, int keyLen,
+                                           const char *name)
+{
+    EVP_CIPHER *cipher;
+
+    cipher = EVP_CIPHER_meth_new(nid, AES_BLOCK_SIZE, keyLen);
+    if (cipher == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, name, cipher);
+    }
+    else if (we_init_aescbc_hmac_meth(cipher) != 1) {
+        EVP_CIPHER_meth_free(cipher);
+        cipher = NULL;
+    }
+
+    return cipher;
+}
+
 /**
  * Initialize the AES-CBC methods.
  *
@@ -575,32 +1466,44 @@ int we_init_aescbc_hmac_meths()
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_init_aescbc_meths");
 
     /* AES128-CBC HMAC-SHA256 */
-    we_aes128_cbc_hmac_ciph = EVP_CIPHER_meth_new(NID_aes_128_cbc_hmac_sha256,
-        AES_BLOCK_SIZE, AES_128_KEY_SIZE);
-    if (we_aes128_cbc_ciph == NULL) {
-        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
-                                   "EVP_CIPHER_meth_new - AES-128-CBC "
-                                   "HMAC SHA256", we_aes128_cbc_ciph);
+    we_aes128_cbc_hmac_ciph = we_new_aescbc_hmac_meth(
+        NID_aes_128_cbc_hmac_sha256, AES_128_KEY_SIZE,
+        "EVP_CIPHER_meth_new - AES-128-CBC HMAC SHA256");
+    if (we_aes128_cbc_hmac_ciph == NULL) {
         ret = 0;
     }
+
+    /* AES256-CBC HMAC-SHA256 */
     if (ret == 1) {
-        ret = we_init_aescbc_hmac_meth(we_aes128_cbc_hmac_ciph);
+        we_aes256_cbc_hmac_ciph = we_new_aescbc_hmac_meth(
+            NID_aes_256_cbc_hmac_sha256, AES_256_KEY_SIZE,
+            "EVP_CIPHER_meth_new - AES-256-CBC HMAC SHA256");
+        if (we_aes256_cbc_hmac_ciph == NULL) {
+            ret = 0;
+        }
     }
 
-    /* AES256-CBC HMAC-SHA256 */
+#ifdef WE_HAVE_SHA1
+    /* AES128-CBC HMAC-SHA1 */
     if (ret == 1) {
-        we_aes256_cbc_hmac_ciph = EVP_CIPHER_meth_new(
-            NID_aes_256_cbc_hmac_sha256, AES_BLOCK_SIZE, AES_256_KEY_SIZE);
-        if (we_aes256_cbc_ciph == NULL) {
-            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
-                                       "EVP_CIPHER_meth_new - AES-256-CBC "
-                                       "HMAC SHA256", we_aes256_cbc_ciph);
+        we_aes128_cbc_hmac_sha1_ciph = we_new_aescbc_hmac_meth(
+            NID_aes_128_cbc_hmac_sha1, AES_128_KEY_SIZE,
+            "EVP_CIPHER_meth_new - AES-128-CBC HMAC SHA1");
+        if (we_aes128_cbc_hmac_sha1_ciph == NULL) {
             ret = 0;
         }
     }
+
+    /* AES256-CBC HMAC-SHA1 */
     if (ret == 1) {
-        ret = we_init_aescbc_hmac_meth(we_aes256_cbc_hmac_ciph);
+        we_aes256_cbc_hmac_sha1_ciph = we_new_aescbc_hmac_meth(
+            NID_aes_256_cbc_hmac_sha1, AES_256_KEY_SIZE,
+            "EVP_CIPHER_meth_new - AES-256-CBC HMAC SHA1");
+        if (we_aes256_cbc_hmac_sha1_ciph == NULL) {
+            ret = 0;
+        }
     }
+#endif
 
     /* Cleanup */
     if ((ret == 0) && (we_aes128_cbc_hmac_ciph != NULL)) {
@@ -611,11 +1514,27 @@ int we_init_aescbc_hmac_meths()
         EVP_CIPHER_meth_free(we_aes256_cbc_hmac_ciph);
         we_aes256_cbc_hmac_ciph = NULL;
     }
+#ifdef WE_HAVE_SHA1
+    if ((ret == 0) && (we_aes128_cbc_hmac_sha1_ciph != NULL)) {
+        EVP_CIPHER_meth_free(we_aes128_cbc_hmac_sha1_ciph);
+        we_aes128_cbc_hmac_sha1_ciph = NULL;
+    }
+#endif
 
     WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_init_aescbc_meths", ret);
 
     return ret;
 }
 
+/**
+ * Put the AES-CBC-HMAC context statistics into the stats object.
+ *
+ * @param  stats  [out]  Statistics object.
+ */
+void we_aes_cbc_hmac_get_stats(wolfEngine_Stats *stats)
+{
+    stats->aesCbcHmacCtxBytes = sizeof(we_AesCbcHmac);
+}
+
 #endif /* WE_HAVE_AESCBC */
 
@@ -52,6 +52,13 @@
 #define CCM_LEN_FIELD_MIN_SZ  2
 #define CCM_LEN_FIELD_MAX_SZ  8
 
+/* AES-CCM built on the AES block cipher so that data is authenticated as it is
+ * passed in. FIPS builds only use wolfCrypt's AES-CCM. */
+#if defined(WOLFSSL_AES_DIRECT) && !defined(HAVE_FIPS) && \
+    !defined(HAVE_FIPS_VERSION)
+#define WE_AES_CCM_INCREMENTAL
+#endif
+
 #ifdef WE_HAVE_AESCCM
 
 /*
@@ -65,6 +72,8 @@ typedef struct we_AesCcm
 {
     /** The wolfSSL AES data object. */
     Aes            aes;
+    /** Key expanded into wolfSSL object. */
+    we_AesKeyCache keyCache;
     /** IV to use with encrypt/decrypt. */
     unsigned char  iv[CCM_NONCE_MAX_SZ];
     /** Length of IV data. */
@@ -75,10 +84,28 @@ typedef struct we_AesCcm
     unsigned char  tag[AES_BLOCK_SIZE];
     /** Length of tag data stored.  */
     int            tagLen;
-    /** Additional Authentication Data (AAD) - cumulative. */
+    /** Additional Authentication Data (AAD) - cumulative. Authenticated when
+     *  the first data is passed in as CCM needs the total length first. */
     unsigned char *aad;
     /** Length of AAD stored. */
     int            aadLen;
+    /** AAD of TLS record - length field adjusted. */
+    unsigned char  tlsAad[EVP_AEAD_TLS1_AAD_LEN];
+#ifdef WE_AES_CCM_INCREMENTAL
+    /** CBC-MAC state - first block and AAD processed when AAD passed in. */
+    unsigned char  mac[AES_BLOCK_SIZE];
+    /** Length of message set with length only call. */
+    size_t         msgLen;
+    /** Length of message encrypted/decrypted so far. */
+    size_t         msgDone;
+    /** Counter block of last key stream block. */
+    unsigned char  ctr[AES_BLOCK_SIZE];
+    /** Key stream block - partially used between calls. */
+    unsigned char  ks[AES_BLOCK_SIZE];
+    /** Number of bytes of key stream block used. Same as the number of bytes
+     *  of data in the CBC-MAC block. */
+    int            ksUsed;
+#endif
     /** Size of CCM length field, default is 8 for OpenSSL AES unless set
      *  with ctrl function. wolfSSL calculates L based on nonce, but OpenSSL
      *  allows ctrl command to set L. */
@@ -89,6 +116,12 @@ typedef struct we_AesCcm
     unsigned int   enc:1;
     /** Flag to indicate whether doing this for TLS */
     unsigned int   tls:1;
+#ifdef WE_AES_CCM_INCREMENTAL
+    /** Message length set. */
+    unsigned int   lenSet:1;
+    /** CBC-MAC started with AAD. */
+    unsigned int   macSet:1;
+#endif
 } we_AesCcm;
 
 /**
@@ -106,6 +139,7 @@ static int we_aes_ccm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     int ret = 1;
     int rc;
     we_AesCcm *aes;
+    int keyLen;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ccm_init");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, iv = %p, "
@@ -136,15 +170,28 @@ static int we_aes_ccm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
         aes->init = 1;
         /* Not doing CCM for TLS unless ctrl function called. */
         aes->tls = 0;
+    #ifdef WE_AES_CCM_INCREMENTAL
+        aes->lenSet = 0;
+        aes->macSet = 0;
+    #endif
     }
     if ((ret == 1) && (key != NULL)) {
-        /* Set the AES-CCM key. */
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES-CCM key (%d bytes)",
-                       EVP_CIPHER_CTX_key_length(ctx));
-        rc = wc_AesCcmSetKey(&aes->aes, key, EVP_CIPHER_CTX_key_length(ctx));
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCcmSetKey", rc);
-            ret = 0;
+        keyLen = EVP_CIPHER_CTX_key_length(ctx);
+        if (we_aes_key_cache_match(&aes->keyCache, key, keyLen,
+                                   AES_ENCRYPTION)) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-CCM key unchanged");
+        }
+        else {
+            /* Set the AES-CCM key. */
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES-CCM key (%d bytes)",
+                           keyLen);
+            rc = wc_AesCcmSetKey(&aes->aes, key, keyLen);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCcmSetKey", rc);
+                ret = 0;
+            }
+            we_aes_key_cache_set(&aes->keyCache, (ret == 1) ? key : NULL,
+                                 keyLen, AES_ENCRYPTION);
         }
     }
     if ((ret == 1) && (iv != NULL)) {
@@ -159,6 +206,402 @@ static int we_aes_ccm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     return ret;
 }
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/**
+ * Cleanup the internal AES-CCM object. Does not free object.
+ *
+ * AAD will be left allocated only if encrypt/decrypt operations is not
+ * completed and AAD is buffered.
+ *
+ * @param  ctx  [in]  EVP cipher context.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_aes_ccm_cleanup(EVP_CIPHER_CTX *ctx)
+{
+    int ret = 1;
+    we_AesCcm *aes;
+
+    /* Get the AES-CCM data to work with. */
+    aes = (we_AesCcm *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (aes == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", aes);
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        /* Dispose of the AAD if not freed in encrypt/decrypt operation. */
+        if (aes->aad != NULL) {
+            OPENSSL_free(aes->aad);
+            aes->aad = NULL;
+        }
+        aes->aadLen = 0;
+    #ifdef WE_AES_CCM_INCREMENTAL
+        OPENSSL_cleanse(aes->mac, sizeof(aes->mac));
+    #endif
+    }
+
+    return ret;
+}
+#endif
+
+/**
+ * Give the copy of an AES-CCM context its own copy of the buffered AAD.
+ *
+ * OpenSSL has already copied the cipher data byte-wise - key schedule, nonce
+ * and tag need nothing more.
+ *
+ * @param  aes     [in]  Internal AES-CCM object copied from.
+ * @param  dstCtx  [in]  EVP cipher context copied into.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_ccm_copy(we_AesCcm *aes, EVP_CIPHER_CTX *dstCtx)
+{
+    int ret = 1;
+    we_AesCcm *dst;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ccm_copy");
+
+    dst = (we_AesCcm *)EVP_CIPHER_CTX_get_cipher_data(dstCtx);
+    if (dst == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", dst);
+        ret = 0;
+    }
+    if (ret == 1) {
+        /* Buffer belongs to the original - never freed through the copy. */
+        dst->aad = NULL;
+        dst->aadLen = 0;
+    }
+    if ((ret == 1) && (aes->aad != NULL) && (aes->aadLen > 0)) {
+        dst->aad = (unsigned char *)OPENSSL_malloc(aes->aadLen);
+        if (dst->aad == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "OPENSSL_malloc",
+                                       dst->aad);
+            ret = 0;
+        }
+        else {
+            XMEMCPY(dst->aad, aes->aad, aes->aadLen);
+            dst->aadLen = aes->aadLen;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_ccm_copy", ret);
+
+    return ret;
+}
+
+/**
+ * Seal or open a batch of independent packets with the key of the context.
+ *
+ * Each packet has its own nonce, AAD and tag. The IV, AAD and tag of the
+ * context are not used or changed.
+ *
+ * @param  aes   [in,out]  Internal AES-CCM object.
+ * @param  cnt   [in]      Number of packets.
+ * @param  pkts  [in,out]  Packets to process. Status of each set.
+ * @return  1 when all packets succeeded and 0 otherwise.
+ */
+static int we_aes_ccm_batch(we_AesCcm *aes, int cnt,
+                            wolfEngine_AeadPacket *pkts)
+{
+    int ret = 1;
+    int rc;
+    int i;
+    wolfEngine_AeadPacket *pkt;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ccm_batch");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p, cnt = %d, "
+                           "pkts = %p]", aes, cnt, pkts);
+
+    if ((cnt <= 0) || (pkts == NULL)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid batch of packets");
+        ret = 0;
+    }
+    else if (aes->keyCache.keyLen == 0) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "No key set for batch");
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-CCM %s %d packets",
+                       aes->enc ? "sealing" : "opening", cnt);
+        for (i = 0; i < cnt; i++) {
+            pkt = &pkts[i];
+            if (aes->enc) {
+                rc = wc_AesCcmEncrypt(&aes->aes, pkt->out, pkt->in, pkt->len,
+                        pkt->nonce, pkt->nonceLen, pkt->tag, pkt->tagLen,
+                        pkt->aad, pkt->aadLen);
+                if (rc != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCcmEncrypt",
+                                          rc);
+                }
+            }
+            else {
+                rc = wc_AesCcmDecrypt(&aes->aes, pkt->out, pkt->in, pkt->len,
+                        pkt->nonce, pkt->nonceLen, pkt->tag, pkt->tagLen,
+                        pkt->aad, pkt->aadLen);
+                if (rc != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCcmDecrypt",
+                                          rc);
+                }
+            }
+            /* Keep going - each packet is independent. */
+            pkt->status = (rc == 0);
+            if (rc != 0) {
+                ret = 0;
+            }
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_ccm_batch", ret);
+
+    return ret;
+}
+
+#ifdef WE_AES_CCM_INCREMENTAL
+/**
+ * Encrypt a block with AES - the primitive CCM is built on.
+ *
+ * @param  aes  [in]   Internal AES-CCM object.
+ * @param  out  [out]  Encrypted block.
+ * @param  in   [in]   Block to encrypt.
+ */
+static void we_aes_ccm_encrypt_block(we_AesCcm *aes, unsigned char *out,
+                                     const unsigned char *in)
+{
+    /* Return type differs between wolfSSL versions. Only fails on bad
+     * arguments. */
+    (void)wc_AesEncryptDirect(&aes->aes, out, in);
+}
+
+/**
+ * Update the CBC-MAC with data. A partial last block is zero padded.
+ *
+ * @param  aes  [in,out]  Internal AES-CCM object.
+ * @param  in   [in]      Data to MAC.
+ * @param  len  [in]      Length of data in bytes.
+ */
+static void we_aes_ccm_mac_update(we_AesCcm *aes, const unsigned char *in,
+                                  size_t len)
+{
+    size_t i;
+    size_t n;
+
+    while (len > 0) {
+        n = (len < AES_BLOCK_SIZE) ? len : AES_BLOCK_SIZE;
+        for (i = 0; i < n; i++) {
+            aes->mac[i] ^= in[i];
+        }
+        we_aes_ccm_encrypt_block(aes, aes->mac, aes->mac);
+        in += n;
+        len -= n;
+    }
+}
+
+/**
+ * Start the CBC-MAC with the first block (B0) and the AAD (RFC 3610).
+ *
+ * The nonce, tag length and message length must be known. The AAD is not
+ * needed after this call.
+ *
+ * @param  aes     [in,out]  Internal AES-CCM object.
+ * @param  aad     [in]      AAD to authenticate.
+ * @param  aadLen  [in]      Length of AAD in bytes.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_ccm_mac_start(we_AesCcm *aes, const unsigned char *aad,
+                                size_t aadLen)
+{
+    int ret = 1;
+    int lenSz = 15 - aes->ivLen;
+    unsigned char blk[AES_BLOCK_SIZE];
+    size_t len;
+    word64 aadLen64 = (word64)aadLen;
+    int sz;
+    int lenBytes;
+    int i;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ccm_mac_start");
+
+    if (aes->tagLen == 0) {
+        /* Default to full size tag. */
+        aes->tagLen = EVP_CCM_TLS_TAG_LEN;
+    }
+    if ((aes->tagLen < 4) || (aes->tagLen > AES_BLOCK_SIZE) ||
+            ((aes->tagLen & 1) != 0)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid tag size");
+        ret = 0;
+    }
+    /* Length field size is encoded in 3 bits of B0 and counter blocks. */
+    if ((ret == 1) && ((lenSz < CCM_LEN_FIELD_MIN_SZ) ||
+                       (lenSz > CCM_LEN_FIELD_MAX_SZ))) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid nonce size");
+        ret = 0;
+    }
+    if ((ret == 1) && (lenSz < (int)sizeof(size_t)) &&
+            ((aes->msgLen >> (8 * lenSz)) != 0)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Message too long for nonce");
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        /* B0: flags | nonce | message length. */
+        aes->mac[0] = (unsigned char)(((aadLen > 0) ? 0x40 : 0x00) |
+                                      (((aes->tagLen - 2) / 2) << 3) |
+                                      (lenSz - 1));
+        XMEMCPY(aes->mac + 1, aes->iv, aes->ivLen);
+        for (i = 0, len = aes->msgLen; i < lenSz; i++, len >>= 8) {
+            aes->mac[AES_BLOCK_SIZE - 1 - i] = (unsigned char)len;
+        }
+        we_aes_ccm_encrypt_block(aes, aes->mac, aes->mac);
+
+        /* A0: flags | nonce | counter of 0. */
+        XMEMSET(aes->ctr, 0, sizeof(aes->ctr));
+        aes->ctr[0] = (unsigned char)(lenSz - 1);
+        XMEMCPY(aes->ctr + 1, aes->iv, aes->ivLen);
+        aes->ksUsed = 0;
+        aes->msgDone = 0;
+    }
+    if ((ret == 1) && (aadLen > 0)) {
+        /* Encoded AAD length prepended to AAD. */
+        XMEMSET(blk, 0, sizeof(blk));
+        if (aadLen64 < 0xff00) {
+            sz = 2;
+        }
+        else if (aadLen64 <= 0xffffffffUL) {
+            blk[0] = 0xff;
+            blk[1] = 0xfe;
+            sz = 6;
+        }
+        else {
+            blk[0] = 0xff;
+            blk[1] = 0xff;
+            sz = 10;
+        }
+        lenBytes = (sz == 2) ? 2 : (sz - 2);
+        for (i = 0; i < lenBytes; i++) {
+            blk[sz - 1 - i] = (unsigned char)(aadLen64 >> (8 * i));
+        }
+        /* Fill rest of first block with AAD. */
+        len = AES_BLOCK_SIZE - sz;
+        if (len > aadLen) {
+            len = aadLen;
+        }
+        XMEMCPY(blk + sz, aad, len);
+        we_aes_ccm_mac_update(aes, blk, AES_BLOCK_SIZE);
+        we_aes_ccm_mac_update(aes, aad + len, aadLen - len);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_ccm_mac_start", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt the data when the CBC-MAC has been started with the AAD.
+ *
+ * CTR mode with counter blocks A1, A2, ... and tag encrypted with A0.
+ * Data may be passed in over many calls - the CBC-MAC and CTR state is kept
+ * between calls. The tag is calculated, or checked, when all the data of the
+ * length set has been processed.
+ *
+ * When decrypting in more than one call, the plaintext of each call is output
+ * before the tag is checked - it is unauthenticated until the call that
+ * completes the message succeeds. Only the plaintext of that call is cleansed
+ * when the tag doesn't match.
+ *
+ * @param  aes  [in,out]  Internal AES-CCM object.
+ * @param  out  [out]     Buffer to store enciphered result.
+ * @param  in   [in]      Data to encrypt/decrypt.
+ * @param  len  [in]      Length of data to encrypt/decrypt.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_ccm_mac_cipher(we_AesCcm *aes, unsigned char *out,
+                                 const unsigned char *in, size_t len)
+{
+    int ret = 1;
+    int lenSz = 15 - aes->ivLen;
+    unsigned char ks[AES_BLOCK_SIZE];
+    unsigned char p;
+    size_t i;
+    size_t j;
+    size_t n;
+    int k;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ccm_mac_cipher");
+
+    if (len > aes->msgLen - aes->msgDone) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Data longer than length set");
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        for (i = 0; i < len; i += n) {
+            if (aes->ksUsed == 0) {
+                /* Increment counter in length field. */
+                for (k = AES_BLOCK_SIZE - 1; k >= AES_BLOCK_SIZE - lenSz; k--) {
+                    if (++aes->ctr[k] != 0) {
+                        break;
+                    }
+                }
+                we_aes_ccm_encrypt_block(aes, aes->ks, aes->ctr);
+            }
+            n = len - i;
+            if (n > (size_t)(AES_BLOCK_SIZE - aes->ksUsed)) {
+                n = AES_BLOCK_SIZE - aes->ksUsed;
+            }
+            for (j = 0; j < n; j++) {
+                /* MAC is over plaintext. */
+                p = in[i + j];
+                out[i + j] = p ^ aes->ks[aes->ksUsed + j];
+                if (!aes->enc) {
+                    p = out[i + j];
+                }
+                aes->mac[aes->ksUsed + j] ^= p;
+            }
+            aes->ksUsed += (int)n;
+            if (aes->ksUsed == AES_BLOCK_SIZE) {
+                /* Block of data complete - add to CBC-MAC. */
+                we_aes_ccm_encrypt_block(aes, aes->mac, aes->mac);
+                aes->ksUsed = 0;
+            }
+        }
+        aes->msgDone += len;
+    }
+
+    if ((ret == 1) && (aes->msgDone == aes->msgLen)) {
+        if (aes->ksUsed != 0) {
+            /* Last block of data is zero padded. */
+            we_aes_ccm_encrypt_block(aes, aes->mac, aes->mac);
+            aes->ksUsed = 0;
+        }
+
+        /* Tag is MAC encrypted with A0. */
+        XMEMSET(aes->ctr + AES_BLOCK_SIZE - lenSz, 0, lenSz);
+        we_aes_ccm_encrypt_block(aes, ks, aes->ctr);
+        for (k = 0; k < aes->tagLen; k++) {
+            ks[k] ^= aes->mac[k];
+        }
+        if (aes->enc) {
+            XMEMCPY(aes->tag, ks, aes->tagLen);
+        }
+        else if (CRYPTO_memcmp(ks, aes->tag, aes->tagLen) != 0) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "AES-CCM tag mismatch");
+            /* Don't release unauthenticated plaintext. */
+            OPENSSL_cleanse(out, len);
+            ret = 0;
+        }
+        OPENSSL_cleanse(ks, sizeof(ks));
+        OPENSSL_cleanse(aes->ks, sizeof(aes->ks));
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_ccm_mac_cipher", ret);
+
+    return ret;
+}
+#endif /* WE_AES_CCM_INCREMENTAL */
+
 /**
  * Encrypt/decrypt the data for TLS.
  * One-shot encrypt/decrypt - not streaming.
@@ -212,7 +655,7 @@ static int we_aes_ccm_tls_cipher(we_AesCcm *aes, unsigned char *out,
                                      in + EVP_CCM_TLS_EXPLICIT_IV_LEN,
                                      encLen, aes->iv, aes->ivLen,
                                      out + len - aes->tagLen, aes->tagLen,
-                                     aes->aad, aes->aadLen);
+                                     aes->tlsAad, EVP_AEAD_TLS1_AAD_LEN);
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCcmEncrypt_ex", rc);
                 ret = 0;
@@ -245,7 +688,7 @@ static int we_aes_ccm_tls_cipher(we_AesCcm *aes, unsigned char *out,
                                   in + EVP_CCM_TLS_EXPLICIT_IV_LEN,
                                   decLen, aes->iv, aes->ivLen,
                                   in + len - aes->tagLen, aes->tagLen,
-                                  aes->aad, aes->aadLen);
+                                  aes->tlsAad, EVP_AEAD_TLS1_AAD_LEN);
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCcmDecrypt", rc);
                 ret = 0;
@@ -264,11 +707,6 @@ static int we_aes_ccm_tls_cipher(we_AesCcm *aes, unsigned char *out,
         }
     }
 
-    /* Dispose of any AAD - all used now. */
-    OPENSSL_free(aes->aad);
-    aes->aad = NULL;
-    aes->aadLen = 0;
-
     WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_ccm_tls_cipher", ret);
 
     return ret;
@@ -276,7 +714,14 @@ static int we_aes_ccm_tls_cipher(we_AesCcm *aes, unsigned char *out,
 
 /**
  * Encrypt/decrypt the data.
- * One-shot encrypt/decrypt - not streaming.
+ * One-shot encrypt/decrypt unless the AES block cipher is available and the
+ * message length is set first - then the data may be streamed.
+ *
+ * NOTE: when streaming a decryption over more than one call, the plaintext of
+ * each call is output before the tag is checked. The tag is checked by the
+ * call that completes the message length set - that call, or final, fails on
+ * mismatch. Callers must not use the plaintext until then. Pass all the data
+ * in one call to only get authenticated plaintext.
  *
  * @param  ctx  [in,out]  EVP cipher context of operation.
  * @param  out  [out]     Buffer to store enciphered result.<br>
@@ -289,6 +734,8 @@ static int we_aes_ccm_tls_cipher(we_AesCcm *aes, unsigned char *out,
  *          length of output data on success and 0 on
  *          failure.
  *          When out is not NULL, in is NULL, and len is 0, return 0 (no data).
+ *          <br>
+ *          When streaming after the length is set, -1 on failure.
  */
 static int we_aes_ccm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
                              const unsigned char *in, size_t len)
@@ -314,10 +761,25 @@ static int we_aes_ccm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
         ret = we_aes_ccm_tls_cipher(aes, out, in, len);
     }
     else if ((ret == 1) && (out == NULL) && (in == NULL)) {
+    #ifdef WE_AES_CCM_INCREMENTAL
+        /* Length needed to authenticate AAD as it is passed in. */
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Caching length of plain text");
+        aes->msgLen = len;
+        aes->lenSet = 1;
+        aes->macSet = 0;
+    #else
         /* Don't need to cache length of plain text. Just return size. */
         WOLFENGINE_MSG(WE_LOG_CIPHER, "Not caching length of plain text");
+    #endif
         ret = (int)len;
     }
+#ifdef WE_AES_CCM_INCREMENTAL
+    else if ((ret == 1) && (out == NULL) && aes->macSet) {
+        /* Total length of AAD is authenticated before AAD and data. */
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "AAD must be passed before data");
+        ret = 0;
+    }
+#endif
     else if ((ret == 1) && (out == NULL)) {
         /* Resize stored AAD and append new data. */
         WOLFENGINE_MSG(WE_LOG_CIPHER, "Resizing stored AAD and appending data "
@@ -336,6 +798,71 @@ static int we_aes_ccm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
             ret = (int)len;
         }
     }
+#ifdef WE_AES_CCM_INCREMENTAL
+    else if ((ret == 1) && (len > 0) && aes->lenSet) {
+        if (!aes->macSet) {
+            /* All AAD, if any, buffered - total length now known. */
+            ret = we_aes_ccm_mac_start(aes, aes->aad, aes->aadLen);
+            OPENSSL_free(aes->aad);
+            aes->aad = NULL;
+            aes->aadLen = 0;
+            aes->macSet = (ret == 1);
+        }
+        if (ret == 1) {
+            ret = we_aes_ccm_mac_cipher(aes, out, in, len);
+        }
+        if (ret == 1) {
+            WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "%s %zu bytes (AES-CCM):",
+                                   aes->enc ? "Encrypted" : "Decrypted", len);
+            WOLFENGINE_BUFFER(WE_LOG_CIPHER, out, (unsigned int)len);
+            if (aes->enc && (aes->msgDone == aes->msgLen)) {
+                /* Next nonce as wc_AesCcmEncrypt_ex would leave it. */
+                int i;
+                for (i = aes->ivLen - 1; i >= 0; i--) {
+                    if ((++aes->iv[i]) != 0) {
+                        break;
+                    }
+                }
+            }
+            ret = (int)len;
+        }
+        else {
+            /* Failure, including tag mismatch, reported by EVP API. */
+            ret = -1;
+        }
+        if ((ret == -1) || (aes->msgDone == aes->msgLen)) {
+            /* Message complete or failed - length needed for next. */
+            aes->lenSet = 0;
+            aes->macSet = 0;
+        }
+    }
+    else if ((ret == 1) && (len == 0) && aes->lenSet && (aes->msgLen == 0)) {
+        /* No data - only AAD, if any, authenticated. Calculate or check tag.
+         */
+        if (!aes->macSet) {
+            ret = we_aes_ccm_mac_start(aes, aes->aad, aes->aadLen);
+            OPENSSL_free(aes->aad);
+            aes->aad = NULL;
+            aes->aadLen = 0;
+        }
+        if (ret == 1) {
+            ret = we_aes_ccm_mac_cipher(aes, out, NULL, 0);
+        }
+        if ((ret == 1) && aes->enc) {
+            /* Next nonce as wc_AesCcmEncrypt_ex would leave it. */
+            int i;
+            for (i = aes->ivLen - 1; i >= 0; i--) {
+                if ((++aes->iv[i]) != 0) {
+                    break;
+                }
+            }
+        }
+        /* No data output. */
+        ret = (ret == 1) ? 0 : -1;
+        aes->lenSet = 0;
+        aes->macSet = 0;
+    }
+#endif
     else if ((ret == 1) && (len > 0)) {
         if (aes->tagLen == 0) {
             /* Default to full size tag. */
@@ -403,7 +930,20 @@ static int we_aes_ccm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
         OPENSSL_free(aes->aad);
         aes->aad = NULL;
         aes->aadLen = 0;
-    } else if ((ret == 1) && (in == NULL)) {
+    #ifdef WE_AES_CCM_INCREMENTAL
+        aes->lenSet = 0;
+    #endif
+    }
+#ifdef WE_AES_CCM_INCREMENTAL
+    else if ((ret == 1) && (in == NULL) && aes->macSet) {
+        /* Final call before all data of length set passed in. */
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Data shorter than length set");
+        aes->lenSet = 0;
+        aes->macSet = 0;
+        ret = -1;
+    }
+#endif
+    else if ((ret == 1) && (in == NULL)) {
         /* no error, but no input data or AAD to process, return 0 length */
         WOLFENGINE_MSG(WE_LOG_CIPHER, "No input data or AAd to process, "
                        "returning 0");
@@ -418,6 +958,7 @@ static int we_aes_ccm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
 /**
  * Extra operations for AES-CCM.
  * Supported operations include:
+ *  - EVP_CTRL_COPY: give copy of context its own buffered AAD
  *  - EVP_CTRL_SET_IV (version 3.0+): get IV from wolfengine object
  *  - EVP_CTRL_AEAD_SET_IVLEN: set the length of an IV/nonce
  *  - EVP_CTRL_GET_IVLEN: get the total IV/nonce length
@@ -426,6 +967,7 @@ static int we_aes_ccm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
  *  - EVP_CTRL_AEAD_GET_TAG: get the tag value after encrypt
  *  - EVP_CTRL_AEAD_SET_TAG: set the tag value before decrypt
  *  - EVP_CTRL_AEAD_TLS1_AAD: set AAD for TLS
+ *  - WOLFENGINE_CTRL_AEAD_BATCH: seal or open many packets in one call
  *
  * @param  ctx   [in.out]  EVP cipher context of operation.
  * @param  type  [in]      Type of operation to perform.
@@ -452,6 +994,14 @@ static int we_aes_ccm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
     }
     if (ret == 1) {
         switch (type) {
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Give copy its own buffered AAD
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                ret = we_aes_ccm_copy(aes, (EVP_CIPHER_CTX *)ptr);
+                break;
+
             case EVP_CTRL_CCM_SET_L:
                 WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_CCM_SET_L");
                 /* Set the length field, L
@@ -475,7 +1025,7 @@ static int we_aes_ccm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                  *   arg [in] length of IV/nonce to use
                  *   ptr [in] Unused
                  */
-                if ((arg <= 0) || (arg > CCM_NONCE_MAX_SZ)) {
+                if ((arg < CCM_NONCE_MIN_SZ) || (arg > CCM_NONCE_MAX_SZ)) {
                     WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid nonce length");
                     ret = 0;
                 }
@@ -556,26 +1106,14 @@ static int we_aes_ccm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                     unsigned int len;
 
                     /* Set modified AAD based on record header */
-                    if (aes->aad != NULL) {
-                        OPENSSL_free(aes->aad);
-                    }
-                    aes->aad = (unsigned char*)OPENSSL_malloc(arg);
-                    if (aes->aad == NULL) {
-                        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
-                                                   "OPENSSL_malloc", aes->aad);
+                    XMEMCPY(aes->tlsAad, ptr, arg);
+                    /* Get last two bytes of AAD. */
+                    len = (aes->tlsAad[arg - 2] << 8) | aes->tlsAad[arg - 1];
+                    if (len < EVP_CCM_TLS_EXPLICIT_IV_LEN) {
+                        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER,
+                                             "Length in AAD invalid");
                         ret = 0;
                     }
-                    if (ret == 1) {
-                        XMEMCPY(aes->aad, ptr, arg);
-                        aes->aadLen = arg;
-                        /* Get last two bytes of AAD. */
-                        len = (aes->aad[arg - 2] << 8) | aes->aad[arg - 1];
-                        if (len < EVP_CCM_TLS_EXPLICIT_IV_LEN) {
-                            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER,
-                                                 "Length in AAD invalid");
-                            ret = 0;
-                        }
-                    }
                     if (ret == 1) {
                         len -= EVP_CCM_TLS_EXPLICIT_IV_LEN;
                         if (aes->tagLen == 0) {
@@ -594,8 +1132,8 @@ static int we_aes_ccm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                     }
                     if (ret == 1) {
                         /* Set last two bytes of AAD to exclude explicit len. */
-                        aes->aad[arg - 2] = len >> 8;
-                        aes->aad[arg - 1] = len;
+                        aes->tlsAad[arg - 2] = len >> 8;
+                        aes->tlsAad[arg - 1] = len;
                         /* Encryption to do TLS path. */
                         aes->tls = 1;
                         ret = aes->tagLen;
@@ -603,6 +1141,15 @@ static int we_aes_ccm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                 }
                 break;
 
+            case WOLFENGINE_CTRL_AEAD_BATCH:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "WOLFENGINE_CTRL_AEAD_BATCH");
+                /* Seal or open independent packets with key of context
+                 *   arg [in]      number of packets
+                 *   ptr [in,out]  array of packets
+                 */
+                ret = we_aes_ccm_batch(aes, arg, (wolfEngine_AeadPacket *)ptr);
+                break;
+
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -625,6 +1172,7 @@ static int we_aes_ccm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
      EVP_CIPH_ALWAYS_CALL_INIT   | \
      EVP_CIPH_FLAG_AEAD_CIPHER   | \
      EVP_CIPH_FLAG_DEFAULT_ASN1  | \
+     EVP_CIPH_CUSTOM_COPY        | \
      EVP_CIPH_CCM_MODE)
 
 /** AES128-CCM EVP cipher method. */
@@ -653,6 +1201,11 @@ static int we_init_aesccm_meth(EVP_CIPHER *cipher)
     if (ret == 1) {
         ret = EVP_CIPHER_meth_set_init(cipher, we_aes_ccm_init);
     }
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_cleanup(cipher, we_aes_ccm_cleanup);
+    }
+#endif
     if (ret == 1) {
         ret = EVP_CIPHER_meth_set_do_cipher(cipher, we_aes_ccm_cipher);
     }
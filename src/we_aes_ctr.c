@@ -34,6 +34,8 @@ typedef struct we_AesCtr
 {
     /** The wolfSSL AES data object. */
     Aes            aes;
+    /** Key expanded into wolfSSL object. */
+    we_AesKeyCache keyCache;
 } we_AesCtr;
 
 
@@ -52,6 +54,7 @@ static int we_aes_ctr_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     int ret = 1;
     int rc;
     we_AesCtr *aes;
+    int keyLen;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_ctr_init");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, iv = %p, "
@@ -67,20 +70,29 @@ static int we_aes_ctr_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     }
 
     if ((ret == 1) && (key != NULL)) {
-        rc = wc_AesInit(&aes->aes, NULL, INVALID_DEVID);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesInit", rc);
-            ret = 0;
-        }
-    }
-
-    if ((ret == 1) && (key != NULL)) {
+        keyLen = EVP_CIPHER_CTX_key_length(ctx);
         /* No decryption for CTR. */
-        rc = wc_AesSetKey(&aes->aes, key, EVP_CIPHER_CTX_key_length(ctx), iv,
-                          AES_ENCRYPTION);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesSetKey", rc);
-            ret = 0;
+        if (we_aes_key_cache_match(&aes->keyCache, key, keyLen,
+                                   AES_ENCRYPTION)) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES key unchanged");
+            /* Discard any cached key stream - IV set on each cipher call. */
+            aes->aes.left = 0;
+        }
+        else {
+            rc = wc_AesInit(&aes->aes, NULL, INVALID_DEVID);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesInit", rc);
+                ret = 0;
+            }
+            if (ret == 1) {
+                rc = wc_AesSetKey(&aes->aes, key, keyLen, iv, AES_ENCRYPTION);
+                if (rc != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesSetKey", rc);
+                    ret = 0;
+                }
+            }
+            we_aes_key_cache_set(&aes->keyCache, (ret == 1) ? key : NULL,
+                                 keyLen, AES_ENCRYPTION);
         }
     }
 
@@ -128,7 +140,17 @@ static int we_aes_ctr_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
         }
     }
     if (ret == 1) {
-        rc = wc_AesCtrEncrypt(&aes->aes, out, in, (word32)len);
+    #ifdef WE_HAVE_BULK_THREADS
+        if (WE_BULK_SPLIT(len)) {
+            /* Key stream blocks are independent - split across worker
+             * threads. */
+            rc = we_aes_bulk(&aes->aes, WE_BULK_AES_CTR, out, in, len);
+        }
+        else
+    #endif
+        {
+            rc = wc_AesCtrEncrypt(&aes->aes, out, in, (word32)len);
+        }
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesCtrEncrypt", rc);
             ret = -1;
@@ -149,8 +171,8 @@ static int we_aes_ctr_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
 
 /**
  * Extra operations for AES-CTR.
- *
- * No supported operations yet.
+ * Supported operations include:
+ *  - EVP_CTRL_COPY: copy of context made - nothing more to copy
  *
  * @param  ctx   [in]  EVP cipher context of operation.
  * @param  type  [in]  Type of operation to perform.
@@ -173,13 +195,20 @@ static int we_aes_ctr_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 
     /* Get the AES-CTR data to work with. */
     aes = (we_AesCtr *)EVP_CIPHER_CTX_get_cipher_data(ctx);
-    if (aes != NULL) {
+    if (aes == NULL) {
         WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
                                    "EVP_CIPHER_CTX_get_cipher_data", aes);
         ret = 0;
     }
     if (ret == 1) {
         switch (type) {
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Cipher data copied byte-wise - holds no pointers.
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                break;
+
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -197,6 +226,7 @@ static int we_aes_ctr_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 /** Flags for AES-CTR method. */
 #define AES_CTR_FLAGS              \
     (EVP_CIPH_FLAG_DEFAULT_ASN1  | \
+     EVP_CIPH_CUSTOM_COPY        | \
      EVP_CIPH_CTR_MODE)
 
 /** AES128-CTR EVP cipher method. */
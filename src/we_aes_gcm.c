@@ -33,17 +33,237 @@
 
 #ifdef WE_HAVE_AESGCM
 
+/* Lean contexts reference a key schedule and GHASH table shared by all
+ * contexts with the same key - only per-stream state is in each context.
+ * Streaming AES-GCM keeps per-stream state in the wolfSSL object. */
+#if defined(WE_LEAN_CIPHER_CTX) && !defined(WOLFSSL_AESGCM_STREAM) && \
+    (OPENSSL_VERSION_NUMBER >= 0x10100000L) && \
+    (defined(WE_SINGLE_THREADED) || defined(HAVE_PTHREAD))
+#define WE_AES_GCM_LEAN
+#endif
+
 /*
  * AES-GCM
  */
 
+#ifdef WE_AES_GCM_LEAN
+/* Number of buckets in table of shared key schedules - power of 2. */
+#define WE_AES_GCM_SHARED_BUCKETS   64
+
+/**
+ * Key schedule and GHASH table shared by AES-GCM contexts with the same key.
+ */
+typedef struct we_AesGcmShared
+{
+    /** The wolfSSL AES data object - not changed once key set. */
+    Aes                      aes;
+    /** Key expanded into wolfSSL object. */
+    unsigned char            key[AES_256_KEY_SIZE];
+    /** Length of key in bytes. */
+    int                      keyLen;
+    /** Fingerprint of key - selects bucket. */
+    word32                   fp;
+    /** Number of contexts referencing this object. */
+    int                      refCnt;
+    /** Next object in bucket. */
+    struct we_AesGcmShared  *next;
+} we_AesGcmShared;
+
+/** Table of shared key schedules. */
+static we_AesGcmShared *we_aesGcmShared[WE_AES_GCM_SHARED_BUCKETS];
+/** Number of shared key schedules in table. */
+static unsigned long we_aesGcmSharedCnt = 0;
+#ifndef WE_SINGLE_THREADED
+/** Protects table of shared key schedules and reference counts. */
+static pthread_mutex_t we_aesGcmSharedMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/**
+ * Calculate a fingerprint of a key - FNV-1a.
+ *
+ * @param  key     [in]  Key bytes.
+ * @param  keyLen  [in]  Length of key in bytes.
+ * @return  Fingerprint of key.
+ */
+static word32 we_aes_gcm_key_fp(const unsigned char *key, int keyLen)
+{
+    word32 fp = 0x811c9dc5;
+    int i;
+
+    for (i = 0; i < keyLen; i++) {
+        fp = (fp ^ key[i]) * 0x01000193;
+    }
+
+    return fp;
+}
+
+/**
+ * Get a reference to the shared key schedule for the key.
+ *
+ * Key schedule and GHASH table created when no context has the key.
+ *
+ * @param  key     [in]  AES key - 16/24/32 bytes.
+ * @param  keyLen  [in]  Length of key in bytes.
+ * @return  Shared key schedule on success and NULL on failure.
+ */
+static we_AesGcmShared* we_aes_gcm_shared_get(const unsigned char *key,
+                                              int keyLen)
+{
+    int rc;
+    word32 fp = we_aes_gcm_key_fp(key, keyLen);
+    we_AesGcmShared **bucket;
+    we_AesGcmShared *shared = NULL;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_shared_get");
+
+    bucket = &we_aesGcmShared[fp & (WE_AES_GCM_SHARED_BUCKETS - 1)];
+#ifndef WE_SINGLE_THREADED
+    rc = pthread_mutex_lock(&we_aesGcmSharedMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "pthread_mutex_lock", rc);
+    }
+    else
+#endif
+    {
+        for (shared = *bucket; shared != NULL; shared = shared->next) {
+            if ((shared->fp == fp) && (shared->keyLen == keyLen) &&
+                    (CRYPTO_memcmp(shared->key, key, keyLen) == 0)) {
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "Sharing AES-GCM key schedule");
+                shared->refCnt++;
+                break;
+            }
+        }
+        if (shared == NULL) {
+            shared = (we_AesGcmShared *)OPENSSL_zalloc(sizeof(*shared));
+            if (shared == NULL) {
+                WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "OPENSSL_zalloc",
+                                           shared);
+            }
+        }
+        if ((shared != NULL) && (shared->refCnt == 0)) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting shared AES-GCM key (%d "
+                           "bytes)", keyLen);
+            rc = wc_AesInit(&shared->aes, NULL, INVALID_DEVID);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesInit", rc);
+            }
+            else {
+                rc = wc_AesGcmSetKey(&shared->aes, key, keyLen);
+                if (rc != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmSetKey",
+                                          rc);
+                    wc_AesFree(&shared->aes);
+                }
+            }
+            if (rc != 0) {
+                OPENSSL_clear_free(shared, sizeof(*shared));
+                shared = NULL;
+            }
+            else {
+                XMEMCPY(shared->key, key, keyLen);
+                shared->keyLen = keyLen;
+                shared->fp = fp;
+                shared->refCnt = 1;
+                shared->next = *bucket;
+                *bucket = shared;
+                we_aesGcmSharedCnt++;
+            }
+        }
+    #ifndef WE_SINGLE_THREADED
+        pthread_mutex_unlock(&we_aesGcmSharedMutex);
+    #endif
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_shared_get", shared != NULL);
+
+    return shared;
+}
+
+/**
+ * Add a reference to a shared key schedule.
+ *
+ * @param  shared  [in,out]  Shared key schedule. May be NULL.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_gcm_shared_ref(we_AesGcmShared *shared)
+{
+    int ret = 1;
+#ifndef WE_SINGLE_THREADED
+    int rc;
+#endif
+
+    if (shared != NULL) {
+    #ifndef WE_SINGLE_THREADED
+        rc = pthread_mutex_lock(&we_aesGcmSharedMutex);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "pthread_mutex_lock", rc);
+            ret = 0;
+        }
+        else
+    #endif
+        {
+            shared->refCnt++;
+        #ifndef WE_SINGLE_THREADED
+            pthread_mutex_unlock(&we_aesGcmSharedMutex);
+        #endif
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Release a reference to a shared key schedule. Freed with last reference.
+ *
+ * @param  shared  [in]  Shared key schedule. May be NULL.
+ */
+static void we_aes_gcm_shared_put(we_AesGcmShared *shared)
+{
+    we_AesGcmShared **prev;
+    int last = 0;
+
+    if (shared == NULL) {
+        return;
+    }
+#ifndef WE_SINGLE_THREADED
+    if (pthread_mutex_lock(&we_aesGcmSharedMutex) != 0) {
+        /* Leaked rather than freed while in use. */
+        return;
+    }
+#endif
+    if (--shared->refCnt == 0) {
+        prev = &we_aesGcmShared[shared->fp & (WE_AES_GCM_SHARED_BUCKETS - 1)];
+        while (*prev != shared) {
+            prev = &(*prev)->next;
+        }
+        *prev = shared->next;
+        we_aesGcmSharedCnt--;
+        last = 1;
+    }
+#ifndef WE_SINGLE_THREADED
+    pthread_mutex_unlock(&we_aesGcmSharedMutex);
+#endif
+    if (last) {
+        wc_AesFree(&shared->aes);
+        OPENSSL_clear_free(shared, sizeof(*shared));
+    }
+}
+#endif /* WE_AES_GCM_LEAN */
+
 /**
  * Data required to complete an AES-GCM encrypt/decrypt operation.
  */
 typedef struct we_AesGcm
 {
+#ifdef WE_AES_GCM_LEAN
+    /** Key schedule and GHASH table shared with contexts using same key. */
+    we_AesGcmShared *shared;
+#else
     /** The wolfSSL AES data object. */
     Aes            aes;
+    /** Key expanded into wolfSSL object. */
+    we_AesKeyCache keyCache;
+#endif
     /** IV to use with encrypt/decrypt. */
     unsigned char  iv[GCM_NONCE_MAX_SZ];
     /** Length of IV data. */
@@ -52,6 +272,9 @@ typedef struct we_AesGcm
     unsigned char  tag[AES_BLOCK_SIZE];
     /** Length of tag data stored.  */
     int            tagLen;
+    /** AAD of TLS record - length field adjusted. */
+    unsigned char  tlsAad[EVP_AEAD_TLS1_AAD_LEN];
+#ifndef WOLFSSL_AESGCM_STREAM
     /** Additional Authentication Data (AAD) - cumulative. */
     unsigned char *aad;
     /** Length of AAD stored. */
@@ -64,6 +287,11 @@ typedef struct we_AesGcm
      * be saved on "update" calls since encryption/decryption is deferred to
      * the "final" call. */
     unsigned char *outputBuf;
+#endif
+#ifdef WE_HAVE_PIPELINE
+    /** TLS records passed in for one cipher call. */
+    we_Pipeline    pipe;
+#endif
     /** Flag to indicate whether object initialized. */
     unsigned int   init:1;
     /** Flag to indicate whether we are doing encrypt (1) or decrpyt (0). */
@@ -74,8 +302,89 @@ typedef struct we_AesGcm
     int            ivSet:1;
     /** IV increment. */
     int            ivInc:1;
+#ifdef WOLFSSL_AESGCM_STREAM
+    /** Streaming operation started with IV in wolfSSL object. */
+    unsigned int   started:1;
+#endif
 } we_AesGcm;
 
+#ifdef WE_AES_GCM_LEAN
+/** wolfSSL AES object of an AES-GCM context - read only. */
+#define WE_AES_GCM_OBJ(aes)         (&(aes)->shared->aes)
+/** Whether a key has been set into an AES-GCM context. */
+#define WE_AES_GCM_HAS_KEY(aes)     ((aes)->shared != NULL)
+#else
+/** wolfSSL AES object of an AES-GCM context. */
+#define WE_AES_GCM_OBJ(aes)         (&(aes)->aes)
+/** Whether a key has been set into an AES-GCM context. */
+#define WE_AES_GCM_HAS_KEY(aes)     ((aes)->keyCache.keyLen != 0)
+#endif
+
+/**
+ * Set the key into the AES-GCM context.
+ *
+ * Key expansion and GHASH table only redone when key changes. Lean contexts
+ * reference the key schedule of another context with the same key.
+ *
+ * @param  aes     [in,out]  Internal AES-GCM object.
+ * @param  key     [in]      AES key - 16/24/32 bytes.
+ * @param  keyLen  [in]      Length of key in bytes.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_gcm_set_key(we_AesGcm *aes, const unsigned char *key,
+                              int keyLen)
+{
+    int ret = 1;
+#ifdef WE_AES_GCM_LEAN
+    we_AesGcmShared *shared;
+
+    if ((aes->shared != NULL) && (aes->shared->keyLen == keyLen) &&
+            (CRYPTO_memcmp(aes->shared->key, key, keyLen) == 0)) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM key unchanged");
+    }
+    else {
+        shared = we_aes_gcm_shared_get(key, keyLen);
+        if (shared == NULL) {
+            ret = 0;
+        }
+        else {
+            we_aes_gcm_shared_put(aes->shared);
+            aes->shared = shared;
+            aes->init = 1;
+        }
+    }
+#else
+    int rc;
+
+    if (we_aes_key_cache_match(&aes->keyCache, key, keyLen, AES_ENCRYPTION)) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM key unchanged");
+    }
+    else {
+        rc = wc_AesInit(&aes->aes, NULL, INVALID_DEVID);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesInit", rc);
+            ret = 0;
+        }
+        aes->init = (ret == 1);
+
+        if (ret == 1) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES-GCM key (%d bytes)",
+                           keyLen);
+            /* Set the AES-GCM key. */
+            rc = wc_AesGcmSetKey(&aes->aes, key, keyLen);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmSetKey", rc);
+                ret = 0;
+            }
+        }
+        we_aes_key_cache_set(&aes->keyCache, (ret == 1) ? key : NULL, keyLen,
+                             AES_ENCRYPTION);
+    }
+#endif
+
+    return ret;
+}
+
 /**
  * Initialize the AES-GCM encrypt/decrypt operation using wolfSSL.
  *
@@ -89,7 +398,6 @@ static int we_aes_gcm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
                            const unsigned char *iv, int enc)
 {
     int ret = 1;
-    int rc;
     we_AesGcm *aes;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_init");
@@ -105,29 +413,20 @@ static int we_aes_gcm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
     }
 
     if ((ret == 1) && (key != NULL)) {
-        rc = wc_AesInit(&aes->aes, NULL, INVALID_DEVID);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesInit", rc);
-            ret = 0;
-        }
-        aes->init = (ret == 1);
-    }
-
-    if ((ret == 1) && (key != NULL)) {
-        WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES-GCM key (%d bytes)",
-                       EVP_CIPHER_CTX_key_length(ctx));
-        /* Set the AES-GCM key. */
-        rc = wc_AesGcmSetKey(&aes->aes, key, EVP_CIPHER_CTX_key_length(ctx));
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmSetKey", rc);
-            ret = 0;
-        }
+    #ifdef WOLFSSL_AESGCM_STREAM
+        aes->started = 0;
+    #endif
+        ret = we_aes_gcm_set_key(aes, key, EVP_CIPHER_CTX_key_length(ctx));
     }
     if ((ret == 1) && (iv != NULL)) {
         /* Cache IV - see ctrl func for other ways to set IV. */
         WOLFENGINE_MSG(WE_LOG_CIPHER, "Caching IV into aes->iv");
         XMEMCPY(aes->iv, iv, aes->ivLen);
         aes->ivSet = 0;
+    #ifdef WOLFSSL_AESGCM_STREAM
+        /* Next operation starts with new IV. */
+        aes->started = 0;
+    #endif
     }
 
     if (ret == 1) {
@@ -144,7 +443,7 @@ static int we_aes_gcm_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
  * Cleanup the internal AES-GCM object. Does not free object.
  *
  * AAD will be left allocated only if encrypt/decrypt operations is not
- * completed.
+ * completed and AAD is buffered.
  *
  * @param  ctx  [in]  EVP cipher context.
  * @returns  1 on success and 0 on failure.
@@ -163,6 +462,7 @@ static int we_aes_gcm_cleanup(EVP_CIPHER_CTX *ctx)
     }
 
     if (ret == 1) {
+    #ifndef WOLFSSL_AESGCM_STREAM
         /* Dispose of the AAD if not freed in encrypt/decrypt operation. */
         if (aes->aad != NULL) {
             OPENSSL_free(aes->aad);
@@ -173,13 +473,176 @@ static int we_aes_gcm_cleanup(EVP_CIPHER_CTX *ctx)
         }
         aes->tmpLen = 0;
         aes->outputBuf = NULL;
+    #endif
+    #ifdef WE_AES_GCM_LEAN
+        /* Key schedule freed with last context using it. */
+        we_aes_gcm_shared_put(aes->shared);
+        aes->shared = NULL;
+    #else
         wc_AesFree(&aes->aes);
+        /* Key schedule no longer valid. */
+        we_aes_key_cache_set(&aes->keyCache, NULL, 0, 0);
+    #endif
     }
 
     return ret;
 }
 #endif
 
+/**
+ * Give the copy of an AES-GCM context its own copies of owned data.
+ *
+ * OpenSSL has already copied the cipher data byte-wise - key schedule, GHASH
+ * table, IV and tag need nothing more.
+ *
+ * Without streaming support in wolfSSL, a context with buffered data can't be
+ * copied - the data is output to the caller's buffer of the original at final.
+ *
+ * @param  aes     [in]  Internal AES-GCM object copied from.
+ * @param  dstCtx  [in]  EVP cipher context copied into.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_gcm_copy(we_AesGcm *aes, EVP_CIPHER_CTX *dstCtx)
+{
+    int ret = 1;
+    we_AesGcm *dst;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_copy");
+
+#ifdef WOLFSSL_AESGCM_STREAM
+    /* Streaming state all in wolfSSL object. */
+    (void)aes;
+#endif
+
+    dst = (we_AesGcm *)EVP_CIPHER_CTX_get_cipher_data(dstCtx);
+    if (dst == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", dst);
+        ret = 0;
+    }
+#ifndef WOLFSSL_AESGCM_STREAM
+    if (ret == 1) {
+        /* Buffers belong to the original - never freed through the copy. */
+        dst->aad = NULL;
+        dst->aadLen = 0;
+        dst->tmp = NULL;
+        dst->tmpLen = 0;
+        dst->outputBuf = NULL;
+    }
+    if ((ret == 1) && (aes->tmpLen > 0)) {
+        /* Buffered data is written to the original's output buffer at final -
+         * the copy can't finish the operation. */
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Can't copy with buffered data");
+        ret = 0;
+    }
+#endif
+    if (ret == 1) {
+    #ifdef WE_AES_GCM_LEAN
+        /* Copy references the same key schedule. */
+        if (!we_aes_gcm_shared_ref(dst->shared)) {
+            dst->shared = NULL;
+            ret = 0;
+        }
+    #else
+        ret = we_aes_copy_fixup(&dst->aes);
+    #endif
+    }
+#ifndef WOLFSSL_AESGCM_STREAM
+    if ((ret == 1) && (aes->aad != NULL) && (aes->aadLen > 0)) {
+        dst->aad = (unsigned char *)OPENSSL_malloc(aes->aadLen);
+        if (dst->aad == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "OPENSSL_malloc",
+                                       dst->aad);
+            ret = 0;
+        }
+        else {
+            XMEMCPY(dst->aad, aes->aad, aes->aadLen);
+            dst->aadLen = aes->aadLen;
+        }
+    }
+#endif
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_copy", ret);
+
+    return ret;
+}
+
+/**
+ * Seal or open a batch of independent packets with the key of the context.
+ *
+ * Each packet has its own nonce, AAD and tag. The IV, AAD and tag of the
+ * context are not used or changed. With streaming AES-GCM, the batch fails
+ * when a stream is in progress as the one-shot calls change the state in the
+ * wolfSSL object.
+ *
+ * @param  aes   [in,out]  Internal AES-GCM object.
+ * @param  cnt   [in]      Number of packets.
+ * @param  pkts  [in,out]  Packets to process. Status of each set.
+ * @return  1 when all packets succeeded and 0 otherwise.
+ */
+static int we_aes_gcm_batch(we_AesGcm *aes, int cnt,
+                            wolfEngine_AeadPacket *pkts)
+{
+    int ret = 1;
+    int rc;
+    int i;
+    wolfEngine_AeadPacket *pkt;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_batch");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p, cnt = %d, "
+                           "pkts = %p]", aes, cnt, pkts);
+
+    if ((cnt <= 0) || (pkts == NULL)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid batch of packets");
+        ret = 0;
+    }
+    else if (!WE_AES_GCM_HAS_KEY(aes)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "No key set for batch");
+        ret = 0;
+    }
+#ifdef WOLFSSL_AESGCM_STREAM
+    else if (aes->started) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Batch during streaming operation");
+        ret = 0;
+    }
+#endif
+
+    if (ret == 1) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM %s %d packets",
+                       aes->enc ? "sealing" : "opening", cnt);
+        for (i = 0; i < cnt; i++) {
+            pkt = &pkts[i];
+            if (aes->enc) {
+                rc = wc_AesGcmEncrypt(WE_AES_GCM_OBJ(aes), pkt->out, pkt->in,
+                        pkt->len, pkt->nonce, pkt->nonceLen, pkt->tag,
+                        pkt->tagLen, pkt->aad, pkt->aadLen);
+                if (rc != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmEncrypt",
+                                          rc);
+                }
+            }
+            else {
+                rc = wc_AesGcmDecrypt(WE_AES_GCM_OBJ(aes), pkt->out, pkt->in,
+                        pkt->len, pkt->nonce, pkt->nonceLen, pkt->tag,
+                        pkt->tagLen, pkt->aad, pkt->aadLen);
+                if (rc != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmDecrypt",
+                                          rc);
+                }
+            }
+            /* Keep going - each packet is independent. */
+            pkt->status = (rc == 0);
+            if (rc != 0) {
+                ret = 0;
+            }
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_batch", ret);
+
+    return ret;
+}
+
 static int we_aes_gcm_tls_cipher(we_AesGcm *aes, unsigned char *out,
                                  const unsigned char *in, size_t len)
 {
@@ -204,21 +667,30 @@ static int we_aes_gcm_tls_cipher(we_AesGcm *aes, unsigned char *out,
             /* Encrypt the data except explicit IV.
              * Tag goes at end of output buffer.
              */
-            rc = wc_AesGcmEncrypt(&aes->aes, out, in, encLen, aes->iv,
-                aes->ivLen, out + encLen, EVP_GCM_TLS_TAG_LEN, aes->aad,
-                aes->aadLen);
+            rc = wc_AesGcmEncrypt(WE_AES_GCM_OBJ(aes), out, in, encLen, aes->iv,
+                aes->ivLen, out + encLen, EVP_GCM_TLS_TAG_LEN, aes->tlsAad,
+                EVP_AEAD_TLS1_AAD_LEN);
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmEncrypt_ex", rc);
                 ret = -1;
             }
         }
         if (ret == 1) {
+            int i;
+
             WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "Encrypted %d bytes "
                                    "(AES-GCM):", encLen);
             WOLFENGINE_BUFFER(WE_LOG_CIPHER, out, encLen);
             WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "Generated tag:");
             WOLFENGINE_BUFFER(WE_LOG_CIPHER, out + encLen, EVP_GCM_TLS_TAG_LEN);
 
+            /* Next record uses the next explicit IV. */
+            for (i = aes->ivLen - 1; i >= EVP_GCM_TLS_FIXED_IV_LEN; i--) {
+                if ((++aes->iv[i]) != 0) {
+                    break;
+                }
+            }
+
             ret = (int)len;
         }
     }
@@ -234,12 +706,13 @@ static int we_aes_gcm_tls_cipher(we_AesGcm *aes, unsigned char *out,
             /* Decrypt the data except explicit IV.
              * Tag is at end of input buffer.
              */
-            rc = wc_AesGcmDecrypt(&aes->aes,
+            rc = wc_AesGcmDecrypt(WE_AES_GCM_OBJ(aes),
                                   out + EVP_GCM_TLS_EXPLICIT_IV_LEN,
                                   in + EVP_GCM_TLS_EXPLICIT_IV_LEN,
                                   decLen, aes->iv, aes->ivLen,
                                   in + len - EVP_GCM_TLS_TAG_LEN,
-                                  EVP_GCM_TLS_TAG_LEN, aes->aad, aes->aadLen);
+                                  EVP_GCM_TLS_TAG_LEN, aes->tlsAad,
+                                  EVP_AEAD_TLS1_AAD_LEN);
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmDecrypt", rc);
                 ret = -1;
@@ -258,16 +731,261 @@ static int we_aes_gcm_tls_cipher(we_AesGcm *aes, unsigned char *out,
         }
     }
 
-    /* Dispose of any AAD - all used now. */
-    OPENSSL_free(aes->aad);
-    aes->aad = NULL;
-    aes->aadLen = 0;
-
     WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_tls_cipher", ret);
 
     return ret;
 }
 
+#ifdef WE_HAVE_PIPELINE
+/**
+ * Encrypt/decrypt the TLS records set with the pipeline ctrl commands.
+ *
+ * Each record is processed with its own TLS AAD.
+ *
+ * @param  aes  [in,out]  wolfEngine AES-GCM state object.
+ * @return  Total length of records processed on success, -1 on failure.
+ */
+static int we_aes_gcm_tls_pipeline(we_AesGcm *aes)
+{
+    int ret = 0;
+    int rc;
+    int i;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_tls_pipeline");
+
+    if ((!we_pipeline_check(&aes->pipe)) || (aes->pipe.aadCnt == 0)) {
+        ret = -1;
+    }
+    if (ret != -1) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Pipelining %d TLS records",
+                       aes->pipe.num);
+    }
+    for (i = 0; (ret != -1) && (i < aes->pipe.num); i++) {
+        XMEMCPY(aes->tlsAad, aes->pipe.aad[i], EVP_AEAD_TLS1_AAD_LEN);
+        rc = we_aes_gcm_tls_cipher(aes, aes->pipe.out[i], aes->pipe.in[i],
+                                   aes->pipe.lens[i]);
+        if (rc == -1) {
+            ret = -1;
+        }
+        else {
+            ret += rc;
+        }
+    }
+
+    /* Records are only good for one call. */
+    we_pipeline_reset(&aes->pipe);
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_tls_pipeline", ret);
+
+    return ret;
+}
+#endif
+
+#ifdef WOLFSSL_AESGCM_STREAM
+/**
+ * Start a streaming encrypt/decrypt operation if not already started.
+ *
+ * Sets the IV into the wolfSSL object.
+ *
+ * @param  aes  [in,out]  wolfEngine AES-GCM state object.
+ *
+ * @return  0 on success, -1 on failure.
+ */
+static int we_aes_gcm_start(we_AesGcm* aes)
+{
+    int ret = 0;
+    int rc;
+
+    if (!aes->started) {
+        /* Key already set - only IV changes. */
+        rc = wc_AesGcmInit(&aes->aes, NULL, 0, aes->iv, aes->ivLen);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmInit", rc);
+            ret = -1;
+        }
+        else {
+            aes->started = 1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Add AAD. Can be called multiple times to add more AAD.
+ *
+ * AAD is authenticated as it is passed in - not stored.
+ *
+ * @param  aes  [in,out]  wolfEngine AES-GCM state object.
+ * @param  in   [in]      AAD to add.
+ * @param  len  [in]      Length of AAD.
+ *
+ * @return  Length of AAD added on success, -1 on failure.
+ */
+static int we_aes_gcm_update_aad(we_AesGcm* aes, const unsigned char* in,
+                                 size_t len)
+{
+    int ret;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_update_aad");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p, in = %p, len = %zu]",
+                           aes, in, len);
+
+    ret = we_aes_gcm_start(aes);
+    if (ret == 0) {
+        /* GHASH the AAD - no data passed in yet. */
+        if (aes->enc) {
+            rc = wc_AesGcmEncryptUpdate(&aes->aes, NULL, NULL, 0, in,
+                                        (word32)len);
+        }
+        else {
+            rc = wc_AesGcmDecryptUpdate(&aes->aes, NULL, NULL, 0, in,
+                                        (word32)len);
+        }
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmUpdate", rc);
+            ret = -1;
+        }
+        else {
+            ret = (int)len;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_update_aad", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt the data. Output is produced as data is passed in - no data
+ * is buffered.
+ *
+ * @param  aes  [in,out]  wolfEngine AES-GCM state object.
+ * @param  in   [in]      Data to encrypt/decrypt.
+ * @param  len  [in]      Length input data.
+ * @param  out  [out]     Buffer to store encryption/decryption result.
+ *
+ * @return  Length of data encrypted/decrypted on success, -1 on failure.
+ */
+static int we_aes_gcm_update(we_AesGcm* aes, const unsigned char* in,
+                             size_t len, unsigned char* out)
+{
+    int ret = 0;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_update");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p, in = %p, len = %zu, "
+                           "out = %p]", aes, in, len, out);
+
+    if (len != 0 && in == NULL) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "we_aes_gcm_update called with "
+                             "non-zero length and NULL input buffer.");
+        ret = -1;
+    }
+    if ((ret == 0) && (len != 0)) {
+        ret = we_aes_gcm_start(aes);
+    }
+    if ((ret == 0) && (len != 0)) {
+        if (aes->enc) {
+            rc = wc_AesGcmEncryptUpdate(&aes->aes, out, in, (word32)len, NULL,
+                                        0);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmEncryptUpdate",
+                                      rc);
+                ret = -1;
+            }
+        }
+        else {
+            rc = wc_AesGcmDecryptUpdate(&aes->aes, out, in, (word32)len, NULL,
+                                        0);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmDecryptUpdate",
+                                      rc);
+                ret = -1;
+            }
+        }
+        if (ret == 0) {
+            WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "%s %zu bytes (AES-GCM):",
+                                   aes->enc ? "Encrypted" : "Decrypted", len);
+            WOLFENGINE_BUFFER(WE_LOG_CIPHER, out, (unsigned int)len);
+            ret = (int)len;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_update", ret);
+
+    return ret;
+}
+
+/**
+ * Complete the encryption/decryption - calculate or check the tag. Reset the
+ * state of the aes object after and increment the IV, if applicable.
+ *
+ * @param  aes  [in,out]  wolfEngine AES-GCM state object.
+ *
+ * @return  0 on success, -1 on failure.
+ */
+static int we_aes_gcm_final(we_AesGcm* aes)
+{
+    int ret;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_final");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p]", aes);
+
+    /* No data passed in when only doing GMAC. */
+    ret = we_aes_gcm_start(aes);
+    if (ret == 0) {
+        if (aes->enc == 1) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM encrypting");
+            /* Tag always full size on calculation. */
+            aes->tagLen = EVP_GCM_TLS_TAG_LEN;
+            rc = wc_AesGcmEncryptFinal(&aes->aes, aes->tag, aes->tagLen);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmEncryptFinal",
+                                      rc);
+                ret = -1;
+            }
+            else {
+                WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "AES-GCM tag:");
+                WOLFENGINE_BUFFER(WE_LOG_CIPHER, aes->tag, aes->tagLen);
+            }
+        }
+        else if (aes->tagLen == 0) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "No tag set for decrypt");
+            ret = -1;
+        }
+        else {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM decrypting");
+            rc = wc_AesGcmDecryptFinal(&aes->aes, aes->tag, aes->tagLen);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmDecryptFinal",
+                                      rc);
+                ret = -1;
+            }
+        }
+    }
+
+    /* Next operation starts again with IV. */
+    aes->started = 0;
+
+    if (aes->ivInc) {
+        int i;
+        for (i = aes->ivLen - 1; i >= aes->ivLen - 8; i--) {
+            if ((++aes->iv[i]) != 0) {
+                break;
+            }
+        }
+        aes->ivInc = 0;
+        aes->ivSet = 0;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_gcm_final", ret);
+
+    return ret;
+}
+#else
 /**
  * Add AAD. Can be called multiple times to append more AAD.
  *
@@ -310,6 +1028,11 @@ static int we_aes_gcm_update_aad(we_AesGcm* aes, const unsigned char* in,
  * Add data to the encryption/decryption buffer. No encryption/decryption is
  * performed here. That is handled by we_aes_gcm_final.
  *
+ * Used when wolfSSL doesn't have the streaming AES-GCM API. Data of multiple
+ * calls is appended and the output is written contiguously from the output
+ * buffer of the first call. Output buffers of later calls must continue on
+ * from the previous call's as the whole result is written there on final.
+ *
  * @param  aes  [in,out]  wolfEngine AES-GCM state object.
  * @param  in   [in]      Data to add to encryption/decryption buffer.
  * @param  len  [in]      Length input data.
@@ -322,16 +1045,23 @@ static int we_aes_gcm_update(we_AesGcm* aes, const unsigned char* in,
                              size_t len, unsigned char* out)
 {
     int ret;
+    unsigned char *p;
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_update");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p, in = %p, len = %d, "
                            "out = %p]", aes, in, len, out);
 
-    if (len != 0 && in != NULL) {
-        aes->tmp = (unsigned char*)OPENSSL_malloc(len);
-        if (aes->tmp == NULL) {
-            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "OPENSSL_malloc",
-                                       aes->tmp);
+    if ((len != 0) && (in != NULL) && (aes->tmpLen != 0) &&
+            (out != aes->outputBuf + aes->tmpLen)) {
+        /* Final writes all output from the first call's buffer. */
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "we_aes_gcm_update output buffer "
+                             "doesn't follow on from previous call.");
+        ret = -1;
+    }
+    else if (len != 0 && in != NULL) {
+        p = (unsigned char*)OPENSSL_realloc(aes->tmp, aes->tmpLen + len);
+        if (p == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "OPENSSL_realloc", p);
             ret = -1;
         }
         else {
@@ -340,9 +1070,12 @@ static int we_aes_gcm_update(we_AesGcm* aes, const unsigned char* in,
              * just save the input data and the address of the output buffer
              * here.
              */
-            XMEMCPY(aes->tmp, in, len);
-            aes->tmpLen = (int)len;
-            aes->outputBuf = out;
+            aes->tmp = p;
+            XMEMCPY(aes->tmp + aes->tmpLen, in, len);
+            if (aes->tmpLen == 0) {
+                aes->outputBuf = out;
+            }
+            aes->tmpLen += (int)len;
             /* Return length of buffered input data. */
             ret = (int)len;
         }
@@ -377,6 +1110,8 @@ static int we_aes_gcm_final(we_AesGcm* aes)
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_final");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p]", aes);
 
+#ifndef WE_AES_GCM_LEAN
+    /* Shared wolfSSL object is never changed - IV passed in on encrypt. */
     if (!aes->ivSet) {
         /* Set extern IV. */
         WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting external IV");
@@ -389,16 +1124,24 @@ static int we_aes_gcm_final(we_AesGcm* aes)
             aes->ivSet = 1;
         }
     }
+#endif
 
     if (ret == 0) {
         if (aes->enc == 1) {
             WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM encrypting");
             /* Tag always full size on calculation. */
             aes->tagLen = EVP_GCM_TLS_TAG_LEN;
+        #ifdef WE_AES_GCM_LEAN
+            ret = wc_AesGcmEncrypt(WE_AES_GCM_OBJ(aes), aes->outputBuf,
+                                   aes->tmp, aes->tmpLen, aes->iv, aes->ivLen,
+                                   aes->tag, aes->tagLen, aes->aad,
+                                   aes->aadLen);
+        #else
             ret = wc_AesGcmEncrypt_ex(&aes->aes, aes->outputBuf, aes->tmp,
                                       aes->tmpLen, aes->iv, aes->ivLen,
                                       aes->tag, aes->tagLen, aes->aad,
                                       aes->aadLen);
+        #endif
             if (ret != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmEncrypt_ex",
                                       ret);
@@ -414,9 +1157,10 @@ static int we_aes_gcm_final(we_AesGcm* aes)
         }
         else {
             WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-GCM decrypting");
-            ret = wc_AesGcmDecrypt(&aes->aes, aes->outputBuf, aes->tmp,
-                                   aes->tmpLen, aes->iv, aes->ivLen, aes->tag,
-                                   aes->tagLen, aes->aad, aes->aadLen);
+            ret = wc_AesGcmDecrypt(WE_AES_GCM_OBJ(aes), aes->outputBuf,
+                                   aes->tmp, aes->tmpLen, aes->iv, aes->ivLen,
+                                   aes->tag, aes->tagLen, aes->aad,
+                                   aes->aadLen);
             if (ret != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesGcmDecrypt", ret);
                 ret = -1;
@@ -457,9 +1201,11 @@ static int we_aes_gcm_final(we_AesGcm* aes)
     return ret;
 }
 
+#endif /* WOLFSSL_AESGCM_STREAM */
+
 /**
  * Encrypt/decrypt the data.
- * One-shot encrypt/decrypt - not streaming.
+ * Streaming when wolfSSL has the streaming AES-GCM API, otherwise one-shot.
  *
  * @param  ctx  [in,out]  EVP cipher context of operation.
  * @param  out  [out]     Buffer to store enciphered result.<br>
@@ -490,8 +1236,18 @@ static int we_aes_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
     }
 
     if (ret == 1) {
+    #ifdef WE_HAVE_PIPELINE
+        if ((aes->tls == 1) && (aes->pipe.num > 0)) {
+            ret = we_aes_gcm_tls_pipeline(aes);
+        }
+        else
+    #endif
         if (aes->tls == 1) {
             ret = we_aes_gcm_tls_cipher(aes, out, in, len);
+        #ifdef WE_HAVE_PIPELINE
+            /* TLS AAD used - clear pipeline for next call. */
+            we_pipeline_reset(&aes->pipe);
+        #endif
         }
         else if (out == NULL && len != 0 && in != NULL) {
             ret = we_aes_gcm_update_aad(aes, in, len);
@@ -512,6 +1268,7 @@ static int we_aes_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
 /**
  * Extra operations for AES-GCM.
  * Supported operations include:
+ *  - EVP_CTRL_COPY: give copy of context its own buffered data
  *  - EVP_CTRL_GET_IV (version 3.0+): get IV from wolfengine object
  *  - EVP_CTRL_AEAD_SET_IVLEN: set the length of an IV/nonce
  *  - EVP_CTRL_GCM_SET_IV_FIXED: set the fixed part of an IV/nonce
@@ -520,6 +1277,8 @@ static int we_aes_gcm_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
  *  - EVP_CTRL_AEAD_GET_TAG: get the tag value after encrypt
  *  - EVP_CTRL_AEAD_SET_TAG: set the tag value before decrypt
  *  - EVP_CTRL_AEAD_TLS1_AAD: set AAD for TLS
+ *  - EVP_CTRL_SET_PIPELINE_*: set TLS records to process in one call
+ *  - WOLFENGINE_CTRL_AEAD_BATCH: seal or open many packets in one call
  *
  * @param  ctx   [in.out]  EVP cipher context of operation.
  * @param  type  [in]      Type of operation to perform.
@@ -532,6 +1291,7 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
     int ret = 1;
     int rc;
     we_AesGcm *aes;
+    we_RngShard *shard;
     char errBuff[WOLFENGINE_MAX_LOG_WIDTH];
 
     WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_gcm_ctrl");
@@ -555,16 +1315,31 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                 aes->ivInc = 0;
                 /* No tag set. */
                 aes->tagLen = 0;
-                /* Start with no AAD. */
-                aes->aad = NULL;
-                aes->aadLen = 0;
                 /* Internal AES-GCM object initialized. */
                 aes->init = 1;
                 /* Not doing GCM for TLS unless ctrl function called. */
                 aes->tls = 0;
+            #ifdef WOLFSSL_AESGCM_STREAM
+                aes->started = 0;
+            #else
+                /* Start with no AAD. */
+                aes->aad = NULL;
+                aes->aadLen = 0;
                 aes->tmp = NULL;
                 aes->tmpLen = 0;
                 aes->outputBuf = NULL;
+            #endif
+            #ifdef WE_HAVE_PIPELINE
+                we_pipeline_reset(&aes->pipe);
+            #endif
+                break;
+
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Give copy its own buffered data
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                ret = we_aes_gcm_copy(aes, (EVP_CIPHER_CTX *)ptr);
                 break;
 
             case EVP_CTRL_AEAD_SET_IVLEN:
@@ -605,20 +1380,34 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                                    "generate the rest");
                     if (aes->ivLen == 0)
                         aes->ivLen = GCM_NONCE_MID_SZ;
+                    /* Shard of global random for this thread. */
+                    shard = we_rng_shard();
                 #ifndef WE_SINGLE_THREADED
-                    rc = wc_LockMutex(we_rng_mutex);
+                    rc = we_rng_shard_lock(shard);
                     if (rc != 0) {
                         WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
-                                              "wc_LockMutex", rc);
+                                              "we_rng_shard_lock", rc);
                         ret = 0;
                     }
                     if (ret == 1)
                 #endif
                     {
+                    #ifdef WE_AES_GCM_LEAN
+                        /* Shared wolfSSL object never holds an IV. */
+                        if ((arg < 0) || (arg >= aes->ivLen)) {
+                            rc = BAD_FUNC_ARG;
+                        }
+                        else {
+                            XMEMCPY(aes->iv, ptr, arg);
+                            rc = wc_RNG_GenerateBlock(&shard->rng,
+                                    aes->iv + arg, aes->ivLen - arg);
+                        }
+                    #else
                         rc = wc_AesGcmSetIV(&aes->aes, aes->ivLen,
-                                (const byte*)ptr, arg, we_rng);
+                                (const byte*)ptr, arg, &shard->rng);
+                    #endif
                 #ifndef WE_SINGLE_THREADED
-                        wc_UnLockMutex(we_rng_mutex);
+                        wc_UnLockMutex(&shard->mutex);
                 #endif
                         if (rc != 0) {
                             WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
@@ -628,7 +1417,9 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                     }
                     if (ret == 1) {
                        aes->ivSet = 1;
+                    #ifndef WE_AES_GCM_LEAN
                        XMEMCPY(aes->iv, aes->aes.reg, aes->ivLen);
+                    #endif
                        XMEMCPY(EVP_CIPHER_CTX_iv_noconst(ctx), aes->iv,
                                aes->ivLen);
                     }
@@ -711,25 +1502,13 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                     unsigned int len;
 
                     /* Set modified AAD based on record header */
-                    if (aes->aad != NULL) {
-                        OPENSSL_free(aes->aad);
-                    }
-                    aes->aad = (unsigned char*)OPENSSL_malloc(arg);
-                    if (aes->aad == NULL) {
-                        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
-                                                   "OPENSSL_malloc", aes->aad);
+                    XMEMCPY(aes->tlsAad, ptr, arg);
+                    len = (aes->tlsAad[arg - 2] << 8) | aes->tlsAad[arg - 1];
+                    if (len < EVP_GCM_TLS_EXPLICIT_IV_LEN) {
+                        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER,
+                            "Length in AAD invalid");
                         ret = 0;
                     }
-                    if (ret == 1) {
-                        XMEMCPY(aes->aad, ptr, arg);
-                        aes->aadLen = arg;
-                        len = (aes->aad[arg - 2] << 8) | aes->aad[arg - 1];
-                        if (len < EVP_GCM_TLS_EXPLICIT_IV_LEN) {
-                            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER,
-                                "Length in AAD invalid");
-                            ret = 0;
-                        }
-                    }
                     if (ret == 1) {
                         len -= EVP_GCM_TLS_EXPLICIT_IV_LEN;
                         if (!aes->enc) {
@@ -744,14 +1523,42 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
                         }
                     }
                     if (ret == 1) {
-                        aes->aad[arg - 2] = len >> 8;
-                        aes->aad[arg - 1] = len;
+                        aes->tlsAad[arg - 2] = len >> 8;
+                        aes->tlsAad[arg - 1] = len;
+                    #ifdef WE_HAVE_PIPELINE
+                        /* Keep AAD of each record in case of pipelining. */
+                        ret = we_pipeline_add_aad(&aes->pipe, aes->tlsAad);
+                    }
+                    if (ret == 1) {
+                    #endif
                         aes->tls = 1;
                         ret = EVP_GCM_TLS_TAG_LEN;
                     }
                 }
                 break;
 
+        #ifdef WE_HAVE_PIPELINE
+            case EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS:
+            case EVP_CTRL_SET_PIPELINE_INPUT_BUFS:
+            case EVP_CTRL_SET_PIPELINE_INPUT_LENS:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_SET_PIPELINE_*");
+                /* Set TLS records to process in next cipher call
+                 *   arg [in] number of records
+                 *   ptr [in] array of buffers or lengths
+                 */
+                ret = we_pipeline_ctrl(&aes->pipe, type, arg, ptr);
+                break;
+        #endif
+
+            case WOLFENGINE_CTRL_AEAD_BATCH:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "WOLFENGINE_CTRL_AEAD_BATCH");
+                /* Seal or open independent packets with key of context
+                 *   arg [in]      number of packets
+                 *   ptr [in,out]  array of packets
+                 */
+                ret = we_aes_gcm_batch(aes, arg, (wolfEngine_AeadPacket *)ptr);
+                break;
+
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -775,6 +1582,8 @@ static int we_aes_gcm_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
      EVP_CIPH_CTRL_INIT          | \
      EVP_CIPH_FLAG_AEAD_CIPHER   | \
      EVP_CIPH_FLAG_DEFAULT_ASN1  | \
+     EVP_CIPH_CUSTOM_COPY        | \
+     WE_CIPH_FLAG_PIPELINE       | \
      EVP_CIPH_GCM_MODE)
 
 /** AES128-GCM EVP cipher method. */
@@ -896,5 +1705,30 @@ int we_init_aesgcm_meths()
     return ret;
 }
 
+/**
+ * Put the AES-GCM context statistics into the stats object.
+ *
+ * With lean contexts, the key schedules shared between contexts are counted
+ * separately.
+ *
+ * @param  stats  [out]  Statistics object.
+ */
+void we_aes_gcm_get_stats(wolfEngine_Stats *stats)
+{
+    stats->aesGcmCtxBytes = sizeof(we_AesGcm);
+#ifdef WE_AES_GCM_LEAN
+#ifndef WE_SINGLE_THREADED
+    if (pthread_mutex_lock(&we_aesGcmSharedMutex) == 0)
+#endif
+    {
+        stats->sharedKeys = we_aesGcmSharedCnt;
+        stats->sharedKeyBytes = we_aesGcmSharedCnt * sizeof(we_AesGcmShared);
+    #ifndef WE_SINGLE_THREADED
+        pthread_mutex_unlock(&we_aesGcmSharedMutex);
+    #endif
+    }
+#endif
+}
+
 #endif /* WE_HAVE_AESGCM */
 
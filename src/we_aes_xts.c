@@ -0,0 +1,482 @@
+/* we_aes_xts.c
+ *
+ * Copyright (C) 2006-2019 wolfSSL Inc.
+ *
+ * This file is part of wolfengine.
+ *
+ * wolfengine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfengine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfengine/we_internal.h>
+
+#ifdef WE_HAVE_AESXTS
+
+/** Maximum number of blocks in a data unit - IEEE Std 1619-2007. */
+#define WE_XTS_MAX_BLOCKS       (1 << 20)
+
+/*
+ * AES-XTS
+ */
+
+/**
+ * Data required to complete an AES-XTS encrypt/decrypt operation.
+ */
+typedef struct we_AesXts
+{
+    /** The wolfSSL AES-XTS data object - data and tweak keys. */
+    XtsAes         xts;
+    /** Size of sectors covered by one call. 0 when call is one data unit. */
+    size_t         sectorSz;
+    /** Flag to indicate whether key set into wolfSSL object. */
+    unsigned int   keySet:1;
+    /** Flag to indicate whether we are doing encrypt (1) or decrpyt (0). */
+    unsigned int   enc:1;
+} we_AesXts;
+
+
+/**
+ * Initialize the AES-XTS encrypt/decrypt operation using wolfSSL.
+ *
+ * @param  ctx  [in,out]  EVP cipher context of operation.
+ * @param  key  [in]      Data key followed by tweak key - 32/64 bytes.
+ * @param  iv   [in]      Tweak of first sector - 16 bytes.
+ * @param  enc  [in]      1 when initializing for encrypt and 0 when decrypt.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_xts_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
+                           const unsigned char *iv, int enc)
+{
+    int ret = 1;
+    int rc;
+    int keyLen;
+    we_AesXts *xts;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_xts_init");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, iv = %p, "
+                           "enc = %d]", ctx, key, iv, enc);
+
+    xts = (we_AesXts *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (xts == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", xts);
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        xts->enc = enc;
+    }
+
+    if ((ret == 1) && (key != NULL)) {
+        keyLen = EVP_CIPHER_CTX_key_length(ctx);
+        /* Data and tweak keys must differ - IEEE Std 1619-2007. */
+        if (enc && (CRYPTO_memcmp(key, key + keyLen / 2, keyLen / 2) == 0)) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "XTS data and tweak keys "
+                                 "are the same");
+            ret = 0;
+        }
+        if ((ret == 1) && xts->keySet) {
+            wc_AesXtsFree(&xts->xts);
+            xts->keySet = 0;
+        }
+        if (ret == 1) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "Setting AES-XTS key (%d bytes)",
+                           keyLen);
+            rc = wc_AesXtsSetKey(&xts->xts, key, (word32)keyLen,
+                                 enc ? AES_ENCRYPTION : AES_DECRYPTION, NULL,
+                                 INVALID_DEVID);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesXtsSetKey", rc);
+                ret = 0;
+            }
+            xts->keySet = (ret == 1);
+        }
+    }
+    if ((ret == 1) && (iv != NULL)) {
+        /* Tweak used with each call - see cipher. */
+        XMEMCPY(EVP_CIPHER_CTX_iv_noconst(ctx), iv, AES_BLOCK_SIZE);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_xts_init", ret);
+
+    return ret;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/**
+ * Cleanup the internal AES-XTS object. Does not free object.
+ *
+ * @param  ctx  [in]  EVP cipher context.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_aes_xts_cleanup(EVP_CIPHER_CTX *ctx)
+{
+    int ret = 1;
+    we_AesXts *xts;
+
+    xts = (we_AesXts *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (xts == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", xts);
+        ret = 0;
+    }
+
+    if ((ret == 1) && xts->keySet) {
+        wc_AesXtsFree(&xts->xts);
+        xts->keySet = 0;
+    }
+
+    return ret;
+}
+#endif
+
+/**
+ * Give the copy of an AES-XTS context its own copies of wolfSSL allocated data.
+ *
+ * OpenSSL has already copied the cipher data byte-wise - data and tweak key
+ * schedules need nothing more.
+ *
+ * @param  dstCtx  [in]  EVP cipher context copied into.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_xts_copy(EVP_CIPHER_CTX *dstCtx)
+{
+    int ret = 1;
+    we_AesXts *dst;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_xts_copy");
+
+    dst = (we_AesXts *)EVP_CIPHER_CTX_get_cipher_data(dstCtx);
+    if (dst == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", dst);
+        ret = 0;
+    }
+    if ((ret == 1) && dst->keySet) {
+        /* Both objects are freed with the copy - fix up each. */
+        ret = we_aes_copy_fixup(&dst->xts.aes);
+        if (we_aes_copy_fixup(&dst->xts.tweak) != 1) {
+            ret = 0;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_xts_copy", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt one data unit with wolfSSL.
+ *
+ * @param  xts    [in]  Internal AES-XTS object.
+ * @param  out    [out] Buffer to store enciphered result.
+ * @param  in     [in]  Data to encrypt/decrypt.
+ * @param  len    [in]  Length of data in bytes.
+ * @param  tweak  [in]  Tweak of data unit - 16 bytes.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_xts_unit(we_AesXts *xts, unsigned char *out,
+                           const unsigned char *in, size_t len,
+                           const unsigned char *tweak)
+{
+    int ret = 1;
+    int rc;
+
+    if (xts->enc) {
+        rc = wc_AesXtsEncrypt(&xts->xts, out, in, (word32)len, tweak,
+                              AES_BLOCK_SIZE);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesXtsEncrypt", rc);
+            ret = 0;
+        }
+    }
+    else {
+        rc = wc_AesXtsDecrypt(&xts->xts, out, in, (word32)len, tweak,
+                              AES_BLOCK_SIZE);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_AesXtsDecrypt", rc);
+            ret = 0;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt the data using wolfSSL.
+ *
+ * Each call is a data unit using the IV as the tweak. When a sector size is
+ * set, the call covers consecutive sectors and the tweak is incremented, as a
+ * little-endian number, for each sector after the first.
+ *
+ * @param  ctx  [in,out]  EVP cipher context of operation.
+ * @param  out  [out]     Buffer to store enciphered result.
+ * @param  in   [in]      Data to encrypt/decrypt.
+ * @param  len  [in]      Length of data to encrypt/decrypt.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_xts_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                             const unsigned char *in, size_t len)
+{
+    int ret = 1;
+    we_AesXts *xts;
+    size_t unitSz;
+    size_t sz;
+    int i;
+    unsigned char tweak[AES_BLOCK_SIZE];
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_xts_cipher");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, out = %p, in = %p, "
+                           "len = %zu]", ctx, out, in, len);
+
+    xts = (we_AesXts *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (xts == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", xts);
+        ret = 0;
+    }
+    else if ((!xts->keySet) || (out == NULL) || (in == NULL)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "AES-XTS not ready for data");
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        unitSz = (xts->sectorSz != 0) ? xts->sectorSz : len;
+        /* Each data unit, including a trailing partial sector, must be at
+         * least a block and no more than the maximum allowed. */
+        if ((len < AES_BLOCK_SIZE) ||
+                ((unitSz != len) && (len % unitSz != 0) &&
+                 (len % unitSz < AES_BLOCK_SIZE)) ||
+                (unitSz > (size_t)WE_XTS_MAX_BLOCKS * AES_BLOCK_SIZE)) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid AES-XTS data length");
+            ret = 0;
+        }
+    }
+    if (ret == 1) {
+        XMEMCPY(tweak, EVP_CIPHER_CTX_iv_noconst(ctx), AES_BLOCK_SIZE);
+        if (unitSz != len) {
+            WOLFENGINE_MSG(WE_LOG_CIPHER, "AES-XTS %zu bytes of %zu byte "
+                           "sectors", len, unitSz);
+        }
+    }
+    while ((ret == 1) && (len > 0)) {
+        sz = (len < unitSz) ? len : unitSz;
+        ret = we_aes_xts_unit(xts, out, in, sz, tweak);
+        in += sz;
+        out += sz;
+        len -= sz;
+
+        /* Next sector number. */
+        for (i = 0; (len > 0) && (i < AES_BLOCK_SIZE); i++) {
+            if ((++tweak[i]) != 0) {
+                break;
+            }
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_xts_cipher", ret);
+
+    return ret;
+}
+
+/**
+ * Extra operations for AES-XTS.
+ * Supported operations include:
+ *  - EVP_CTRL_INIT: initialize the internal object
+ *  - EVP_CTRL_COPY: give copy of context its own wolfSSL allocated data
+ *  - WOLFENGINE_CTRL_XTS_SECTOR_SIZE: set the size of the sectors covered by
+ *    one call
+ *
+ * @param  ctx   [in]  EVP cipher context of operation.
+ * @param  type  [in]  Type of operation to perform.
+ * @param  arg   [in]  Integer argument.
+ * @param  ptr   [in]  Pointer argument.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_aes_xts_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
+{
+    int ret = 1;
+    we_AesXts *xts;
+    char errBuff[WOLFENGINE_MAX_LOG_WIDTH];
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_xts_ctrl");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, type = %d, "
+                           "arg = %d, ptr = %p]", ctx, type, arg, ptr);
+
+    (void)ptr;
+
+    xts = (we_AesXts *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (xts == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", xts);
+        ret = 0;
+    }
+    if (ret == 1) {
+        switch (type) {
+            case EVP_CTRL_INIT:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_INIT");
+                /* No key yet and each call is one data unit. */
+                xts->keySet = 0;
+                xts->sectorSz = 0;
+                break;
+
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Copy holds keys already - fix up wolfSSL allocated data
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                ret = we_aes_xts_copy((EVP_CIPHER_CTX *)ptr);
+                break;
+
+            case WOLFENGINE_CTRL_XTS_SECTOR_SIZE:
+                WOLFENGINE_MSG(WE_LOG_CIPHER,
+                               "WOLFENGINE_CTRL_XTS_SECTOR_SIZE");
+                /* Set the sector size
+                 *   arg [in] size of sector in bytes - 0 for whole call
+                 *   ptr [in] Unused
+                 */
+                if ((arg != 0) && ((arg < AES_BLOCK_SIZE) ||
+                        (arg > WE_XTS_MAX_BLOCKS * AES_BLOCK_SIZE))) {
+                    XSNPRINTF(errBuff, sizeof(errBuff), "Invalid sector size "
+                              "%d", arg);
+                    WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, errBuff);
+                    ret = 0;
+                }
+                else {
+                    xts->sectorSz = (size_t)arg;
+                }
+                break;
+
+            default:
+                XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
+                          type);
+                WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, errBuff);
+                ret = 0;
+                break;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_xts_ctrl", ret);
+
+    return ret;
+}
+
+/** Flags for AES-XTS method. */
+#define AES_XTS_FLAGS              \
+    (EVP_CIPH_CUSTOM_IV          | \
+     EVP_CIPH_ALWAYS_CALL_INIT   | \
+     EVP_CIPH_CTRL_INIT          | \
+     EVP_CIPH_FLAG_DEFAULT_ASN1  | \
+     EVP_CIPH_CUSTOM_COPY        | \
+     EVP_CIPH_XTS_MODE)
+
+/** AES128-XTS EVP cipher method. */
+EVP_CIPHER* we_aes128_xts_ciph = NULL;
+/** AES256-XTS EVP cipher method. */
+EVP_CIPHER* we_aes256_xts_ciph = NULL;
+
+
+/**
+ * Initialize an AES-XTS method.
+ *
+ * @return  1 on success and 0 on failure.
+ */
+static int we_init_aesxts_meth(EVP_CIPHER *cipher)
+{
+    int ret;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_init_aesxts_meth");
+
+    ret = EVP_CIPHER_meth_set_iv_length(cipher, AES_BLOCK_SIZE);
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_flags(cipher, AES_XTS_FLAGS);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_init(cipher, we_aes_xts_init);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_cleanup(cipher, we_aes_xts_cleanup);
+    }
+#endif
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_do_cipher(cipher, we_aes_xts_cipher);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_ctrl(cipher, we_aes_xts_ctrl);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_impl_ctx_size(cipher, sizeof(we_AesXts));
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_init_aesxts_meth", ret);
+
+    return ret;
+}
+
+/**
+ * Initialize the AES-XTS methods.
+ *
+ * @return  1 on success and 0 on failure.
+ */
+int we_init_aesxts_meths()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_init_aesxts_meths");
+
+    /* AES128-XTS - two 128-bit keys. */
+    we_aes128_xts_ciph = EVP_CIPHER_meth_new(NID_aes_128_xts, 1,
+                                             2 * AES_128_KEY_SIZE);
+    if (we_aes128_xts_ciph == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_meth_new - AES-128-XTS",
+                                   we_aes128_xts_ciph);
+        ret = 0;
+    }
+    if (ret == 1) {
+        ret = we_init_aesxts_meth(we_aes128_xts_ciph);
+    }
+
+    /* AES256-XTS - two 256-bit keys. */
+    if (ret == 1) {
+        we_aes256_xts_ciph = EVP_CIPHER_meth_new(NID_aes_256_xts, 1,
+                                                 2 * AES_256_KEY_SIZE);
+        if (we_aes256_xts_ciph == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                       "EVP_CIPHER_meth_new - AES-256-XTS",
+                                       we_aes256_xts_ciph);
+            ret = 0;
+        }
+    }
+    if (ret == 1) {
+        ret = we_init_aesxts_meth(we_aes256_xts_ciph);
+    }
+
+    /* Cleanup */
+    if ((ret == 0) && (we_aes128_xts_ciph != NULL)) {
+        EVP_CIPHER_meth_free(we_aes128_xts_ciph);
+        we_aes128_xts_ciph = NULL;
+    }
+    if ((ret == 0) && (we_aes256_xts_ciph != NULL)) {
+        EVP_CIPHER_meth_free(we_aes256_xts_ciph);
+        we_aes256_xts_ciph = NULL;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_init_aesxts_meths", ret);
+
+    return ret;
+}
+
+#endif /* WE_HAVE_AESXTS */
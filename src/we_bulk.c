@@ -0,0 +1,640 @@
+/* we_bulk.c
+ *
+ * Copyright (C) 2019-2021 wolfSSL Inc.
+ *
+ * This file is part of wolfengine.
+ *
+ * wolfengine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfengine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfengine/we_internal.h>
+
+#ifdef WE_HAVE_BULK_THREADS
+
+#include <pthread.h>
+
+/*
+ * Bulk worker pool
+ *
+ * Opt-in pool of engine-owned threads that very large buffers of
+ * block-parallel cipher modes, and large batches of digests, are split
+ * across. The calling thread works on a part too and returns once all parts
+ * are done.
+ */
+
+/* Default minimum length of data, in bytes, to split across the pool. */
+#ifndef WE_BULK_DEFAULT_THRESHOLD
+#define WE_BULK_DEFAULT_THRESHOLD   (1024 * 1024)
+#endif
+/* Smallest part of a buffer, in bytes, worth handing to a thread. */
+#ifndef WE_BULK_MIN_PART_SZ
+#define WE_BULK_MIN_PART_SZ         (64 * 1024)
+#endif
+
+/**
+ * Batch of jobs from one call. Lives on the caller's stack until all its jobs
+ * are done.
+ */
+typedef struct we_BulkBatch {
+    /** Function performing each job. */
+    we_BulkFunc func;
+    /** Array of jobs. */
+    unsigned char *jobs;
+    /** Size of a job in bytes. */
+    size_t jobSz;
+    /** Number of jobs. */
+    int cnt;
+    /** Number of jobs claimed by threads. */
+    int claimed;
+    /** Number of jobs completed. */
+    int done;
+    /** 1 when all jobs succeeded and 0 otherwise. */
+    int ret;
+    /** Next batch in queue. */
+    struct we_BulkBatch *next;
+} we_BulkBatch;
+
+/* Number of worker threads in the bulk pool. 0 when not splitting. */
+volatile int we_bulkWorkers = 0;
+/* Minimum length of data, in bytes, to split across the bulk pool. */
+volatile size_t we_bulkThreshold = WE_BULK_DEFAULT_THRESHOLD;
+
+/* Worker threads of the bulk pool. */
+static pthread_t we_bulkThreads[WE_BULK_MAX_THREADS];
+/* Number of worker threads created and not joined. */
+static int we_bulkRunning = 0;
+/* Serializes starting and stopping the workers. */
+static pthread_mutex_t we_bulkCtrlMutex = PTHREAD_MUTEX_INITIALIZER;
+/* Mutex protecting the queue of batches and the workers' state. */
+static pthread_mutex_t we_bulkMutex = PTHREAD_MUTEX_INITIALIZER;
+/* Signals workers that jobs are queued or that they are to stop. */
+static pthread_cond_t we_bulkWorkCond = PTHREAD_COND_INITIALIZER;
+/* Signals callers that a batch has completed. */
+static pthread_cond_t we_bulkDoneCond = PTHREAD_COND_INITIALIZER;
+/* Batches with unclaimed jobs, oldest first. */
+static we_BulkBatch *we_bulkQueue = NULL;
+/* Workers are to exit. */
+static int we_bulkStop = 0;
+/* Workers of the parent are to be started again, in a forked child, on the
+ * next split call. */
+static volatile int we_bulkRestart = 0;
+/* Number of calls split across the bulk pool. */
+static unsigned long we_bulkSplits = 0;
+
+/**
+ * Claim the next job of a batch. The batch is taken off the queue when all its
+ * jobs are claimed.
+ *
+ * Caller must hold the bulk pool's lock and the batch must have an unclaimed
+ * job.
+ *
+ * @param  batch  [in,out]  Batch of jobs.
+ * @returns  Job claimed.
+ */
+static void *we_bulk_claim(we_BulkBatch *batch)
+{
+    we_BulkBatch **p;
+    void *job = batch->jobs + batch->claimed * batch->jobSz;
+
+    if (++batch->claimed == batch->cnt) {
+        for (p = &we_bulkQueue; *p != NULL; p = &(*p)->next) {
+            if (*p == batch) {
+                *p = batch->next;
+                break;
+            }
+        }
+    }
+
+    return job;
+}
+
+/**
+ * Perform a claimed job and record its completion.
+ *
+ * Caller must hold the bulk pool's lock. The lock is released while the job is
+ * performed. The batch must not be used after this call as its owner may have
+ * returned.
+ *
+ * @param  batch  [in,out]  Batch the job belongs to.
+ * @param  job    [in,out]  Job to perform.
+ */
+static void we_bulk_do_job(we_BulkBatch *batch, void *job)
+{
+    int ok;
+
+    pthread_mutex_unlock(&we_bulkMutex);
+    ok = batch->func(job);
+    pthread_mutex_lock(&we_bulkMutex);
+
+    if (!ok) {
+        batch->ret = 0;
+    }
+    if (++batch->done == batch->cnt) {
+        pthread_cond_broadcast(&we_bulkDoneCond);
+    }
+}
+
+/**
+ * Bulk worker thread.
+ *
+ * Performs queued jobs until told to stop.
+ *
+ * @param  arg  [in]  Unused.
+ * @returns  NULL.
+ */
+static void *we_bulk_thread_main(void *arg)
+{
+    we_BulkBatch *batch;
+
+    (void)arg;
+
+    pthread_mutex_lock(&we_bulkMutex);
+    while (!we_bulkStop) {
+        batch = we_bulkQueue;
+        if (batch == NULL) {
+            pthread_cond_wait(&we_bulkWorkCond, &we_bulkMutex);
+        }
+        else {
+            we_bulk_do_job(batch, we_bulk_claim(batch));
+        }
+    }
+    pthread_mutex_unlock(&we_bulkMutex);
+
+    return NULL;
+}
+
+/**
+ * Create worker threads for the bulk pool.
+ *
+ * Caller must hold the bulk pool's control lock and no workers are running.
+ *
+ * @param  cnt  [in]  Number of worker threads.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_bulk_threads_create(int cnt)
+{
+    int ret = 1;
+    int rc;
+
+    we_bulkStop = 0;
+    while ((ret == 1) && (we_bulkRunning < cnt)) {
+        rc = pthread_create(&we_bulkThreads[we_bulkRunning], NULL,
+                            we_bulk_thread_main, NULL);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "pthread_create", rc);
+            ret = 0;
+        }
+        else {
+            we_bulkRunning++;
+        }
+    }
+    if (ret == 1) {
+        we_bulkWorkers = cnt;
+    }
+
+    return ret;
+}
+
+/**
+ * Stop the worker threads of the bulk pool and wait for them to exit.
+ *
+ * Calls in progress complete their jobs on the calling thread.
+ *
+ * Caller must hold the bulk pool's control lock.
+ */
+static void we_bulk_threads_stop(void)
+{
+    int i;
+
+    /* New calls are no longer split. */
+    we_bulkWorkers = 0;
+    we_bulkRestart = 0;
+
+    pthread_mutex_lock(&we_bulkMutex);
+    we_bulkStop = 1;
+    pthread_cond_broadcast(&we_bulkWorkCond);
+    pthread_mutex_unlock(&we_bulkMutex);
+
+    for (i = 0; i < we_bulkRunning; i++) {
+        pthread_join(we_bulkThreads[i], NULL);
+    }
+    we_bulkRunning = 0;
+}
+
+/**
+ * Start the workers again in a forked child.
+ *
+ * Threads can't safely be created in the fork handler so it is done on the
+ * first split call after the fork.
+ */
+static void we_bulk_restart(void)
+{
+    pthread_mutex_lock(&we_bulkCtrlMutex);
+    /* Check again now that no other thread can be restarting. */
+    if (we_bulkRestart) {
+        we_bulkRestart = 0;
+        if (we_bulk_threads_create(we_bulkWorkers) == 0) {
+            we_bulk_threads_stop();
+        }
+    }
+    pthread_mutex_unlock(&we_bulkCtrlMutex);
+}
+
+/**
+ * Perform a batch of jobs with the bulk pool and wait for them to complete.
+ *
+ * The calling thread performs jobs too so the batch completes even when the
+ * workers are busy or being stopped.
+ *
+ * @param  func   [in]      Function performing each job.
+ * @param  jobs   [in,out]  Array of jobs.
+ * @param  jobSz  [in]      Size of a job in bytes.
+ * @param  cnt    [in]      Number of jobs.
+ * @returns  1 when all jobs succeeded and 0 otherwise.
+ */
+int we_bulk_run(we_BulkFunc func, void *jobs, size_t jobSz, int cnt)
+{
+    we_BulkBatch batch;
+    we_BulkBatch **p;
+
+    batch.func = func;
+    batch.jobs = (unsigned char *)jobs;
+    batch.jobSz = jobSz;
+    batch.cnt = cnt;
+    batch.claimed = 0;
+    batch.done = 0;
+    batch.ret = 1;
+    batch.next = NULL;
+
+    if (we_bulkRestart) {
+        we_bulk_restart();
+    }
+
+    pthread_mutex_lock(&we_bulkMutex);
+    for (p = &we_bulkQueue; *p != NULL; p = &(*p)->next) {
+    }
+    *p = &batch;
+    we_bulkSplits++;
+    pthread_cond_broadcast(&we_bulkWorkCond);
+
+    while (batch.claimed < batch.cnt) {
+        we_bulk_do_job(&batch, we_bulk_claim(&batch));
+    }
+    while (batch.done < batch.cnt) {
+        pthread_cond_wait(&we_bulkDoneCond, &we_bulkMutex);
+    }
+    pthread_mutex_unlock(&we_bulkMutex);
+
+    return batch.ret;
+}
+
+/**
+ * Start, stop or resize the bulk pool.
+ *
+ * @param  cnt  [in]  Number of worker threads. 0 stops the workers and no
+ *                    buffers are split.
+ * @returns  1 on success and 0 on failure.
+ */
+int we_bulk_set_threads(long cnt)
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_bulk_set_threads");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_ENGINE, "ARGS [cnt = %ld]", cnt);
+
+    if ((cnt < 0) || (cnt > WE_BULK_MAX_THREADS)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Bulk thread count out of range");
+        ret = 0;
+    }
+    if (ret == 1) {
+        pthread_mutex_lock(&we_bulkCtrlMutex);
+        we_bulk_threads_stop();
+        if (cnt > 0) {
+            ret = we_bulk_threads_create((int)cnt);
+            if (ret == 0) {
+                we_bulk_threads_stop();
+            }
+        }
+        pthread_mutex_unlock(&we_bulkCtrlMutex);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_bulk_set_threads", ret);
+
+    return ret;
+}
+
+/**
+ * Set the minimum length of data to split across the bulk pool.
+ *
+ * Buffers are only split into parts of at least WE_BULK_MIN_PART_SZ bytes.
+ *
+ * @param  threshold  [in]  Minimum length in bytes. 0 restores the default.
+ * @returns  1 on success and 0 on failure.
+ */
+int we_bulk_set_threshold(long threshold)
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_bulk_set_threshold");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_ENGINE, "ARGS [threshold = %ld]",
+                           threshold);
+
+    if (threshold < 0) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Bulk threshold is negative");
+        ret = 0;
+    }
+    else if (threshold == 0) {
+        we_bulkThreshold = WE_BULK_DEFAULT_THRESHOLD;
+    }
+    else {
+        we_bulkThreshold = (size_t)threshold;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_bulk_set_threshold", ret);
+
+    return ret;
+}
+
+/**
+ * Put the bulk pool's statistics into the stats object.
+ *
+ * @param  stats  [out]  Statistics object.
+ */
+void we_bulk_get_stats(wolfEngine_Stats *stats)
+{
+    if (pthread_mutex_lock(&we_bulkMutex) == 0) {
+        stats->bulkSplits = we_bulkSplits;
+        pthread_mutex_unlock(&we_bulkMutex);
+    }
+}
+
+/**
+ * Stop the bulk pool's workers.
+ */
+void we_final_bulk(void)
+{
+    pthread_mutex_lock(&we_bulkCtrlMutex);
+    we_bulk_threads_stop();
+    pthread_mutex_unlock(&we_bulkCtrlMutex);
+}
+
+/**
+ * Take the bulk pool's locks before forking.
+ */
+void we_bulk_fork_prepare(void)
+{
+    pthread_mutex_lock(&we_bulkCtrlMutex);
+    pthread_mutex_lock(&we_bulkMutex);
+}
+
+/**
+ * Release the bulk pool's locks after forking, in the parent.
+ */
+void we_bulk_fork_parent(void)
+{
+    pthread_mutex_unlock(&we_bulkMutex);
+    pthread_mutex_unlock(&we_bulkCtrlMutex);
+}
+
+/**
+ * Mark the workers as gone after forking, in the child, and release locks.
+ *
+ * Threads are not copied into the child. They are started again on the next
+ * split call - creating threads in a fork handler isn't safe. Until then calls
+ * are completed by the calling thread. Batches queued by other threads of the
+ * parent will never complete in the child and are dropped.
+ */
+void we_bulk_fork_child(void)
+{
+    /* Conditions may have had the parent's threads waiting on them. */
+    pthread_cond_init(&we_bulkWorkCond, NULL);
+    pthread_cond_init(&we_bulkDoneCond, NULL);
+    we_bulkQueue = NULL;
+    we_bulkRunning = 0;
+    we_bulkRestart = (we_bulkWorkers > 0);
+    pthread_mutex_unlock(&we_bulkMutex);
+    pthread_mutex_unlock(&we_bulkCtrlMutex);
+}
+
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC)
+
+/*
+ * AES bulk operations
+ */
+
+/**
+ * Part of an AES operation performed by one thread.
+ */
+typedef struct we_AesBulkJob {
+    /** Copy of AES object - key schedule and chaining state of part. */
+    Aes                  aes;
+    /** AES operation - WE_BULK_AES_*. */
+    int                  mode;
+    /** Output buffer of part. */
+    unsigned char       *out;
+    /** Input buffer of part. */
+    const unsigned char *in;
+    /** Length of part in bytes. */
+    size_t               len;
+    /** wolfCrypt result of operation on part. */
+    int                  rc;
+} we_AesBulkJob;
+
+/**
+ * Perform an AES operation with wolfSSL.
+ *
+ * @param  aes   [in,out]  wolfSSL AES object.
+ * @param  mode  [in]      AES operation - WE_BULK_AES_*.
+ * @param  out   [out]     Buffer to hold result.
+ * @param  in    [in]      Data to encrypt/decrypt.
+ * @param  len   [in]      Length of data in bytes.
+ * @returns  0 on success and wolfCrypt error code on failure.
+ */
+static int we_aes_bulk_crypt(Aes *aes, int mode, unsigned char *out,
+                             const unsigned char *in, size_t len)
+{
+    int rc;
+
+    switch (mode) {
+    #ifdef WE_HAVE_AESCTR
+        case WE_BULK_AES_CTR:
+            rc = wc_AesCtrEncrypt(aes, out, in, (word32)len);
+            break;
+    #endif
+    #ifdef WE_HAVE_AESECB
+        case WE_BULK_AES_ECB_ENC:
+            rc = wc_AesEcbEncrypt(aes, out, in, (word32)len);
+            break;
+        case WE_BULK_AES_ECB_DEC:
+            rc = wc_AesEcbDecrypt(aes, out, in, (word32)len);
+            break;
+    #endif
+    #ifdef WE_HAVE_AESCBC
+        case WE_BULK_AES_CBC_DEC:
+            rc = wc_AesCbcDecrypt(aes, out, in, (word32)len);
+            break;
+    #endif
+        default:
+            rc = BAD_FUNC_ARG;
+            break;
+    }
+
+    return rc;
+}
+
+/**
+ * Perform the AES operation on a part - bulk pool job.
+ *
+ * @param  arg  [in,out]  AES bulk job.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_aes_bulk_job(void *arg)
+{
+    we_AesBulkJob *job = (we_AesBulkJob *)arg;
+
+    job->rc = we_aes_bulk_crypt(&job->aes, job->mode, job->out, job->in,
+                                job->len);
+
+    return job->rc == 0;
+}
+
+#ifdef WE_HAVE_AESCTR
+/**
+ * Add a number of blocks to a big-endian 128-bit counter.
+ *
+ * @param  ctr     [in,out]  Counter block.
+ * @param  blocks  [in]      Number of blocks to add.
+ */
+static void we_aes_ctr_add(unsigned char *ctr, size_t blocks)
+{
+    int i;
+
+    for (i = AES_BLOCK_SIZE - 1; (i >= 0) && (blocks > 0); i--) {
+        blocks += ctr[i];
+        ctr[i] = (unsigned char)blocks;
+        blocks >>= 8;
+    }
+}
+#endif
+
+/**
+ * Encrypt/decrypt a very large buffer split across the bulk pool.
+ *
+ * Each part is given a copy of the AES object with the counter, or chaining
+ * IV, of the part's first block. All parts but the last are whole blocks. The
+ * AES object is left as if the whole buffer was done in one call.
+ *
+ * @param  aes   [in,out]  wolfSSL AES object with key and chaining state.
+ * @param  mode  [in]      AES operation - WE_BULK_AES_*.
+ * @param  out   [out]     Buffer to hold result. May be the same as in.
+ * @param  in    [in]      Data to encrypt/decrypt.
+ * @param  len   [in]      Length of data in bytes.
+ * @returns  0 on success and wolfCrypt error code on failure.
+ */
+int we_aes_bulk(Aes *aes, int mode, unsigned char *out,
+                const unsigned char *in, size_t len)
+{
+    int rc = 0;
+    int parts;
+    int cnt = 0;
+    int i;
+    size_t partSz;
+    size_t off;
+    we_AesBulkJob *jobs = NULL;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_aes_bulk");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [aes = %p, mode = %d, "
+                           "out = %p, in = %p, len = %zu]", aes, mode, out, in,
+                           len);
+
+#ifdef WE_HAVE_AESCTR
+    /* Use up key stream left from last call so parts start on a block. */
+    if ((mode == WE_BULK_AES_CTR) && (aes->left > 0)) {
+        partSz = (len < aes->left) ? len : aes->left;
+        rc = wc_AesCtrEncrypt(aes, out, in, (word32)partSz);
+        out += partSz;
+        in += partSz;
+        len -= partSz;
+    }
+#endif
+
+    /* Calling thread and each worker take a part of at least minimum size. */
+    parts = we_bulkWorkers + 1;
+    if ((size_t)parts > len / WE_BULK_MIN_PART_SZ) {
+        parts = (int)(len / WE_BULK_MIN_PART_SZ);
+    }
+    if ((rc == 0) && (parts > 1)) {
+        jobs = (we_AesBulkJob *)OPENSSL_malloc(parts * sizeof(*jobs));
+        if (jobs == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "OPENSSL_malloc", jobs);
+        }
+    }
+
+    if ((rc == 0) && (jobs == NULL)) {
+        /* Not splitting - do all data on calling thread. */
+        rc = we_aes_bulk_crypt(aes, mode, out, in, len);
+    }
+    else if (rc == 0) {
+        partSz = ((len / parts) + AES_BLOCK_SIZE - 1) &
+                 ~(size_t)(AES_BLOCK_SIZE - 1);
+        for (off = 0; off < len; off += partSz) {
+            XMEMCPY(&jobs[cnt].aes, aes, sizeof(Aes));
+            jobs[cnt].mode = mode;
+            jobs[cnt].out = out + off;
+            jobs[cnt].in = in + off;
+            jobs[cnt].len = (len - off < partSz) ? (len - off) : partSz;
+            jobs[cnt].rc = 0;
+        #ifdef WE_HAVE_AESCTR
+            if (mode == WE_BULK_AES_CTR) {
+                we_aes_ctr_add((unsigned char *)jobs[cnt].aes.reg,
+                               off / AES_BLOCK_SIZE);
+            }
+        #endif
+        #ifdef WE_HAVE_AESCBC
+            if ((mode == WE_BULK_AES_CBC_DEC) && (off > 0)) {
+                /* Last cipher text block of previous part - taken now as
+                 * decrypting in place overwrites it. */
+                XMEMCPY(jobs[cnt].aes.reg, in + off - AES_BLOCK_SIZE,
+                        AES_BLOCK_SIZE);
+            }
+        #endif
+            cnt++;
+        }
+
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Splitting %zu bytes into %d parts",
+                       len, cnt);
+        if (we_bulk_run(we_aes_bulk_job, jobs, sizeof(*jobs), cnt) != 1) {
+            for (i = 0; (rc == 0) && (i < cnt); i++) {
+                rc = jobs[i].rc;
+            }
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "we_aes_bulk_job", rc);
+        }
+        else {
+            /* Last part has chaining state of whole buffer. */
+            XMEMCPY(aes, &jobs[cnt - 1].aes, sizeof(Aes));
+        }
+
+        OPENSSL_clear_free(jobs, parts * sizeof(*jobs));
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_aes_bulk", rc == 0);
+
+    return rc;
+}
+
+#endif /* WE_HAVE_AESCTR || WE_HAVE_AESECB || WE_HAVE_AESCBC */
+
+#endif /* WE_HAVE_BULK_THREADS */
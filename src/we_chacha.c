@@ -0,0 +1,1000 @@
+/* we_chacha.c
+ *
+ * Copyright (C) 2006-2019 wolfSSL Inc.
+ *
+ * This file is part of wolfengine.
+ *
+ * wolfengine is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * wolfengine is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1335, USA
+ */
+
+#include <wolfengine/we_internal.h>
+
+#ifdef WE_HAVE_CHACHA
+
+/** Size of ChaCha20 key in bytes. */
+#define WE_CHACHA_KEY_SIZE          CHACHA20_POLY1305_AEAD_KEYSIZE
+/** Size of ChaCha20 IV in bytes - 32-bit counter followed by 96-bit nonce. */
+#define WE_CHACHA_IV_SIZE           16
+/** Size of counter at start of ChaCha20 IV in bytes. */
+#define WE_CHACHA_CTR_SIZE          4
+/** Size of ChaCha20-Poly1305 nonce in bytes. */
+#define WE_CHACHA_POLY_NONCE_SIZE   CHACHA20_POLY1305_AEAD_IV_SIZE
+/** Size of ChaCha20-Poly1305 tag in bytes. */
+#define WE_CHACHA_POLY_TAG_SIZE     CHACHA20_POLY1305_AEAD_AUTHTAG_SIZE
+
+/*
+ * ChaCha20
+ */
+
+/**
+ * Data required to complete a ChaCha20 encrypt/decrypt operation.
+ */
+typedef struct we_ChaCha
+{
+    /** The wolfSSL ChaCha20 data object. */
+    ChaCha         chacha;
+} we_ChaCha;
+
+
+/**
+ * Initialize the ChaCha20 encrypt/decrypt operation using wolfSSL.
+ *
+ * @param  ctx  [in,out]  EVP cipher context of operation.
+ * @param  key  [in]      ChaCha20 key - 32 bytes.
+ * @param  iv   [in]      Counter (little-endian) and nonce - 16 bytes.
+ * @param  enc  [in]      1 when initializing for encrypt and 0 when decrypt.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_chacha_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
+                          const unsigned char *iv, int enc)
+{
+    int ret = 1;
+    int rc;
+    we_ChaCha *chacha;
+    word32 counter;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_init");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, iv = %p, "
+                           "enc = %d]", ctx, key, iv, enc);
+
+    /* Encrypt and decrypt are the same operation. */
+    (void)enc;
+
+    chacha = (we_ChaCha *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (chacha == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", chacha);
+        ret = 0;
+    }
+
+    if ((ret == 1) && (key != NULL)) {
+        rc = wc_Chacha_SetKey(&chacha->chacha, key, WE_CHACHA_KEY_SIZE);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_Chacha_SetKey", rc);
+            ret = 0;
+        }
+    }
+    if ((ret == 1) && (iv != NULL)) {
+        /* OpenSSL's IV is the initial block counter followed by nonce. */
+        counter = ((word32)iv[0]      ) | ((word32)iv[1] <<  8) |
+                  ((word32)iv[2] << 16) | ((word32)iv[3] << 24);
+        rc = wc_Chacha_SetIV(&chacha->chacha, iv + WE_CHACHA_CTR_SIZE,
+                             counter);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_Chacha_SetIV", rc);
+            ret = 0;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_init", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt the data using wolfSSL.
+ *
+ * Key stream left over from previous call is used first.
+ *
+ * @param  ctx  [in,out]  EVP cipher context of operation.
+ * @param  out  [out]     Buffer to store enciphered result.
+ * @param  in   [in]      Data to encrypt/decrypt.
+ * @param  len  [in]      Length of data to encrypt/decrypt.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_chacha_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                            const unsigned char *in, size_t len)
+{
+    int ret = 1;
+    int rc;
+    we_ChaCha *chacha;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_cipher");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, out = %p, in = %p, "
+                           "len = %zu]", ctx, out, in, len);
+
+    chacha = (we_ChaCha *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (chacha == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", chacha);
+        ret = 0;
+    }
+
+    if ((ret == 1) && (len > 0)) {
+        rc = wc_Chacha_Process(&chacha->chacha, out, in, (word32)len);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_Chacha_Process", rc);
+            ret = 0;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_cipher", ret);
+
+    return ret;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/**
+ * Cleanup the internal ChaCha20 object. Does not free object.
+ *
+ * @param  ctx  [in]  EVP cipher context.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_chacha_cleanup(EVP_CIPHER_CTX *ctx)
+{
+    int ret = 1;
+    we_ChaCha *chacha;
+
+    chacha = (we_ChaCha *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (chacha == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", chacha);
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        /* Key and key stream are sensitive. */
+        OPENSSL_cleanse(&chacha->chacha, sizeof(chacha->chacha));
+    }
+
+    return ret;
+}
+#endif
+
+/*
+ * ChaCha20-Poly1305
+ */
+
+/**
+ * Data required to complete a ChaCha20-Poly1305 encrypt/decrypt operation.
+ */
+typedef struct we_ChaChaPoly
+{
+    /** The wolfSSL ChaCha20-Poly1305 streaming object. */
+    ChaChaPoly_Aead aead;
+    /** Key - the wolfSSL object is initialized with key and nonce together. */
+    unsigned char   key[WE_CHACHA_KEY_SIZE];
+    /** Nonce to use with encrypt/decrypt. */
+    unsigned char   iv[WE_CHACHA_POLY_NONCE_SIZE];
+    /** Length of nonce passed in. */
+    int             ivLen;
+    /** Tag created when encrypting or tag set for decryption. */
+    unsigned char   tag[WE_CHACHA_POLY_TAG_SIZE];
+    /** Length of tag data stored.  */
+    int             tagLen;
+    /** AAD of TLS record - length field adjusted. */
+    unsigned char   tlsAad[EVP_AEAD_TLS1_AAD_LEN];
+#ifdef WE_HAVE_PIPELINE
+    /** TLS records passed in for one cipher call. */
+    we_Pipeline     pipe;
+#endif
+    /** Flag to indicate whether we are doing encrypt (1) or decrpyt (0). */
+    unsigned int    enc:1;
+    /** Flag to indicate whether doing this for TLS. */
+    unsigned int    tls:1;
+    /** Key set. */
+    unsigned int    keySet:1;
+    /** Streaming operation started with key and nonce in wolfSSL object. */
+    unsigned int    started:1;
+} we_ChaChaPoly;
+
+
+/**
+ * Initialize the ChaCha20-Poly1305 encrypt/decrypt operation.
+ *
+ * Key and nonce are cached as wolfSSL needs both to start an operation.
+ *
+ * @param  ctx  [in,out]  EVP cipher context of operation.
+ * @param  key  [in]      ChaCha20 key - 32 bytes.
+ * @param  iv   [in]      Nonce - up to 12 bytes.
+ * @param  enc  [in]      1 when initializing for encrypt and 0 when decrypt.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_chacha_poly_init(EVP_CIPHER_CTX *ctx, const unsigned char *key,
+                               const unsigned char *iv, int enc)
+{
+    int ret = 1;
+    we_ChaChaPoly *cp;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_init");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, key = %p, iv = %p, "
+                           "enc = %d]", ctx, key, iv, enc);
+
+    cp = (we_ChaChaPoly *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (cp == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", cp);
+        ret = 0;
+    }
+
+    if ((ret == 1) && (key != NULL)) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Caching ChaCha20 key");
+        XMEMCPY(cp->key, key, WE_CHACHA_KEY_SIZE);
+        cp->keySet = 1;
+        cp->started = 0;
+    }
+    if ((ret == 1) && (iv != NULL)) {
+        /* Short nonces are padded on the left with zeros. */
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Caching nonce into cp->iv");
+        XMEMSET(cp->iv, 0, WE_CHACHA_POLY_NONCE_SIZE - cp->ivLen);
+        XMEMCPY(cp->iv + WE_CHACHA_POLY_NONCE_SIZE - cp->ivLen, iv,
+                cp->ivLen);
+        cp->started = 0;
+    }
+
+    if (ret == 1) {
+        cp->enc = enc;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_init", ret);
+
+    return ret;
+}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+/**
+ * Cleanup the internal ChaCha20-Poly1305 object. Does not free object.
+ *
+ * @param  ctx  [in]  EVP cipher context.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_chacha_poly_cleanup(EVP_CIPHER_CTX *ctx)
+{
+    int ret = 1;
+    we_ChaChaPoly *cp;
+
+    cp = (we_ChaChaPoly *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (cp == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", cp);
+        ret = 0;
+    }
+
+    if (ret == 1) {
+        /* Key and key stream are sensitive. */
+        OPENSSL_cleanse(&cp->aead, sizeof(cp->aead));
+        OPENSSL_cleanse(cp->key, sizeof(cp->key));
+        cp->keySet = 0;
+        cp->started = 0;
+    }
+
+    return ret;
+}
+#endif
+
+/**
+ * Encrypt/decrypt a TLS record.
+ *
+ * Nonce is the fixed IV XORed with the sequence number from the TLS AAD.
+ * Input is the record data followed by space for, or the value of, the tag.
+ *
+ * @param  cp   [in,out]  wolfEngine ChaCha20-Poly1305 state object.
+ * @param  out  [out]     Buffer to store enciphered result.
+ * @param  in   [in]      Record data to encrypt/decrypt.
+ * @param  len  [in]      Length of record data including tag.
+ * @return  Length of record on success and -1 on failure.
+ */
+static int we_chacha_poly_tls_cipher(we_ChaChaPoly *cp, unsigned char *out,
+                                     const unsigned char *in, size_t len)
+{
+    int ret = 1;
+    int rc;
+    int i;
+    word32 dataLen = 0;
+    unsigned char nonce[WE_CHACHA_POLY_NONCE_SIZE];
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_tls_cipher");
+
+    /* Length of data in AAD has been adjusted to exclude tag. */
+    dataLen = ((word32)cp->tlsAad[EVP_AEAD_TLS1_AAD_LEN - 2] << 8) |
+              cp->tlsAad[EVP_AEAD_TLS1_AAD_LEN - 1];
+    if ((!cp->keySet) || (len != dataLen + WE_CHACHA_POLY_TAG_SIZE)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid TLS record length");
+        ret = -1;
+    }
+
+    if (ret == 1) {
+        /* Sequence number is XORed into last 8 bytes of nonce. */
+        XMEMCPY(nonce, cp->iv, WE_CHACHA_POLY_NONCE_SIZE);
+        for (i = 0; i < 8; i++) {
+            nonce[WE_CHACHA_POLY_NONCE_SIZE - 8 + i] ^= cp->tlsAad[i];
+        }
+
+        if (cp->enc) {
+            /* Tag goes at end of output buffer. */
+            rc = wc_ChaCha20Poly1305_Encrypt(cp->key, nonce, cp->tlsAad,
+                EVP_AEAD_TLS1_AAD_LEN, in, dataLen, out, out + dataLen);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
+                                      "wc_ChaCha20Poly1305_Encrypt", rc);
+                ret = -1;
+            }
+        }
+        else {
+            /* Tag is at end of input buffer. */
+            rc = wc_ChaCha20Poly1305_Decrypt(cp->key, nonce, cp->tlsAad,
+                EVP_AEAD_TLS1_AAD_LEN, in, dataLen, in + dataLen, out);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
+                                      "wc_ChaCha20Poly1305_Decrypt", rc);
+                ret = -1;
+            }
+        }
+        OPENSSL_cleanse(nonce, sizeof(nonce));
+    }
+    if (ret == 1) {
+        WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "%s %d bytes "
+                               "(ChaCha20-Poly1305):",
+                               cp->enc ? "Encrypted" : "Decrypted", dataLen);
+        WOLFENGINE_BUFFER(WE_LOG_CIPHER, out, dataLen);
+        ret = (int)len;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_tls_cipher", ret);
+
+    return ret;
+}
+
+#ifdef WE_HAVE_PIPELINE
+/**
+ * Encrypt/decrypt the TLS records set with the pipeline ctrl commands.
+ *
+ * Each record is processed with its own TLS AAD and so its own nonce.
+ *
+ * @param  cp  [in,out]  wolfEngine ChaCha20-Poly1305 state object.
+ * @return  Total length of records processed on success, -1 on failure.
+ */
+static int we_chacha_poly_tls_pipeline(we_ChaChaPoly *cp)
+{
+    int ret = 0;
+    int rc;
+    int i;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_tls_pipeline");
+
+    if ((!we_pipeline_check(&cp->pipe)) || (cp->pipe.aadCnt == 0)) {
+        ret = -1;
+    }
+    if (ret != -1) {
+        WOLFENGINE_MSG(WE_LOG_CIPHER, "Pipelining %d TLS records",
+                       cp->pipe.num);
+    }
+    for (i = 0; (ret != -1) && (i < cp->pipe.num); i++) {
+        XMEMCPY(cp->tlsAad, cp->pipe.aad[i], EVP_AEAD_TLS1_AAD_LEN);
+        rc = we_chacha_poly_tls_cipher(cp, cp->pipe.out[i], cp->pipe.in[i],
+                                       cp->pipe.lens[i]);
+        if (rc == -1) {
+            ret = -1;
+        }
+        else {
+            ret += rc;
+        }
+    }
+
+    /* Records are only good for one call. */
+    we_pipeline_reset(&cp->pipe);
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_tls_pipeline", ret);
+
+    return ret;
+}
+#endif
+
+/**
+ * Start a streaming encrypt/decrypt operation if not already started.
+ *
+ * Sets the key and nonce into the wolfSSL object.
+ *
+ * @param  cp  [in,out]  wolfEngine ChaCha20-Poly1305 state object.
+ * @return  0 on success, -1 on failure.
+ */
+static int we_chacha_poly_start(we_ChaChaPoly *cp)
+{
+    int ret = 0;
+    int rc;
+
+    if (!cp->keySet) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "No key set");
+        ret = -1;
+    }
+    else if (!cp->started) {
+        rc = wc_ChaCha20Poly1305_Init(&cp->aead, cp->key, cp->iv,
+            cp->enc ? CHACHA20_POLY1305_AEAD_ENCRYPT :
+                      CHACHA20_POLY1305_AEAD_DECRYPT);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_ChaCha20Poly1305_Init",
+                                  rc);
+            ret = -1;
+        }
+        else {
+            cp->started = 1;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Add AAD. Can be called multiple times to add more AAD.
+ *
+ * AAD is authenticated as it is passed in - not stored.
+ *
+ * @param  cp   [in,out]  wolfEngine ChaCha20-Poly1305 state object.
+ * @param  in   [in]      AAD to add.
+ * @param  len  [in]      Length of AAD.
+ * @return  Length of AAD added on success, -1 on failure.
+ */
+static int we_chacha_poly_update_aad(we_ChaChaPoly *cp,
+                                     const unsigned char *in, size_t len)
+{
+    int ret;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_update_aad");
+
+    ret = we_chacha_poly_start(cp);
+    if (ret == 0) {
+        rc = wc_ChaCha20Poly1305_UpdateAad(&cp->aead, in, (word32)len);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
+                                  "wc_ChaCha20Poly1305_UpdateAad", rc);
+            ret = -1;
+        }
+        else {
+            ret = (int)len;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_update_aad", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt the data. Output is produced as data is passed in - no data
+ * is buffered.
+ *
+ * @param  cp   [in,out]  wolfEngine ChaCha20-Poly1305 state object.
+ * @param  in   [in]      Data to encrypt/decrypt.
+ * @param  len  [in]      Length input data.
+ * @param  out  [out]     Buffer to store encryption/decryption result.
+ * @return  Length of data encrypted/decrypted on success, -1 on failure.
+ */
+static int we_chacha_poly_update(we_ChaChaPoly *cp, const unsigned char *in,
+                                 size_t len, unsigned char *out)
+{
+    int ret = 0;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_update");
+
+    if ((len != 0) && (in == NULL)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "we_chacha_poly_update called "
+                             "with non-zero length and NULL input buffer.");
+        ret = -1;
+    }
+    if ((ret == 0) && (len != 0)) {
+        ret = we_chacha_poly_start(cp);
+    }
+    if ((ret == 0) && (len != 0)) {
+        rc = wc_ChaCha20Poly1305_UpdateData(&cp->aead, in, out, (word32)len);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER,
+                                  "wc_ChaCha20Poly1305_UpdateData", rc);
+            ret = -1;
+        }
+        else {
+            WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "%s %zu bytes "
+                                   "(ChaCha20-Poly1305):",
+                                   cp->enc ? "Encrypted" : "Decrypted", len);
+            WOLFENGINE_BUFFER(WE_LOG_CIPHER, out, (unsigned int)len);
+            ret = (int)len;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_update", ret);
+
+    return ret;
+}
+
+/**
+ * Complete the encryption/decryption - calculate or check the tag.
+ *
+ * @param  cp  [in,out]  wolfEngine ChaCha20-Poly1305 state object.
+ * @return  0 on success, -1 on failure.
+ */
+static int we_chacha_poly_final(we_ChaChaPoly *cp)
+{
+    int ret;
+    int rc;
+    unsigned char tag[WE_CHACHA_POLY_TAG_SIZE];
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_final");
+
+    /* No data passed in when only authenticating AAD. */
+    ret = we_chacha_poly_start(cp);
+    if ((ret == 0) && (!cp->enc) && (cp->tagLen == 0)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "No tag set for decrypt");
+        ret = -1;
+    }
+    if (ret == 0) {
+        rc = wc_ChaCha20Poly1305_Final(&cp->aead, tag);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_CIPHER, "wc_ChaCha20Poly1305_Final",
+                                  rc);
+            ret = -1;
+        }
+    }
+    if ((ret == 0) && cp->enc) {
+        /* Tag always full size on calculation. */
+        XMEMCPY(cp->tag, tag, WE_CHACHA_POLY_TAG_SIZE);
+        cp->tagLen = WE_CHACHA_POLY_TAG_SIZE;
+        WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ChaCha20-Poly1305 tag:");
+        WOLFENGINE_BUFFER(WE_LOG_CIPHER, cp->tag, cp->tagLen);
+    }
+    else if ((ret == 0) && (CRYPTO_memcmp(tag, cp->tag, cp->tagLen) != 0)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Tag does not match");
+        ret = -1;
+    }
+
+    /* Next operation starts again with key and nonce. */
+    cp->started = 0;
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_final", ret);
+
+    return ret;
+}
+
+/**
+ * Encrypt/decrypt the data.
+ *
+ * @param  ctx  [in,out]  EVP cipher context of operation.
+ * @param  out  [out]     Buffer to store enciphered result.<br>
+ *                        NULL indicates AAD in.
+ * @param  in   [in]      AAD or data to encrypt/decrypt.
+ * @param  len  [in]      Length of AAD or data to encrypt/decrypt.
+ * @return  When out is NULL, length of input data on success and -1 on failure.
+ *          <br>
+ *          When out is not NULL, length of output data on success and -1 on
+ *          failure.
+ */
+static int we_chacha_poly_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                 const unsigned char *in, size_t len)
+{
+    int ret = 1;
+    we_ChaChaPoly *cp;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_cipher");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, out = %p, in = %p, "
+                           "len = %zu]", ctx, out, in, len);
+
+    cp = (we_ChaChaPoly *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (cp == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", cp);
+        ret = -1;
+    }
+
+    if (ret == 1) {
+    #ifdef WE_HAVE_PIPELINE
+        if ((cp->tls == 1) && (cp->pipe.num > 0)) {
+            ret = we_chacha_poly_tls_pipeline(cp);
+        }
+        else
+    #endif
+        if (cp->tls == 1) {
+            ret = we_chacha_poly_tls_cipher(cp, out, in, len);
+        #ifdef WE_HAVE_PIPELINE
+            /* TLS AAD used - clear pipeline for next call. */
+            we_pipeline_reset(&cp->pipe);
+        #endif
+        }
+        else if (out == NULL && len != 0 && in != NULL) {
+            ret = we_chacha_poly_update_aad(cp, in, len);
+        }
+        else if (len != 0 || in != NULL) {
+            ret = we_chacha_poly_update(cp, in, len, out);
+        }
+        else {
+            ret = we_chacha_poly_final(cp);
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_cipher", ret);
+
+    return ret;
+}
+
+/**
+ * Extra operations for ChaCha20-Poly1305.
+ * Supported operations include:
+ *  - EVP_CTRL_COPY: copy of context made - nothing more to copy
+ *  - EVP_CTRL_AEAD_SET_IVLEN: set the length of the nonce
+ *  - EVP_CTRL_GET_IVLEN: get the nonce length
+ *  - EVP_CTRL_AEAD_SET_IV_FIXED: set the fixed nonce for TLS
+ *  - EVP_CTRL_AEAD_GET_TAG: get the tag value after encrypt
+ *  - EVP_CTRL_AEAD_SET_TAG: set the tag value before decrypt
+ *  - EVP_CTRL_AEAD_TLS1_AAD: set AAD for TLS
+ *  - EVP_CTRL_SET_PIPELINE_*: set TLS records to process in one call
+ *
+ * @param  ctx   [in,out]  EVP cipher context of operation.
+ * @param  type  [in]      Type of operation to perform.
+ * @param  arg   [in]      Integer argument.
+ * @param  ptr   [in]      Pointer argument.
+ * @return  1 on success and 0 on failure.
+ */
+static int we_chacha_poly_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg,
+                               void *ptr)
+{
+    int ret = 1;
+    we_ChaChaPoly *cp;
+    char errBuff[WOLFENGINE_MAX_LOG_WIDTH];
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_chacha_poly_ctrl");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_CIPHER, "ARGS [ctx = %p, type = %d, "
+                           "arg = %d, ptr = %p]", ctx, type, arg, ptr);
+
+    cp = (we_ChaChaPoly *)EVP_CIPHER_CTX_get_cipher_data(ctx);
+    if (cp == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_CTX_get_cipher_data", cp);
+        ret = 0;
+    }
+    if (ret == 1) {
+        switch (type) {
+            case EVP_CTRL_INIT:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_INIT");
+                /* No key or nonce yet. */
+                cp->ivLen = WE_CHACHA_POLY_NONCE_SIZE;
+                XMEMSET(cp->iv, 0, sizeof(cp->iv));
+                cp->keySet = 0;
+                cp->started = 0;
+                /* No tag set. */
+                cp->tagLen = 0;
+                /* Not doing TLS unless ctrl function called. */
+                cp->tls = 0;
+            #ifdef WE_HAVE_PIPELINE
+                we_pipeline_reset(&cp->pipe);
+            #endif
+                break;
+
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Cipher data copied byte-wise - holds no owned pointers.
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                break;
+
+            case EVP_CTRL_AEAD_SET_IVLEN:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_AEAD_SET_IVLEN");
+                /* Set the nonce length to use
+                 *   arg [in] length of nonce to use
+                 *   ptr [in] Unused
+                 */
+                if ((arg <= 0) || (arg > WE_CHACHA_POLY_NONCE_SIZE)) {
+                    XSNPRINTF(errBuff, sizeof(errBuff), "Invalid nonce length "
+                              "%d", arg);
+                    WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, errBuff);
+                    ret = 0;
+                }
+                else {
+                    WOLFENGINE_MSG(WE_LOG_CIPHER, "Set cp->ivLen: %d", arg);
+                    cp->ivLen = arg;
+                }
+                break;
+
+            case EVP_CTRL_GET_IVLEN:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_GET_IVLEN");
+                /* Get the nonce length
+                 *   ptr [out] Length of nonce
+                 */
+                *(int *)ptr = cp->ivLen;
+                break;
+
+            case EVP_CTRL_AEAD_SET_IV_FIXED:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_AEAD_SET_IV_FIXED");
+                /* Set the fixed nonce that TLS sequence numbers are XORed
+                 * into.
+                 *   arg [in] size of nonce - must be full size
+                 *   ptr [in] nonce data
+                 */
+                if (arg != WE_CHACHA_POLY_NONCE_SIZE) {
+                    XSNPRINTF(errBuff, sizeof(errBuff), "Invalid fixed nonce "
+                              "length %d", arg);
+                    WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, errBuff);
+                    ret = 0;
+                }
+                else {
+                    XMEMCPY(cp->iv, ptr, WE_CHACHA_POLY_NONCE_SIZE);
+                    cp->started = 0;
+                }
+                break;
+
+            case EVP_CTRL_AEAD_GET_TAG:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_AEAD_GET_TAG");
+                /* Get the tag from encryption.
+                 *   arg [in] size of buffer
+                 *   ptr [in] buffer to copy into
+                 */
+                if ((!cp->enc) || (arg <= 0) || (arg > cp->tagLen)) {
+                    ret = 0;
+                }
+                else {
+                    XMEMCPY(ptr, cp->tag, arg);
+                }
+                break;
+
+            case EVP_CTRL_AEAD_SET_TAG:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_AEAD_SET_TAG");
+                /* Set the tag for decryption.
+                 *   arg [in] size of tag
+                 *   ptr [in] tag data to copy
+                 */
+                if ((arg <= 0) || (arg > WE_CHACHA_POLY_TAG_SIZE)) {
+                    WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid tag size");
+                    ret = 0;
+                }
+                else if ((!cp->enc) && (ptr == NULL)) {
+                    WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "No tag for decrypt");
+                    ret = 0;
+                }
+                else {
+                    if ((!cp->enc) && (ptr != NULL)) {
+                        XMEMCPY(cp->tag, ptr, arg);
+                    }
+                    cp->tagLen = arg;
+                }
+                break;
+
+            case EVP_CTRL_AEAD_TLS1_AAD:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_AEAD_TLS1_AAD");
+                /* Set additional authentication data for TLS
+                 *   arg [in] size of AAD
+                 *   ptr [in] AAD to use
+                 */
+                if (arg != EVP_AEAD_TLS1_AAD_LEN) {
+                    WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid TLS AAD size");
+                    ret = 0;
+                }
+                if (ret == 1) {
+                    unsigned int len;
+
+                    /* Set modified AAD based on record header. */
+                    XMEMCPY(cp->tlsAad, ptr, arg);
+                    len = (cp->tlsAad[arg - 2] << 8) | cp->tlsAad[arg - 1];
+                    if (!cp->enc) {
+                        /* Record length includes tag when decrypting. */
+                        if (len < WE_CHACHA_POLY_TAG_SIZE) {
+                            WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER,
+                                "Length in AAD invalid");
+                            ret = 0;
+                        }
+                        else {
+                            len -= WE_CHACHA_POLY_TAG_SIZE;
+                        }
+                    }
+                    if (ret == 1) {
+                        cp->tlsAad[arg - 2] = len >> 8;
+                        cp->tlsAad[arg - 1] = len;
+                    #ifdef WE_HAVE_PIPELINE
+                        /* Keep AAD of each record in case of pipelining. */
+                        ret = we_pipeline_add_aad(&cp->pipe, cp->tlsAad);
+                    }
+                    if (ret == 1) {
+                    #endif
+                        cp->tls = 1;
+                        ret = WE_CHACHA_POLY_TAG_SIZE;
+                    }
+                }
+                break;
+
+        #ifdef WE_HAVE_PIPELINE
+            case EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS:
+            case EVP_CTRL_SET_PIPELINE_INPUT_BUFS:
+            case EVP_CTRL_SET_PIPELINE_INPUT_LENS:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_SET_PIPELINE_*");
+                /* Set TLS records to process in next cipher call
+                 *   arg [in] number of records
+                 *   ptr [in] array of buffers or lengths
+                 */
+                ret = we_pipeline_ctrl(&cp->pipe, type, arg, ptr);
+                break;
+        #endif
+
+            default:
+                XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
+                          type);
+                WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, errBuff);
+                ret = 0;
+                break;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_chacha_poly_ctrl", ret);
+
+    return ret;
+}
+
+/** Flags for ChaCha20 method. */
+#define CHACHA_FLAGS               \
+    (EVP_CIPH_CUSTOM_IV          | \
+     EVP_CIPH_ALWAYS_CALL_INIT)
+
+/** Flags for ChaCha20-Poly1305 method. */
+#define CHACHA_POLY_FLAGS          \
+    (EVP_CIPH_FLAG_CUSTOM_CIPHER | \
+     EVP_CIPH_CUSTOM_IV          | \
+     EVP_CIPH_CUSTOM_IV_LENGTH   | \
+     EVP_CIPH_ALWAYS_CALL_INIT   | \
+     EVP_CIPH_CTRL_INIT          | \
+     EVP_CIPH_FLAG_AEAD_CIPHER   | \
+     EVP_CIPH_CUSTOM_COPY        | \
+     WE_CIPH_FLAG_PIPELINE)
+
+/** ChaCha20 EVP cipher method. */
+EVP_CIPHER* we_chacha20_ciph = NULL;
+/** ChaCha20-Poly1305 EVP cipher method. */
+EVP_CIPHER* we_chacha20_poly1305_ciph = NULL;
+
+
+/**
+ * Initialize the ChaCha20 method.
+ *
+ * @return  1 on success and 0 on failure.
+ */
+static int we_init_chacha_meth(EVP_CIPHER *cipher)
+{
+    int ret;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_init_chacha_meth");
+
+    ret = EVP_CIPHER_meth_set_iv_length(cipher, WE_CHACHA_IV_SIZE);
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_flags(cipher, CHACHA_FLAGS);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_init(cipher, we_chacha_init);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_cleanup(cipher, we_chacha_cleanup);
+    }
+#endif
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_do_cipher(cipher, we_chacha_cipher);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_impl_ctx_size(cipher, sizeof(we_ChaCha));
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_init_chacha_meth", ret);
+
+    return ret;
+}
+
+/**
+ * Initialize the ChaCha20-Poly1305 method.
+ *
+ * @return  1 on success and 0 on failure.
+ */
+static int we_init_chacha_poly_meth(EVP_CIPHER *cipher)
+{
+    int ret;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_init_chacha_poly_meth");
+
+    ret = EVP_CIPHER_meth_set_iv_length(cipher, WE_CHACHA_POLY_NONCE_SIZE);
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_flags(cipher, CHACHA_POLY_FLAGS);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_init(cipher, we_chacha_poly_init);
+    }
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_cleanup(cipher, we_chacha_poly_cleanup);
+    }
+#endif
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_do_cipher(cipher, we_chacha_poly_cipher);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_ctrl(cipher, we_chacha_poly_ctrl);
+    }
+    if (ret == 1) {
+        ret = EVP_CIPHER_meth_set_impl_ctx_size(cipher, sizeof(we_ChaChaPoly));
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_init_chacha_poly_meth", ret);
+
+    return ret;
+}
+
+/**
+ * Initialize the ChaCha20 and ChaCha20-Poly1305 methods.
+ *
+ * @return  1 on success and 0 on failure.
+ */
+int we_init_chacha_meths()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_init_chacha_meths");
+
+    /* ChaCha20 */
+    we_chacha20_ciph = EVP_CIPHER_meth_new(NID_chacha20, 1,
+                                           WE_CHACHA_KEY_SIZE);
+    if (we_chacha20_ciph == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                   "EVP_CIPHER_meth_new - ChaCha20",
+                                   we_chacha20_ciph);
+        ret = 0;
+    }
+    if (ret == 1) {
+        ret = we_init_chacha_meth(we_chacha20_ciph);
+    }
+
+    /* ChaCha20-Poly1305 */
+    if (ret == 1) {
+        we_chacha20_poly1305_ciph = EVP_CIPHER_meth_new(NID_chacha20_poly1305,
+                                                        1, WE_CHACHA_KEY_SIZE);
+        if (we_chacha20_poly1305_ciph == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
+                                       "EVP_CIPHER_meth_new - "
+                                       "ChaCha20-Poly1305",
+                                       we_chacha20_poly1305_ciph);
+            ret = 0;
+        }
+    }
+    if (ret == 1) {
+        ret = we_init_chacha_poly_meth(we_chacha20_poly1305_ciph);
+    }
+
+    /* Cleanup */
+    if ((ret == 0) && (we_chacha20_ciph != NULL)) {
+        EVP_CIPHER_meth_free(we_chacha20_ciph);
+        we_chacha20_ciph = NULL;
+    }
+    if ((ret == 0) && (we_chacha20_poly1305_ciph != NULL)) {
+        EVP_CIPHER_meth_free(we_chacha20_poly1305_ciph);
+        we_chacha20_poly1305_ciph = NULL;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_init_chacha_meths", ret);
+
+    return ret;
+}
+
+#endif /* WE_HAVE_CHACHA */
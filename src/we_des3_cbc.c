@@ -256,8 +256,8 @@ static int we_des3_cbc_cipher(EVP_CIPHER_CTX *ctx, unsigned char *out,
 
 /**
  * Extra operations for DES3-CBC.
- *
- * No supported operations yet.
+ * Supported operations include:
+ *  - EVP_CTRL_COPY: copy of context made - nothing more to copy
  *
  * @param  ctx   [in]  EVP cipher context of operation.
  * @param  type  [in]  Type of operation to perform.
@@ -280,13 +280,20 @@ static int we_des3_cbc_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
 
     /* Get the DES3-CBC data to work with. */
     des3 = (we_Des3Cbc *)EVP_CIPHER_CTX_get_cipher_data(ctx);
-    if (des3 != NULL) {
+    if (des3 == NULL) {
         WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER,
                                    "EVP_CIPHER_CTX_get_cipher_data", des3);
         ret = 0;
     }
     if (ret == 1) {
         switch (type) {
+            case EVP_CTRL_COPY:
+                WOLFENGINE_MSG(WE_LOG_CIPHER, "EVP_CTRL_COPY");
+                /* Cipher data copied byte-wise - holds no pointers.
+                 *   ptr [in] EVP cipher context copied into
+                 */
+                break;
+
             default:
                 XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                           type);
@@ -313,6 +320,7 @@ static int we_des3_cbc_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
  */
 #define DES3_CBC_FLAGS             \
      (EVP_CIPH_FLAG_DEFAULT_ASN1 | \
+     EVP_CIPH_CUSTOM_COPY        | \
      EVP_CIPH_CBC_MODE)
 
 /** DES3-CBC EVP cipher method. */
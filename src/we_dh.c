@@ -47,6 +47,13 @@ typedef struct we_Dh
 #ifndef WE_DH_USE_GLOBAL_RNG
     /** wolfSSL random number generator. */
     WC_RNG rng;
+#ifdef WE_HAVE_FORK_CHECK
+    /** Fork generation random number generator was instantiated in. */
+    int rngForkGen;
+#endif
+#else
+    /** Shard of global random number generator used with this key. */
+    we_RngShard *rngShard;
 #endif
     /** Length of prime ("p") in bits. */
     int primeLen;
@@ -132,6 +139,14 @@ static int we_dh_init_int(we_Dh **dh)
             WOLFENGINE_ERROR_FUNC(WE_LOG_KE, "wc_InitRng", rc);
             ret = 0;
         }
+    #ifdef WE_HAVE_FORK_CHECK
+        engineDh->rngForkGen = we_forkGen;
+    #endif
+    }
+#else
+    if (ret == 1) {
+        /* Key is only used with one shard so operations on it serialize. */
+        engineDh->rngShard = we_rng_shard();
     }
 #endif
 
@@ -356,7 +371,7 @@ static int we_dh_generate_key_int(DH *dh, we_Dh *engineDh)
 #ifndef WE_DH_USE_GLOBAL_RNG
     WC_RNG *pRng = &engineDh->rng;
 #else
-    WC_RNG *pRng = we_rng;
+    WC_RNG *pRng = &engineDh->rngShard->rng;
 #endif
 
     WOLFENGINE_ENTER(WE_LOG_KE, "we_dh_generate_key_int");
@@ -419,11 +434,16 @@ static int we_dh_generate_key_int(DH *dh, we_Dh *engineDh)
             }
         }
         else {
+        #if !defined(WE_DH_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+            /* Don't generate the same random as the parent process. */
+            ret = we_rng_fork_check(pRng, &engineDh->rngForkGen);
+            if (ret == 1)
+        #endif
             /* Generate public/private key pair with wolfSSL. */
         #if defined(WE_DH_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-            rc = wc_LockMutex(we_rng_mutex);
+            rc = we_rng_shard_lock(engineDh->rngShard);
             if (rc != 0) {
-                WOLFENGINE_ERROR_FUNC(WE_LOG_KE, "wc_LockMutex", rc);
+                WOLFENGINE_ERROR_FUNC(WE_LOG_KE, "we_rng_shard_lock", rc);
                 ret = 0;
             }
             else
@@ -438,7 +458,7 @@ static int we_dh_generate_key_int(DH *dh, we_Dh *engineDh)
                 }
             }
         #if defined(WE_DH_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&engineDh->rngShard->mutex);
         #endif
         }
     }
@@ -829,15 +849,20 @@ static int we_dh_paramgen_int(DH *dh, we_Dh *engineDh)
 #ifndef WE_DH_USE_GLOBAL_RNG
     WC_RNG *pRng = &engineDh->rng;
 #else
-    WC_RNG *pRng = we_rng;
+    WC_RNG *pRng = &engineDh->rngShard->rng;
 #endif
 
     WOLFENGINE_ENTER(WE_LOG_KE, "we_dh_paramgen_int");
 
+#if !defined(WE_DH_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    /* Don't generate the same random as the parent process. */
+    ret = we_rng_fork_check(pRng, &engineDh->rngForkGen);
+    if (ret == 1)
+#endif
 #if defined(WE_DH_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    rc = wc_LockMutex(we_rng_mutex);
+    rc = we_rng_shard_lock(engineDh->rngShard);
     if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_KE, "wc_LockMutex", rc);
+        WOLFENGINE_ERROR_FUNC(WE_LOG_KE, "we_rng_shard_lock", rc);
         ret = 0;
     }
     else
@@ -851,7 +876,7 @@ static int we_dh_paramgen_int(DH *dh, we_Dh *engineDh)
         }
     }
 #if defined(WE_DH_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    wc_UnLockMutex(we_rng_mutex);
+    wc_UnLockMutex(&engineDh->rngShard->mutex);
 #endif
 
     if (ret == 1) {
@@ -21,978 +21,469 @@
 
 #include <wolfengine/we_internal.h>
 
-
-#if defined(WE_HAVE_SHA1) && defined(WE_SHA1_DIRECT)
-
 /*
- * SHA-1
- */
-
-/**
- * Initialize the SHA-1 digest operation using wolfSSL.
+ * Direct digest methods
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * Each algorithm has its own EVP digest method. The method's data is the
+ * wolfSSL hash object of just that algorithm and the method's functions call
+ * the algorithm's wolfSSL functions directly.
  */
-static int we_sha_init(EVP_MD_CTX *ctx)
-{
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    rc = wc_InitSha((wc_Sha*)EVP_MD_CTX_md_data(ctx));
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_InitSha", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha_init", ret);
-
-    return ret;
-}
-
-/**
- * Digest some more data with SHA-1 using wolfSSL.
- *
- * @param  ctx   [in]  EVP digest context of operation.
- * @param  data  [in]  More data to digest with SHA-1.
- * @param  len   [in]  Length of data to digest.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha_update(EVP_MD_CTX *ctx, const void *data, size_t len)
-{
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha_update");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, data = %p, "
-                           "len = %zu]", ctx, data, len);
-
-    rc = wc_ShaUpdate((wc_Sha*)EVP_MD_CTX_md_data(ctx),
-                         (const byte*)data, (word32)len);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_ShaUpdate", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha_update", ret);
-
-    return ret;
-}
 
-/**
- * Finalize the SHA-1 digest operation.
- *
- * @param  ctx  [in]  EVP digest context of operation.
- * @param  md   [in]  SHA-1 digest of data.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha_final(EVP_MD_CTX *ctx, unsigned char *md)
-{
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha_final");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, md = %p]",
-                           ctx, md);
-
-    rc = wc_ShaFinal((wc_Sha*)EVP_MD_CTX_md_data(ctx), (byte*)md);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_ShaFinal", rc);
-        ret = 0;
-    }
-    else {
-        WOLFENGINE_MSG(WE_LOG_DIGEST, "SHA-1 Digest");
-        WOLFENGINE_BUFFER(WE_LOG_DIGEST, md, WC_SHA_DIGEST_SIZE);
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha_final", ret);
-
-    return ret;
-}
+/* Free the wolfSSL hash object - not available in old FIPS wolfCrypt. */
+#if !defined(HAVE_FIPS_VERSION) || HAVE_FIPS_VERSION >= 2
+#define WE_DIGEST_FREE(wcFree, obj)     wcFree(obj)
+#else
+#define WE_DIGEST_FREE(wcFree, obj)     (void)(obj)
+#endif
 
 /**
- * Cleanup the SHA-1 digest object.
+ * Define the init, update, final and cleanup functions of an EVP digest
+ * method that calls an algorithm's wolfSSL functions directly.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 for success.
+ * @param  name      [in]  Name of algorithm in function names - e.g. sha256.
+ * @param  desc      [in]  Name of algorithm in log messages - e.g. "SHA-256".
+ * @param  wcType    [in]  wolfSSL hash object type.
+ * @param  wcInit    [in]  wolfSSL function initializing the hash object.
+ * @param  wcUpdate  [in]  wolfSSL function digesting more data.
+ * @param  wcFinal   [in]  wolfSSL function producing the digest.
+ * @param  wcFree    [in]  wolfSSL function freeing the hash object.
+ * @param  size      [in]  Size of digest in bytes.
  */
-static int we_sha_cleanup(EVP_MD_CTX *ctx)
-{
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha_cleanup");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    wc_ShaFree((wc_Sha*)EVP_MD_CTX_md_data(ctx));
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha_cleanup", 1);
-    return 1;
+#define WE_DIGEST_DIRECT(name, desc, wcType, wcInit, wcUpdate, wcFinal,     \
+                         wcFree, size)                                      \
+static int we_##name##_init(EVP_MD_CTX *ctx)                                \
+{                                                                           \
+    int ret = 1, rc;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_init");                   \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);          \
+                                                                            \
+    rc = wcInit((wcType*)EVP_MD_CTX_md_data(ctx));                          \
+    if (rc != 0) {                                                          \
+        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, #wcInit, rc);                  \
+        ret = 0;                                                            \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_init", ret);              \
+                                                                            \
+    return ret;                                                             \
+}                                                                           \
+                                                                            \
+static int we_##name##_update(EVP_MD_CTX *ctx, const void *data,            \
+                              size_t len)                                   \
+{                                                                           \
+    int ret = 1, rc;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_update");                 \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, data = %p, "     \
+                           "len = %zu]", ctx, data, len);                   \
+                                                                            \
+    rc = wcUpdate((wcType*)EVP_MD_CTX_md_data(ctx), (const byte*)data,      \
+                  (word32)len);                                             \
+    if (rc != 0) {                                                          \
+        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, #wcUpdate, rc);                \
+        ret = 0;                                                            \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_update", ret);            \
+                                                                            \
+    return ret;                                                             \
+}                                                                           \
+                                                                            \
+static int we_##name##_final(EVP_MD_CTX *ctx, unsigned char *md)            \
+{                                                                           \
+    int ret = 1, rc;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_final");                  \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, md = %p]", ctx,  \
+                           md);                                             \
+                                                                            \
+    rc = wcFinal((wcType*)EVP_MD_CTX_md_data(ctx), (byte*)md);              \
+    if (rc != 0) {                                                          \
+        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, #wcFinal, rc);                 \
+        ret = 0;                                                            \
+    }                                                                       \
+    else {                                                                  \
+        WOLFENGINE_MSG(WE_LOG_DIGEST, desc " Digest");                      \
+        WOLFENGINE_BUFFER(WE_LOG_DIGEST, md, size);                         \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_final", ret);             \
+                                                                            \
+    return ret;                                                             \
+}                                                                           \
+                                                                            \
+static int we_##name##_cleanup(EVP_MD_CTX *ctx)                             \
+{                                                                           \
+    wcType *obj;                                                            \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_cleanup");                \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);          \
+                                                                            \
+    /* No data when context never initialized. */                           \
+    obj = (wcType*)EVP_MD_CTX_md_data(ctx);                                 \
+    if (obj != NULL) {                                                      \
+        WE_DIGEST_FREE(wcFree, obj);                                        \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_cleanup", 1);             \
+                                                                            \
+    return 1;                                                               \
 }
 
-/** EVP digest method - SHA-1 using wolfSSL for the implementation. */
-EVP_MD *we_sha1_md = NULL;
-
 /**
- * Initialize the global SHA-1 EVP digest method.
+ * Initialize the EVP digest method.
  *
+ * @param  method    [in]  EVP digest method to modify.
+ * @param  update    [in]  Digest update function of algorithm.
+ * @param  final     [in]  Digest final function of algorithm.
+ * @param  cleanup   [in]  Digest cleanup function of algorithm.
+ * @param  dataSize  [in]  Size of wolfSSL hash object of algorithm.
  * @return  1 on success else failure.
  */
-int we_init_sha_meth()
+static int we_init_digest_meth(EVP_MD *method,
+    int (*update)(EVP_MD_CTX *ctx, const void *data, size_t len),
+    int (*final)(EVP_MD_CTX *ctx, unsigned char *md),
+    int (*cleanup)(EVP_MD_CTX *ctx), int dataSize)
 {
     int ret;
 
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_sha_meth");
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_digest_meth");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [method = %p]", method);
 
-    ret = (we_sha1_md = EVP_MD_meth_new(NID_sha, EVP_PKEY_NONE)) != NULL;
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_init(we_sha1_md, we_sha_init);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_update(we_sha1_md, we_sha_update);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_final(we_sha1_md, we_sha_final);
-    }
+    ret = EVP_MD_meth_set_update(method, update);
     if (ret == 1) {
-        ret = EVP_MD_meth_set_cleanup(we_sha1_md, we_sha_cleanup);
+        ret = EVP_MD_meth_set_final(method, final);
     }
     if (ret == 1) {
-        ret = EVP_MD_meth_set_result_size(we_sha1_md, WC_SHA_DIGEST_SIZE);
+        ret = EVP_MD_meth_set_cleanup(method, cleanup);
     }
     if (ret == 1) {
-        ret = EVP_MD_meth_set_input_blocksize(we_sha1_md, WC_SHA_BLOCK_SIZE);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_app_datasize(we_sha1_md, sizeof(wc_Sha));
-    }
-
-    if ((ret != 1) && (we_sha1_md != NULL)) {
-        EVP_MD_meth_free(we_sha1_md);
+        ret = EVP_MD_meth_set_app_datasize(method, dataSize);
     }
 
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_sha_meth", ret);
-
-    return ret;
-};
-
-#endif /* WE_HAVE_SHA1 && WE_SHA1_DIRECT */
-
-#if defined(WE_HAVE_SHA224) && defined(WE_SHA224_DIRECT)
-
-/*
- * SHA-224
- */
-
-/**
- * Initialize the SHA-224 digest operation using wolfSSL.
- *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha224_init(EVP_MD_CTX *ctx)
-{
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha224_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
+#ifdef WE_HAVE_EVP_PKEY
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+    if (ret == 1) {
+        const int *nids;
+        int cnt;
 
-    rc = wc_InitSha224((wc_Sha224*)EVP_MD_CTX_md_data(ctx));
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_InitSha224", rc);
-        ret = 0;
+        cnt = we_pkey_get_nids(&nids);
+        XMEMCPY(method->required_pkey_type, nids, cnt);
+        method->flags |= EVP_MD_FLAG_PKEY_METHOD_SIGNATURE;
     }
+#endif
+#endif
 
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha224_init", ret);
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_digest_meth", ret);
 
     return ret;
 }
 
-/**
- * Digest some more data with SHA-224 using wolfSSL.
- *
- * @param  ctx   [in]  EVP digest context of operation.
- * @param  data  [in]  More data to digest with SHA-224.
- * @param  len   [in]  Length of data to digest.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha224_update(EVP_MD_CTX *ctx, const void *data, size_t len)
-{
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha224_update");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, data = %p, "
-                           "len = %zu]", ctx, data, len);
-
-    rc = wc_Sha224Update((wc_Sha224*)EVP_MD_CTX_md_data(ctx),
-                         (const byte*)data, (word32)len);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_Sha224Update", rc);
-        ret = 0;
-    }
+#ifdef WE_HAVE_SHA1
+WE_DIGEST_DIRECT(sha1, "SHA-1", wc_Sha, wc_InitSha, wc_ShaUpdate, wc_ShaFinal,
+                 wc_ShaFree, WC_SHA_DIGEST_SIZE)
+#endif
 
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha224_update", ret);
+#ifdef WE_HAVE_SHA224
+WE_DIGEST_DIRECT(sha224, "SHA-224", wc_Sha224, wc_InitSha224, wc_Sha224Update,
+                 wc_Sha224Final, wc_Sha224Free, WC_SHA224_DIGEST_SIZE)
+#endif
 
-    return ret;
-}
+#ifdef WE_HAVE_SHA256
+WE_DIGEST_DIRECT(sha256, "SHA-256", wc_Sha256, wc_InitSha256, wc_Sha256Update,
+                 wc_Sha256Final, wc_Sha256Free, WC_SHA256_DIGEST_SIZE)
+#endif
 
+#ifdef WE_HAVE_SHA384
+#ifdef WE_ALIGNMENT_SAFETY
 /**
- * Finalize the SHA-224 digest operation.
+ * Update a SHA-384 hash object - called through a generic pointer.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @param  md   [in]  SHA-224 digest of data.
- * @return  1 on success and 0 on failure.
+ * @param  sha   [in,out]  wolfSSL SHA-384 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha224_final(EVP_MD_CTX *ctx, unsigned char *md)
+static int we_sha384_obj_update(void *sha, const byte *data, word32 len)
 {
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha224_final");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, md = %p]",
-                           ctx, md);
-
-    rc = wc_Sha224Final((wc_Sha224*)EVP_MD_CTX_md_data(ctx), (byte*)md);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_Sha224Final", rc);
-        ret = 0;
-    }
-    else {
-        WOLFENGINE_MSG(WE_LOG_DIGEST, "SHA-224 Digest");
-        WOLFENGINE_BUFFER(WE_LOG_DIGEST, md, WC_SHA224_DIGEST_SIZE);
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha224_final", ret);
-
-    return ret;
+    return wc_Sha384Update((wc_Sha384 *)sha, data, len);
 }
 
 /**
- * Cleanup the SHA-224 digest object.
+ * Update a SHA-384 hash object avoiding a potential alignment crash.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 for success.
+ * @param  sha   [in,out]  wolfSSL SHA-384 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha224_cleanup(EVP_MD_CTX *ctx)
+static int we_sha384_aligned_update(wc_Sha384 *sha, const byte *data,
+                                    word32 len)
 {
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha224_cleanup");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    wc_Sha224Free((wc_Sha224*)EVP_MD_CTX_md_data(ctx));
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha224_cleanup", 1);
-    return 1;
+    return we_aligned_update(sha, we_sha384_obj_update, sha->buffLen, data,
+                             len);
 }
 
-/** EVP digest method - SHA-224 using wolfSSL for the implementation. */
-EVP_MD *we_sha224_md = NULL;
-
-/**
- * Initialize the global SHA-224 EVP digest method.
- *
- * @return  1 on success else failure.
- */
-int we_init_sha224_meth()
-{
-    int ret;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_sha224_meth");
-
-    ret = (we_sha224_md = EVP_MD_meth_new(NID_sha224, EVP_PKEY_NONE)) != NULL;
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_init(we_sha224_md, we_sha224_init);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_update(we_sha224_md, we_sha224_update);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_final(we_sha224_md, we_sha224_final);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_cleanup(we_sha224_md, we_sha224_cleanup);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_result_size(we_sha224_md, WC_SHA224_DIGEST_SIZE);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_input_blocksize(we_sha224_md,
-                                              WC_SHA224_BLOCK_SIZE);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_app_datasize(we_sha224_md, sizeof(wc_Sha224));
-    }
-
-    if ((ret != 1) && (we_sha224_md != NULL)) {
-        EVP_MD_meth_free(we_sha224_md);
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_sha224_meth", ret);
-
-    return ret;
-};
-
-#endif /* WE_HAVE_SHA224 && WE_SHA224_DIRECT */
-
-#if defined(WE_HAVE_SHA256) && defined(WE_SHA256_DIRECT)
-
-/*
- * SHA-256
- */
+WE_DIGEST_DIRECT(sha384, "SHA-384", wc_Sha384, wc_InitSha384,
+                 we_sha384_aligned_update, wc_Sha384Final, wc_Sha384Free,
+                 WC_SHA384_DIGEST_SIZE)
+#else
+WE_DIGEST_DIRECT(sha384, "SHA-384", wc_Sha384, wc_InitSha384, wc_Sha384Update,
+                 wc_Sha384Final, wc_Sha384Free, WC_SHA384_DIGEST_SIZE)
+#endif
+#endif
 
+#ifdef WE_HAVE_SHA512
+#ifdef WE_ALIGNMENT_SAFETY
 /**
- * Initialize the SHA-256 digest operation using wolfSSL.
+ * Update a SHA-512 hash object - called through a generic pointer.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha   [in,out]  wolfSSL SHA-512 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha256_init(EVP_MD_CTX *ctx)
+static int we_sha512_obj_update(void *sha, const byte *data, word32 len)
 {
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha256_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    rc = wc_InitSha256((wc_Sha256*)EVP_MD_CTX_md_data(ctx));
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_InitSha256", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha256_init", ret);
-
-    return ret;
+    return wc_Sha512Update((wc_Sha512 *)sha, data, len);
 }
 
 /**
- * Digest some more data with SHA-256 using wolfSSL.
+ * Update a SHA-512 hash object avoiding a potential alignment crash.
  *
- * @param  ctx   [in]  EVP digest context of operation.
- * @param  data  [in]  More data to digest with SHA-256.
- * @param  len   [in]  Length of data to digest.
- * @return  1 on success and 0 on failure.
+ * @param  sha   [in,out]  wolfSSL SHA-512 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha256_update(EVP_MD_CTX *ctx, const void *data, size_t len)
+static int we_sha512_aligned_update(wc_Sha512 *sha, const byte *data,
+                                    word32 len)
 {
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha256_update");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, data = %p, "
-                           "len = %zu]", ctx, data, len);
-
-    rc = wc_Sha256Update((wc_Sha256*)EVP_MD_CTX_md_data(ctx),
-                         (const byte*)data, (word32)len);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_Sha256Update", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha256_update", ret);
-
-    return ret;
+    return we_aligned_update(sha, we_sha512_obj_update, sha->buffLen, data,
+                             len);
 }
 
-/**
- * Finalize the SHA-256 digest operation.
- *
- * @param  ctx  [in]  EVP digest context of operation.
- * @param  md   [in]  SHA-256 digest of data.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha256_final(EVP_MD_CTX *ctx, unsigned char *md)
-{
-    int ret = 1, rc;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha256_final");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, md = %p]", ctx, md);
-
-    rc = wc_Sha256Final((wc_Sha256*)EVP_MD_CTX_md_data(ctx), (byte*)md);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_Sha256Final", rc);
-        ret = 0;
-    }
-    else {
-        WOLFENGINE_MSG(WE_LOG_DIGEST, "SHA-256 Digest");
-        WOLFENGINE_BUFFER(WE_LOG_DIGEST, md, WC_SHA256_DIGEST_SIZE);
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha256_final", ret);
-
-    return ret;
-}
+WE_DIGEST_DIRECT(sha512, "SHA-512", wc_Sha512, wc_InitSha512,
+                 we_sha512_aligned_update, wc_Sha512Final, wc_Sha512Free,
+                 WC_SHA512_DIGEST_SIZE)
+#else
+WE_DIGEST_DIRECT(sha512, "SHA-512", wc_Sha512, wc_InitSha512, wc_Sha512Update,
+                 wc_Sha512Final, wc_Sha512Free, WC_SHA512_DIGEST_SIZE)
+#endif
+#endif
 
+#ifdef WE_HAVE_SHA512_224
+#ifdef WE_ALIGNMENT_SAFETY
 /**
- * Cleanup the SHA-256 digest object.
+ * Update a SHA-512/224 hash object - called through a generic pointer.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 for success.
+ * @param  sha   [in,out]  wolfSSL SHA-512 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha256_cleanup(EVP_MD_CTX *ctx)
+static int we_sha512_224_obj_update(void *sha, const byte *data, word32 len)
 {
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha256_cleanup");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    wc_Sha256Free((wc_Sha256*)EVP_MD_CTX_md_data(ctx));
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha256_cleanup", 1);
-    return 1;
+    return wc_Sha512_224Update((wc_Sha512 *)sha, data, len);
 }
 
-/** EVP digest method - SHA-256 using wolfSSL for the implementation. */
-EVP_MD *we_sha256_md = NULL;
-
-/**
- * Initialize the global SHA-256 EVP digest method.
- *
- * @return  1 on success else failure.
- */
-int we_init_sha256_meth()
-{
-    int ret;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_sha256_meth");
-
-    ret = (we_sha256_md = EVP_MD_meth_new(NID_sha256, EVP_PKEY_NONE)) != NULL;
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_init(we_sha256_md, we_sha256_init);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_update(we_sha256_md, we_sha256_update);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_final(we_sha256_md, we_sha256_final);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_cleanup(we_sha256_md, we_sha256_cleanup);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_result_size(we_sha256_md, WC_SHA256_DIGEST_SIZE);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_input_blocksize(we_sha256_md,
-                                              WC_SHA256_BLOCK_SIZE);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_app_datasize(we_sha256_md, sizeof(wc_Sha256));
-    }
-
-    if ((ret != 1) && (we_sha256_md != NULL)) {
-        EVP_MD_meth_free(we_sha256_md);
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_sha256_meth", ret);
-
-    return ret;
-};
-
-#endif /* WE_HAVE_SHA256 && WE_SHA256_DIRECT */
-
-#ifdef WE_USE_HASH
-
-/**
- * Data required to complete a digest operation.
- */
-typedef struct we_Digest
-{
-    /* Hash algorithm object. */
-    wc_HashAlg       hash;
-    /* Hash algorithm ID. */
-    enum wc_HashType hashType;
-} we_Digest;
-
-#ifdef WE_HAVE_SHA1
 /**
- * Initialize the SHA-1 digest operation using wolfSSL.
+ * Update a SHA-512/224 hash object avoiding a potential alignment crash.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha   [in,out]  wolfSSL SHA-512 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha_init(EVP_MD_CTX *ctx)
+static int we_sha512_224_aligned_update(wc_Sha512 *sha, const byte *data,
+                                        word32 len)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha_init", ret);
-
-    return ret;
+    return we_aligned_update(sha, we_sha512_224_obj_update, sha->buffLen,
+                             data, len);
 }
-#endif /* WE_HAVE_SHA1 */
-
-#ifdef WE_HAVE_SHA224
-/**
- * Initialize the SHA-224 digest operation using wolfSSL.
- *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha224_init(EVP_MD_CTX *ctx)
-{
-    int ret = 1, rc;
-    we_Digest *digest;
 
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha224_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA224;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha224_init", ret);
-
-    return ret;
-}
+WE_DIGEST_DIRECT(sha512_224, "SHA-512/224", wc_Sha512, wc_InitSha512_224,
+                 we_sha512_224_aligned_update, wc_Sha512_224Final,
+                 wc_Sha512_224Free, WC_SHA512_224_DIGEST_SIZE)
+#else
+WE_DIGEST_DIRECT(sha512_224, "SHA-512/224", wc_Sha512, wc_InitSha512_224,
+                 wc_Sha512_224Update, wc_Sha512_224Final, wc_Sha512_224Free,
+                 WC_SHA512_224_DIGEST_SIZE)
 #endif
-
-#ifdef WE_HAVE_SHA256
-/**
- * Initialize the SHA-256 digest operation using wolfSSL.
- *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
- */
-static int we_sha256_init(EVP_MD_CTX *ctx)
-{
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha256_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA256;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha256_init", ret);
-
-    return ret;
-}
 #endif
 
-#ifdef WE_HAVE_SHA384
+#ifdef WE_HAVE_SHA512_256
+#ifdef WE_ALIGNMENT_SAFETY
 /**
- * Initialize the SHA-384 digest operation using wolfSSL.
+ * Update a SHA-512/256 hash object - called through a generic pointer.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha   [in,out]  wolfSSL SHA-512 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha384_init(EVP_MD_CTX *ctx)
+static int we_sha512_256_obj_update(void *sha, const byte *data, word32 len)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha384_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA384;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha384_init", ret);
-
-    return ret;
+    return wc_Sha512_256Update((wc_Sha512 *)sha, data, len);
 }
-#endif
 
-#ifdef WE_HAVE_SHA512
 /**
- * Initialize the SHA-512 digest operation using wolfSSL.
+ * Update a SHA-512/256 hash object avoiding a potential alignment crash.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha   [in,out]  wolfSSL SHA-512 hash object.
+ * @param  data  [in]      More data to digest.
+ * @param  len   [in]      Length of data to digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha512_init(EVP_MD_CTX *ctx)
+static int we_sha512_256_aligned_update(wc_Sha512 *sha, const byte *data,
+                                        word32 len)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha512_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA512;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha512_init", ret);
-
-    return ret;
+    return we_aligned_update(sha, we_sha512_256_obj_update, sha->buffLen,
+                             data, len);
 }
+
+WE_DIGEST_DIRECT(sha512_256, "SHA-512/256", wc_Sha512, wc_InitSha512_256,
+                 we_sha512_256_aligned_update, wc_Sha512_256Final,
+                 wc_Sha512_256Free, WC_SHA512_256_DIGEST_SIZE)
+#else
+WE_DIGEST_DIRECT(sha512_256, "SHA-512/256", wc_Sha512, wc_InitSha512_256,
+                 wc_Sha512_256Update, wc_Sha512_256Final, wc_Sha512_256Free,
+                 WC_SHA512_256_DIGEST_SIZE)
+#endif
 #endif
 
 #ifdef WE_HAVE_SHA3_224
 /**
- * Initialize the SHA3-224 digest operation using wolfSSL.
+ * Initialize a wolfSSL SHA3-224 hash object.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha3  [in,out]  wolfSSL SHA-3 hash object.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha3_224_init(EVP_MD_CTX *ctx)
+static int we_init_sha3_224(wc_Sha3 *sha3)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha3_224_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA3_224;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha3_224_init", ret);
-
-    return ret;
+    return wc_InitSha3_224(sha3, NULL, INVALID_DEVID);
 }
+
+WE_DIGEST_DIRECT(sha3_224, "SHA3-224", wc_Sha3, we_init_sha3_224,
+                 wc_Sha3_224_Update, wc_Sha3_224_Final, wc_Sha3_224_Free,
+                 WC_SHA3_224_DIGEST_SIZE)
 #endif
 
 #ifdef WE_HAVE_SHA3_256
 /**
- * Initialize the SHA3-256 digest operation using wolfSSL.
+ * Initialize a wolfSSL SHA3-256 hash object.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha3  [in,out]  wolfSSL SHA-3 hash object.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha3_256_init(EVP_MD_CTX *ctx)
+static int we_init_sha3_256(wc_Sha3 *sha3)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha3_256_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA3_256;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha3_256_init", ret);
-
-    return ret;
+    return wc_InitSha3_256(sha3, NULL, INVALID_DEVID);
 }
+
+WE_DIGEST_DIRECT(sha3_256, "SHA3-256", wc_Sha3, we_init_sha3_256,
+                 wc_Sha3_256_Update, wc_Sha3_256_Final, wc_Sha3_256_Free,
+                 WC_SHA3_256_DIGEST_SIZE)
 #endif
 
 #ifdef WE_HAVE_SHA3_384
 /**
- * Initialize the SHA3-384 digest operation using wolfSSL.
+ * Initialize a wolfSSL SHA3-384 hash object.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha3  [in,out]  wolfSSL SHA-3 hash object.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha3_384_init(EVP_MD_CTX *ctx)
+static int we_init_sha3_384(wc_Sha3 *sha3)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha3_384_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA3_384;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha3_384_init", ret);
-
-    return ret;
+    return wc_InitSha3_384(sha3, NULL, INVALID_DEVID);
 }
+
+WE_DIGEST_DIRECT(sha3_384, "SHA3-384", wc_Sha3, we_init_sha3_384,
+                 wc_Sha3_384_Update, wc_Sha3_384_Final, wc_Sha3_384_Free,
+                 WC_SHA3_384_DIGEST_SIZE)
 #endif
 
 #ifdef WE_HAVE_SHA3_512
 /**
- * Initialize the SHA3-512 digest operation using wolfSSL.
+ * Initialize a wolfSSL SHA3-512 hash object.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 on success and 0 on failure.
+ * @param  sha3  [in,out]  wolfSSL SHA-3 hash object.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_sha3_512_init(EVP_MD_CTX *ctx)
+static int we_init_sha3_512(wc_Sha3 *sha3)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_sha3_512_init");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-    digest->hashType = WC_HASH_TYPE_SHA3_512;
-
-    WOLFENGINE_MSG(WE_LOG_DIGEST, "Initializing wolfCrypt wc_HashAlg "
-                   "structure: %p", &digest->hash);
-    rc = wc_HashInit(&digest->hash, digest->hashType);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashInit", rc);
-        ret = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_sha3_512_init", ret);
-
-    return ret;
+    return wc_InitSha3_512(sha3, NULL, INVALID_DEVID);
 }
+
+WE_DIGEST_DIRECT(sha3_512, "SHA3-512", wc_Sha3, we_init_sha3_512,
+                 wc_Sha3_512_Update, wc_Sha3_512_Final, wc_Sha3_512_Free,
+                 WC_SHA3_512_DIGEST_SIZE)
 #endif
 
+#ifdef WE_HAVE_BLAKE2B
 /**
- * Digest some more data using wolfSSL.
+ * Initialize a wolfSSL BLAKE2b hash object for a 512-bit digest.
  *
- * @param  ctx   [in]  EVP digest context of operation.
- * @param  data  [in]  More data to digest with SHA-256.
- * @param  len   [in]  Length of data to digest.
- * @return  1 on success and 0 on failure.
+ * @param  blake2  [in,out]  wolfSSL BLAKE2b hash object.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-
-static int we_digest_update(EVP_MD_CTX *ctx, const void *data, size_t len)
+static int we_init_blake2b(Blake2b *blake2)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_digest_update");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, data = %p, "
-                           "len = %zu]", ctx, data, len);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-
-    if (digest == NULL) {
-        WOLFENGINE_ERROR_MSG(WE_LOG_DIGEST, "digest was NULL");
-        ret = 0;
-    }
-
-#ifdef WE_ALIGNMENT_SAFETY
-    const word32 ALIGNMENT_REQ = 8;
-    word32 add = 0;
-    byte* tmp = NULL;
-    if (ret == 1 && (digest->hashType == WC_HASH_TYPE_SHA384 ||
-        digest->hashType == WC_HASH_TYPE_SHA512))  {
-        add = len > (WC_SHA512_BLOCK_SIZE - digest->hash.sha512.buffLen) ?
-              (WC_SHA512_BLOCK_SIZE - digest->hash.sha512.buffLen) : len;
-    }
-    /* If the conditions below are satisfied, just calling wc_HashUpdate with
-     * the passed in buffer and length can cause a memory alignment crash on
-     * certain platforms. The alternate algorithm used below (2 calls to
-     * wc_HashUpdate) avoids this crash. */
-    if (len > 0 && add > 0 && ((len - add) >= WC_SHA512_BLOCK_SIZE) &&
-        (((unsigned long)data + add) % ALIGNMENT_REQ != 0)) {
-        /* Update the hash with "add" bytes of data, which will result in
-         * an update with a full WC_SHA512_BLOCK_SIZE number of bytes with no
-         * leftovers. */
-        rc = wc_HashUpdate(&digest->hash, digest->hashType,
-            (const byte*)data, add);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashUpdate", rc);
-            ret = 0;
-        }
-        if (ret == 1) {
-            /* Allocate new, aligned buffer. */
-            tmp = (byte*)XMALLOC(WC_SHA512_BLOCK_SIZE, NULL, DYNAMIC_TYPE_TMP_BUFFER);
-            if (tmp == NULL) {
-                WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_DIGEST, "XMALLOC",
-                    tmp);
-                ret = 0;
-            }
-        }
-        if (ret == 1) {
-            /* Copy remaining data from the unaligned buffer to the aligned one
-             * and update the hash iteratively, one block's worth of data at a
-             * time. */
-            byte* nextData = (byte*)data + add;
-            for (size_t remaining = len - add; remaining > 0;) {
-                size_t nextLen = (remaining <= WC_SHA512_BLOCK_SIZE) ?
-                    remaining : WC_SHA512_BLOCK_SIZE;
-                XMEMCPY(tmp, nextData, nextLen);
-                rc = wc_HashUpdate(&digest->hash, digest->hashType,
-                    (const byte*)tmp, nextLen);
-                if (rc != 0) {
-                    WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashUpdate", rc);
-                    ret = 0;
-                    break;
-                }
-                nextData += nextLen;
-                remaining -= nextLen;
-            }
-        }
-
-        if (tmp != NULL) {
-            XFREE(tmp, NULL, DYNAMIC_TYPE_TMP_BUFFER);
-        }
-    }
-    else
-#endif
-    if (ret == 1) {
-        rc = wc_HashUpdate(&digest->hash, digest->hashType, (const byte*)data,
-                           (word32)len);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashUpdate", rc);
-            ret = 0;
-        }
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_digest_update", ret);
-
-    return ret;
+    return wc_InitBlake2b(blake2, BLAKE2B_OUTBYTES);
 }
 
 /**
- * Finalize the digest operation.
+ * Produce the 512-bit BLAKE2b digest.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @param  md   [in]  SHA-256 digest of data.
- * @return  1 on success and 0 on failure.
+ * @param  blake2  [in,out]  wolfSSL BLAKE2b hash object.
+ * @param  md      [out]     Buffer to hold digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_digest_final(EVP_MD_CTX *ctx, unsigned char *md)
+static int we_blake2b_final(Blake2b *blake2, byte *md)
 {
-    int ret = 1, rc;
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_digest_final");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, md = %p]",
-                           ctx, md);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-
-    rc = wc_HashFinal(&digest->hash, digest->hashType, (byte*)md);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashFinal", rc);
-        ret = 0;
-    }
-    else {
-        WOLFENGINE_MSG(WE_LOG_DIGEST, "Message Digest");
-        WOLFENGINE_BUFFER(WE_LOG_DIGEST, md,
-                          wc_HashGetDigestSize(digest->hashType));
-    }
+    return wc_Blake2bFinal(blake2, md, BLAKE2B_OUTBYTES);
+}
 
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_digest_final", ret);
+/* wolfSSL BLAKE2b hash object holds no allocated data. */
+#define we_blake2b_free(blake2)    (void)(blake2)
 
-    return ret;
-}
+WE_DIGEST_DIRECT(blake2b512, "BLAKE2b-512", Blake2b, we_init_blake2b,
+                 wc_Blake2bUpdate, we_blake2b_final, we_blake2b_free,
+                 BLAKE2B_OUTBYTES)
+#endif
 
+#ifdef WE_HAVE_BLAKE2S
 /**
- * Cleanup the digest object.
+ * Initialize a wolfSSL BLAKE2s hash object for a 256-bit digest.
  *
- * @param  ctx  [in]  EVP digest context of operation.
- * @return  1 for success.
+ * @param  blake2  [in,out]  wolfSSL BLAKE2s hash object.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_digest_cleanup(EVP_MD_CTX *ctx)
+static int we_init_blake2s(Blake2s *blake2)
 {
-    int ret = 1, rc;
-#if !defined(HAVE_FIPS_VERSION) || HAVE_FIPS_VERSION >= 2
-    we_Digest *digest;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_digest_cleanup");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);
-
-    digest = (we_Digest *)EVP_MD_CTX_md_data(ctx);
-
-    /* Free the digest unless no hash initialized. */
-    if ((digest != NULL) && (digest->hashType != 0)) {
-        rc = wc_HashFree(&digest->hash, digest->hashType);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, "wc_HashFree", rc);
-            ret = 0;
-        }
-    }
-#else
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_digest_cleanup");
-
-    (void)ctx;
-    ret = 1; 
-#endif
-
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_digest_cleanup", ret);
-    return ret;
+    return wc_InitBlake2s(blake2, BLAKE2S_OUTBYTES);
 }
 
 /**
- * Initialize the EVP digest method.
+ * Produce the 256-bit BLAKE2s digest.
  *
- * @param  method  [in]  EVP digest method to modify.
- * @return  1 on success else failure.
+ * @param  blake2  [in,out]  wolfSSL BLAKE2s hash object.
+ * @param  md      [out]     Buffer to hold digest.
+ * @return  0 on success and wolfCrypt error code on failure.
  */
-static int we_init_digest_meth(EVP_MD *method)
+static int we_blake2s_final(Blake2s *blake2, byte *md)
 {
-    int ret;
-
-    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_digest_meth");
-    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [method = %p]", method);
-
-    ret = EVP_MD_meth_set_update(method, we_digest_update);
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_final(method, we_digest_final);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_cleanup(method, we_digest_cleanup);
-    }
-    if (ret == 1) {
-        ret = EVP_MD_meth_set_app_datasize(method, sizeof(we_Digest));
-    }
-
-#ifdef WE_HAVE_EVP_PKEY
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-    if (ret == 1) {
-        const int *nids;
-        int cnt;
-
-        cnt = we_pkey_get_nids(&nids);
-        XMEMCPY(method->required_pkey_type, nids, cnt);
-        method->flags |= EVP_MD_FLAG_PKEY_METHOD_SIGNATURE;
-    }
-#endif
-#endif
+    return wc_Blake2sFinal(blake2, md, BLAKE2S_OUTBYTES);
+}
 
-    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_digest_meth", ret);
+/* wolfSSL BLAKE2s hash object holds no allocated data. */
+#define we_blake2s_free(blake2)    (void)(blake2)
 
-    return ret;
-}
+WE_DIGEST_DIRECT(blake2s256, "BLAKE2s-256", Blake2s, we_init_blake2s,
+                 wc_Blake2sUpdate, we_blake2s_final, we_blake2s_free,
+                 BLAKE2S_OUTBYTES)
+#endif
 
 #ifdef WE_HAVE_SHA1
 /** EVP digest method - SHA-1 using wolfSSL for the implementation. */
@@ -1011,7 +502,7 @@ int we_init_sha_meth()
 
     ret = (we_sha1_md = EVP_MD_meth_new(NID_sha1, EVP_PKEY_NONE)) != NULL;
     if (ret == 1) {
-        ret = EVP_MD_meth_set_init(we_sha1_md, we_sha_init);
+        ret = EVP_MD_meth_set_init(we_sha1_md, we_sha1_init);
     }
     if (ret == 1) {
         ret = EVP_MD_meth_set_result_size(we_sha1_md, WC_SHA_DIGEST_SIZE);
@@ -1020,7 +511,9 @@ int we_init_sha_meth()
         ret = EVP_MD_meth_set_input_blocksize(we_sha1_md, WC_SHA_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha1_md);
+        ret = we_init_digest_meth(we_sha1_md, we_sha1_update,
+                                   we_sha1_final, we_sha1_cleanup,
+                                   sizeof(wc_Sha));
     }
 
     if ((ret != 1) && (we_sha1_md != NULL)) {
@@ -1055,13 +548,15 @@ int we_init_ecdsa_sha1_meth()
     ret = (we_ecdsa_sha1_md =
         EVP_MD_meth_new(NID_ecdsa_with_SHA1, EVP_PKEY_NONE)) != NULL;
     if (ret == 1) {
-        ret = EVP_MD_meth_set_init(we_ecdsa_sha1_md, we_sha_init);
+        ret = EVP_MD_meth_set_init(we_ecdsa_sha1_md, we_sha1_init);
     }
     if (ret == 1) {
         ret = EVP_MD_meth_set_result_size(we_ecdsa_sha1_md, WC_SHA_DIGEST_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_ecdsa_sha1_md);
+        ret = we_init_digest_meth(we_ecdsa_sha1_md, we_sha1_update,
+                                   we_sha1_final, we_sha1_cleanup,
+                                   sizeof(wc_Sha));
     }
 
     if ((ret != 1) && (we_ecdsa_sha1_md != NULL)) {
@@ -1102,7 +597,9 @@ int we_init_sha224_meth()
                                               WC_SHA224_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha224_md);
+        ret = we_init_digest_meth(we_sha224_md, we_sha224_update,
+                                   we_sha224_final, we_sha224_cleanup,
+                                   sizeof(wc_Sha224));
     }
 
     if ((ret != 1) && (we_sha224_md != NULL)) {
@@ -1142,7 +639,9 @@ int we_init_sha256_meth()
                                               WC_SHA256_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha256_md);
+        ret = we_init_digest_meth(we_sha256_md, we_sha256_update,
+                                   we_sha256_final, we_sha256_cleanup,
+                                   sizeof(wc_Sha256));
     }
 
     if ((ret != 1) && (we_sha256_md != NULL)) {
@@ -1182,7 +681,9 @@ int we_init_sha384_meth()
                                               WC_SHA384_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha384_md);
+        ret = we_init_digest_meth(we_sha384_md, we_sha384_update,
+                                   we_sha384_final, we_sha384_cleanup,
+                                   sizeof(wc_Sha384));
     }
 
     if ((ret != 1) && (we_sha384_md != NULL)) {
@@ -1222,7 +723,9 @@ int we_init_sha512_meth()
                                               WC_SHA512_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha512_md);
+        ret = we_init_digest_meth(we_sha512_md, we_sha512_update,
+                                   we_sha512_final, we_sha512_cleanup,
+                                   sizeof(wc_Sha512));
     }
 
     if ((ret != 1) && (we_sha512_md != NULL)) {
@@ -1235,6 +738,94 @@ int we_init_sha512_meth()
 };
 #endif
 
+#ifdef WE_HAVE_SHA512_224
+/** EVP digest method - SHA-512/224 using wolfSSL for the implementation. */
+EVP_MD *we_sha512_224_md = NULL;
+
+/**
+ * Initialize the global SHA-512/224 EVP digest method.
+ *
+ * @return  1 on success else failure.
+ */
+int we_init_sha512_224_meth()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_sha512_224_meth");
+
+    ret = (we_sha512_224_md = EVP_MD_meth_new(NID_sha512_224,
+                                              EVP_PKEY_NONE)) != NULL;
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_init(we_sha512_224_md, we_sha512_224_init);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_result_size(we_sha512_224_md,
+                                          WC_SHA512_224_DIGEST_SIZE);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_input_blocksize(we_sha512_224_md,
+                                              WC_SHA512_BLOCK_SIZE);
+    }
+    if (ret == 1) {
+        ret = we_init_digest_meth(we_sha512_224_md, we_sha512_224_update,
+                                  we_sha512_224_final, we_sha512_224_cleanup,
+                                  sizeof(wc_Sha512));
+    }
+
+    if ((ret != 1) && (we_sha512_224_md != NULL)) {
+        EVP_MD_meth_free(we_sha512_224_md);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_sha512_224_meth", ret);
+
+    return ret;
+};
+#endif
+
+#ifdef WE_HAVE_SHA512_256
+/** EVP digest method - SHA-512/256 using wolfSSL for the implementation. */
+EVP_MD *we_sha512_256_md = NULL;
+
+/**
+ * Initialize the global SHA-512/256 EVP digest method.
+ *
+ * @return  1 on success else failure.
+ */
+int we_init_sha512_256_meth()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_sha512_256_meth");
+
+    ret = (we_sha512_256_md = EVP_MD_meth_new(NID_sha512_256,
+                                              EVP_PKEY_NONE)) != NULL;
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_init(we_sha512_256_md, we_sha512_256_init);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_result_size(we_sha512_256_md,
+                                          WC_SHA512_256_DIGEST_SIZE);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_input_blocksize(we_sha512_256_md,
+                                              WC_SHA512_BLOCK_SIZE);
+    }
+    if (ret == 1) {
+        ret = we_init_digest_meth(we_sha512_256_md, we_sha512_256_update,
+                                  we_sha512_256_final, we_sha512_256_cleanup,
+                                  sizeof(wc_Sha512));
+    }
+
+    if ((ret != 1) && (we_sha512_256_md != NULL)) {
+        EVP_MD_meth_free(we_sha512_256_md);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_sha512_256_meth", ret);
+
+    return ret;
+};
+#endif
+
 #ifdef WE_HAVE_SHA3_224
 /** EVP digest method - SHA3-224 using wolfSSL for the implementation. */
 EVP_MD *we_sha3_224_md = NULL;
@@ -1264,7 +855,9 @@ int we_init_sha3_224_meth()
                                               WC_SHA3_224_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha3_224_md);
+        ret = we_init_digest_meth(we_sha3_224_md, we_sha3_224_update,
+                                   we_sha3_224_final, we_sha3_224_cleanup,
+                                   sizeof(wc_Sha3));
     }
 
     if ((ret != 1) && (we_sha3_224_md != NULL)) {
@@ -1306,7 +899,9 @@ int we_init_sha3_256_meth()
                                               WC_SHA3_256_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha3_256_md);
+        ret = we_init_digest_meth(we_sha3_256_md, we_sha3_256_update,
+                                   we_sha3_256_final, we_sha3_256_cleanup,
+                                   sizeof(wc_Sha3));
     }
 
     if ((ret != 1) && (we_sha3_256_md != NULL)) {
@@ -1348,7 +943,9 @@ int we_init_sha3_384_meth()
                                               WC_SHA3_384_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha3_384_md);
+        ret = we_init_digest_meth(we_sha3_384_md, we_sha3_384_update,
+                                   we_sha3_384_final, we_sha3_384_cleanup,
+                                   sizeof(wc_Sha3));
     }
 
     if ((ret != 1) && (we_sha3_384_md != NULL)) {
@@ -1390,7 +987,9 @@ int we_init_sha3_512_meth()
                                               WC_SHA3_512_BLOCK_SIZE);
     }
     if (ret == 1) {
-        ret = we_init_digest_meth(we_sha3_512_md);
+        ret = we_init_digest_meth(we_sha3_512_md, we_sha3_512_update,
+                                   we_sha3_512_final, we_sha3_512_cleanup,
+                                   sizeof(wc_Sha3));
     }
 
     if ((ret != 1) && (we_sha3_512_md != NULL)) {
@@ -1403,6 +1002,598 @@ int we_init_sha3_512_meth()
 };
 #endif
 
-#endif /* WE_USE_HASH */
+#if defined(WE_HAVE_SHAKE128) || defined(WE_HAVE_SHAKE256)
+/*
+ * Extendable-output digest methods
+ *
+ * The length of output is set with EVP_MD_CTRL_XOF_LEN by
+ * EVP_DigestFinalXOF() and defaults to the security strength in bytes. The
+ * wolfSSL final function squeezes out whole blocks straight into the caller's
+ * buffer so large outputs are never buffered.
+ */
+
+/** Default output size of SHAKE128 in bytes - as OpenSSL. */
+#define WE_SHAKE128_DIGEST_SIZE     16
+/** Default output size of SHAKE256 in bytes - as OpenSSL. */
+#define WE_SHAKE256_DIGEST_SIZE     32
+/** Rate of SHAKE128 in bytes. */
+#define WE_SHAKE128_BLOCK_SIZE      168
+/** Rate of SHAKE256 in bytes. */
+#define WE_SHAKE256_BLOCK_SIZE      136
+
+/** Data for an extendable-output digest operation. */
+typedef struct we_Shake
+{
+    /** wolfSSL SHAKE object. */
+    wc_Shake shake;
+    /** Number of bytes to output on final. */
+    size_t   outLen;
+} we_Shake;
+
+/**
+ * Define the init, update, final, cleanup and ctrl functions of an EVP
+ * digest method for a wolfSSL SHAKE algorithm.
+ *
+ * @param  name      [in]  Name of algorithm in function names - e.g. shake128.
+ * @param  desc      [in]  Name of algorithm in log messages - e.g. "SHAKE128".
+ * @param  wcInit    [in]  wolfSSL function initializing the SHAKE object.
+ * @param  wcUpdate  [in]  wolfSSL function absorbing more data.
+ * @param  wcFinal   [in]  wolfSSL function squeezing out the output.
+ * @param  wcFree    [in]  wolfSSL function freeing the SHAKE object.
+ * @param  size      [in]  Default size of output in bytes.
+ */
+#define WE_DIGEST_XOF(name, desc, wcInit, wcUpdate, wcFinal, wcFree, size)  \
+static int we_##name##_init(EVP_MD_CTX *ctx)                                \
+{                                                                           \
+    int ret = 1, rc;                                                        \
+    we_Shake *shake;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_init");                   \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);          \
+                                                                            \
+    shake = (we_Shake*)EVP_MD_CTX_md_data(ctx);                             \
+    rc = wcInit(&shake->shake, NULL, INVALID_DEVID);                        \
+    if (rc != 0) {                                                          \
+        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, #wcInit, rc);                  \
+        ret = 0;                                                            \
+    }                                                                       \
+    else {                                                                  \
+        shake->outLen = size;                                               \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_init", ret);              \
+                                                                            \
+    return ret;                                                             \
+}                                                                           \
+                                                                            \
+static int we_##name##_update(EVP_MD_CTX *ctx, const void *data,            \
+                              size_t len)                                   \
+{                                                                           \
+    int ret = 1, rc;                                                        \
+    we_Shake *shake;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_update");                 \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, data = %p, "     \
+                           "len = %zu]", ctx, data, len);                   \
+                                                                            \
+    shake = (we_Shake*)EVP_MD_CTX_md_data(ctx);                             \
+    rc = wcUpdate(&shake->shake, (const byte*)data, (word32)len);           \
+    if (rc != 0) {                                                          \
+        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, #wcUpdate, rc);                \
+        ret = 0;                                                            \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_update", ret);            \
+                                                                            \
+    return ret;                                                             \
+}                                                                           \
+                                                                            \
+static int we_##name##_final(EVP_MD_CTX *ctx, unsigned char *md)            \
+{                                                                           \
+    int ret = 1, rc;                                                        \
+    we_Shake *shake;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_final");                  \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, md = %p]", ctx,  \
+                           md);                                             \
+                                                                            \
+    shake = (we_Shake*)EVP_MD_CTX_md_data(ctx);                             \
+    rc = wcFinal(&shake->shake, (byte*)md, (word32)shake->outLen);          \
+    if (rc != 0) {                                                          \
+        WOLFENGINE_ERROR_FUNC(WE_LOG_DIGEST, #wcFinal, rc);                 \
+        ret = 0;                                                            \
+    }                                                                       \
+    else {                                                                  \
+        WOLFENGINE_MSG(WE_LOG_DIGEST, desc " Digest");                      \
+        WOLFENGINE_BUFFER(WE_LOG_DIGEST, md, (word32)shake->outLen);        \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_final", ret);             \
+                                                                            \
+    return ret;                                                             \
+}                                                                           \
+                                                                            \
+static int we_##name##_cleanup(EVP_MD_CTX *ctx)                             \
+{                                                                           \
+    we_Shake *shake;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_cleanup");                \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p]", ctx);          \
+                                                                            \
+    /* No data when context never initialized. */                           \
+    shake = (we_Shake*)EVP_MD_CTX_md_data(ctx);                             \
+    if (shake != NULL) {                                                    \
+        wcFree(&shake->shake);                                              \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_cleanup", 1);             \
+                                                                            \
+    return 1;                                                               \
+}                                                                           \
+                                                                            \
+static int we_##name##_ctrl(EVP_MD_CTX *ctx, int cmd, int p1, void *p2)     \
+{                                                                           \
+    int ret = 1;                                                            \
+    we_Shake *shake;                                                        \
+                                                                            \
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_" #name "_ctrl");                   \
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [ctx = %p, cmd = %d, "      \
+                           "p1 = %d, p2 = %p]", ctx, cmd, p1, p2);          \
+                                                                            \
+    shake = (we_Shake*)EVP_MD_CTX_md_data(ctx);                             \
+    switch (cmd) {                                                          \
+        case EVP_MD_CTRL_XOF_LEN:                                           \
+            /* Length of output for next final. */                          \
+            if ((shake == NULL) || (p1 < 0)) {                              \
+                WOLFENGINE_ERROR_MSG(WE_LOG_DIGEST, "Invalid XOF length");  \
+                ret = 0;                                                    \
+            }                                                               \
+            else {                                                          \
+                shake->outLen = (size_t)p1;                                 \
+            }                                                               \
+            break;                                                          \
+        default:                                                            \
+            WOLFENGINE_ERROR_MSG(WE_LOG_DIGEST, "Unsupported ctrl type");   \
+            ret = 0;                                                        \
+            break;                                                          \
+    }                                                                       \
+                                                                            \
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_" #name "_ctrl", ret);              \
+                                                                            \
+    return ret;                                                             \
+}
+
+/**
+ * Initialize an extendable-output EVP digest method.
+ *
+ * @param  method     [in]  EVP digest method to modify.
+ * @param  init       [in]  Digest init function of algorithm.
+ * @param  update     [in]  Digest update function of algorithm.
+ * @param  final      [in]  Digest final function of algorithm.
+ * @param  cleanup    [in]  Digest cleanup function of algorithm.
+ * @param  ctrl       [in]  Digest ctrl function of algorithm.
+ * @param  size       [in]  Default size of output in bytes.
+ * @param  blockSize  [in]  Rate of algorithm in bytes.
+ * @return  1 on success else failure.
+ */
+static int we_init_xof_meth(EVP_MD *method, int (*init)(EVP_MD_CTX *ctx),
+    int (*update)(EVP_MD_CTX *ctx, const void *data, size_t len),
+    int (*final)(EVP_MD_CTX *ctx, unsigned char *md),
+    int (*cleanup)(EVP_MD_CTX *ctx),
+    int (*ctrl)(EVP_MD_CTX *ctx, int cmd, int p1, void *p2), int size,
+    int blockSize)
+{
+    int ret;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_xof_meth");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [method = %p]", method);
+
+    ret = EVP_MD_meth_set_init(method, init);
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_result_size(method, size);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_input_blocksize(method, blockSize);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_flags(method, EVP_MD_FLAG_XOF);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_ctrl(method, ctrl);
+    }
+    if (ret == 1) {
+        ret = we_init_digest_meth(method, update, final, cleanup,
+                                  sizeof(we_Shake));
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_xof_meth", ret);
+
+    return ret;
+}
+#endif
+
+#ifdef WE_HAVE_SHAKE128
+WE_DIGEST_XOF(shake128, "SHAKE128", wc_InitShake128, wc_Shake128_Update,
+              wc_Shake128_Final, wc_Shake128_Free, WE_SHAKE128_DIGEST_SIZE)
+
+/** EVP digest method - SHAKE128 using wolfSSL for the implementation. */
+EVP_MD *we_shake128_md = NULL;
+
+/**
+ * Initialize the global SHAKE128 EVP digest method.
+ *
+ * @return  1 on success else failure.
+ */
+int we_init_shake128_meth()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_shake128_meth");
+
+    ret = (we_shake128_md = EVP_MD_meth_new(NID_shake128,
+                                            EVP_PKEY_NONE)) != NULL;
+    if (ret == 1) {
+        ret = we_init_xof_meth(we_shake128_md, we_shake128_init,
+                               we_shake128_update, we_shake128_final,
+                               we_shake128_cleanup, we_shake128_ctrl,
+                               WE_SHAKE128_DIGEST_SIZE,
+                               WE_SHAKE128_BLOCK_SIZE);
+    }
+
+    if ((ret != 1) && (we_shake128_md != NULL)) {
+        EVP_MD_meth_free(we_shake128_md);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_shake128_meth", ret);
+
+    return ret;
+};
+#endif
+
+#ifdef WE_HAVE_SHAKE256
+WE_DIGEST_XOF(shake256, "SHAKE256", wc_InitShake256, wc_Shake256_Update,
+              wc_Shake256_Final, wc_Shake256_Free, WE_SHAKE256_DIGEST_SIZE)
+
+/** EVP digest method - SHAKE256 using wolfSSL for the implementation. */
+EVP_MD *we_shake256_md = NULL;
+
+/**
+ * Initialize the global SHAKE256 EVP digest method.
+ *
+ * @return  1 on success else failure.
+ */
+int we_init_shake256_meth()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_shake256_meth");
+
+    ret = (we_shake256_md = EVP_MD_meth_new(NID_shake256,
+                                            EVP_PKEY_NONE)) != NULL;
+    if (ret == 1) {
+        ret = we_init_xof_meth(we_shake256_md, we_shake256_init,
+                               we_shake256_update, we_shake256_final,
+                               we_shake256_cleanup, we_shake256_ctrl,
+                               WE_SHAKE256_DIGEST_SIZE,
+                               WE_SHAKE256_BLOCK_SIZE);
+    }
+
+    if ((ret != 1) && (we_shake256_md != NULL)) {
+        EVP_MD_meth_free(we_shake256_md);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_shake256_meth", ret);
+
+    return ret;
+};
+#endif
+
+#ifdef WE_HAVE_BLAKE2B
+/** EVP digest method - BLAKE2b-512 using wolfSSL for the implementation. */
+EVP_MD *we_blake2b512_md = NULL;
+
+/**
+ * Initialize the global BLAKE2b-512 EVP digest method.
+ *
+ * @return  1 on success else failure.
+ */
+int we_init_blake2b512_meth()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_blake2b512_meth");
+
+    ret = (we_blake2b512_md = EVP_MD_meth_new(NID_blake2b512,
+                                              EVP_PKEY_NONE)) != NULL;
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_init(we_blake2b512_md, we_blake2b512_init);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_result_size(we_blake2b512_md,
+                                          BLAKE2B_OUTBYTES);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_input_blocksize(we_blake2b512_md,
+                                              BLAKE2B_BLOCKBYTES);
+    }
+    if (ret == 1) {
+        ret = we_init_digest_meth(we_blake2b512_md, we_blake2b512_update,
+                                  we_blake2b512_final, we_blake2b512_cleanup,
+                                  sizeof(Blake2b));
+    }
+
+    if ((ret != 1) && (we_blake2b512_md != NULL)) {
+        EVP_MD_meth_free(we_blake2b512_md);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_blake2b512_meth", ret);
+
+    return ret;
+};
+#endif
+
+#ifdef WE_HAVE_BLAKE2S
+/** EVP digest method - BLAKE2s-256 using wolfSSL for the implementation. */
+EVP_MD *we_blake2s256_md = NULL;
+
+/**
+ * Initialize the global BLAKE2s-256 EVP digest method.
+ *
+ * @return  1 on success else failure.
+ */
+int we_init_blake2s256_meth()
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_init_blake2s256_meth");
+
+    ret = (we_blake2s256_md = EVP_MD_meth_new(NID_blake2s256,
+                                              EVP_PKEY_NONE)) != NULL;
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_init(we_blake2s256_md, we_blake2s256_init);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_result_size(we_blake2s256_md,
+                                          BLAKE2S_OUTBYTES);
+    }
+    if (ret == 1) {
+        ret = EVP_MD_meth_set_input_blocksize(we_blake2s256_md,
+                                              BLAKE2S_BLOCKBYTES);
+    }
+    if (ret == 1) {
+        ret = we_init_digest_meth(we_blake2s256_md, we_blake2s256_update,
+                                  we_blake2s256_final, we_blake2s256_cleanup,
+                                  sizeof(Blake2s));
+    }
+
+    if ((ret != 1) && (we_blake2s256_md != NULL)) {
+        EVP_MD_meth_free(we_blake2s256_md);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_init_blake2s256_meth", ret);
+
+    return ret;
+};
+#endif
+
+#ifdef WE_HAVE_DIGEST
+
+/*
+ * Batched digests
+ */
+
+/* Largest amount of data, in bytes, passed to wolfSSL in one update. */
+#define WE_DIGEST_MAX_UPDATE    0x40000000
+
+/**
+ * Lane of a digest batch - consecutive messages digested by one thread.
+ */
+typedef struct we_DigestLane {
+    /** Hash object reused for each message of lane. */
+    wc_HashAlg            hash;
+    /** Hash algorithm ID. */
+    enum wc_HashType      hashType;
+    /** First message of lane. */
+    wolfEngine_DigestJob *jobs;
+    /** Number of messages in lane. */
+    int                   cnt;
+} we_DigestLane;
+
+/**
+ * Get the wolfSSL hash algorithm ID for an OpenSSL digest NID.
+ *
+ * @param  nid  [in]  OpenSSL digest NID.
+ * @returns  wolfSSL hash algorithm ID or WC_HASH_TYPE_NONE when not supported.
+ */
+static enum wc_HashType we_digest_nid_to_hash_type(int nid)
+{
+    enum wc_HashType hashType;
+
+    switch (nid) {
+    #ifdef WE_HAVE_SHA1
+        case NID_sha1:
+            hashType = WC_HASH_TYPE_SHA;
+            break;
+    #endif
+    #ifdef WE_HAVE_SHA224
+        case NID_sha224:
+            hashType = WC_HASH_TYPE_SHA224;
+            break;
+    #endif
+    #ifdef WE_HAVE_SHA256
+        case NID_sha256:
+            hashType = WC_HASH_TYPE_SHA256;
+            break;
+    #endif
+    #ifdef WE_HAVE_SHA384
+        case NID_sha384:
+            hashType = WC_HASH_TYPE_SHA384;
+            break;
+    #endif
+    #ifdef WE_HAVE_SHA512
+        case NID_sha512:
+            hashType = WC_HASH_TYPE_SHA512;
+            break;
+    #endif
+        default:
+            hashType = WC_HASH_TYPE_NONE;
+            break;
+    }
+
+    return hashType;
+}
+
+/**
+ * Digest each message of a lane with one hash object - bulk pool job.
+ *
+ * Finalizing resets the hash object so that it is ready for the next message.
+ *
+ * @param  arg  [in,out]  Digest lane.
+ * @returns  1 when all messages succeeded and 0 otherwise.
+ */
+static int we_digest_lane(void *arg)
+{
+    int ret = 1, rc;
+    we_DigestLane *lane = (we_DigestLane *)arg;
+    wolfEngine_DigestJob *job;
+    const unsigned char *data;
+    size_t left;
+    word32 len;
+    int init = 0;
+    int i;
+
+    for (i = 0; i < lane->cnt; i++) {
+        job = &lane->jobs[i];
+        rc = 0;
+        if ((job->out == NULL) || ((job->data == NULL) && (job->len > 0))) {
+            rc = BAD_FUNC_ARG;
+        }
+        if ((rc == 0) && (!init)) {
+            rc = wc_HashInit(&lane->hash, lane->hashType);
+            init = (rc == 0);
+        }
+        data = job->data;
+        for (left = job->len; (rc == 0) && (left > 0); left -= len) {
+            len = (left > WE_DIGEST_MAX_UPDATE) ? WE_DIGEST_MAX_UPDATE :
+                                                  (word32)left;
+            rc = wc_HashUpdate(&lane->hash, lane->hashType, data, len);
+            data += len;
+        }
+        if (rc == 0) {
+            rc = wc_HashFinal(&lane->hash, lane->hashType, job->out);
+        }
+        if ((rc != 0) && init) {
+            /* Hash object may hold part of message - start again. */
+        #if !defined(HAVE_FIPS_VERSION) || HAVE_FIPS_VERSION >= 2
+            wc_HashFree(&lane->hash, lane->hashType);
+        #endif
+            init = 0;
+        }
+        job->status = (rc == 0);
+        if (rc != 0) {
+            ret = 0;
+        }
+    }
+
+#if !defined(HAVE_FIPS_VERSION) || HAVE_FIPS_VERSION >= 2
+    if (init) {
+        wc_HashFree(&lane->hash, lane->hashType);
+    }
+#endif
+
+    return ret;
+}
+
+/**
+ * Digest many independent messages with one algorithm.
+ *
+ * One hash object is set up for all the messages on a thread. When the bulk
+ * worker pool is running and the messages add up to at least the bulk
+ * threshold, the messages are divided into lanes of about equal length that
+ * are digested by the workers and the calling thread concurrently.
+ *
+ * @param  batch  [in,out]  Algorithm and messages. Status of each message set.
+ * @returns  1 when all messages succeeded and 0 otherwise.
+ */
+int we_digest_batch(wolfEngine_DigestBatch *batch)
+{
+    int ret = 1;
+    enum wc_HashType hashType = WC_HASH_TYPE_NONE;
+    we_DigestLane lane;
+#ifdef WE_HAVE_BULK_THREADS
+    we_DigestLane *lanes = NULL;
+    int laneCnt = 0;
+    int cnt = 0;
+    int i;
+    size_t total = 0;
+    size_t sz = 0;
+#endif
+
+    WOLFENGINE_ENTER(WE_LOG_DIGEST, "we_digest_batch");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_DIGEST, "ARGS [batch = %p]", batch);
+
+    if ((batch == NULL) || (batch->cnt < 0) ||
+        ((batch->jobs == NULL) && (batch->cnt > 0))) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_DIGEST, "Bad digest batch");
+        ret = 0;
+    }
+    if (ret == 1) {
+        hashType = we_digest_nid_to_hash_type(batch->nid);
+        if (hashType == WC_HASH_TYPE_NONE) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_DIGEST, "Digest not supported");
+            ret = 0;
+        }
+    }
+
+#ifdef WE_HAVE_BULK_THREADS
+    if ((ret == 1) && (we_bulkWorkers > 0) && (batch->cnt > 1)) {
+        for (i = 0; i < batch->cnt; i++) {
+            total += batch->jobs[i].len;
+        }
+        if (WE_BULK_SPLIT(total)) {
+            laneCnt = we_bulkWorkers + 1;
+            if (laneCnt > batch->cnt) {
+                laneCnt = batch->cnt;
+            }
+            lanes = (we_DigestLane *)OPENSSL_malloc(laneCnt * sizeof(*lanes));
+            if (lanes == NULL) {
+                WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_DIGEST, "OPENSSL_malloc",
+                                           lanes);
+            }
+        }
+    }
+    if ((ret == 1) && (lanes != NULL)) {
+        /* Start a new lane once the current one has its share of data. */
+        for (i = 0; i < batch->cnt; i++) {
+            if ((i == 0) || ((cnt < laneCnt) && (sz >= total / laneCnt))) {
+                lanes[cnt].hashType = hashType;
+                lanes[cnt].jobs = &batch->jobs[i];
+                lanes[cnt].cnt = 0;
+                cnt++;
+                sz = 0;
+            }
+            lanes[cnt - 1].cnt++;
+            sz += batch->jobs[i].len;
+        }
+
+        WOLFENGINE_MSG(WE_LOG_DIGEST, "Splitting %d messages into %d lanes",
+                       batch->cnt, cnt);
+        ret = we_bulk_run(we_digest_lane, lanes, sizeof(*lanes), cnt);
+
+        OPENSSL_clear_free(lanes, laneCnt * sizeof(*lanes));
+    }
+    else
+#endif
+    if (ret == 1) {
+        lane.hashType = hashType;
+        lane.jobs = batch->jobs;
+        lane.cnt = batch->cnt;
+        ret = we_digest_lane(&lane);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_DIGEST, "we_digest_batch", ret);
 
+    return ret;
+}
 
+#endif /* WE_HAVE_DIGEST */
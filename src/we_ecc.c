@@ -280,6 +280,13 @@ typedef struct we_Ecc
 #ifndef WE_ECC_USE_GLOBAL_RNG
     /** wolfSSL random number generator. */
     WC_RNG         rng;
+#ifdef WE_HAVE_FORK_CHECK
+    /** Fork generation random number generator was instantiated in. */
+    int            rngForkGen;
+#endif
+#else
+    /** Shard of global random number generator used with this key. */
+    we_RngShard   *rngShard;
 #endif
     /** wolfSSL curve id for key. */
     int            curveId;
@@ -359,6 +366,14 @@ static int we_ec_init(EVP_PKEY_CTX *ctx)
         if (rc != 0) {
             ret = 0;
         }
+    #ifdef WE_HAVE_FORK_CHECK
+        ecc->rngForkGen = we_forkGen;
+    #endif
+    }
+#else
+    if (ret == 1) {
+        /* Key is only used with one shard so operations on it serialize. */
+        ecc->rngShard = we_rng_shard();
     }
 #endif
 #if !defined(HAVE_FIPS) || \
@@ -368,7 +383,7 @@ static int we_ec_init(EVP_PKEY_CTX *ctx)
 #ifndef WE_ECC_USE_GLOBAL_RNG
         rc = wc_ecc_set_rng(&ecc->key, &ecc->rng);
 #else
-        rc = wc_ecc_set_rng(&ecc->key, we_rng);
+        rc = wc_ecc_set_rng(&ecc->key, &ecc->rngShard->rng);
 #endif
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_ecc_set_rng", rc);
@@ -775,6 +790,12 @@ static int we_pkey_ecdsa_sign(EVP_PKEY_CTX *ctx, unsigned char *sig, size_t *sig
         *sigLen = wc_ecc_sig_size(&ecc->key);
         WOLFENGINE_MSG(WE_LOG_PK, "sig is NULL, returning size: %zu", *sigLen);
     }
+#if !defined(WE_ECC_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    if (ret == 1 && sig != NULL) {
+        /* Don't generate the same random as the parent process. */
+        ret = we_rng_fork_check(&ecc->rng, &ecc->rngForkGen);
+    }
+#endif
     if (ret == 1 && sig != NULL) {
         /* Sign the data with wolfSSL EC key object. */
         outLen = (word32)*sigLen;
@@ -783,18 +804,18 @@ static int we_pkey_ecdsa_sign(EVP_PKEY_CTX *ctx, unsigned char *sig, size_t *sig
                               &ecc->key);
 #else
 #ifndef WE_SINGLE_THREADED
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(ecc->rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             ret = 0;
         }
         else
 #endif /* !WE_SINGLE_THREADED */
         {
-            rc = wc_ecc_sign_hash(tbs, (word32)tbsLen, sig, &outLen, we_rng,
-                                  &ecc->key);
+            rc = wc_ecc_sign_hash(tbs, (word32)tbsLen, sig, &outLen,
+                                  &ecc->rngShard->rng, &ecc->key);
         #ifndef WE_SINGLE_THREADED
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&ecc->rngShard->mutex);
         #endif
         }
 #endif /* !WE_ECC_USE_GLOBAL_RNG */
@@ -1021,23 +1042,30 @@ static int we_ec_keygen(EVP_PKEY_CTX *ctx, EVP_PKEY *pkey)
         }
     }
 
+#if !defined(WE_ECC_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    if (ret == 1) {
+        /* Don't generate the same random as the parent process. */
+        ret = we_rng_fork_check(&ecc->rng, &ecc->rngForkGen);
+    }
+#endif
     if (ret == 1) {
         /* Generate a new EC key with wolfSSL. */
 #ifndef WE_ECC_USE_GLOBAL_RNG
         rc = wc_ecc_make_key_ex(&ecc->rng, len, &ecc->key, ecc->curveId);
 #else
 #ifndef WE_SINGLE_THREADED
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(ecc->rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             ret = 0;
         }
         else
 #endif /* !WE_SINGLE_THREADED */
         {
-            rc = wc_ecc_make_key_ex(we_rng, len, &ecc->key, ecc->curveId);
+            rc = wc_ecc_make_key_ex(&ecc->rngShard->rng, len, &ecc->key,
+                                    ecc->curveId);
         #ifndef WE_SINGLE_THREADED
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&ecc->rngShard->mutex);
         #endif
         }
 #endif /* !WE_ECC_USE_GLOBAL_RNG */
@@ -1146,12 +1174,18 @@ static int we_ecdh_derive(EVP_PKEY_CTX *ctx, unsigned char *key, size_t *keyLen)
                 ret = 0;
             }
 
+        #if !defined(WE_ECC_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+            if (ret == 1) {
+                /* Don't generate the same random as the parent process. */
+                ret = we_rng_fork_check(&ecc->rng, &ecc->rngForkGen);
+            }
+        #endif
             if (ret == 1) {
             #if defined(WE_ECC_USE_GLOBAL_RNG) && defined(ECC_TIMING_RESISTANT) \
                 && !defined(WE_SINGLE_THREADED)
-                rc = wc_LockMutex(we_rng_mutex);
+                rc = we_rng_shard_lock(ecc->rngShard);
                 if (rc != 0) {
-                    WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
                     ret = 0;
                 }
                 else
@@ -1196,7 +1230,7 @@ static int we_ecdh_derive(EVP_PKEY_CTX *ctx, unsigned char *key, size_t *keyLen)
                 }
             #if defined(WE_ECC_USE_GLOBAL_RNG) && defined(ECC_TIMING_RESISTANT) \
                 && !defined(WE_SINGLE_THREADED)
-                wc_UnLockMutex(we_rng_mutex);
+                wc_UnLockMutex(&ecc->rngShard->mutex);
             #endif
             }
             if (ret == 1) {
@@ -1263,6 +1297,12 @@ static int we_ec_ctrl(EVP_PKEY_CTX *ctx, int type, int num, void *ptr)
                     (EVP_MD_type((const EVP_MD *)ptr) != NID_sha224) &&
                     (EVP_MD_type((const EVP_MD *)ptr) != NID_sha256) &&
                     (EVP_MD_type((const EVP_MD *)ptr) != NID_sha384) &&
+                #ifdef WE_HAVE_SHA512_224
+                    (EVP_MD_type((const EVP_MD *)ptr) != NID_sha512_224) &&
+                #endif
+                #ifdef WE_HAVE_SHA512_256
+                    (EVP_MD_type((const EVP_MD *)ptr) != NID_sha512_256) &&
+                #endif
                     (EVP_MD_type((const EVP_MD *)ptr) != NID_sha512)) {
                     XSNPRINTF(errBuff, sizeof(errBuff), "Invalid digest: %d",
                               EVP_MD_type((const EVP_MD *)ptr));
@@ -1750,7 +1790,9 @@ static int we_ec_key_keygen(EC_KEY *key)
     WC_RNG rng;
     WC_RNG *pRng = NULL;
 #else
-    WC_RNG *pRng = we_rng;
+    /* Shard of global random for this thread. */
+    we_RngShard *rngShard = we_rng_shard();
+    WC_RNG *pRng = &rngShard->rng;
 #endif
     int len = 0;
 
@@ -1799,9 +1841,9 @@ static int we_ec_key_keygen(EC_KEY *key)
 
         /* Generate key. */
 #if defined(WE_ECC_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             ret = 0;
         }
         else
@@ -1809,7 +1851,7 @@ static int we_ec_key_keygen(EC_KEY *key)
         {
             rc = wc_ecc_make_key_ex(pRng, len, &ecc, curveId);
         #if defined(WE_ECC_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&rngShard->mutex);
         #endif
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_ecc_make_key_ex", rc);
@@ -1851,13 +1893,17 @@ static int we_ec_key_compute_key(unsigned char **psec, size_t *pseclen,
     int ret, rc;
     ecc_key key;
     ecc_key peer;
+#ifdef WE_ECC_USE_GLOBAL_RNG
+    /* Shard of global random for this thread. */
+    we_RngShard *rngShard = we_rng_shard();
+#endif
 #if !defined(HAVE_FIPS) || \
     (defined(HAVE_FIPS_VERSION) && HAVE_FIPS_VERSION != 2)
 #ifndef WE_ECC_USE_GLOBAL_RNG
     WC_RNG rng;
     WC_RNG *pRng = NULL;
 #else
-    WC_RNG *pRng = we_rng;
+    WC_RNG *pRng = &rngShard->rng;
 #endif
 #endif
     ecc_key *pKey = NULL;
@@ -1963,9 +2009,9 @@ static int we_ec_key_compute_key(unsigned char **psec, size_t *pseclen,
     if (ret == 1) {
     #if defined(WE_ECC_USE_GLOBAL_RNG) && defined(ECC_TIMING_RESISTANT) \
         && !defined(WE_SINGLE_THREADED)
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             ret = 0;
         }
         else
@@ -1980,7 +2026,7 @@ static int we_ec_key_compute_key(unsigned char **psec, size_t *pseclen,
         }
     #if defined(WE_ECC_USE_GLOBAL_RNG) && defined(ECC_TIMING_RESISTANT) \
         && !defined(WE_SINGLE_THREADED)
-        wc_UnLockMutex(we_rng_mutex);
+        wc_UnLockMutex(&rngShard->mutex);
     #endif
     }
     if (ret == 1) {
@@ -2032,7 +2078,9 @@ static ECDSA_SIG* we_ecdsa_do_sign_ex(const unsigned char *d, int dlen,
     WC_RNG rng;
     WC_RNG *pRng = NULL;
 #else
-    WC_RNG *pRng = we_rng;
+    /* Shard of global random for this thread. */
+    we_RngShard *rngShard = we_rng_shard();
+    WC_RNG *pRng = &rngShard->rng;
 #endif
     int curveId = 0;
     mp_int sig_r, sig_s;
@@ -2124,9 +2172,9 @@ static ECDSA_SIG* we_ecdsa_do_sign_ex(const unsigned char *d, int dlen,
     /* Sign hash with ECDSA */
     if (err == 0) {
 #if defined(WE_ECC_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             err = 1;
         }
         else
@@ -2134,7 +2182,7 @@ static ECDSA_SIG* we_ecdsa_do_sign_ex(const unsigned char *d, int dlen,
         {
             rc = wc_ecc_sign_hash_ex(d, dlen, pRng, &we_key, &sig_r, &sig_s);
         #if defined(WE_ECC_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&rngShard->mutex);
         #endif
             if (rc != MP_OKAY) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_ecc_sign_hash_ex", rc);
@@ -2384,7 +2432,9 @@ static int we_ec_key_sign(int type, const unsigned char *dgst, int dLen,
     WC_RNG rng;
     WC_RNG *pRng = NULL;
 #else
-    WC_RNG *pRng = we_rng;
+    /* Shard of global random for this thread. */
+    we_RngShard *rngShard = we_rng_shard();
+    WC_RNG *pRng = &rngShard->rng;
 #endif
     const EC_GROUP *group;
     int curveId;
@@ -2441,9 +2491,9 @@ static int we_ec_key_sign(int type, const unsigned char *dgst, int dLen,
         /* Sign hash with wolfSSL. */
         outLen = *sigLen;
 #if defined(WE_ECC_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             ret = 0;
         }
         else
@@ -2451,7 +2501,7 @@ static int we_ec_key_sign(int type, const unsigned char *dgst, int dLen,
         {
             rc = wc_ecc_sign_hash(dgst, dLen, sig, &outLen, pRng, &key);
         #if defined(WE_ECC_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&rngShard->mutex);
         #endif
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_ecc_sign_hash", rc);
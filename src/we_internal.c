@@ -24,6 +24,11 @@
 #if defined(HAVE_FIPS_VERSION) && HAVE_FIPS_VERSION == 5
 #include <wolfssl/wolfcrypt/fips_test.h>
 #endif
+#if !defined(WE_SINGLE_THREADED) && defined(HAVE_PTHREAD)
+#include <pthread.h>
+#include <errno.h>
+#include <time.h>
+#endif
 
 #ifdef WE_NO_OPENSSL_MALLOC
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
@@ -150,74 +155,1177 @@ int we_pkey_asn1_get_nids(const int **nids)
  * Random number generator
  */
 
-/* Global random number generator. */
-static WC_RNG we_globalRng;
-/* Pointer to global random number generator. */
-WC_RNG* we_rng = &we_globalRng;
+/* Shards of the global random number generator. */
+we_RngShard we_rngShards[WE_RNG_SHARDS];
 /* Global RNG has been initialized. */
 static int we_globalRngInited = 0;
+
+/**
+ * Get the shard of the global random number generator for the calling thread.
+ *
+ * The shard is selected by a hash of the thread id so that threads are spread
+ * across the shards and don't all contend on one lock. Caller must lock the
+ * shard's mutex around use of the shard's DRBG.
+ *
+ * @returns  Shard of global random number generator.
+ */
+we_RngShard* we_rng_shard(void)
+{
+#if WE_RNG_SHARDS > 1
+    unsigned long h = 0;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    CRYPTO_THREAD_ID id;
+#else
+    CRYPTO_THREADID id;
+#endif
+#endif
+
+#ifdef WE_HAVE_RESEED_THREAD
+    /* Worker is started again on first use after fork. */
+    if (we_reseedRestart) {
+        we_reseed_thread_restart();
+    }
+#endif
+
+#if WE_RNG_SHARDS > 1
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    id = CRYPTO_THREAD_get_current_id();
+
+    /* Thread id is opaque - use as many bytes as fit. */
+    XMEMCPY(&h, &id, sizeof(id) < sizeof(h) ? sizeof(id) : sizeof(h));
+#else
+    CRYPTO_THREADID_current(&id);
+    h = CRYPTO_THREADID_hash(&id);
+#endif
+    /* Thread ids are often aligned addresses - mix in the high bits. */
+    h ^= h >> 17;
+    h *= 0x45d9f3bUL;
+    h ^= h >> 16;
+
+    return &we_rngShards[h % WE_RNG_SHARDS];
+#else
+    return &we_rngShards[0];
+#endif
+}
+
+#ifndef WE_SINGLE_THREADED
+/**
+ * Lock a shard of the global random number generator for use.
+ *
+ * The shard's DRBG is re-instantiated if the process has forked since the
+ * DRBG was last used.
+ *
+ * @param  shard  [in]  Shard of global random number generator.
+ * @returns  0 on success and non-zero on failure.
+ */
+int we_rng_shard_lock(we_RngShard *shard)
+{
+    int rc;
+
+    rc = wc_LockMutex(&shard->mutex);
+#ifdef WE_HAVE_FORK_CHECK
+    if ((rc == 0) && (we_rng_fork_check(&shard->rng, &shard->forkGen) != 1)) {
+        wc_UnLockMutex(&shard->mutex);
+        rc = RNG_FAILURE_E;
+    }
+#endif
+
+    return rc;
+}
+#endif
+
+#ifdef WE_HAVE_RESEED_THREAD
+
+/* Number of fresh DRBGs the reseed worker keeps ready for threads to use. */
+#ifndef WE_RESEED_SPARE_RNGS
+#define WE_RESEED_SPARE_RNGS    2
+#endif
+/* Number of bytes of entropy used to reseed a DRBG. */
+#ifndef WE_RESEED_ENTROPY_SZ
+#define WE_RESEED_ENTROPY_SZ    48
+#endif
+
+/* Reseed worker thread. */
+static pthread_t we_reseedThread;
+/* Serializes starting and stopping the reseed worker. */
+static pthread_mutex_t we_reseedCtrlMutex = PTHREAD_MUTEX_INITIALIZER;
+/* Held by the reseed worker while it works on DRBGs. */
+static pthread_mutex_t we_reseedWorkMutex = PTHREAD_MUTEX_INITIALIZER;
+/* Mutex protecting the reseed worker's state. */
+static pthread_mutex_t we_reseedMutex = PTHREAD_MUTEX_INITIALIZER;
+/* Signals the reseed worker to stop or to replace spare DRBGs. */
+static pthread_cond_t we_reseedCond = PTHREAD_COND_INITIALIZER;
+/* Seconds between reseeds. 0 when the reseed worker is not wanted. */
+static long we_reseedSecs = 0;
+/* Reseed worker thread has been created and not joined. */
+static int we_reseedRunning = 0;
+/* Reseed worker is to exit. */
+static int we_reseedStop = 0;
+/* Reseed worker is to replace the spare DRBGs handed out. */
+static int we_reseedWake = 0;
+/* Number of DRBGs reseeded or instantiated by the reseed worker. */
+static unsigned long we_reseedCount = 0;
+/* Reseed worker is to be started again, in a forked child, on next use of a
+ * DRBG. */
+volatile int we_reseedRestart = 0;
+
+/**
+ * Wake the reseed worker to replace a spare DRBG handed out to a thread.
+ */
+static void we_reseed_thread_wake(void)
+{
+    if (pthread_mutex_lock(&we_reseedMutex) == 0) {
+        we_reseedWake = 1;
+        pthread_cond_signal(&we_reseedCond);
+        pthread_mutex_unlock(&we_reseedMutex);
+    }
+}
+
+#endif /* WE_HAVE_RESEED_THREAD */
+
+#ifdef WE_HAVE_THREAD_RNG
+
+/* Number of times a per-thread DRBG is used before it is re-instantiated with
+ * fresh entropy. */
+#ifndef WE_THREAD_RNG_RESEED_INTERVAL
+#define WE_THREAD_RNG_RESEED_INTERVAL    0x10000
+#endif
+
+/**
+ * Long-lived DRBG that is owned by one thread at a time.
+ */
+typedef struct we_ThreadRng {
+    /** wolfSSL random number generator. */
+    WC_RNG rng;
+    /** Number of uses since the DRBG was instantiated. */
+    word32 uses;
+    /** DRBG is owned by a live thread. */
+    int inUse;
+#ifdef WE_HAVE_FORK_CHECK
+    /** Fork generation the DRBG was instantiated in. */
+    int forkGen;
+#endif
+    /** Next DRBG in the list of all per-thread DRBGs. */
+    struct we_ThreadRng *next;
+} we_ThreadRng;
+
+/* List of all per-thread DRBGs allocated. */
+static we_ThreadRng *we_threadRngs = NULL;
+/* Number of per-thread DRBGs allocated. */
+static unsigned long we_threadRngCount = 0;
+/* Number of per-thread DRBG instantiations by threads using them. */
+static unsigned long we_threadRngInitCount = 0;
+#ifndef WE_SINGLE_THREADED
+/* Key to the calling thread's DRBG. */
+static pthread_key_t we_threadRngKey;
+/* Mutex for protecting the list of per-thread DRBGs. */
+static wolfSSL_Mutex we_threadRngMutex;
+
+/**
+ * Return a thread's DRBG to the pool when the thread exits.
+ *
+ * @param  data  [in]  Per-thread DRBG object.
+ */
+static void we_thread_rng_release(void *data)
+{
+    we_ThreadRng *threadRng = (we_ThreadRng *)data;
+
+    if (wc_LockMutex(&we_threadRngMutex) == 0) {
+        /* DRBG state is kept so that the next thread needn't instantiate. */
+        threadRng->inUse = 0;
+        wc_UnLockMutex(&we_threadRngMutex);
+    }
+}
+#endif
+
+/**
+ * Initialize the per-thread DRBG pool.
+ *
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_init_thread_rng(void)
+{
+    int ret = 1;
+#ifndef WE_SINGLE_THREADED
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_init_thread_rng");
+
+    rc = wc_InitMutex(&we_threadRngMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitMutex", rc);
+        ret = 0;
+    }
+    if (ret == 1) {
+        /* Destructor puts DRBG back in pool when thread exits. */
+        rc = pthread_key_create(&we_threadRngKey, we_thread_rng_release);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "pthread_key_create", rc);
+            wc_FreeMutex(&we_threadRngMutex);
+            ret = 0;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_init_thread_rng", ret);
+#endif
+
+    return ret;
+}
+
+/**
+ * Free all per-thread DRBGs.
+ */
+static void we_final_thread_rng(void)
+{
+    we_ThreadRng *threadRng;
+    we_ThreadRng *next;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_final_thread_rng");
+
+#ifndef WE_SINGLE_THREADED
+    /* Threads still alive no longer see their DRBG. */
+    pthread_key_delete(we_threadRngKey);
+#endif
+    for (threadRng = we_threadRngs; threadRng != NULL; threadRng = next) {
+        next = threadRng->next;
+        wc_FreeRng(&threadRng->rng);
+        OPENSSL_free(threadRng);
+    }
+    we_threadRngs = NULL;
+#ifndef WE_SINGLE_THREADED
+    wc_FreeMutex(&we_threadRngMutex);
+#endif
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_final_thread_rng", 1);
+}
+
+/**
+ * Get a DRBG for the calling thread from the pool.
+ *
+ * Reuses a DRBG released by a thread that has exited, otherwise a new DRBG is
+ * instantiated and added to the pool.
+ *
+ * @returns  Per-thread DRBG object on success and NULL on failure.
+ */
+static we_ThreadRng *we_thread_rng_acquire(void)
+{
+    we_ThreadRng *threadRng = NULL;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_thread_rng_acquire");
+
+#ifndef WE_SINGLE_THREADED
+    rc = wc_LockMutex(&we_threadRngMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_LockMutex", rc);
+    }
+    else {
+        for (threadRng = we_threadRngs; threadRng != NULL;
+             threadRng = threadRng->next) {
+            if (!threadRng->inUse) {
+                threadRng->inUse = 1;
+                break;
+            }
+        }
+        wc_UnLockMutex(&we_threadRngMutex);
+    }
+#endif
+
+    if (threadRng == NULL) {
+        /* Instantiate outside of lock - gathering entropy may block. */
+        threadRng = (we_ThreadRng *)OPENSSL_zalloc(sizeof(we_ThreadRng));
+        if (threadRng == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_ENGINE, "OPENSSL_zalloc",
+                                       threadRng);
+        }
+        else {
+            rc = wc_InitRng(&threadRng->rng);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+                OPENSSL_free(threadRng);
+                threadRng = NULL;
+            }
+        #ifdef WE_HAVE_FORK_CHECK
+            else {
+                threadRng->forkGen = we_forkGen;
+            }
+        #endif
+        }
+    #ifndef WE_SINGLE_THREADED
+        if (threadRng != NULL) {
+            rc = wc_LockMutex(&we_threadRngMutex);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_LockMutex", rc);
+                wc_FreeRng(&threadRng->rng);
+                OPENSSL_free(threadRng);
+                threadRng = NULL;
+            }
+        }
+    #endif
+        if (threadRng != NULL) {
+            threadRng->inUse = 1;
+            threadRng->next = we_threadRngs;
+            we_threadRngs = threadRng;
+            we_threadRngCount++;
+            we_threadRngInitCount++;
+        #ifndef WE_SINGLE_THREADED
+            wc_UnLockMutex(&we_threadRngMutex);
+        #endif
+        }
+    }
+
+#ifndef WE_SINGLE_THREADED
+    if (threadRng != NULL) {
+        rc = pthread_setspecific(we_threadRngKey, threadRng);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "pthread_setspecific", rc);
+            we_thread_rng_release(threadRng);
+            threadRng = NULL;
+        }
+    }
+#endif
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_thread_rng_acquire", threadRng != NULL);
+
+    return threadRng;
+}
+
+#ifdef WE_HAVE_RESEED_THREAD
+/**
+ * Swap the calling thread's used up DRBG for a spare one.
+ *
+ * Spares are instantiated ahead of time by the reseed worker. The used up DRBG
+ * is left in the pool for the reseed worker to re-instantiate.
+ *
+ * @param  threadRng  [in]  Calling thread's used up DRBG.
+ * @returns  Fresh DRBG on success and NULL when no spare is available.
+ */
+static we_ThreadRng *we_thread_rng_swap(we_ThreadRng *threadRng)
+{
+    we_ThreadRng *spare = NULL;
+    int rc;
+
+    rc = wc_LockMutex(&we_threadRngMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_LockMutex", rc);
+    }
+    else {
+        for (spare = we_threadRngs; spare != NULL; spare = spare->next) {
+            if ((!spare->inUse) && (spare->uses == 0)) {
+                break;
+            }
+        }
+        if (spare != NULL) {
+            rc = pthread_setspecific(we_threadRngKey, spare);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "pthread_setspecific",
+                                      rc);
+                spare = NULL;
+            }
+        }
+        if (spare != NULL) {
+            spare->inUse = 1;
+            /* Use count left at limit marks DRBG for re-instantiation. */
+            threadRng->inUse = 0;
+        }
+        wc_UnLockMutex(&we_threadRngMutex);
+    }
+
+    if (spare != NULL) {
+        we_reseed_thread_wake();
+    }
+
+    return spare;
+}
+#endif /* WE_HAVE_RESEED_THREAD */
+
+/**
+ * Get the calling thread's DRBG.
+ *
+ * The DRBG is created on first use by the thread and is only ever used by that
+ * thread so no locking is required to generate with it. The DRBG is
+ * re-instantiated with fresh entropy after WE_THREAD_RNG_RESEED_INTERVAL uses,
+ * or swapped for a spare when the reseed worker is running.
+ *
+ * @returns  Random number generator on success and NULL on failure.
+ */
+WC_RNG* we_thread_rng(void)
+{
+    we_ThreadRng *threadRng;
+#ifdef WE_HAVE_RESEED_THREAD
+    we_ThreadRng *spare;
+#endif
+    WC_RNG *rng = NULL;
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_thread_rng");
+
+#ifdef WE_HAVE_RESEED_THREAD
+    /* Worker is started again on first use after fork. */
+    if (we_reseedRestart) {
+        we_reseed_thread_restart();
+    }
+#endif
+
+#ifndef WE_SINGLE_THREADED
+    threadRng = (we_ThreadRng *)pthread_getspecific(we_threadRngKey);
+#else
+    threadRng = we_threadRngs;
+#endif
+    if (threadRng == NULL) {
+        threadRng = we_thread_rng_acquire();
+    }
+    if (threadRng != NULL) {
+        if (++threadRng->uses >= WE_THREAD_RNG_RESEED_INTERVAL) {
+        #ifdef WE_HAVE_RESEED_THREAD
+            spare = we_thread_rng_swap(threadRng);
+            if (spare != NULL) {
+                threadRng = spare;
+            }
+            else
+        #endif
+            {
+                WOLFENGINE_MSG(WE_LOG_ENGINE,
+                               "Re-instantiating per-thread DRBG");
+                wc_FreeRng(&threadRng->rng);
+                rc = wc_InitRng(&threadRng->rng);
+                if (rc != 0) {
+                    /* Leave count at limit so next use tries again. */
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+                    threadRng = NULL;
+                }
+                else {
+                    threadRng->uses = 0;
+                #ifdef WE_HAVE_FORK_CHECK
+                    threadRng->forkGen = we_forkGen;
+                #endif
+                #ifndef WE_SINGLE_THREADED
+                    if (wc_LockMutex(&we_threadRngMutex) == 0)
+                #endif
+                    {
+                        we_threadRngInitCount++;
+                    #ifndef WE_SINGLE_THREADED
+                        wc_UnLockMutex(&we_threadRngMutex);
+                    #endif
+                    }
+                }
+            }
+        }
+    }
+#ifdef WE_HAVE_FORK_CHECK
+    /* Don't generate the same random as the parent process. */
+    if ((threadRng != NULL) &&
+            (we_rng_fork_check(&threadRng->rng, &threadRng->forkGen) != 1)) {
+        threadRng = NULL;
+    }
+#endif
+    if (threadRng != NULL) {
+        rng = &threadRng->rng;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_thread_rng", rng != NULL);
+
+    return rng;
+}
+
+/**
+ * Put the per-thread DRBG statistics into the stats object.
+ *
+ * @param  stats  [out]  Statistics object.
+ */
+static void we_thread_rng_get_stats(wolfEngine_Stats *stats)
+{
 #ifndef WE_SINGLE_THREADED
-/* Mutex for protecting use of global random number generator. */
-wolfSSL_Mutex we_global_rng_mutex;
-/* Pointer to mutex for protecting use of global random number generator.*/
-wolfSSL_Mutex* we_rng_mutex = &we_global_rng_mutex;
+    if (wc_LockMutex(&we_threadRngMutex) == 0)
+#endif
+    {
+        stats->threadRngs = we_threadRngCount;
+        stats->threadRngInits = we_threadRngInitCount;
+    #ifndef WE_SINGLE_THREADED
+        wc_UnLockMutex(&we_threadRngMutex);
+    #endif
+    }
+}
+
+#endif /* WE_HAVE_THREAD_RNG */
+
+#ifdef WE_HAVE_RESEED_THREAD
+
+#ifdef WE_STATIC_WOLFSSL
+/**
+ * Reseed the DRBG of each shard of the global random.
+ *
+ * Entropy is gathered before the shard's lock is taken so that the lock is
+ * only held for the reseed calculation. Reseeding restarts wolfCrypt's reseed
+ * counter so requests don't have to reseed the DRBG.
+ *
+ * @returns  Number of DRBGs reseeded.
+ */
+static int we_reseed_shards(void)
+{
+    int cnt = 0;
+    int rc;
+    int i;
+    unsigned char entropy[WE_RESEED_ENTROPY_SZ];
+#ifndef WE_HAVE_ENTROPY_POOL
+    OS_Seed os;
+#endif
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_reseed_shards");
+
+#ifdef WE_HAVE_ENTROPY_POOL
+    /* One read of the entropy source for all shards. */
+    (void)we_entropy_prefetch();
+#endif
+    for (i = 0; i < WE_RNG_SHARDS; i++) {
+    #ifdef WE_HAVE_ENTROPY_POOL
+        rc = (we_entropy_get(entropy, sizeof(entropy)) == 1) ? 0 : -1;
+    #else
+        rc = wc_GenerateSeed(&os, entropy, sizeof(entropy));
+    #endif
+        if (rc != 0) {
+            WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE,
+                                 "Failed to get entropy for reseed");
+            break;
+        }
+        rc = we_rng_shard_lock(&we_rngShards[i]);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "we_rng_shard_lock", rc);
+        }
+        else {
+            rc = wc_RNG_DRBG_Reseed(&we_rngShards[i].rng, entropy,
+                                    sizeof(entropy));
+            wc_UnLockMutex(&we_rngShards[i].mutex);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_RNG_DRBG_Reseed", rc);
+            }
+            else {
+                cnt++;
+            }
+        }
+    }
+    OPENSSL_cleanse(entropy, sizeof(entropy));
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_reseed_shards", cnt);
+
+    return cnt;
+}
+#endif /* WE_STATIC_WOLFSSL */
+
+/**
+ * Re-instantiate used up per-thread DRBGs and keep spare DRBGs ready.
+ *
+ * DRBGs are instantiated without holding the pool's lock as gathering entropy
+ * may block.
+ *
+ * @returns  Number of DRBGs instantiated.
+ */
+static int we_reseed_thread_rngs(void)
+{
+    int cnt = 0;
+    int spares = 0;
+    int rc = 0;
+    we_ThreadRng *threadRng;
+    we_ThreadRng *curr;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_reseed_thread_rngs");
+
+    /* Re-instantiate DRBGs left behind by threads that took a spare. */
+    while (rc == 0) {
+        threadRng = NULL;
+        rc = wc_LockMutex(&we_threadRngMutex);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_LockMutex", rc);
+            break;
+        }
+        spares = 0;
+        for (curr = we_threadRngs; curr != NULL; curr = curr->next) {
+            if (curr->inUse) {
+                continue;
+            }
+            if (curr->uses == 0) {
+                spares++;
+            }
+            else if ((threadRng == NULL) &&
+                     (curr->uses >= WE_THREAD_RNG_RESEED_INTERVAL)) {
+                /* Owned by worker until re-instantiated. */
+                curr->inUse = 1;
+                threadRng = curr;
+            }
+        }
+        wc_UnLockMutex(&we_threadRngMutex);
+        if (threadRng == NULL) {
+            break;
+        }
+
+        wc_FreeRng(&threadRng->rng);
+        rc = wc_InitRng(&threadRng->rng);
+        if (rc != 0) {
+            /* Use count left at limit so next pass tries again. */
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+        }
+        else {
+            cnt++;
+        }
+        if (wc_LockMutex(&we_threadRngMutex) == 0) {
+            if (rc == 0) {
+                threadRng->uses = 0;
+                threadRng->forkGen = we_forkGen;
+            }
+            threadRng->inUse = 0;
+            wc_UnLockMutex(&we_threadRngMutex);
+        }
+    }
+
+    /* Add spares to the pool for threads to swap to. */
+    for (; (rc == 0) && (spares < WE_RESEED_SPARE_RNGS); spares++) {
+        threadRng = (we_ThreadRng *)OPENSSL_zalloc(sizeof(we_ThreadRng));
+        if (threadRng == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_ENGINE, "OPENSSL_zalloc",
+                                       threadRng);
+            break;
+        }
+        rc = wc_InitRng(&threadRng->rng);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+            OPENSSL_free(threadRng);
+            break;
+        }
+        threadRng->forkGen = we_forkGen;
+        rc = wc_LockMutex(&we_threadRngMutex);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_LockMutex", rc);
+            wc_FreeRng(&threadRng->rng);
+            OPENSSL_free(threadRng);
+            break;
+        }
+        threadRng->next = we_threadRngs;
+        we_threadRngs = threadRng;
+        we_threadRngCount++;
+        wc_UnLockMutex(&we_threadRngMutex);
+        cnt++;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_reseed_thread_rngs", cnt);
+
+    return cnt;
+}
+
+/**
+ * Reseed worker thread.
+ *
+ * Reseeds the global random's DRBGs every we_reseedSecs seconds and replaces
+ * spare per-thread DRBGs as soon as they are handed out. Requests then don't
+ * wait on the entropy source.
+ *
+ * @param  arg  [in]  Unused.
+ * @returns  NULL.
+ */
+static void *we_reseed_thread_main(void *arg)
+{
+    int cnt;
+    int reseed = 1;
+    struct timespec next;
+
+    (void)arg;
+
+    pthread_mutex_lock(&we_reseedMutex);
+    while (!we_reseedStop) {
+        we_reseedWake = 0;
+        pthread_mutex_unlock(&we_reseedMutex);
+
+        pthread_mutex_lock(&we_reseedWorkMutex);
+        cnt = 0;
+    #ifdef WE_STATIC_WOLFSSL
+        if (reseed) {
+            cnt += we_reseed_shards();
+        }
+    #endif
+        cnt += we_reseed_thread_rngs();
+        pthread_mutex_unlock(&we_reseedWorkMutex);
+
+        pthread_mutex_lock(&we_reseedMutex);
+        we_reseedCount += cnt;
+        if (reseed) {
+            clock_gettime(CLOCK_REALTIME, &next);
+            next.tv_sec += we_reseedSecs;
+            reseed = 0;
+        }
+        while ((!we_reseedStop) && (!we_reseedWake) && (!reseed)) {
+            if (pthread_cond_timedwait(&we_reseedCond, &we_reseedMutex,
+                                       &next) == ETIMEDOUT) {
+                reseed = 1;
+            }
+        }
+    }
+    pthread_mutex_unlock(&we_reseedMutex);
+
+    return NULL;
+}
+
+/**
+ * Create the reseed worker thread.
+ *
+ * Caller must hold the reseed worker's state lock.
+ *
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_reseed_thread_create(void)
+{
+    int ret = 1;
+    int rc;
+
+    we_reseedStop = 0;
+    we_reseedWake = 0;
+    rc = pthread_create(&we_reseedThread, NULL, we_reseed_thread_main, NULL);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "pthread_create", rc);
+        ret = 0;
+    }
+    else {
+        we_reseedRunning = 1;
+    }
+
+    return ret;
+}
+
+/**
+ * Start the reseed worker again in a forked child.
+ *
+ * Threads can't safely be created in the fork handler so it is done on the
+ * first use of a DRBG after the fork.
+ */
+void we_reseed_thread_restart(void)
+{
+    pthread_mutex_lock(&we_reseedCtrlMutex);
+    pthread_mutex_lock(&we_reseedMutex);
+    /* Check again now that no other thread can be restarting. */
+    if (we_reseedRestart) {
+        we_reseedRestart = 0;
+        if ((we_reseedSecs > 0) && (!we_reseedRunning) &&
+                (we_reseed_thread_create() == 0)) {
+            we_reseedSecs = 0;
+        }
+    }
+    pthread_mutex_unlock(&we_reseedMutex);
+    pthread_mutex_unlock(&we_reseedCtrlMutex);
+}
+
+/**
+ * Stop the reseed worker thread and wait for it to exit.
+ *
+ * Caller must hold the reseed worker's control lock.
+ */
+static void we_reseed_thread_stop(void)
+{
+    int running;
+
+    pthread_mutex_lock(&we_reseedMutex);
+    running = we_reseedRunning;
+    we_reseedSecs = 0;
+    we_reseedRestart = 0;
+    we_reseedStop = 1;
+    we_reseedRunning = 0;
+    pthread_cond_signal(&we_reseedCond);
+    pthread_mutex_unlock(&we_reseedMutex);
+
+    if (running) {
+        pthread_join(we_reseedThread, NULL);
+    }
+}
+
+/**
+ * Start, stop or change the period of the reseed worker.
+ *
+ * @param  secs  [in]  Seconds between reseeds of the DRBGs. 0 stops the
+ *                     worker.
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_reseed_thread_set(long secs)
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_reseed_thread_set");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_ENGINE, "ARGS [secs = %ld]", secs);
+
+    if (secs < 0) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Reseed period is negative");
+        ret = 0;
+    }
+    else if (!we_globalRngInited) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Global random not initialized");
+        ret = 0;
+    }
+    if (ret == 1) {
+        pthread_mutex_lock(&we_reseedCtrlMutex);
+        if (secs == 0) {
+            we_reseed_thread_stop();
+        }
+        else {
+            pthread_mutex_lock(&we_reseedMutex);
+            we_reseedSecs = secs;
+            if (we_reseedRunning) {
+                /* New period is used after the next reseed. */
+                we_reseedWake = 1;
+                pthread_cond_signal(&we_reseedCond);
+            }
+            else {
+                ret = we_reseed_thread_create();
+                if (ret == 0) {
+                    we_reseedSecs = 0;
+                }
+            }
+            pthread_mutex_unlock(&we_reseedMutex);
+        }
+        pthread_mutex_unlock(&we_reseedCtrlMutex);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_reseed_thread_set", ret);
+
+    return ret;
+}
+
+/**
+ * Put the reseed worker's statistics into the stats object.
+ *
+ * @param  stats  [out]  Statistics object.
+ */
+static void we_reseed_get_stats(wolfEngine_Stats *stats)
+{
+    if (pthread_mutex_lock(&we_reseedMutex) == 0) {
+        stats->drbgReseeds = we_reseedCount;
+        pthread_mutex_unlock(&we_reseedMutex);
+    }
+}
+
+/**
+ * Take the reseed worker's locks before forking - waits for the worker to
+ * finish working on DRBGs.
+ */
+static void we_reseed_fork_prepare(void)
+{
+    pthread_mutex_lock(&we_reseedCtrlMutex);
+    pthread_mutex_lock(&we_reseedWorkMutex);
+    pthread_mutex_lock(&we_reseedMutex);
+}
+
+/**
+ * Release the reseed worker's locks after forking, in the parent.
+ */
+static void we_reseed_fork_parent(void)
+{
+    pthread_mutex_unlock(&we_reseedMutex);
+    pthread_mutex_unlock(&we_reseedWorkMutex);
+    pthread_mutex_unlock(&we_reseedCtrlMutex);
+}
+
+/**
+ * Mark the reseed worker as gone after forking, in the child, and release
+ * locks.
+ *
+ * Threads are not copied into the child. When it was running in the parent,
+ * the worker is started again on the next use of a DRBG - creating threads in
+ * a fork handler isn't safe.
+ */
+static void we_reseed_fork_child(void)
+{
+    /* Condition may have had the parent's worker waiting on it. */
+    pthread_cond_init(&we_reseedCond, NULL);
+    we_reseedRunning = 0;
+    we_reseedRestart = (we_reseedSecs > 0);
+    pthread_mutex_unlock(&we_reseedMutex);
+    pthread_mutex_unlock(&we_reseedWorkMutex);
+    pthread_mutex_unlock(&we_reseedCtrlMutex);
+}
+
+#endif /* WE_HAVE_RESEED_THREAD */
+
+/**
+ * Dispose of the first cnt shards of the global random number generator.
+ *
+ * @param  cnt  [in]  Number of shards to free.
+ */
+static void we_free_rng_shards(int cnt)
+{
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+    #ifndef WE_SINGLE_THREADED
+        wc_FreeMutex(&we_rngShards[i].mutex);
+    #endif
+        wc_FreeRng(&we_rngShards[i].rng);
+    #ifndef WE_STATIC_WOLFSSL
+        /* Don't leave seed data in memory. */
+        OPENSSL_cleanse(we_rngShards[i].seed, sizeof(we_rngShards[i].seed));
+        we_rngShards[i].haveSeed = 0;
+    #endif
+    }
+}
+
+/**
+ * Initialize the global random number generator object.
+ *
+ * Each shard has its own DRBG, instantiated with independent entropy, and its
+ * own lock.
+ *
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_init_random(void)
+{
+    int ret = 1;
+    int rc;
+    int i;
+
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_init_random");
+
+    if (!we_globalRngInited) {
+        for (i = 0; (ret == 1) && (i < WE_RNG_SHARDS); i++) {
+            rc = wc_InitRng(&we_rngShards[i].rng);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+                ret = 0;
+            }
+        #ifdef WE_HAVE_FORK_CHECK
+            we_rngShards[i].forkGen = we_forkGen;
+        #endif
+        #ifndef WE_SINGLE_THREADED
+            if (ret == 1) {
+                rc = wc_InitMutex(&we_rngShards[i].mutex);
+                if (rc != 0) {
+                    wc_FreeRng(&we_rngShards[i].rng);
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitMutex", rc);
+                    ret = 0;
+                }
+            }
+        #endif
+            if (ret == 0) {
+                we_free_rng_shards(i);
+            }
+        }
+    #ifdef WE_HAVE_THREAD_RNG
+        if (ret == 1) {
+            ret = we_init_thread_rng();
+            if (ret == 0) {
+                we_free_rng_shards(WE_RNG_SHARDS);
+            }
+        }
+    #endif
+    #ifdef WE_HAVE_ENTROPY_POOL
+        if (ret == 1) {
+            ret = we_init_entropy_pool();
+            if (ret == 0) {
+            #ifdef WE_HAVE_THREAD_RNG
+                we_final_thread_rng();
+            #endif
+                we_free_rng_shards(WE_RNG_SHARDS);
+            }
+        }
+    #endif
+        if (ret == 1) {
+            we_globalRngInited = 1;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_init_random", ret);
+
+    return ret;
+}
+
+/**
+ * Free the global random number generator object.
+ */
+static void we_final_random(void)
+{
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_final_random");
+
+    if (we_globalRngInited) {
+    #ifdef WE_HAVE_RESEED_THREAD
+        /* Worker uses the DRBGs about to be freed. */
+        pthread_mutex_lock(&we_reseedCtrlMutex);
+        we_reseed_thread_stop();
+        pthread_mutex_unlock(&we_reseedCtrlMutex);
+    #endif
+    #ifdef WE_HAVE_ENTROPY_POOL
+        we_final_entropy_pool();
+    #endif
+    #ifdef WE_HAVE_THREAD_RNG
+        we_final_thread_rng();
+    #endif
+        we_free_rng_shards(WE_RNG_SHARDS);
+        we_globalRngInited = 0;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_final_random", 1);
+}
+
+#ifdef WE_HAVE_FORK_CHECK
+
+/* Number of times this process has been forked from its ancestor. */
+volatile int we_forkGen = 0;
+/* Fork handlers have been registered - can't be unregistered. */
+static int we_forkHandlersSet = 0;
+
+/**
+ * Re-instantiate a long-lived RNG if the process has forked since the RNG was
+ * last used.
+ *
+ * Parent and child processes must not produce the same random.
+ *
+ * @param  rng      [in]      Random number generator.
+ * @param  forkGen  [in,out]  Fork generation the RNG was instantiated in.
+ * @returns  1 on success and 0 on failure.
+ */
+int we_rng_fork_check(WC_RNG *rng, int *forkGen)
+{
+    int ret = 1;
+    int rc;
+
+    if (*forkGen != we_forkGen) {
+        WOLFENGINE_MSG(WE_LOG_ENGINE, "Process forked - re-instantiating RNG");
+        wc_FreeRng(rng);
+        rc = wc_InitRng(rng);
+        if (rc != 0) {
+            /* Generation left as is so next use tries again. */
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+            ret = 0;
+        }
+        else {
+            *forkGen = we_forkGen;
+        }
+    }
+
+    return ret;
+}
+
+/**
+ * Take all random locks before forking so that the child gets consistent
+ * random state and no locks held by threads that don't exist in the child.
+ */
+static void we_fork_prepare(void)
+{
+    int i;
+
+#ifdef WE_HAVE_BULK_THREADS
+    we_bulk_fork_prepare();
+#endif
+#ifdef WE_HAVE_RESEED_THREAD
+    /* Taken first as the worker takes the random locks while working. */
+    we_reseed_fork_prepare();
+#endif
+    if (we_globalRngInited) {
+        for (i = 0; i < WE_RNG_SHARDS; i++) {
+            wc_LockMutex(&we_rngShards[i].mutex);
+        }
+    #ifdef WE_HAVE_THREAD_RNG
+        wc_LockMutex(&we_threadRngMutex);
+    #endif
+    #ifdef WE_HAVE_ENTROPY_POOL
+        we_entropy_fork_prepare();
+    #endif
+    }
+}
+
+/**
+ * Release all random locks after forking, in the parent.
+ */
+static void we_fork_parent(void)
+{
+    int i;
+
+    if (we_globalRngInited) {
+    #ifdef WE_HAVE_ENTROPY_POOL
+        we_entropy_fork_parent();
+    #endif
+    #ifdef WE_HAVE_THREAD_RNG
+        wc_UnLockMutex(&we_threadRngMutex);
+    #endif
+        for (i = WE_RNG_SHARDS - 1; i >= 0; i--) {
+            wc_UnLockMutex(&we_rngShards[i].mutex);
+        }
+    }
+#ifdef WE_HAVE_RESEED_THREAD
+    we_reseed_fork_parent();
+#endif
+#ifdef WE_HAVE_BULK_THREADS
+    we_bulk_fork_parent();
+#endif
+}
+
+/**
+ * Release all random locks after forking, in the child.
+ *
+ * The child has only the forking thread. Cached DRBGs are not re-instantiated
+ * here - each is re-instantiated on next use by checking the fork generation,
+ * so fork is not slowed by gathering entropy for DRBGs the child may never
+ * use.
+ */
+static void we_fork_child(void)
+{
+    int i;
+#ifdef WE_HAVE_THREAD_RNG
+    we_ThreadRng *threadRng;
+    we_ThreadRng *current;
+#endif
+
+    we_forkGen++;
+
+    if (we_globalRngInited) {
+    #ifdef WE_HAVE_ENTROPY_POOL
+        /* Discards entropy the parent may also hand out. */
+        we_entropy_fork_child();
+    #endif
+    #ifdef WE_HAVE_THREAD_RNG
+        /* Only the forking thread exists - other threads' DRBGs are free. */
+        current = (we_ThreadRng *)pthread_getspecific(we_threadRngKey);
+        for (threadRng = we_threadRngs; threadRng != NULL;
+             threadRng = threadRng->next) {
+            threadRng->inUse = (threadRng == current);
+        }
+        wc_UnLockMutex(&we_threadRngMutex);
+    #endif
+        for (i = WE_RNG_SHARDS - 1; i >= 0; i--) {
+            wc_UnLockMutex(&we_rngShards[i].mutex);
+        }
+    }
+#ifdef WE_HAVE_RESEED_THREAD
+    we_reseed_fork_child();
 #endif
+#ifdef WE_HAVE_BULK_THREADS
+    we_bulk_fork_child();
+#endif
+}
 
 /**
- * Initialize the global random number generator object.
+ * Register the fork handlers - once per process.
+ *
+ * Handlers registered by a shared library are removed when it is unloaded.
  *
  * @returns  1 on success and 0 on failure.
  */
-static int we_init_random(void)
+static int we_init_fork_handlers(void)
 {
     int ret = 1;
     int rc;
 
-    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_init_random");
+    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_init_fork_handlers");
 
-    if (!we_globalRngInited) {
-        rc = wc_InitRng(&we_globalRng);
+    if (!we_forkHandlersSet) {
+        rc = pthread_atfork(we_fork_prepare, we_fork_parent, we_fork_child);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "pthread_atfork", rc);
             ret = 0;
         }
-    #ifndef WE_SINGLE_THREADED
-        if (ret == 1) {
-            rc = wc_InitMutex(&we_global_rng_mutex);
-            if (rc != 0) {
-                wc_FreeRng(&we_globalRng);
-                WOLFENGINE_ERROR_FUNC(WE_LOG_ENGINE, "wc_InitRng", rc);
-                ret = 0;
-            }
-        }
-    #endif
-        if (ret == 1) {
-            we_globalRngInited = 1;
+        else {
+            we_forkHandlersSet = 1;
         }
     }
 
-    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_init_random", ret);
+    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_init_fork_handlers", ret);
 
     return ret;
 }
 
-/**
- * Free the global random number generator object.
- */
-static void we_final_random(void)
-{
-    WOLFENGINE_ENTER(WE_LOG_ENGINE, "we_final_random");
-
-    if (we_globalRngInited) {
-    #ifndef WE_SINGLE_THREADED
-        wc_FreeMutex(&we_global_rng_mutex);
-    #endif
-        wc_FreeRng(&we_globalRng);
-        we_globalRngInited = 0;
-    }
-
-    WOLFENGINE_LEAVE(WE_LOG_ENGINE, "we_final_random", 1);
-}
+#endif /* WE_HAVE_FORK_CHECK */
 
 #endif /* WE_HAVE_ECC || WE_HAVE_AESGCM || WE_HAVE_RSA */
 
@@ -238,6 +1346,12 @@ static const int we_digest_nids[] = {
 #ifdef WE_HAVE_SHA512
     NID_sha512,
 #endif
+#ifdef WE_HAVE_SHA512_224
+    NID_sha512_224,
+#endif
+#ifdef WE_HAVE_SHA512_256
+    NID_sha512_256,
+#endif
 #ifdef WE_HAVE_SHA3_224
     NID_sha3_224,
 #endif
@@ -250,6 +1364,18 @@ static const int we_digest_nids[] = {
 #ifdef WE_HAVE_SHA3_512
     NID_sha3_512,
 #endif
+#ifdef WE_HAVE_SHAKE128
+    NID_shake128,
+#endif
+#ifdef WE_HAVE_SHAKE256
+    NID_shake256,
+#endif
+#ifdef WE_HAVE_BLAKE2B
+    NID_blake2b512,
+#endif
+#ifdef WE_HAVE_BLAKE2S
+    NID_blake2s256,
+#endif
 #if defined(WE_HAVE_ECC) && defined(WE_HAVE_SHA1)
     NID_ecdsa_with_SHA1,
 #endif
@@ -300,6 +1426,16 @@ enum wc_HashType we_nid_to_wc_hash_type(int nid)
             hashType = WC_HASH_TYPE_SHA512;
             break;
 #endif
+#ifdef WE_HAVE_SHA512_224
+        case NID_sha512_224:
+            hashType = WC_HASH_TYPE_SHA512_224;
+            break;
+#endif
+#ifdef WE_HAVE_SHA512_256
+        case NID_sha512_256:
+            hashType = WC_HASH_TYPE_SHA512_256;
+            break;
+#endif
 #ifdef WE_HAVE_SHA3_224
         case NID_sha3_224:
             hashType = WC_HASH_TYPE_SHA3_224;
@@ -413,6 +1549,16 @@ static int we_digests(ENGINE *e, const EVP_MD **digest, const int **nids,
             *digest = we_sha512_md;
             break;
 #endif
+#ifdef WE_HAVE_SHA512_224
+        case NID_sha512_224:
+            *digest = we_sha512_224_md;
+            break;
+#endif
+#ifdef WE_HAVE_SHA512_256
+        case NID_sha512_256:
+            *digest = we_sha512_256_md;
+            break;
+#endif
 #ifdef WE_HAVE_SHA3_224
         case NID_sha3_224:
             *digest = we_sha3_224_md;
@@ -433,6 +1579,26 @@ static int we_digests(ENGINE *e, const EVP_MD **digest, const int **nids,
             *digest = we_sha3_512_md;
             break;
 #endif
+#ifdef WE_HAVE_SHAKE128
+        case NID_shake128:
+            *digest = we_shake128_md;
+            break;
+#endif
+#ifdef WE_HAVE_SHAKE256
+        case NID_shake256:
+            *digest = we_shake256_md;
+            break;
+#endif
+#ifdef WE_HAVE_BLAKE2B
+        case NID_blake2b512:
+            *digest = we_blake2b512_md;
+            break;
+#endif
+#ifdef WE_HAVE_BLAKE2S
+        case NID_blake2s256:
+            *digest = we_blake2s256_md;
+            break;
+#endif
 #if defined(WE_HAVE_ECDSA) && defined(WE_HAVE_SHA1)
         case NID_ecdsa_with_SHA1:
             *digest = we_ecdsa_sha1_md;
@@ -470,6 +1636,10 @@ static const int we_cipher_nids[] = {
     NID_aes_256_cbc,
     NID_aes_128_cbc_hmac_sha256,
     NID_aes_256_cbc_hmac_sha256,
+#ifdef WE_HAVE_SHA1
+    NID_aes_128_cbc_hmac_sha1,
+    NID_aes_256_cbc_hmac_sha1,
+#endif
 #endif
 #ifdef WE_HAVE_AESCTR
     NID_aes_128_ctr,
@@ -486,9 +1656,288 @@ static const int we_cipher_nids[] = {
     NID_aes_192_ccm,
     NID_aes_256_ccm,
 #endif
+#ifdef WE_HAVE_AESXTS
+    NID_aes_128_xts,
+    NID_aes_256_xts,
+#endif
+#ifdef WE_HAVE_CHACHA
+    NID_chacha20,
+    NID_chacha20_poly1305,
+#endif
 };
 
 
+#ifdef WE_HAVE_PIPELINE
+/*
+ * Cipher pipelining
+ */
+
+/**
+ * Clear the records and AADs of a pipeline.
+ *
+ * @param  pipe  [in,out]  Pipeline object.
+ */
+void we_pipeline_reset(we_Pipeline *pipe)
+{
+    pipe->out = NULL;
+    pipe->in = NULL;
+    pipe->lens = NULL;
+    pipe->num = 0;
+    pipe->aadCnt = 0;
+}
+
+/**
+ * Handle the pipeline ctrl commands of a cipher.
+ *
+ * Records are not copied - the buffers must be valid until the cipher is
+ * called.
+ *
+ * @param  pipe  [in,out]  Pipeline object.
+ * @param  type  [in]      EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS,
+ *                         EVP_CTRL_SET_PIPELINE_INPUT_BUFS or
+ *                         EVP_CTRL_SET_PIPELINE_INPUT_LENS.
+ * @param  arg   [in]      Number of records.
+ * @param  ptr   [in]      Array of buffers or lengths.
+ * @return  1 on success and 0 on failure.
+ */
+int we_pipeline_ctrl(we_Pipeline *pipe, int type, int arg, void *ptr)
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_CIPHER, "we_pipeline_ctrl");
+
+    if ((arg <= 0) || (arg > WE_MAX_PIPELINES) || (ptr == NULL)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Invalid pipeline records");
+        ret = 0;
+    }
+    else if ((pipe->num != 0) && (pipe->num != arg)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Pipeline record count differs");
+        ret = 0;
+    }
+    else {
+        switch (type) {
+            case EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS:
+                pipe->out = (unsigned char **)ptr;
+                break;
+            case EVP_CTRL_SET_PIPELINE_INPUT_BUFS:
+                pipe->in = (unsigned char **)ptr;
+                break;
+            case EVP_CTRL_SET_PIPELINE_INPUT_LENS:
+                pipe->lens = (size_t *)ptr;
+                break;
+            default:
+                ret = 0;
+                break;
+        }
+        if (ret == 1) {
+            pipe->num = arg;
+        }
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_CIPHER, "we_pipeline_ctrl", ret);
+
+    return ret;
+}
+
+/**
+ * Store the TLS AAD of the next record.
+ *
+ * AADs are set before the pipeline records so each one is kept.
+ *
+ * @param  pipe  [in,out]  Pipeline object.
+ * @param  aad   [in]      TLS AAD - EVP_AEAD_TLS1_AAD_LEN bytes.
+ * @return  1 on success and 0 on failure.
+ */
+int we_pipeline_add_aad(we_Pipeline *pipe, const unsigned char *aad)
+{
+    int ret = 1;
+
+    if (pipe->aadCnt == WE_MAX_PIPELINES) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Too many TLS AADs for pipeline");
+        ret = 0;
+    }
+    else {
+        XMEMCPY(pipe->aad[pipe->aadCnt++], aad, EVP_AEAD_TLS1_AAD_LEN);
+    }
+
+    return ret;
+}
+
+/**
+ * Check all the records of a pipeline have been set.
+ *
+ * When AADs have been set there must be one for each record.
+ *
+ * @param  pipe  [in]  Pipeline object.
+ * @return  1 when pipeline is complete and 0 otherwise.
+ */
+int we_pipeline_check(we_Pipeline *pipe)
+{
+    int ret = 1;
+
+    if ((pipe->out == NULL) || (pipe->in == NULL) || (pipe->lens == NULL)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Pipeline buffers not set");
+        ret = 0;
+    }
+    else if ((pipe->aadCnt != 0) && (pipe->aadCnt != pipe->num)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_CIPHER, "Pipeline TLS AAD count differs");
+        ret = 0;
+    }
+
+    return ret;
+}
+#endif /* WE_HAVE_PIPELINE */
+
+#ifdef WE_HAVE_AES_KEY_CACHE
+/*
+ * AES key schedule reuse
+ */
+
+/**
+ * Check whether a key is the one already expanded into the AES object.
+ *
+ * Callers re-initializing with the same key and a new IV for each message
+ * then only pay for setting the IV.
+ *
+ * @param  cache   [in]  Key expanded into AES object.
+ * @param  key     [in]  Key to set.
+ * @param  keyLen  [in]  Length of key in bytes.
+ * @param  dir     [in]  Direction of key schedule - AES_ENCRYPTION or
+ *                       AES_DECRYPTION.
+ * @returns  1 when the key schedule can be reused and 0 otherwise.
+ */
+int we_aes_key_cache_match(const we_AesKeyCache *cache,
+                           const unsigned char *key, int keyLen, int dir)
+{
+    return (cache->keyLen == keyLen) && (cache->dir == dir) &&
+           (CRYPTO_memcmp(cache->key, key, keyLen) == 0);
+}
+
+/**
+ * Record the key expanded into the AES object.
+ *
+ * @param  cache   [out]  Key expanded into AES object.
+ * @param  key     [in]   Key expanded. NULL when expansion failed - no key is
+ *                        reused.
+ * @param  keyLen  [in]   Length of key in bytes.
+ * @param  dir     [in]   Direction of key schedule - AES_ENCRYPTION or
+ *                        AES_DECRYPTION.
+ */
+void we_aes_key_cache_set(we_AesKeyCache *cache, const unsigned char *key,
+                          int keyLen, int dir)
+{
+    if ((key == NULL) || (keyLen <= 0) ||
+            (keyLen > (int)sizeof(cache->key))) {
+        OPENSSL_cleanse(cache->key, sizeof(cache->key));
+        cache->keyLen = 0;
+    }
+    else {
+        XMEMCPY(cache->key, key, keyLen);
+        cache->keyLen = keyLen;
+        cache->dir = dir;
+    }
+}
+#endif /* WE_HAVE_AES_KEY_CACHE */
+
+#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESXTS)
+/**
+ * Give a byte-wise copy of a wolfSSL AES object its own copy of any memory
+ * wolfSSL allocated for it.
+ *
+ * Used when copying EVP cipher contexts. OpenSSL copies the cipher data
+ * byte-wise before the cipher's EVP_CTRL_COPY is called.
+ *
+ * @param  aes  [in,out]  Copy of wolfSSL AES object.
+ * @return  1 on success and 0 on failure.
+ */
+int we_aes_copy_fixup(Aes *aes)
+{
+    int ret = 1;
+#if defined(WOLFSSL_AESGCM_STREAM) && defined(WOLFSSL_SMALL_STACK) && \
+    !defined(WOLFSSL_AESNI)
+    byte *streamData = aes->streamData;
+
+    /* Never left pointing at the original's buffer - freed with object. */
+    aes->streamData = NULL;
+    if (streamData != NULL) {
+        aes->streamData = (byte *)XMALLOC(5 * AES_BLOCK_SIZE, aes->heap,
+                                          DYNAMIC_TYPE_AES);
+        if (aes->streamData == NULL) {
+            WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_CIPHER, "XMALLOC",
+                                       aes->streamData);
+            ret = 0;
+        }
+        else {
+            XMEMCPY(aes->streamData, streamData, 5 * AES_BLOCK_SIZE);
+        }
+    }
+#else
+    /* Object holds no pointers to wolfSSL allocated memory. */
+    (void)aes;
+#endif
+
+    return ret;
+}
+#endif /* WE_HAVE_AESGCM || WE_HAVE_AESXTS */
+
+#ifdef WE_ALIGNMENT_SAFETY
+/*
+ * Aligned bounce of hash data
+ */
+
+/**
+ * Update a SHA-384/512 based hash object without a potential alignment crash
+ * in the wolfCrypt FIPS 140-2 code.
+ *
+ * wolfCrypt processes whole blocks straight from the data pointer once its
+ * partial block is filled. When that point in the data isn't aligned, the
+ * partial block is filled first and the rest of the data is copied through
+ * an aligned stack buffer, many blocks at a time. No memory is allocated.
+ *
+ * @param  obj      [in,out]  wolfSSL hash or HMAC object.
+ * @param  update   [in]      Update function of object.
+ * @param  buffLen  [in]      Number of bytes in object's partial block.
+ * @param  data     [in]      More data to digest.
+ * @param  len      [in]      Length of data in bytes.
+ * @returns  0 on success and wolfCrypt error code on failure.
+ */
+int we_aligned_update(void *obj, we_HashUpdateFunc update, word32 buffLen,
+                      const byte *data, size_t len)
+{
+    int rc = 0;
+    size_t add;
+    size_t sz;
+    /* 64-bit words keep the buffer aligned. */
+    word64 bounce[WE_ALIGNED_BOUNCE_BLOCKS * WC_SHA512_BLOCK_SIZE /
+                  sizeof(word64)];
+
+    /* Number of bytes that fill the partial block. */
+    add = WC_SHA512_BLOCK_SIZE - buffLen;
+    if (add > len) {
+        add = len;
+    }
+    if (((len - add) >= WC_SHA512_BLOCK_SIZE) &&
+        (((size_t)data + add) % WE_ALIGNMENT_REQ != 0)) {
+        rc = update(obj, data, (word32)add);
+        data += add;
+        len -= add;
+        /* Whole blocks of bounce buffer leave partial block empty. */
+        while ((rc == 0) && (len > 0)) {
+            sz = (len < sizeof(bounce)) ? len : sizeof(bounce);
+            XMEMCPY(bounce, data, sz);
+            rc = update(obj, (const byte *)bounce, (word32)sz);
+            data += sz;
+            len -= sz;
+        }
+    }
+    else {
+        rc = update(obj, data, (word32)len);
+    }
+
+    return rc;
+}
+#endif /* WE_ALIGNMENT_SAFETY */
+
 /*
  * Ciphers
  */
@@ -554,6 +2003,14 @@ static int we_ciphers(ENGINE *e, const EVP_CIPHER **cipher, const int **nids,
         case NID_aes_256_cbc_hmac_sha256:
             *cipher = we_aes256_cbc_hmac_ciph;
             break;
+#ifdef WE_HAVE_SHA1
+        case NID_aes_128_cbc_hmac_sha1:
+            *cipher = we_aes128_cbc_hmac_sha1_ciph;
+            break;
+        case NID_aes_256_cbc_hmac_sha1:
+            *cipher = we_aes256_cbc_hmac_sha1_ciph;
+            break;
+#endif
 #endif
 #ifdef WE_HAVE_AESCTR
         case NID_aes_128_ctr:
@@ -587,6 +2044,22 @@ static int we_ciphers(ENGINE *e, const EVP_CIPHER **cipher, const int **nids,
         case NID_aes_256_ccm:
             *cipher = we_aes256_ccm_ciph;
             break;
+#endif
+#ifdef WE_HAVE_AESXTS
+        case NID_aes_128_xts:
+            *cipher = we_aes128_xts_ciph;
+            break;
+        case NID_aes_256_xts:
+            *cipher = we_aes256_xts_ciph;
+            break;
+#endif
+#ifdef WE_HAVE_CHACHA
+        case NID_chacha20:
+            *cipher = we_chacha20_ciph;
+            break;
+        case NID_chacha20_poly1305:
+            *cipher = we_chacha20_poly1305_ciph;
+            break;
 #endif
         default:
             XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported cipher NID: %d",
@@ -849,6 +2322,16 @@ static int wolfengine_init(ENGINE *e)
         ret = we_init_sha512_meth();
     }
 #endif
+#ifdef WE_HAVE_SHA512_224
+    if (ret == 1) {
+        ret = we_init_sha512_224_meth();
+    }
+#endif
+#ifdef WE_HAVE_SHA512_256
+    if (ret == 1) {
+        ret = we_init_sha512_256_meth();
+    }
+#endif
 #ifdef WE_HAVE_SHA3_224
     if (ret == 1) {
         ret = we_init_sha3_224_meth();
@@ -869,6 +2352,26 @@ static int wolfengine_init(ENGINE *e)
         ret = we_init_sha3_512_meth();
     }
 #endif
+#ifdef WE_HAVE_SHAKE128
+    if (ret == 1) {
+        ret = we_init_shake128_meth();
+    }
+#endif
+#ifdef WE_HAVE_SHAKE256
+    if (ret == 1) {
+        ret = we_init_shake256_meth();
+    }
+#endif
+#ifdef WE_HAVE_BLAKE2B
+    if (ret == 1) {
+        ret = we_init_blake2b512_meth();
+    }
+#endif
+#ifdef WE_HAVE_BLAKE2S
+    if (ret == 1) {
+        ret = we_init_blake2s256_meth();
+    }
+#endif
 #ifdef WE_HAVE_DES3CBC
     if (ret == 1) {
         ret = we_init_des3cbc_meths();
@@ -902,6 +2405,16 @@ static int wolfengine_init(ENGINE *e)
         ret = we_init_aesccm_meths();
     }
 #endif
+#ifdef WE_HAVE_AESXTS
+    if (ret == 1) {
+        ret = we_init_aesxts_meths();
+    }
+#endif
+#ifdef WE_HAVE_CHACHA
+    if (ret == 1) {
+        ret = we_init_chacha_meths();
+    }
+#endif
 #ifdef WE_HAVE_HMAC
     if (ret == 1) {
         ret = we_init_hmac_pkey_meth();
@@ -1041,6 +2554,12 @@ static int wolfengine_destroy(ENGINE *e)
     we_aes128_cbc_hmac_ciph = NULL;
     EVP_CIPHER_meth_free(we_aes256_cbc_hmac_ciph);
     we_aes256_cbc_hmac_ciph = NULL;
+#ifdef WE_HAVE_SHA1
+    EVP_CIPHER_meth_free(we_aes128_cbc_hmac_sha1_ciph);
+    we_aes128_cbc_hmac_sha1_ciph = NULL;
+    EVP_CIPHER_meth_free(we_aes256_cbc_hmac_sha1_ciph);
+    we_aes256_cbc_hmac_sha1_ciph = NULL;
+#endif
 #endif
 #ifdef WE_HAVE_AESCTR
     EVP_CIPHER_meth_free(we_aes128_ctr_ciph);
@@ -1066,6 +2585,18 @@ static int wolfengine_destroy(ENGINE *e)
     EVP_CIPHER_meth_free(we_aes256_ccm_ciph);
     we_aes256_ccm_ciph = NULL;
 #endif
+#ifdef WE_HAVE_AESXTS
+    EVP_CIPHER_meth_free(we_aes128_xts_ciph);
+    we_aes128_xts_ciph = NULL;
+    EVP_CIPHER_meth_free(we_aes256_xts_ciph);
+    we_aes256_xts_ciph = NULL;
+#endif
+#ifdef WE_HAVE_CHACHA
+    EVP_CIPHER_meth_free(we_chacha20_ciph);
+    we_chacha20_ciph = NULL;
+    EVP_CIPHER_meth_free(we_chacha20_poly1305_ciph);
+    we_chacha20_poly1305_ciph = NULL;
+#endif
 #ifdef WE_HAVE_SHA1
     EVP_MD_meth_free(we_sha1_md);
     we_sha1_md = NULL;
@@ -1086,6 +2617,14 @@ static int wolfengine_destroy(ENGINE *e)
     EVP_MD_meth_free(we_sha512_md);
     we_sha512_md = NULL;
 #endif
+#ifdef WE_HAVE_SHA512_224
+    EVP_MD_meth_free(we_sha512_224_md);
+    we_sha512_224_md = NULL;
+#endif
+#ifdef WE_HAVE_SHA512_256
+    EVP_MD_meth_free(we_sha512_256_md);
+    we_sha512_256_md = NULL;
+#endif
 #ifdef WE_HAVE_SHA3_224
     EVP_MD_meth_free(we_sha3_224_md);
     we_sha3_224_md = NULL;
@@ -1102,6 +2641,22 @@ static int wolfengine_destroy(ENGINE *e)
     EVP_MD_meth_free(we_sha3_512_md);
     we_sha3_512_md = NULL;
 #endif
+#ifdef WE_HAVE_SHAKE128
+    EVP_MD_meth_free(we_shake128_md);
+    we_shake128_md = NULL;
+#endif
+#ifdef WE_HAVE_SHAKE256
+    EVP_MD_meth_free(we_shake256_md);
+    we_shake256_md = NULL;
+#endif
+#ifdef WE_HAVE_BLAKE2B
+    EVP_MD_meth_free(we_blake2b512_md);
+    we_blake2b512_md = NULL;
+#endif
+#ifdef WE_HAVE_BLAKE2S
+    EVP_MD_meth_free(we_blake2s256_md);
+    we_blake2s256_md = NULL;
+#endif
 #if defined(WE_HAVE_ECDSA) && defined(WE_HAVE_SHA1)
     EVP_MD_meth_free(we_ecdsa_sha1_md);
     we_ecdsa_sha1_md = NULL;
@@ -1109,6 +2664,9 @@ static int wolfengine_destroy(ENGINE *e)
 #if defined(WE_HAVE_ECC) || defined(WE_HAVE_AESGCM) || defined(WE_HAVE_RSA)
     we_final_random();
 #endif
+#ifdef WE_HAVE_BULK_THREADS
+    we_final_bulk();
+#endif
 
     bound = NULL;
 
@@ -1124,6 +2682,12 @@ static int wolfengine_destroy(ENGINE *e)
 #define WOLFENGINE_CMD_ENABLE_FIPS_CHECKS     (ENGINE_CMD_BASE + 4)
 #define WOLFENGINE_CMD_ENABLE_DEBUG_WOLFSSL   (ENGINE_CMD_BASE + 5)
 #define WOLFENGINE_CMD_SET_LOGGING_CB_WOLFSSL (ENGINE_CMD_BASE + 6)
+#define WOLFENGINE_CMD_SET_ENTROPY_WATERMARK  (ENGINE_CMD_BASE + 7)
+#define WOLFENGINE_CMD_GET_STATS              (ENGINE_CMD_BASE + 8)
+#define WOLFENGINE_CMD_SET_RESEED_THREAD      (ENGINE_CMD_BASE + 9)
+#define WOLFENGINE_CMD_SET_BULK_THREADS       (ENGINE_CMD_BASE + 10)
+#define WOLFENGINE_CMD_SET_BULK_THRESHOLD     (ENGINE_CMD_BASE + 11)
+#define WOLFENGINE_CMD_DIGEST_BATCH           (ENGINE_CMD_BASE + 12)
 
 /**
  * wolfEngine control command list.
@@ -1150,10 +2714,30 @@ static int wolfengine_destroy(ENGINE *e)
  *                  wolfEngine_LogComponents enum. Default wolfEngine component
  *                  selection logs all components unless set by application.
  *
+ * entropy_watermark - Set the number of bytes of entropy left in the entropy
+ *                     pool below which it is refilled. Default 0 refills only
+ *                     when empty. Only used when statically linked.
+ *
+ * reseed_thread - Run a worker thread that reseeds the DRBGs every given
+ *                 number of seconds, so that requests don't wait on the
+ *                 entropy source. 0 stops the worker. Requires pthreads.
+ *
+ * bulk_threads - Number of worker threads that very large AES-CTR, AES-ECB
+ *                and AES-CBC decrypt buffers, and large digest batches, are
+ *                split across. 0, the default, processes all data on the
+ *                calling thread. Requires pthreads.
+ *
+ * bulk_threshold - Minimum length of data, in bytes, to split across the bulk
+ *                  worker threads. 0 restores the default of 1 MiB.
+ *
  * INTERNAL COMMANDS (not listed here, as not NUMERIC, STRING, or NO_INPUT):
  * "set_logging_cb" - Sets the wolfEngine loggging callback, function pointer
  *                    passed in must match wolfEngine_Logging_cb prototype
  *                    from we_logging.h.
+ * "get_stats"      - Copies the engine statistics into the wolfEngine_Stats
+ *                    object passed in as the pointer.
+ * "digest_batch"   - Digests each message of the wolfEngine_DigestBatch
+ *                    object passed in as the pointer.
  *
  */
 static ENGINE_CMD_DEFN wolfengine_cmd_defns[] = {
@@ -1187,6 +2771,31 @@ static ENGINE_CMD_DEFN wolfengine_cmd_defns[] = {
       "set_logging_cb_wolfssl",
       "Set wolfSSL logging callback",
       ENGINE_CMD_FLAG_INTERNAL },
+    { WOLFENGINE_CMD_SET_ENTROPY_WATERMARK,
+      "entropy_watermark",
+      "Set entropy pool refill watermark in bytes (0=refill when empty)",
+      ENGINE_CMD_FLAG_NUMERIC },
+    { WOLFENGINE_CMD_GET_STATS,
+      "get_stats",
+      "Get wolfEngine statistics (pointer to wolfEngine_Stats)",
+      ENGINE_CMD_FLAG_INTERNAL },
+    { WOLFENGINE_CMD_SET_RESEED_THREAD,
+      "reseed_thread",
+      "Reseed DRBGs in a worker thread every N seconds (0=stop)",
+      ENGINE_CMD_FLAG_NUMERIC },
+    { WOLFENGINE_CMD_SET_BULK_THREADS,
+      "bulk_threads",
+      "Split large AES-CTR/ECB/CBC-decrypt data and digest batches "
+          "across N threads (0=off)",
+      ENGINE_CMD_FLAG_NUMERIC },
+    { WOLFENGINE_CMD_SET_BULK_THRESHOLD,
+      "bulk_threshold",
+      "Minimum data length in bytes to split across threads (0=default)",
+      ENGINE_CMD_FLAG_NUMERIC },
+    { WOLFENGINE_CMD_DIGEST_BATCH,
+      "digest_batch",
+      "Digest many messages (pointer to wolfEngine_DigestBatch)",
+      ENGINE_CMD_FLAG_INTERNAL },
 
     /* last element MUST be NULL/0 entry, do not remove */
     {0, NULL, NULL, 0}
@@ -1291,6 +2900,94 @@ static int wolfengine_ctrl(ENGINE* e, int cmd, long i, void* p,
                 "wolfCrypt isn't FIPS.");
         #endif /* HAVE_FIPS || HAVE_FIPS_VERSION */
             break;
+        case WOLFENGINE_CMD_SET_ENTROPY_WATERMARK:
+        #ifdef WE_HAVE_RANDOM
+            ret = we_entropy_set_watermark(i);
+        #else
+            WOLFENGINE_MSG(WE_LOG_ENGINE, "Control command "
+                "WOLFENGINE_CMD_SET_ENTROPY_WATERMARK has no effect when "
+                "random isn't enabled.");
+        #endif
+            break;
+        case WOLFENGINE_CMD_GET_STATS:
+            if (p == NULL) {
+                WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Stats object is NULL");
+                ret = 0;
+            }
+            else {
+                XMEMSET(p, 0, sizeof(wolfEngine_Stats));
+            #ifdef WE_HAVE_RANDOM
+                we_entropy_get_stats((wolfEngine_Stats *)p);
+            #ifdef WE_HAVE_THREAD_RNG
+                we_thread_rng_get_stats((wolfEngine_Stats *)p);
+            #endif
+            #endif
+            #ifdef WE_HAVE_RESEED_THREAD
+                we_reseed_get_stats((wolfEngine_Stats *)p);
+            #endif
+            #ifdef WE_HAVE_BULK_THREADS
+                we_bulk_get_stats((wolfEngine_Stats *)p);
+            #endif
+            #ifdef WE_HAVE_AESGCM
+                we_aes_gcm_get_stats((wolfEngine_Stats *)p);
+            #endif
+            #ifdef WE_HAVE_AESCBC
+                we_aes_cbc_hmac_get_stats((wolfEngine_Stats *)p);
+            #endif
+            }
+            break;
+        case WOLFENGINE_CMD_SET_RESEED_THREAD:
+        #ifdef WE_HAVE_RESEED_THREAD
+            ret = we_reseed_thread_set(i);
+        #else
+            WOLFENGINE_MSG(WE_LOG_ENGINE, "Control command "
+                "WOLFENGINE_CMD_SET_RESEED_THREAD has no effect when "
+                "built without pthreads.");
+        #endif
+            break;
+        case WOLFENGINE_CMD_SET_BULK_THREADS:
+            /* Validated in all builds - same behavior with or without pool. */
+            if ((i < 0) || (i > WE_BULK_MAX_THREADS)) {
+                WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Bulk thread count out "
+                                     "of range");
+                ret = 0;
+            }
+            else {
+            #ifdef WE_HAVE_BULK_THREADS
+                ret = we_bulk_set_threads(i);
+            #else
+                WOLFENGINE_MSG(WE_LOG_ENGINE, "Control command "
+                    "WOLFENGINE_CMD_SET_BULK_THREADS has no effect when "
+                    "built without pthreads.");
+            #endif
+            }
+            break;
+        case WOLFENGINE_CMD_SET_BULK_THRESHOLD:
+            if (i < 0) {
+                WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Bulk threshold is "
+                                     "negative");
+                ret = 0;
+            }
+            else {
+            #ifdef WE_HAVE_BULK_THREADS
+                ret = we_bulk_set_threshold(i);
+            #else
+                WOLFENGINE_MSG(WE_LOG_ENGINE, "Control command "
+                    "WOLFENGINE_CMD_SET_BULK_THRESHOLD has no effect when "
+                    "built without pthreads.");
+            #endif
+            }
+            break;
+        case WOLFENGINE_CMD_DIGEST_BATCH:
+        #ifdef WE_HAVE_DIGEST
+            ret = we_digest_batch((wolfEngine_DigestBatch *)p);
+        #else
+            WOLFENGINE_ERROR_MSG(WE_LOG_ENGINE, "Control command "
+                "WOLFENGINE_CMD_DIGEST_BATCH not supported when built "
+                "without digests.");
+            ret = 0;
+        #endif
+            break;
         default:
             XSNPRINTF(errBuff, sizeof(errBuff), "Unsupported ctrl type %d",
                       cmd);
@@ -1390,6 +3087,12 @@ int wolfengine_bind(ENGINE *e, const char *id)
     if (ret == 1) {
         ret = ENGINE_set_id(e, wolfengine_id);
     }
+#ifdef WE_HAVE_FORK_CHECK
+    if (ret == 1) {
+        /* Cached random state must not be shared with forked children. */
+        ret = we_init_fork_handlers();
+    }
+#endif
     if (ret == 1) {
         ret = wolfengine_init(e);
     }
@@ -852,6 +852,18 @@ static int we_hmac_copy(Hmac* dst, Hmac* src)
                 rc = wc_Sha512Copy(&src->hash.sha512, &dst->hash.sha512);
                 break;
         #endif /* WOLFSSL_SHA512 */
+        #ifdef WE_HAVE_SHA512_224
+            case WC_SHA512_224:
+                WOLFENGINE_MSG(WE_LOG_MAC, "macType: WC_SHA512_224");
+                rc = wc_Sha512_224Copy(&src->hash.sha512, &dst->hash.sha512);
+                break;
+        #endif /* WE_HAVE_SHA512_224 */
+        #ifdef WE_HAVE_SHA512_256
+            case WC_SHA512_256:
+                WOLFENGINE_MSG(WE_LOG_MAC, "macType: WC_SHA512_256");
+                rc = wc_Sha512_256Copy(&src->hash.sha512, &dst->hash.sha512);
+                break;
+        #endif /* WE_HAVE_SHA512_256 */
     #ifdef WOLFSSL_SHA3
         #ifndef WOLFSSL_NOSHA3_224
             case WC_SHA3_224:
@@ -996,6 +1008,21 @@ static int we_hmac_pkey_init(EVP_PKEY_CTX *ctx)
     return ret;
 }
 
+#ifdef WE_ALIGNMENT_SAFETY
+/**
+ * Update a wolfCrypt HMAC object - called through a generic pointer.
+ *
+ * @param  hmac  [in,out]  wolfCrypt HMAC data structure.
+ * @param  data  [in]      Data to be passed to HMAC update.
+ * @param  len   [in]      Size of data buffer.
+ * @returns  0 on success and wolfCrypt error code on failure.
+ */
+static int we_hmac_obj_update(void *hmac, const byte *data, word32 len)
+{
+    return wc_HmacUpdate((Hmac *)hmac, data, len);
+}
+#endif
+
 /**
  * Update the HMAC hmac with dataSz bytes from data. If wolfEngine has been
  * built with WE_ALIGNMENT_SAFETY, this function provides a fix for a potential
@@ -1015,71 +1042,28 @@ int we_hmac_update(Hmac* hmac, const void *data, size_t dataSz) {
                            "dataSz = %zu]", hmac, data, dataSz);
 
 #ifdef WE_ALIGNMENT_SAFETY
-    const word32 ALIGNMENT_REQ = 8;
-    word32 add = 0;
-    word32 internalBuffLen = 0;
-    byte* tmp = NULL;
     if (hmac->macType == WC_HASH_TYPE_SHA384 ||
+    #ifdef WE_HAVE_SHA512_224
+        hmac->macType == WC_HASH_TYPE_SHA512_224 ||
+    #endif
+    #ifdef WE_HAVE_SHA512_256
+        hmac->macType == WC_HASH_TYPE_SHA512_256 ||
+    #endif
         hmac->macType == WC_HASH_TYPE_SHA512)  {
-        internalBuffLen = hmac->hash.sha512.buffLen;
-        add = dataSz > (WC_SHA512_BLOCK_SIZE - internalBuffLen) ?
-              (WC_SHA512_BLOCK_SIZE - internalBuffLen) : dataSz;
-    }
-    /* If the conditions below are satisfied, just calling wc_HmacUpdate with
-     * the passed in buffer and length can cause a memory alignment crash on
-     * certain platforms. The alternate algorithm used below (2 calls to
-     * wc_HmacUpdate) avoids this crash. */
-    if (dataSz > 0 && add > 0 && ((dataSz - add) >= WC_SHA512_BLOCK_SIZE) &&
-        (((unsigned long)data + add) % ALIGNMENT_REQ != 0)) {
-        /* Update the hash with "add" bytes of data, which will result in
-         * an update with a full WC_SHA512_BLOCK_SIZE number of bytes with no
-         * leftovers. */
-        rc = wc_HmacUpdate(hmac, (const byte*)data, add);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_MAC, "wc_HmacUpdate", rc);
-            ret = 0;
-        }
-        if (ret == 1) {
-            /* Allocate new, aligned buffer. */
-            tmp = (byte*)XMALLOC(WC_SHA512_BLOCK_SIZE, NULL, DYNAMIC_TYPE_TMP_BUFFER);
-            if (tmp == NULL) {
-                WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_MAC, "XMALLOC", tmp);
-                ret = 0;
-            }
-        }
-        if (ret == 1) {
-            /* Copy remaining data from the unaligned buffer to the aligned one
-             * and update the hash iteratively, one block's worth of data at a
-             * time. */
-            byte* nextData = (byte*)data + add;
-            for (size_t remaining = dataSz - add; remaining > 0;) {
-                size_t nextLen = (remaining <= WC_SHA512_BLOCK_SIZE) ?
-                    remaining : WC_SHA512_BLOCK_SIZE;
-                XMEMCPY(tmp, nextData, nextLen);
-                rc = wc_HmacUpdate(hmac, (const byte*)tmp, nextLen);
-                if (rc != 0) {
-                    WOLFENGINE_ERROR_FUNC(WE_LOG_MAC, "wc_HmacUpdate", rc);
-                    ret = 0;
-                    break;
-                }
-                nextData += nextLen;
-                remaining -= nextLen;
-            }
-        }
-
-        if (tmp != NULL) {
-            XFREE(tmp, NULL, DYNAMIC_TYPE_TMP_BUFFER);
-        }
+        /* Unaligned blocks are copied through an aligned stack buffer. */
+        rc = we_aligned_update(hmac, we_hmac_obj_update,
+                               hmac->hash.sha512.buffLen, (const byte*)data,
+                               dataSz);
     }
     else
 #endif
     {
         /* Update the wolfCrypt HMAC object with more data. */
         rc = wc_HmacUpdate(hmac, (const byte*)data, (word32)dataSz);
-        if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_MAC, "wc_HmacUpdate", rc);
-            ret = 0;
-        }
+    }
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_MAC, "wc_HmacUpdate", rc);
+        ret = 0;
     }
 
     WOLFENGINE_LEAVE(WE_LOG_MAC, "we_hmac_update", ret);
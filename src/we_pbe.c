@@ -67,10 +67,16 @@ static int we_hmac_to_wc_hash(int nid)
             hashType = WC_SHA512;
             break;
     #endif
-        /* TODO: OpenSSL also has -
-         *     NID_hmacWithSHA512_224
-         *     NID_hmacWithSHA512_256
-         */
+    #ifdef WE_HAVE_SHA512_224
+        case NID_hmacWithSHA512_224:
+            hashType = WC_SHA512_224;
+            break;
+    #endif
+    #ifdef WE_HAVE_SHA512_256
+        case NID_hmacWithSHA512_256:
+            hashType = WC_SHA512_256;
+            break;
+    #endif
         default:
             /* Unsupported hash algorithm in wolfCrypt. */
             WOLFENGINE_ERROR_MSG(WE_LOG_PBE, "Hash not supported");
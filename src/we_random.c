@@ -23,17 +23,337 @@
 
 #ifdef WE_HAVE_RANDOM
 
-#ifdef WE_STATIC_WOLFSSL
-extern int wc_RNG_DRBG_Reseed(WC_RNG* rng, const byte* seed, word32 seedSz);
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
-extern int wc_GenerateSeed(OS_Seed* os, byte* seed, int sz);
+#ifdef WE_HAVE_ENTROPY_POOL
+
+/* Entropy read from the entropy source but not yet handed out. */
+static byte we_entropyPool[WE_ENTROPY_POOL_SZ];
+/* Index of next unused byte of entropy. Pool is empty when at end. */
+static int we_entropyPoolIdx = WE_ENTROPY_POOL_SZ;
+/* Refill pool when fewer than this many bytes are left after a request. */
+static int we_entropyWatermark = 0;
+/* Number of requests for entropy. */
+static unsigned long we_entropyRequests = 0;
+/* Number of reads of the entropy source. */
+static unsigned long we_entropyReads = 0;
+/* Number of bytes read from the entropy source. */
+static unsigned long we_entropyReadBytes = 0;
+#ifndef WE_SINGLE_THREADED
+/* Mutex for protecting the entropy pool. */
+static wolfSSL_Mutex we_entropyMutex;
+#endif
+
+/**
+ * Initialize the entropy pool.
+ *
+ * @returns  1 on success and 0 on failure.
+ */
+int we_init_entropy_pool(void)
+{
+    int ret = 1;
+#ifndef WE_SINGLE_THREADED
+    int rc;
+
+    WOLFENGINE_ENTER(WE_LOG_RNG, "we_init_entropy_pool");
+
+    rc = wc_InitMutex(&we_entropyMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_InitMutex", rc);
+        ret = 0;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_RNG, "we_init_entropy_pool", ret);
+#endif
+
+    return ret;
+}
+
+/**
+ * Dispose of the entropy pool - unused entropy is zeroized.
+ */
+void we_final_entropy_pool(void)
+{
+    WOLFENGINE_ENTER(WE_LOG_RNG, "we_final_entropy_pool");
+
+    OPENSSL_cleanse(we_entropyPool, sizeof(we_entropyPool));
+    we_entropyPoolIdx = WE_ENTROPY_POOL_SZ;
+#ifndef WE_SINGLE_THREADED
+    wc_FreeMutex(&we_entropyMutex);
+#endif
+
+    WOLFENGINE_LEAVE(WE_LOG_RNG, "we_final_entropy_pool", 1);
+}
+
+/**
+ * Fill the pool with entropy, keeping the bytes not yet handed out.
+ *
+ * Caller must hold the entropy pool lock.
+ *
+ * @returns  1 on success and 0 on failure.
+ */
+static int we_entropy_pool_fill(void)
+{
+    int ret = 1;
+    int rc;
+    int left = WE_ENTROPY_POOL_SZ - we_entropyPoolIdx;
+    OS_Seed os;
+
+    WOLFENGINE_ENTER(WE_LOG_RNG, "we_entropy_pool_fill");
+
+    /* Move unused entropy to the start and fill the rest in one read. */
+    if ((left > 0) && (we_entropyPoolIdx > 0)) {
+        XMEMMOVE(we_entropyPool, we_entropyPool + we_entropyPoolIdx, left);
+    }
+    rc = wc_GenerateSeed(&os, we_entropyPool + left, WE_ENTROPY_POOL_SZ - left);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_GenerateSeed", rc);
+        /* Pool holds only the unused entropy - now at the end. */
+        if (left > 0) {
+            XMEMMOVE(we_entropyPool + WE_ENTROPY_POOL_SZ - left,
+                     we_entropyPool, left);
+        }
+        ret = 0;
+    }
+    else {
+        we_entropyPoolIdx = 0;
+        we_entropyReads++;
+        we_entropyReadBytes += WE_ENTROPY_POOL_SZ - left;
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_RNG, "we_entropy_pool_fill", ret);
+
+    return ret;
+}
+
+/**
+ * Get entropy from the pool.
+ *
+ * Small requests are served from memory and the pool is refilled in
+ * WE_ENTROPY_POOL_SZ chunks. Entropy is zeroized in the pool once handed out.
+ * Requests as large as the pool are read directly from the entropy source.
+ *
+ * @param  buf  [out]  Buffer to hold entropy.
+ * @param  num  [in]   Number of bytes of entropy to get.
+ * @returns  1 on success and 0 on failure.
+ */
+int we_entropy_get(unsigned char *buf, int num)
+{
+    int ret = 1;
+    int rc;
+    int len;
+    OS_Seed os;
+
+    WOLFENGINE_ENTER(WE_LOG_RNG, "we_entropy_get");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_RNG, "ARGS [buf = %p, num = %d]", buf, num);
+
+#ifndef WE_SINGLE_THREADED
+    rc = wc_LockMutex(&we_entropyMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_LockMutex", rc);
+        ret = 0;
+    }
+    else
 #endif
+    {
+        we_entropyRequests++;
+
+        if (num >= WE_ENTROPY_POOL_SZ) {
+            /* Pooling would not save any reads. */
+            rc = wc_GenerateSeed(&os, buf, num);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_GenerateSeed", rc);
+                ret = 0;
+            }
+            else {
+                we_entropyReads++;
+                we_entropyReadBytes += num;
+            }
+            num = 0;
+        }
+        while ((ret == 1) && (num > 0)) {
+            if (we_entropyPoolIdx == WE_ENTROPY_POOL_SZ) {
+                ret = we_entropy_pool_fill();
+            }
+            if (ret == 1) {
+                len = WE_ENTROPY_POOL_SZ - we_entropyPoolIdx;
+                if (len > num) {
+                    len = num;
+                }
+                XMEMCPY(buf, we_entropyPool + we_entropyPoolIdx, len);
+                /* Entropy must only ever be handed out once. */
+                OPENSSL_cleanse(we_entropyPool + we_entropyPoolIdx, len);
+                we_entropyPoolIdx += len;
+                buf += len;
+                num -= len;
+            }
+        }
+        /* Top up ahead of time so following requests are served from
+         * memory. Failure is left to be handled when pool runs dry. */
+        if ((ret == 1) &&
+                (WE_ENTROPY_POOL_SZ - we_entropyPoolIdx < we_entropyWatermark)) {
+            (void)we_entropy_pool_fill();
+        }
+
+    #ifndef WE_SINGLE_THREADED
+        wc_UnLockMutex(&we_entropyMutex);
+    #endif
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_RNG, "we_entropy_get", ret);
+
+    return ret;
+}
+
+#ifdef WE_HAVE_RESEED_THREAD
+/**
+ * Top up the entropy pool ahead of time.
+ *
+ * The entropy source is read without holding the lock so that requests are
+ * served from the pool meanwhile. Called by the reseed worker.
+ *
+ * @returns  1 on success and 0 on failure.
+ */
+int we_entropy_prefetch(void)
+{
+    int ret = 1;
+    int rc;
+    int need = 0;
+    int len;
+    OS_Seed os;
+    byte fresh[WE_ENTROPY_POOL_SZ];
+
+    WOLFENGINE_ENTER(WE_LOG_RNG, "we_entropy_prefetch");
+
+    rc = wc_LockMutex(&we_entropyMutex);
+    if (rc != 0) {
+        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_LockMutex", rc);
+        ret = 0;
+    }
+    else {
+        need = we_entropyPoolIdx;
+        wc_UnLockMutex(&we_entropyMutex);
+    }
+    if ((ret == 1) && (need > 0)) {
+        rc = wc_GenerateSeed(&os, fresh, need);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_GenerateSeed", rc);
+            ret = 0;
+        }
+    }
+    if ((ret == 1) && (need > 0)) {
+        rc = wc_LockMutex(&we_entropyMutex);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_LockMutex", rc);
+            ret = 0;
+        }
+        else {
+            /* Requests may have refilled the pool while reading. Unused
+             * entropy is at the end so fresh entropy goes in front of it. */
+            len = need;
+            if (len > we_entropyPoolIdx) {
+                len = we_entropyPoolIdx;
+            }
+            XMEMCPY(we_entropyPool + we_entropyPoolIdx - len, fresh, len);
+            we_entropyPoolIdx -= len;
+            we_entropyReads++;
+            we_entropyReadBytes += need;
+            wc_UnLockMutex(&we_entropyMutex);
+        }
+        OPENSSL_cleanse(fresh, need);
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_RNG, "we_entropy_prefetch", ret);
+
+    return ret;
+}
+#endif /* WE_HAVE_RESEED_THREAD */
+
+#ifdef WE_HAVE_FORK_CHECK
+/**
+ * Lock the entropy pool before forking.
+ */
+void we_entropy_fork_prepare(void)
+{
+    wc_LockMutex(&we_entropyMutex);
+}
+
+/**
+ * Unlock the entropy pool after forking, in the parent.
+ */
+void we_entropy_fork_parent(void)
+{
+    wc_UnLockMutex(&we_entropyMutex);
+}
+
+/**
+ * Empty the entropy pool after forking, in the child, and unlock.
+ *
+ * The parent still has the same entropy to hand out.
+ */
+void we_entropy_fork_child(void)
+{
+    OPENSSL_cleanse(we_entropyPool, sizeof(we_entropyPool));
+    we_entropyPoolIdx = WE_ENTROPY_POOL_SZ;
+    wc_UnLockMutex(&we_entropyMutex);
+}
+#endif /* WE_HAVE_FORK_CHECK */
+#endif /* WE_HAVE_ENTROPY_POOL */
+
+/**
+ * Set the number of bytes of entropy below which the pool is refilled.
+ *
+ * @param  watermark  [in]  Refill watermark in bytes. 0 means refill only when
+ *                          empty.
+ * @returns  1 on success and 0 on failure.
+ */
+int we_entropy_set_watermark(long watermark)
+{
+    int ret = 1;
+
+    WOLFENGINE_ENTER(WE_LOG_RNG, "we_entropy_set_watermark");
+    WOLFENGINE_MSG_VERBOSE(WE_LOG_RNG, "ARGS [watermark = %ld]", watermark);
+
+    if ((watermark < 0) || (watermark > WE_ENTROPY_POOL_SZ)) {
+        WOLFENGINE_ERROR_MSG(WE_LOG_RNG, "Entropy watermark out of range");
+        ret = 0;
+    }
+    else {
+#ifdef WE_HAVE_ENTROPY_POOL
+        /* Single word write - read under lock when used. */
+        we_entropyWatermark = (int)watermark;
 #else
-/* Hash of all the seed so far. */
-unsigned char we_seed[WC_SHA256_DIGEST_SIZE] = {0,};
-/* Have added to global seed. */
-int haveSeed = 0;
+        WOLFENGINE_MSG(WE_LOG_RNG, "Entropy pool not used in this build - "
+                       "watermark has no effect");
 #endif
+    }
+
+    WOLFENGINE_LEAVE(WE_LOG_RNG, "we_entropy_set_watermark", ret);
+
+    return ret;
+}
+
+/**
+ * Put the entropy statistics into the stats object.
+ *
+ * @param  stats  [out]  Statistics object.
+ */
+void we_entropy_get_stats(wolfEngine_Stats *stats)
+{
+#ifdef WE_HAVE_ENTROPY_POOL
+#ifndef WE_SINGLE_THREADED
+    if (wc_LockMutex(&we_entropyMutex) == 0)
+#endif
+    {
+        stats->entropyRequests = we_entropyRequests;
+        stats->entropyReads = we_entropyReads;
+        stats->entropyBytes = we_entropyReadBytes;
+    #ifndef WE_SINGLE_THREADED
+        wc_UnLockMutex(&we_entropyMutex);
+    #endif
+    }
+#else
+    (void)stats;
+#endif
+}
 
 #ifndef WE_STATIC_WOLFSSL
 /**
@@ -45,10 +365,12 @@ int haveSeed = 0;
  * @param  num      [in]   Number of random bytes.
  * @param  seed     [in]   Buffer holding seed data.
  * @param  seedLen  [in]   Number of seed bytes.
+ * @param  isState  [in]   Seed is a shard's seed hash - used directly and
+ *                         updated after use.
  * @returns 1 when successful and 0 on fauilure.
  */
 static int we_rand_mix_seed(unsigned char* buf, int num,
-                            const unsigned char* seed, int seedLen)
+                            unsigned char* seed, int seedLen, int isState)
 {
     int ret = 1;
     int rc;
@@ -60,7 +382,8 @@ static int we_rand_mix_seed(unsigned char* buf, int num,
 
     WOLFENGINE_ENTER(WE_LOG_RNG, "we_rand_mix_seed");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_RNG, "ARGS [buf = %p, num = %d, seed = %p, "
-                           "seedLen = %d]", buf, num, seed, seedLen);
+                           "seedLen = %d, isState = %d]", buf, num, seed,
+                           seedLen, isState);
 
     rc = wc_InitSha256(&sha256);
     if (rc != 0) {
@@ -69,7 +392,7 @@ static int we_rand_mix_seed(unsigned char* buf, int num,
     }
     if (rc == 0) {
         /* Set the base seed hash. */
-        if (seed != we_seed) {
+        if (!isState) {
             /* Calculate hash of seed to save from hashing long data. */
             rc = wc_Sha256Update(&sha256, seed, seedLen);
             if (rc != 0) {
@@ -117,8 +440,8 @@ static int we_rand_mix_seed(unsigned char* buf, int num,
             }
         }
 
-        /* Update global seed if just used - don't leave it in memory. */
-        if (seed == we_seed) {
+        /* Update seed hash if just used - don't leave it in memory. */
+        if (isState) {
             rc = wc_Sha256Update(&sha256, seedHash, sizeof(seedHash));
             if (rc != 0) {
                 WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_Sha256Update", rc);
@@ -129,8 +452,8 @@ static int we_rand_mix_seed(unsigned char* buf, int num,
                 WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_Sha256Update", rc);
                 ret = 0;
             }
-            /* Put hash into global seed. */
-            rc = wc_Sha256Final(&sha256, we_seed);
+            /* Put hash into seed hash. */
+            rc = wc_Sha256Final(&sha256, seed);
             if (rc != 0) {
                WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_Sha256Final", rc);
                ret = 0;
@@ -149,6 +472,8 @@ static int we_rand_mix_seed(unsigned char* buf, int num,
 /**
  * Seed the global random number generator.
  *
+ * Seed data is added to every shard so that all random output depends on it.
+ *
  * @param  buf  [in]  Buffer holding seed data.
  * @param  num  [in]  Number of bytes in buffer.
  */
@@ -159,44 +484,80 @@ static int we_rand_seed(const void *buf, int num)
 #endif
 {
     int ret = 1;
-#if defined(WE_STATIC_WOLFSSL) || !defined(WE_SINGLE_THREADED)
     int rc;
+    int i;
+    we_RngShard *shard;
+#ifndef WE_STATIC_WOLFSSL
+    wc_Sha256 sha256;
+    unsigned char seedHash[WC_SHA256_DIGEST_SIZE];
 #endif
 
     WOLFENGINE_ENTER(WE_LOG_RNG, "we_rand_seed");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_RNG, "ARGS [buf = %p, num = %d]", buf, num);
 
-#ifndef WE_SINGLE_THREADED
-    /* Lock for access to globals. */
-    rc = wc_LockMutex(we_rng_mutex);
+#ifndef WE_STATIC_WOLFSSL
+    /* Hash seed once rather than for each shard. */
+    rc = wc_InitSha256(&sha256);
     if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_LockMutex", rc);
+        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_InitSha256", rc);
         ret = 0;
     }
-    else
-#endif
-    {
-#ifdef WE_STATIC_WOLFSSL
-        /* Add the seed to the underlying random number generator. */
-        rc = wc_RNG_DRBG_Reseed(we_rng, buf, num);
+    else {
+        rc = wc_Sha256Update(&sha256, (const byte*)buf, num);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_RNG_DRBG_Reseed", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_Sha256Update", rc);
             ret = 0;
         }
-#else
-        /* Mix the seed into the global seed. */
-        (void)we_rand_mix_seed(we_seed, sizeof(we_seed),
-                (const unsigned char*)buf, num);
-        haveSeed = 1;
+        if (ret == 1) {
+            rc = wc_Sha256Final(&sha256, seedHash);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_Sha256Final", rc);
+                ret = 0;
+            }
+        }
+        wc_Sha256Free(&sha256);
+    }
 #endif
+
+    for (i = 0; (ret == 1) && (i < WE_RNG_SHARDS); i++) {
+        shard = &we_rngShards[i];
     #ifndef WE_SINGLE_THREADED
-        wc_UnLockMutex(we_rng_mutex);
+        /* Lock for access to shard. */
+        rc = we_rng_shard_lock(shard);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "we_rng_shard_lock", rc);
+            ret = 0;
+        }
+        else
     #endif
+        {
+    #ifdef WE_STATIC_WOLFSSL
+            /* Add the seed to the underlying random number generator. */
+            rc = wc_RNG_DRBG_Reseed(&shard->rng, buf, num);
+            if (rc != 0) {
+                WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_RNG_DRBG_Reseed", rc);
+                ret = 0;
+            }
+    #else
+            /* Mix the seed into the shard's seed. */
+            (void)we_rand_mix_seed(shard->seed, sizeof(shard->seed), seedHash,
+                                   sizeof(seedHash), 0);
+            shard->haveSeed = 1;
+    #endif
+        #ifndef WE_SINGLE_THREADED
+            wc_UnLockMutex(&shard->mutex);
+        #endif
+        }
     }
 
+#ifndef WE_STATIC_WOLFSSL
+    OPENSSL_cleanse(seedHash, sizeof(seedHash));
+#endif
+
     WOLFENGINE_LEAVE(WE_LOG_RNG, "we_rand_seed", ret);
 
     (void)ret;
+    (void)rc;
 
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
     return ret;
@@ -207,11 +568,19 @@ static int we_rand_seed(const void *buf, int num)
  * There are public and private randoms that are each seeded from entropy.
  * No way to tell when RAND_priv_rand() is called with methods.
  * Use pseudo-bytes implementation when RAND_bytes(), RAND_priv_bytes() and
- * RAND_pseudo_bytes() are called.
+ * RAND_pseudo_bytes() are called - unless per-thread DRBGs are available, in
+ * which case RAND_bytes() and RAND_priv_bytes() use the calling thread's DRBG
+ * and don't contend on the global random lock.
  */
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#if OPENSSL_VERSION_NUMBER < 0x10100000L || \
+    (defined(WE_HAVE_THREAD_RNG) && !defined(WE_STATIC_WOLFSSL))
+#define WE_HAVE_RAND_BYTES
+#endif
+
+#ifdef WE_HAVE_RAND_BYTES
 /**
- * Generate true random.
+ * Generate true random from the entropy pool, or random from the calling
+ * thread's DRBG or a freshly seeded DRBG.
  *
  * @param  buf  [out]  Buffer to hold random.
  * @param  num  [in]   Number of bytes to generate.
@@ -221,22 +590,56 @@ static int we_rand_bytes(unsigned char *buf, int num)
 {
     int ret = 1;
     int rc;
-#ifdef WE_STATIC_WOLFSSL
-    OS_Seed os;
+#ifndef WE_STATIC_WOLFSSL
+#ifdef WE_HAVE_THREAD_RNG
+    WC_RNG *rng;
+    we_RngShard *shard;
 #else
     WC_RNG rng;
+#endif
 #endif
 
     WOLFENGINE_ENTER(WE_LOG_RNG, "we_rand_bytes");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_RNG, "ARGS [buf = %p, num = %d]", buf, num);
 
 #ifdef WE_STATIC_WOLFSSL
-    /* Generate true random using internal API. */
-    rc = wc_GenerateSeed(&os, buf, num);
-    if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_GenerateSeed", rc);
+    /* Get true random from the pool of entropy. */
+    ret = we_entropy_get(buf, num);
+    (void)rc;
+
+#elif defined(WE_HAVE_THREAD_RNG)
+    /* Long-lived DRBG of this thread - instantiated on first use. */
+    rng = we_thread_rng();
+    if (rng == NULL) {
+        WOLFENGINE_ERROR_FUNC_NULL(WE_LOG_RNG, "we_thread_rng", rng);
         ret = 0;
     }
+    else {
+        rc = wc_RNG_GenerateBlock(rng, buf, num);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_RNG_GenerateBlock", rc);
+            ret = 0;
+        }
+    }
+    /* Mix seed if RAND_add() or RAND_seed() has been called. */
+    shard = we_rng_shard();
+    if ((ret == 1) && shard->haveSeed) {
+    #ifndef WE_SINGLE_THREADED
+        rc = we_rng_shard_lock(shard);
+        if (rc != 0) {
+            WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "we_rng_shard_lock", rc);
+            ret = 0;
+        }
+        else
+    #endif
+        {
+            ret = we_rand_mix_seed(buf, num, shard->seed, sizeof(shard->seed),
+                                   1);
+        #ifndef WE_SINGLE_THREADED
+            wc_UnLockMutex(&shard->mutex);
+        #endif
+        }
+    }
 
 #else
     /* Create a new random number generator that is seeded with true random. */
@@ -267,7 +670,7 @@ static int we_rand_bytes(unsigned char *buf, int num)
 
     return ret;
 }
-#endif
+#endif /* WE_HAVE_RAND_BYTES */
 
 static void we_rand_cleanup(void)
 {
@@ -323,33 +726,37 @@ static int we_rand_pseudorand(unsigned char *buf, int num)
 {
     int ret = 1;
     int rc;
+    /* Shard of global random for this thread. */
+    we_RngShard *shard = we_rng_shard();
 
     WOLFENGINE_ENTER(WE_LOG_RNG, "we_rand_pseudorand");
     WOLFENGINE_MSG_VERBOSE(WE_LOG_RNG, "ARGS [buf = %p, num = %d]",
                            buf, num);
 
 #ifndef WE_SINGLE_THREADED
-    rc = wc_LockMutex(we_rng_mutex);
+    rc = we_rng_shard_lock(shard);
     if (rc != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_LockMutex", rc);
+        WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "we_rng_shard_lock", rc);
+        ret = 0;
     }
     else
 #endif
     {
         /* Use global random to generator pseudo-random data. */
-        rc = wc_RNG_GenerateBlock(we_rng, buf, num);
+        rc = wc_RNG_GenerateBlock(&shard->rng, buf, num);
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_RNG, "wc_RNG_GenerateBlock", rc);
             ret = 0;
         }
     #ifndef WE_STATIC_WOLFSSL
-        /* Mix global seed if RAND_add() or RAND_seed() has been called. */
-        if (haveSeed) {
-            ret = we_rand_mix_seed(buf, num, we_seed, sizeof(we_seed));
+        /* Mix seed if RAND_add() or RAND_seed() has been called. */
+        if ((ret == 1) && shard->haveSeed) {
+            ret = we_rand_mix_seed(buf, num, shard->seed, sizeof(shard->seed),
+                                   1);
         }
     #endif
     #ifndef WE_SINGLE_THREADED
-        wc_UnLockMutex(we_rng_mutex);
+        wc_UnLockMutex(&shard->mutex);
     #endif
     }
 
@@ -377,7 +784,7 @@ static int we_rand_status(void)
  */
 RAND_METHOD we_rand_method ={
     we_rand_seed,
-#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#ifdef WE_HAVE_RAND_BYTES
     we_rand_bytes,
 #else
     /* See note above we_rand_bytes. */
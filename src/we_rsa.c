@@ -54,6 +54,13 @@ typedef struct we_Rsa
 #ifndef WE_RSA_USE_GLOBAL_RNG
     /** Random number generator for RSA operations. */
     WC_RNG rng;
+#ifdef WE_HAVE_FORK_CHECK
+    /** Fork generation random number generator was instantiated in. */
+    int rngForkGen;
+#endif
+#else
+    /** Shard of global random number generator used with this key. */
+    we_RngShard *rngShard;
 #endif
     /** Stored by control command EVP_PKEY_CTRL_MD. */
     const EVP_MD *md;
@@ -165,6 +172,16 @@ static int we_mgf_from_hash(int nid)
         case NID_sha512:
             mgf = WC_MGF1SHA512;
             break;
+#ifdef WE_HAVE_SHA512_224
+        case NID_sha512_224:
+            mgf = WC_MGF1SHA512_224;
+            break;
+#endif
+#ifdef WE_HAVE_SHA512_256
+        case NID_sha512_256:
+            mgf = WC_MGF1SHA512_256;
+            break;
+#endif
         default:
             mgf = WC_MGF1NONE;
             break;
@@ -369,6 +386,14 @@ static int we_rsa_init(RSA *rsa)
                                   "wc_InitRng", rc);
             ret = 0;
         }
+    #ifdef WE_HAVE_FORK_CHECK
+        engineRsa->rngForkGen = we_forkGen;
+    #endif
+    }
+#else
+    if (ret == 1) {
+        /* Key is only used with one shard so operations on it serialize. */
+        engineRsa->rngShard = we_rng_shard();
     }
 #endif
 
@@ -379,7 +404,7 @@ static int we_rsa_init(RSA *rsa)
     #ifndef WE_RSA_USE_GLOBAL_RNG
         rc = wc_RsaSetRNG(&engineRsa->key, &engineRsa->rng);
     #else
-        rc = wc_RsaSetRNG(&engineRsa->key, we_rng);
+        rc = wc_RsaSetRNG(&engineRsa->key, &engineRsa->rngShard->rng);
     #endif
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_RsaSetRNG", rc);
@@ -462,7 +487,7 @@ static int we_rsa_pub_enc_int(size_t fromLen, const unsigned char *from,
 #ifndef WE_RSA_USE_GLOBAL_RNG
     WC_RNG *rng = &rsa->rng;
 #else
-    WC_RNG *rng = we_rng;
+    WC_RNG *rng = &rsa->rngShard->rng;
 #endif
     char errBuff[WOLFENGINE_MAX_LOG_WIDTH];
 
@@ -471,10 +496,17 @@ static int we_rsa_pub_enc_int(size_t fromLen, const unsigned char *from,
                            "toLen = %zu, to = %p, rsa = %p]", fromLen,
                            from, toLen, to, rsa);
 
+#if !defined(WE_RSA_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    /* Don't generate the same random as the parent process. */
+    if (we_rng_fork_check(&rsa->rng, &rsa->rngForkGen) != 1) {
+        return -1;
+    }
+#endif
+
 #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    ret = wc_LockMutex(we_rng_mutex);
+    ret = we_rng_shard_lock(rsa->rngShard);
     if (ret != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", ret);
+        WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", ret);
         return -1;
     }
 #endif
@@ -531,7 +563,7 @@ static int we_rsa_pub_enc_int(size_t fromLen, const unsigned char *from,
     }
 
 #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    wc_UnLockMutex(we_rng_mutex);
+    wc_UnLockMutex(&rsa->rngShard->mutex);
 #endif
 
     WOLFENGINE_LEAVE(WE_LOG_PK, "we_rsa_pub_enc_int", ret);
@@ -631,10 +663,17 @@ static int we_rsa_priv_dec_int(size_t fromLen, const unsigned char *from,
                            "toLen = %zu, to = %p, rsa = %p]", fromLen,
                            from, toLen, to, rsa);
 
+#if !defined(WE_RSA_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    /* Don't generate the same random as the parent process. */
+    if (we_rng_fork_check(&rsa->rng, &rsa->rngForkGen) != 1) {
+        return -1;
+    }
+#endif
+
  #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    ret = wc_LockMutex(we_rng_mutex);
+    ret = we_rng_shard_lock(rsa->rngShard);
     if (ret != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", ret);
+        WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", ret);
         ret = -1;
     }
     else
@@ -704,7 +743,7 @@ static int we_rsa_priv_dec_int(size_t fromLen, const unsigned char *from,
         }
     }
 #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    wc_UnLockMutex(we_rng_mutex);
+    wc_UnLockMutex(&rsa->rngShard->mutex);
 #endif
 
     WOLFENGINE_LEAVE(WE_LOG_PK, "we_rsa_priv_dec_int", ret);
@@ -804,7 +843,7 @@ static int we_rsa_priv_enc_int(size_t fromLen, const unsigned char *from,
 #ifndef WE_RSA_USE_GLOBAL_RNG
     WC_RNG *rng = &rsa->rng;
 #else
-    WC_RNG *rng = we_rng;
+    WC_RNG *rng = &rsa->rngShard->rng;
 #endif
     char errBuff[WOLFENGINE_MAX_LOG_WIDTH];
 
@@ -813,10 +852,17 @@ static int we_rsa_priv_enc_int(size_t fromLen, const unsigned char *from,
                            "toLen = %zu, to = %p, rsa = %p]", fromLen, from,
                            toLen, to, rsa);
 
+#if !defined(WE_RSA_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    /* Don't generate the same random as the parent process. */
+    if (we_rng_fork_check(&rsa->rng, &rsa->rngForkGen) != 1) {
+        return -1;
+    }
+#endif
+
 #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    ret = wc_LockMutex(we_rng_mutex);
+    ret = we_rng_shard_lock(rsa->rngShard);
     if (ret != 0) {
-        WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", ret);
+        WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", ret);
         return -1;
     }
 #endif
@@ -879,7 +925,7 @@ static int we_rsa_priv_enc_int(size_t fromLen, const unsigned char *from,
     }
 
 #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-    wc_UnLockMutex(we_rng_mutex);
+    wc_UnLockMutex(&rsa->rngShard->mutex);
 #endif
 
     WOLFENGINE_LEAVE(WE_LOG_PK, "we_rsa_priv_enc_int", ret);
@@ -988,7 +1034,7 @@ static int we_rsa_pub_dec_int(size_t fromLen, const unsigned char *from,
 #ifndef WE_RSA_USE_GLOBAL_RNG
     WC_RNG *rng = &rsa->rng;
 #else
-    WC_RNG *rng = we_rng;
+    WC_RNG *rng = &rsa->rngShard->rng;
 #endif
     char errBuff[WOLFENGINE_MAX_LOG_WIDTH];
 
@@ -997,6 +1043,13 @@ static int we_rsa_pub_dec_int(size_t fromLen, const unsigned char *from,
                            "toLen = %zu, to = %p, rsa = %p]", fromLen, from,
                            toLen, to, rsa);
 
+#if !defined(WE_RSA_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
+    /* Don't generate the same random as the parent process. */
+    if (we_rng_fork_check(&rsa->rng, &rsa->rngForkGen) != 1) {
+        return -1;
+    }
+#endif
+
     /* Check input length doesn't exceed the prime length. */
     if (fromLen > (size_t)wc_RsaEncryptSize(&rsa->key)) {
         WOLFENGINE_ERROR_MSG(WE_LOG_PK, "Decrypt buffer too big");
@@ -1018,8 +1071,8 @@ static int we_rsa_pub_dec_int(size_t fromLen, const unsigned char *from,
             case RSA_NO_PADDING:
                 WOLFENGINE_MSG(WE_LOG_PK, "padMode: RSA_NO_PADDING");
             #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-                if (wc_LockMutex(we_rng_mutex) != 0) {
-                    WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", ret);
+                if (we_rng_shard_lock(rsa->rngShard) != 0) {
+                    WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", ret);
                     ret = -1;
                 }
                 else
@@ -1032,7 +1085,7 @@ static int we_rsa_pub_dec_int(size_t fromLen, const unsigned char *from,
                         ret = -1;
                     }
             #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-                    wc_UnLockMutex(we_rng_mutex);
+                    wc_UnLockMutex(&rsa->rngShard->mutex);
             #endif
                 }
                 break;
@@ -1239,7 +1292,7 @@ static int we_rsa_keygen_int(we_Rsa *rsa, RSA **osslKey, int bits, long e)
 #ifndef WE_RSA_USE_GLOBAL_RNG
     WC_RNG *rng = &rsa->rng;
 #else
-    WC_RNG *rng = we_rng;
+    WC_RNG *rng = NULL;
 #endif
 
     WOLFENGINE_ENTER(WE_LOG_PK, "we_rsa_pkey_keygen");
@@ -1263,11 +1316,20 @@ static int we_rsa_keygen_int(we_Rsa *rsa, RSA **osslKey, int bits, long e)
         }
     }
 
+#if !defined(WE_RSA_USE_GLOBAL_RNG) && defined(WE_HAVE_FORK_CHECK)
     if (ret == 1) {
+        /* Don't generate the same random as the parent process. */
+        ret = we_rng_fork_check(rng, &rsa->rngForkGen);
+    }
+#endif
+    if (ret == 1) {
+    #ifdef WE_RSA_USE_GLOBAL_RNG
+        rng = &rsa->rngShard->rng;
+    #endif
     #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-        rc = wc_LockMutex(we_rng_mutex);
+        rc = we_rng_shard_lock(rsa->rngShard);
         if (rc != 0) {
-            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_LockMutex", rc);
+            WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "we_rng_shard_lock", rc);
             ret = 0;
         }
         else
@@ -1280,7 +1342,7 @@ static int we_rsa_keygen_int(we_Rsa *rsa, RSA **osslKey, int bits, long e)
                 ret = 0;
             }
     #if defined(WE_RSA_USE_GLOBAL_RNG) && !defined(WE_SINGLE_THREADED)
-            wc_UnLockMutex(we_rng_mutex);
+            wc_UnLockMutex(&rsa->rngShard->mutex);
     #endif
         }
     }
@@ -1435,6 +1497,14 @@ static int we_rsa_pkey_init(EVP_PKEY_CTX *ctx)
             WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_InitRng", rc);
             ret = 0;
         }
+    #ifdef WE_HAVE_FORK_CHECK
+        rsa->rngForkGen = we_forkGen;
+    #endif
+    }
+#else
+    if (ret == 1) {
+        /* Key is only used with one shard so operations on it serialize. */
+        rsa->rngShard = we_rng_shard();
     }
 #endif
 
@@ -2543,7 +2613,7 @@ static int we_rsa_pkey_decrypt(EVP_PKEY_CTX *ctx, unsigned char *plaintext,
     #ifndef WE_RSA_USE_GLOBAL_RNG
         rc = wc_RsaSetRNG(&rsa->key, &rsa->rng);
     #else
-        rc = wc_RsaSetRNG(&rsa->key, we_rng);
+        rc = wc_RsaSetRNG(&rsa->key, &rsa->rngShard->rng);
     #endif
         if (rc != 0) {
             WOLFENGINE_ERROR_FUNC(WE_LOG_PK, "wc_RsaSetRNG", rc);
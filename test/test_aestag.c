@@ -21,6 +21,14 @@
 
 #include "unit.h"
 
+/* IVs are generated from the engine's random in several threads at once. */
+#if defined(HAVE_PTHREAD) && !defined(WE_SINGLE_THREADED)
+    #define TEST_GCM_IV_THREADS
+#endif
+#ifdef TEST_GCM_IV_THREADS
+#include <pthread.h>
+#endif
+
 #ifndef EVP_CCM_TLS_FIXED_IV_LEN
 #define EVP_CCM_TLS_FIXED_IV_LEN        EVP_GCM_TLS_FIXED_IV_LEN
 #endif
@@ -28,7 +36,8 @@
 #define EVP_CCM_TLS_TAG_LEN             EVP_GCM_TLS_TAG_LEN
 #endif
 
-#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESCCM)
+#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESCCM) || \
+    defined(WE_HAVE_CHACHA)
 
 static int test_aes_tag_enc(ENGINE *e, const EVP_CIPHER *cipher,
                             unsigned char *key, unsigned char *iv, int ivLen,
@@ -242,6 +251,10 @@ static int test_aes_tag(ENGINE *e, void *data, const EVP_CIPHER *cipher,
     return err;
 }
 
+#endif /* WE_HAVE_AESGCM || WE_HAVE_AESCCM || WE_HAVE_CHACHA */
+
+#if defined(WE_HAVE_AESGCM) || defined(WE_HAVE_AESCCM)
+
 /* AES-GCM GMAC test, empty plaintext, operation only outputs tag value */
 static int test_aes_gcm_gmac(ENGINE* e, void* data, const EVP_CIPHER* cipher,
                              int keyLen, int ivLen)
@@ -568,6 +581,105 @@ static int test_aes_tag_tls(ENGINE *e, void *data, const EVP_CIPHER *cipher,
     return err;
 }
 
+/******************************************************************************/
+
+#define TEST_BATCH_CNT      5
+
+/* Seal packets in one call and check each against OpenSSL. Then open them in
+ * one call and check that only the corrupted packet fails. */
+static int test_aes_tag_batch(ENGINE *e, const EVP_CIPHER *cipher, int ivLen,
+                              int ccm)
+{
+    int err;
+    int i;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key[32];
+    unsigned char aad[] = "Batched packet AAD";
+    static const unsigned int lens[TEST_BATCH_CNT] = { 1, 15, 16, 100, 255 };
+    unsigned char nonce[TEST_BATCH_CNT][13];
+    unsigned char msg[TEST_BATCH_CNT][255];
+    unsigned char enc[TEST_BATCH_CNT][255];
+    unsigned char dec[TEST_BATCH_CNT][255];
+    unsigned char tag[TEST_BATCH_CNT][16];
+    unsigned char exp[255];
+    unsigned char expTag[16];
+    wolfEngine_AeadPacket pkts[TEST_BATCH_CNT];
+
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes((unsigned char *)nonce, sizeof(nonce)) != 1) ||
+          (RAND_bytes((unsigned char *)msg, sizeof(msg)) != 1);
+    for (i = 0; i < TEST_BATCH_CNT; i++) {
+        pkts[i].nonce = nonce[i];
+        pkts[i].nonceLen = ivLen;
+        pkts[i].aad = aad;
+        pkts[i].aadLen = (unsigned int)strlen((char *)aad);
+        pkts[i].in = msg[i];
+        pkts[i].out = enc[i];
+        pkts[i].len = lens[i];
+        pkts[i].tag = tag[i];
+        pkts[i].tagLen = sizeof(tag[i]);
+        pkts[i].status = 0;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Seal batch with wolfengine");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, e, key, NULL, 1) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_AEAD_BATCH,
+                                  TEST_BATCH_CNT, pkts) != 1;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    ctx = NULL;
+    for (i = 0; (err == 0) && (i < TEST_BATCH_CNT); i++) {
+        PRINT_MSG("Encrypt packet with OpenSSL");
+        err = pkts[i].status != 1;
+        if (err == 0) {
+            err = test_aes_tag_enc(NULL, cipher, key, nonce[i], ivLen, aad,
+                                   msg[i], lens[i], exp, expTag, ccm, 0);
+        }
+        if ((err == 0) && ((memcmp(enc[i], exp, lens[i]) != 0) ||
+                           (memcmp(tag[i], expTag, sizeof(expTag)) != 0))) {
+            err = 1;
+        }
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Open batch with wolfengine - one packet corrupted");
+        tag[2][0] ^= 0x80;
+        for (i = 0; i < TEST_BATCH_CNT; i++) {
+            pkts[i].in = enc[i];
+            pkts[i].out = dec[i];
+            pkts[i].status = 0;
+        }
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, e, key, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        /* Fails as one packet doesn't authenticate. */
+        err = EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_AEAD_BATCH,
+                                  TEST_BATCH_CNT, pkts) == 1;
+    }
+    for (i = 0; (err == 0) && (i < TEST_BATCH_CNT); i++) {
+        if (i == 2) {
+            err = pkts[i].status != 0;
+        }
+        else {
+            err = (pkts[i].status != 1) ||
+                  (memcmp(dec[i], msg[i], lens[i]) != 0);
+        }
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
 #endif /* WE_HAVE_AESGCM || WE_HAVE_AESCCM */
 
 #ifdef WE_HAVE_AESGCM
@@ -625,160 +737,895 @@ int test_aes128_gcm_fixed(ENGINE *e, void *data)
 
 /******************************************************************************/
 
-int test_aes128_gcm_tls(ENGINE *e, void *data)
+/* Number of threads generating AES-GCM IVs at the same time. */
+#define TEST_GCM_IV_THREAD_CNT    8
+/* Number of IVs generated by each thread. */
+#define TEST_GCM_IV_CNT           64
+/* Length of generated AES-GCM IV. */
+#define TEST_GCM_IV_LEN           12
+
+typedef struct TEST_GCM_IV_THREAD {
+#ifdef TEST_GCM_IV_THREADS
+    pthread_t thread;
+#endif
+    ENGINE *e;
+    unsigned char key[AES_128_KEY_SIZE];
+    unsigned char iv[TEST_GCM_IV_CNT][TEST_GCM_IV_LEN];
+    int err;
+} TEST_GCM_IV_THREAD;
+
+static void* test_aes_gcm_iv_gen_thread(void *data)
 {
-    return test_aes_tag_tls(e, data, EVP_aes_128_gcm(), 16,
-                            EVP_GCM_TLS_FIXED_IV_LEN, 0);
+    TEST_GCM_IV_THREAD *t = (TEST_GCM_IV_THREAD *)data;
+    unsigned char aad[] = "IV generation";
+    unsigned char msg[32];
+    unsigned char enc[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    unsigned char tag[16];
+    int i;
+
+    memset(msg, 0xa5, sizeof(msg));
+    t->err = 0;
+    for (i = 0; (t->err == 0) && (i < TEST_GCM_IV_CNT); i++) {
+        /* Same fixed part in all threads - generated part must differ. */
+        memset(t->iv[i], 0, TEST_GCM_IV_LEN);
+        t->err = test_aes_tag_fixed_enc(t->e, EVP_aes_128_gcm(), t->key,
+                                        t->iv[i], EVP_GCM_TLS_FIXED_IV_LEN,
+                                        TEST_GCM_IV_LEN, aad, msg,
+                                        sizeof(msg), enc, tag);
+        if (t->err == 0) {
+            t->err = test_aes_tag_dec(NULL, EVP_aes_128_gcm(), t->key,
+                                      t->iv[i], TEST_GCM_IV_LEN, aad, msg,
+                                      sizeof(msg), enc, tag, dec, 0, 0);
+        }
+    }
+
+    return NULL;
 }
 
-/* 
- * OpenSSL doesn't recommend using EVP_Cipher(), but there are applications
- * using it, so we need to support it. With wolfCrypt, AES-GCM decryption cannot
- * be decoupled from checking the authentication tag, so we only expect the
- * decryption to succeed when the caller has set the tag properly. It is not
- * possible to decrypt ciphertext without checking the tag.
- */
-int test_aes_gcm_evp_cipher(ENGINE *e, void *data)
+static int test_aes_gcm_iv_cmp(const void *a, const void *b)
 {
-    int err = 0;
-    EVP_CIPHER_CTX* ctx = NULL;
-    unsigned char key[AES_128_KEY_SIZE] = {0};
-    unsigned char iv[AES_BLOCK_SIZE] = {0};
-    unsigned char aad[3] = {0x01, 0x02, 0x03};
-    unsigned char plainText[5] = {0x04, 0x05, 0x06, 0x07, 0x08};
-    unsigned char cipherText[sizeof(plainText)];
-    unsigned char decryptedText[sizeof(plainText)];
-    unsigned char tag[EVP_GCM_TLS_TAG_LEN];
+    return memcmp(a, b, TEST_GCM_IV_LEN);
+}
+
+int test_aes128_gcm_iv_gen_threads(ENGINE *e, void *data)
+{
+    int err;
+    int i;
+    int started;
+    int cnt = TEST_GCM_IV_THREAD_CNT * TEST_GCM_IV_CNT;
+    TEST_GCM_IV_THREAD *t;
+    unsigned char *all = NULL;
 
     (void)data;
 
-    /* Encrypt with OpenSSL. */
-    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    err = (t = (TEST_GCM_IV_THREAD *)OPENSSL_zalloc(
+               sizeof(*t) * TEST_GCM_IV_THREAD_CNT)) == NULL;
     if (err == 0) {
-        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), NULL, key, iv, 1) != 1;
+        err = RAND_bytes(t[0].key, sizeof(t[0].key)) != 1;
     }
+    for (i = 0; (err == 0) && (i < TEST_GCM_IV_THREAD_CNT); i++) {
+        t[i].e = e;
+        memcpy(t[i].key, t[0].key, sizeof(t[i].key));
+    }
+
     if (err == 0) {
-        /* AAD */
-        err = EVP_Cipher(ctx, NULL, aad, sizeof(aad)) <= 0;
+        PRINT_MSG("Generate IVs with the same key in several threads");
+    }
+#ifdef TEST_GCM_IV_THREADS
+    for (started = 0; (err == 0) && (started < TEST_GCM_IV_THREAD_CNT);
+         started++) {
+        err = pthread_create(&t[started].thread, NULL,
+                             test_aes_gcm_iv_gen_thread, &t[started]) != 0;
+    }
+    if (err != 0) {
+        started--;
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(t[i].thread, NULL);
+        if (t[i].err != 0) {
+            err = 1;
+        }
+    }
+#else
+    for (started = 0; (err == 0) && (started < TEST_GCM_IV_THREAD_CNT);
+         started++) {
+        test_aes_gcm_iv_gen_thread(&t[started]);
+        err = t[started].err;
     }
+#endif
+
     if (err == 0) {
-        err = EVP_Cipher(ctx, cipherText, plainText, sizeof(plainText)) <= 0;
+        PRINT_MSG("Check all IVs are different");
+        err = (all = (unsigned char *)OPENSSL_malloc(cnt *
+                                                     TEST_GCM_IV_LEN)) == NULL;
     }
     if (err == 0) {
-        /* Compute tag. */
-        err = EVP_Cipher(ctx, NULL, NULL, 0) < 0;
+        for (i = 0; i < TEST_GCM_IV_THREAD_CNT; i++) {
+            memcpy(all + i * TEST_GCM_IV_CNT * TEST_GCM_IV_LEN, t[i].iv,
+                   sizeof(t[i].iv));
+        }
+        qsort(all, cnt, TEST_GCM_IV_LEN, test_aes_gcm_iv_cmp);
+        for (i = 1; (err == 0) && (i < cnt); i++) {
+            err = memcmp(all + (i - 1) * TEST_GCM_IV_LEN,
+                         all + i * TEST_GCM_IV_LEN, TEST_GCM_IV_LEN) == 0;
+        }
+        if (err != 0) {
+            PRINT_ERR_MSG("Same IV generated twice");
+        }
+    }
+
+    OPENSSL_free(all);
+    OPENSSL_free(t);
+
+    return err;
+}
+
+/******************************************************************************/
+
+int test_aes128_gcm_tls(ENGINE *e, void *data)
+{
+    return test_aes_tag_tls(e, data, EVP_aes_128_gcm(), 16,
+                            EVP_GCM_TLS_FIXED_IV_LEN, 0);
+}
+
+/******************************************************************************/
+
+/* Encrypt or decrypt in chunks of varying size - 1 to 67 bytes. */
+static int test_aes_gcm_stream_crypt(ENGINE *e, int enc, unsigned char *key,
+                                     unsigned char *iv, unsigned char *aad,
+                                     int aadLen, unsigned char *in, int len,
+                                     unsigned char *out, unsigned char *tag)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    int outLen;
+    int i;
+    int chunk;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), e, key, iv, enc) != 1;
+    }
+    if ((err == 0) && !enc) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, tag) != 1;
     }
     if (err == 0) {
-        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
-                                  EVP_GCM_TLS_TAG_LEN, tag) != 1;
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad, aadLen) != 1;
     }
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
+    for (i = 0; (err == 0) && (i < len); i += chunk) {
+        chunk = (i % 67) + 1;
+        if (chunk > len - i) {
+            chunk = len - i;
+        }
+        err = EVP_CipherUpdate(ctx, out + i, &outLen, in + i, chunk) != 1;
+        if ((err == 0) && (outLen != chunk)) {
+            PRINT_MSG("Streaming update didn't output all data");
+            err = 1;
+        }
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, out + len, &outLen) != 1;
+    }
+    if ((err == 0) && enc) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1;
     }
 
-    /* Decrypt with wolfEngine. */
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+/* Encrypt two halves into separate output buffers. */
+static int test_aes_gcm_split_out(ENGINE *e, unsigned char *key,
+                                  unsigned char *iv, unsigned char *msg,
+                                  int len, unsigned char *out)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    unsigned char *second;
+    int outLen;
+
+    err = (second = (unsigned char *)OPENSSL_malloc(len)) == NULL;
     if (err == 0) {
         err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+        if (err == 0) {
+            err = EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), e, key, iv) != 1;
+        }
+        if (err == 0) {
+            err = EVP_EncryptUpdate(ctx, out, &outLen, msg, len / 2) != 1;
+        }
+        if (err == 0) {
+            err = EVP_EncryptUpdate(ctx, second, &outLen, msg + len / 2,
+                                    len - len / 2) != 1;
+        }
+        if (err == 0) {
+            err = EVP_EncryptFinal_ex(ctx, out + len, &outLen) != 1;
+        }
+        if (err == 0) {
+            memcpy(out + len / 2, second, len - len / 2);
+        }
+        EVP_CIPHER_CTX_free(ctx);
+        OPENSSL_free(second);
+    }
+
+    return err;
+}
+
+int test_aes128_gcm_stream(ENGINE *e, void *data)
+{
+    int err = 0;
+    int i;
+    unsigned char key[AES_128_KEY_SIZE];
+    unsigned char iv[12];
+    unsigned char aad[20];
+    unsigned char msg[1000];
+    unsigned char enc[sizeof(msg)];
+    unsigned char dec[sizeof(msg)];
+    unsigned char tag[16];
+    unsigned char wetag[16];
+
+    (void)data;
+
+    for (i = 0; i < (int)sizeof(key); i++) {
+        key[i] = (unsigned char)i;
+    }
+    memset(iv, 0x5a, sizeof(iv));
+    memset(aad, 0xa5, sizeof(aad));
+    for (i = 0; i < (int)sizeof(msg); i++) {
+        msg[i] = (unsigned char)(i * 7);
     }
+
+    PRINT_MSG("Stream encrypt with OpenSSL");
+    err = test_aes_gcm_stream_crypt(NULL, 1, key, iv, aad, sizeof(aad), msg,
+                                    sizeof(msg), enc, tag);
     if (err == 0) {
-        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), e, key, iv, 0) != 1;
+        PRINT_MSG("Stream decrypt with wolfengine");
+        err = test_aes_gcm_stream_crypt(e, 0, key, iv, aad, sizeof(aad), enc,
+                                        sizeof(enc), dec, tag);
+    }
+    if ((err == 0) && (memcmp(dec, msg, sizeof(msg)) != 0)) {
+        err = 1;
     }
     if (err == 0) {
-        /* AAD */
-        err = EVP_Cipher(ctx, NULL, aad, sizeof(aad)) <= 0;
+        PRINT_MSG("Stream encrypt with wolfengine");
+        err = test_aes_gcm_stream_crypt(e, 1, key, iv, aad, sizeof(aad), msg,
+                                        sizeof(msg), dec, wetag);
+    }
+    if ((err == 0) && ((memcmp(dec, enc, sizeof(enc)) != 0) ||
+                       (memcmp(wetag, tag, sizeof(tag)) != 0))) {
+        err = 1;
     }
     if (err == 0) {
-        err = EVP_Cipher(ctx, decryptedText, cipherText,
-                         sizeof(cipherText)) <= 0;
+        PRINT_MSG("Stream decrypt with wrong tag with wolfengine");
+        wetag[0] ^= 0x01;
+        err = test_aes_gcm_stream_crypt(e, 0, key, iv, aad, sizeof(aad), enc,
+                                        sizeof(enc), dec, wetag) == 0;
     }
     if (err == 0) {
-        /* Decrypt without tag set, should fail. */
-        err = EVP_Cipher(ctx, NULL, NULL, 0) >= 0;
+        PRINT_MSG("Encrypt into separate output buffers with OpenSSL");
+        err = test_aes_gcm_split_out(NULL, key, iv, msg, sizeof(msg), enc);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt into separate output buffers with wolfengine");
+        err = test_aes_gcm_split_out(e, key, iv, msg, sizeof(msg), dec);
+#ifdef WOLFSSL_AESGCM_STREAM
+        if ((err == 0) && (memcmp(dec, enc, sizeof(msg)) != 0)) {
+            err = 1;
+        }
+#else
+        /* All output is written on final - must be one contiguous buffer. */
+        err = (err == 0);
+#endif
     }
 
-    /* Try the same sequence again, but set the tag before the final
-     * EVP_Cipher() call. */
+    return err;
+}
+
+/* Encrypt on a re-initialized context - no cipher passed in. */
+static int test_aes_gcm_reinit_enc(ENGINE *e, EVP_CIPHER_CTX *ctx,
+                                   unsigned char *key, unsigned char *iv,
+                                   unsigned char *aad, int aadLen,
+                                   unsigned char *msg, int len)
+{
+    int err;
+    int outLen;
+    unsigned char exp[64];
+    unsigned char out[64];
+    unsigned char tag[16];
+    unsigned char wetag[16];
+
+    err = test_aes_gcm_stream_crypt(NULL, 1, key, iv, aad, aadLen, msg, len,
+                                    exp, tag);
     if (err == 0) {
-        err = EVP_Cipher(ctx, NULL, aad, sizeof(aad)) <= 0;
+        err = EVP_CipherInit_ex(ctx, NULL, e, key, iv, 1) != 1;
     }
     if (err == 0) {
-        err = EVP_Cipher(ctx, decryptedText, cipherText,
-                         sizeof(cipherText)) <= 0;
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad, aadLen) != 1;
     }
     if (err == 0) {
-        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
-                                  EVP_GCM_TLS_TAG_LEN, tag) != 1;
+        err = EVP_CipherUpdate(ctx, out, &outLen, msg, len) != 1;
     }
     if (err == 0) {
-        /* Decrypt with tag set, should succeed. */
-        err = EVP_Cipher(ctx, NULL, NULL, 0) < 0;
+        err = EVP_CipherFinal_ex(ctx, out + outLen, &outLen) != 1;
     }
-    if (ctx != NULL) {
-        EVP_CIPHER_CTX_free(ctx);
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, wetag) != 1;
+    }
+    if ((err == 0) && ((memcmp(out, exp, len) != 0) ||
+                       (memcmp(wetag, tag, sizeof(tag)) != 0))) {
+        err = 1;
     }
 
     return err;
 }
 
-#endif /* WE_HAVE_AESGCM */
-
-/******************************************************************************/
-
-#ifdef WE_HAVE_AESCCM
-
-int test_aes128_ccm(ENGINE *e, void *data)
+int test_aes128_gcm_key_reuse(ENGINE *e, void *data)
 {
-    int err = 0;
+    int err;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key1[AES_128_KEY_SIZE];
+    unsigned char key2[AES_128_KEY_SIZE];
+    unsigned char iv1[12];
+    unsigned char iv2[12];
+    unsigned char aad[20];
+    unsigned char msg[64];
 
-    /* test with default length field (L) */
-    err = test_aes_tag(e, data, EVP_aes_128_ccm(), 16, 13, 1, 0);
+    (void)data;
 
-#if OPENSSL_VERSION_NUMBER < 0x30000000L
-    /* test with modified length field (L) of 7 */
+    err = (RAND_bytes(key1, sizeof(key1)) != 1) ||
+          (RAND_bytes(key2, sizeof(key2)) != 1) ||
+          (RAND_bytes(iv1, sizeof(iv1)) != 1) ||
+          (RAND_bytes(iv2, sizeof(iv2)) != 1) ||
+          (RAND_bytes(aad, sizeof(aad)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
     if (err == 0) {
-        err = test_aes_tag(e, data, EVP_aes_128_ccm(), 16, 13, 1, 7);
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
     }
-#endif
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), e, NULL, NULL, 1) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with first key");
+        err = test_aes_gcm_reinit_enc(e, ctx, key1, iv1, aad, sizeof(aad),
+                                      msg, sizeof(msg));
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with same key and new IV");
+        err = test_aes_gcm_reinit_enc(e, ctx, key1, iv2, aad, sizeof(aad),
+                                      msg, sizeof(msg));
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with new key");
+        err = test_aes_gcm_reinit_enc(e, ctx, key2, iv2, aad, sizeof(aad),
+                                      msg, sizeof(msg));
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with new key and no AAD");
+        err = test_aes_gcm_reinit_enc(e, ctx, key2, iv1, aad, 0, msg,
+                                      sizeof(msg) - 3);
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
 
     return err;
 }
 
-/******************************************************************************/
-
-int test_aes192_ccm(ENGINE *e, void *data)
+/* Finish encrypt after AAD - message and final. Returns tag. */
+static int test_aes_gcm_copy_finish(EVP_CIPHER_CTX *ctx,
+                                    const unsigned char *msg, int len,
+                                    unsigned char *out, unsigned char *tag)
 {
-    int err = 0;
-
-    /* test with default length field (L) */
-    err = test_aes_tag(e, data, EVP_aes_192_ccm(), 24, 13, 1, 0);
+    int err;
+    int outLen;
 
-#if OPENSSL_VERSION_NUMBER < 0x30000000L
-    /* test with modified length field (L) of 7 */
+    err = EVP_CipherUpdate(ctx, out, &outLen, msg, len) != 1;
     if (err == 0) {
-        err = test_aes_tag(e, data, EVP_aes_192_ccm(), 24, 13, 1, 7);
+        err = EVP_CipherFinal_ex(ctx, out + outLen, &outLen) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1;
     }
-#endif
 
     return err;
 }
 
-/******************************************************************************/
-
-int test_aes256_ccm(ENGINE *e, void *data)
+int test_aes128_gcm_copy(ENGINE *e, void *data)
 {
-    int err = 0;
+    int err;
+    EVP_CIPHER_CTX *tmpl = NULL;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CIPHER_CTX *ctx2 = NULL;
+    unsigned char key[AES_128_KEY_SIZE];
+    unsigned char iv[12];
+    unsigned char aad[20];
+    unsigned char msg[64];
+    unsigned char exp[sizeof(msg)];
+    unsigned char out[sizeof(msg)];
+    unsigned char out2[sizeof(msg)];
+    unsigned char tag[16];
+    unsigned char wetag[16];
+    unsigned char wetag2[16];
+    int outLen;
 
-    /* test with default length field (L) */
-    err = test_aes_tag(e, data, EVP_aes_256_ccm(), 32, 13, 1, 0);
+    (void)data;
 
-#if OPENSSL_VERSION_NUMBER < 0x30000000L
-    /* test with modified length field (L) of 7 */
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes(iv, sizeof(iv)) != 1) ||
+          (RAND_bytes(aad, sizeof(aad)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
     if (err == 0) {
-        err = test_aes_tag(e, data, EVP_aes_256_ccm(), 32, 13, 1, 7);
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = test_aes_gcm_stream_crypt(NULL, 1, key, iv, aad, sizeof(aad),
+                                        msg, sizeof(msg), exp, tag);
     }
-#endif
 
-    return err;
+    if (err == 0) {
+        PRINT_MSG("Copy keyed template context");
+        err = (tmpl = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(tmpl, EVP_aes_128_gcm(), e, key, NULL, 1) != 1;
+    }
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_copy(ctx, tmpl) != 1;
+    }
+    /* Copy must not depend on template. */
+    EVP_CIPHER_CTX_free(tmpl);
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, NULL, e, NULL, iv, 1) != 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Copy after AAD passed in");
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad, sizeof(aad) / 2) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad + sizeof(aad) / 2,
+                               sizeof(aad) - sizeof(aad) / 2) != 1;
+    }
+    if (err == 0) {
+        err = (ctx2 = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_copy(ctx2, ctx) != 1;
+    }
+    if (err == 0) {
+        err = test_aes_gcm_copy_finish(ctx, msg, sizeof(msg), out, wetag);
+    }
+    /* Copy must not depend on original. */
+    EVP_CIPHER_CTX_free(ctx);
+    if (err == 0) {
+        err = test_aes_gcm_copy_finish(ctx2, msg, sizeof(msg), out2, wetag2);
+    }
+    if ((err == 0) && ((memcmp(out, exp, sizeof(exp)) != 0) ||
+                       (memcmp(wetag, tag, sizeof(tag)) != 0))) {
+        err = 1;
+    }
+    if ((err == 0) && ((memcmp(out2, exp, sizeof(exp)) != 0) ||
+                       (memcmp(wetag2, tag, sizeof(tag)) != 0))) {
+        err = 1;
+    }
+#ifndef WOLFSSL_AESGCM_STREAM
+    /* Buffered data is output at final into the original's buffer. */
+    if (err == 0) {
+        PRINT_MSG("Copy after data passed in fails");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), e, key, iv, 1) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, out, &outLen, msg, sizeof(msg)) != 1;
+    }
+    if (err == 0) {
+        EVP_CIPHER_CTX_free(ctx2);
+        err = (ctx2 = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_copy(ctx2, ctx) == 1;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+#endif
+
+    EVP_CIPHER_CTX_free(ctx2);
+
+    return err;
+}
+
+int test_aes128_gcm_batch(ENGINE *e, void *data)
+{
+    int err;
+#ifdef WOLFSSL_AESGCM_STREAM
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key[16];
+    unsigned char iv[12];
+    unsigned char aad[16];
+    unsigned char msg[16];
+    unsigned char enc[16];
+    unsigned char tag[16];
+    int outLen;
+    wolfEngine_AeadPacket pkt;
+#endif
+
+    (void)data;
+
+    err = test_aes_tag_batch(e, EVP_aes_128_gcm(), 12, 0);
+#ifdef WOLFSSL_AESGCM_STREAM
+    if (err == 0) {
+        PRINT_MSG("Batch during streaming operation fails");
+        err = (RAND_bytes(key, sizeof(key)) != 1) ||
+              (RAND_bytes(iv, sizeof(iv)) != 1) ||
+              (RAND_bytes(aad, sizeof(aad)) != 1) ||
+              (RAND_bytes(msg, sizeof(msg)) != 1);
+    }
+    if (err == 0) {
+        pkt.nonce = iv;
+        pkt.nonceLen = sizeof(iv);
+        pkt.aad = aad;
+        pkt.aadLen = sizeof(aad);
+        pkt.in = msg;
+        pkt.out = enc;
+        pkt.len = sizeof(msg);
+        pkt.tag = tag;
+        pkt.tagLen = sizeof(tag);
+        pkt.status = 0;
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = (EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), e, key, iv) != 1) ||
+              (EVP_EncryptUpdate(ctx, NULL, &outLen, aad, sizeof(aad)) != 1);
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_AEAD_BATCH, 1,
+                                  &pkt) == 1;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+#endif
+
+    return err;
+}
+
+/* Contexts with the same key share a key schedule when built lean. */
+int test_aes128_gcm_shared_key(ENGINE *e, void *data)
+{
+    int err;
+    wolfEngine_Stats before;
+    wolfEngine_Stats mid;
+    wolfEngine_Stats after;
+    EVP_CIPHER_CTX *encCtx = NULL;
+    EVP_CIPHER_CTX *decCtx = NULL;
+    unsigned char key[16];
+    unsigned char iv[12];
+    unsigned char msg[64];
+    unsigned char enc[64];
+    unsigned char dec[64];
+    unsigned char tag[16];
+    int outLen;
+
+    (void)data;
+
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes(iv, sizeof(iv)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &before, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = ((encCtx = EVP_CIPHER_CTX_new()) == NULL) ||
+              ((decCtx = EVP_CIPHER_CTX_new()) == NULL);
+    }
+    if (err == 0) {
+        err = (EVP_EncryptInit_ex(encCtx, EVP_aes_128_gcm(), e, key,
+                                  iv) != 1) ||
+              (EVP_DecryptInit_ex(decCtx, EVP_aes_128_gcm(), e, key,
+                                  iv) != 1);
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &mid, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Context size and shared key schedules");
+        /* One key schedule for both contexts - none when not lean. */
+    #ifdef TEST_AES_GCM_LEAN
+        err = (mid.aesGcmCtxBytes == 0) ||
+              (mid.sharedKeys - before.sharedKeys != 1);
+    #else
+        err = (mid.aesGcmCtxBytes == 0) ||
+              (mid.sharedKeys != before.sharedKeys);
+    #endif
+        if (err != 0) {
+            PRINT_ERR_MSG("Unexpected number of shared key schedules");
+        }
+    }
+    if (err == 0) {
+        err = (EVP_EncryptUpdate(encCtx, enc, &outLen, msg,
+                                 sizeof(msg)) != 1) ||
+              (EVP_EncryptFinal_ex(encCtx, enc + outLen, &outLen) != 1) ||
+              (EVP_CIPHER_CTX_ctrl(encCtx, EVP_CTRL_AEAD_GET_TAG,
+                                   sizeof(tag), tag) != 1);
+    }
+    if (err == 0) {
+        err = (EVP_CIPHER_CTX_ctrl(decCtx, EVP_CTRL_AEAD_SET_TAG,
+                                   sizeof(tag), tag) != 1) ||
+              (EVP_DecryptUpdate(decCtx, dec, &outLen, enc,
+                                 sizeof(enc)) != 1) ||
+              (EVP_DecryptFinal_ex(decCtx, dec + outLen, &outLen) != 1);
+    }
+    if (err == 0) {
+        err = memcmp(dec, msg, sizeof(msg)) != 0;
+    }
+
+    EVP_CIPHER_CTX_free(encCtx);
+
+    if (err == 0) {
+        /* Shared key schedule still referenced by other context. */
+        err = (ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1) ||
+              (after.sharedKeys != mid.sharedKeys);
+        if (err != 0) {
+            PRINT_ERR_MSG("Shared key schedule freed while still in use");
+        }
+    }
+
+    EVP_CIPHER_CTX_free(decCtx);
+
+    if (err == 0) {
+        /* Shared key schedule freed with last context. */
+        err = (ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1) ||
+              (after.sharedKeys != before.sharedKeys);
+        if (err != 0) {
+            PRINT_ERR_MSG("Shared key schedule not freed with last context");
+        }
+    }
+
+    return err;
+}
+
+#ifdef EVP_CIPH_FLAG_PIPELINE
+
+#define TEST_PIPE_RECS      4
+
+int test_aes128_gcm_pipeline(ENGINE *e, void *data)
+{
+    int err = 0;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key[AES_128_KEY_SIZE];
+    unsigned char iv[EVP_GCM_TLS_FIXED_IV_LEN];
+    unsigned char aad[TEST_PIPE_RECS][EVP_AEAD_TLS1_AAD_LEN];
+    unsigned char msg[TEST_PIPE_RECS][24];
+    unsigned char buf[TEST_PIPE_RECS][48];
+    unsigned char *bufs[TEST_PIPE_RECS];
+    size_t lens[TEST_PIPE_RECS];
+    int i;
+
+    (void)data;
+
+    if ((RAND_bytes(key, sizeof(key)) == 0) ||
+        (RAND_bytes(iv, sizeof(iv)) == 0) ||
+        (RAND_bytes(msg[0], sizeof(msg)) == 0)) {
+        err = 1;
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        memset(aad[i], 0, sizeof(aad[i]));
+        aad[i][7]  = (unsigned char)i; /* Sequence number */
+        aad[i][8]  = 23;               /* Content type */
+        aad[i][9]  = 3;                /* Protocol major version */
+        aad[i][10] = 3;                /* Protocol minor version */
+        aad[i][12] = sizeof(buf[i]) - EVP_GCM_TLS_TAG_LEN;
+        memset(buf[i], 0, sizeof(buf[i]));
+        memcpy(buf[i] + EVP_GCM_TLS_EXPLICIT_IV_LEN, msg[i], sizeof(msg[i]));
+        bufs[i] = buf[i];
+        lens[i] = sizeof(buf[i]);
+    }
+
+    PRINT_MSG("Encrypt records in one call with wolfengine - TLS pipeline");
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_EncryptInit_ex(ctx, EVP_aes_128_gcm(), e, key, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_IV_FIXED, sizeof(iv),
+                                  iv) != 1;
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD,
+                                  EVP_AEAD_TLS1_AAD_LEN,
+                                  aad[i]) != EVP_GCM_TLS_TAG_LEN;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS,
+                                  TEST_PIPE_RECS, bufs) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_SET_PIPELINE_INPUT_BUFS,
+                                  TEST_PIPE_RECS, bufs) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_SET_PIPELINE_INPUT_LENS,
+                                  TEST_PIPE_RECS, lens) != 1;
+    }
+    if (err == 0) {
+        err = EVP_Cipher(ctx, bufs[0], bufs[0], (unsigned int)lens[0]) < 0;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    /* Each record must have its own nonce. */
+    for (i = 1; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        if (memcmp(buf[i - 1], buf[i], EVP_GCM_TLS_EXPLICIT_IV_LEN) == 0) {
+            PRINT_MSG("Explicit IV reused across records");
+            err = 1;
+        }
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        PRINT_MSG("Decrypt record with OpenSSL - TLS");
+        aad[i][12] = sizeof(buf[i]);
+        err = test_aes_tag_tls_dec(NULL, EVP_aes_128_gcm(), key, iv,
+                                   sizeof(iv), aad[i], buf[i], sizeof(buf[i]),
+                                   0);
+        if ((err == 0) && (memcmp(buf[i] + EVP_GCM_TLS_EXPLICIT_IV_LEN,
+                                  msg[i], sizeof(msg[i])) != 0)) {
+            err = 1;
+        }
+    }
+
+    return err;
+}
+
+#endif /* EVP_CIPH_FLAG_PIPELINE */
+
+/* 
+ * OpenSSL doesn't recommend using EVP_Cipher(), but there are applications
+ * using it, so we need to support it. With wolfCrypt, AES-GCM decryption cannot
+ * be decoupled from checking the authentication tag, so we only expect the
+ * decryption to succeed when the caller has set the tag properly. It is not
+ * possible to decrypt ciphertext without checking the tag.
+ */
+int test_aes_gcm_evp_cipher(ENGINE *e, void *data)
+{
+    int err = 0;
+    EVP_CIPHER_CTX* ctx = NULL;
+    unsigned char key[AES_128_KEY_SIZE] = {0};
+    unsigned char iv[AES_BLOCK_SIZE] = {0};
+    unsigned char aad[3] = {0x01, 0x02, 0x03};
+    unsigned char plainText[5] = {0x04, 0x05, 0x06, 0x07, 0x08};
+    unsigned char cipherText[sizeof(plainText)];
+    unsigned char decryptedText[sizeof(plainText)];
+    unsigned char tag[EVP_GCM_TLS_TAG_LEN];
+
+    (void)data;
+
+    /* Encrypt with OpenSSL. */
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), NULL, key, iv, 1) != 1;
+    }
+    if (err == 0) {
+        /* AAD */
+        err = EVP_Cipher(ctx, NULL, aad, sizeof(aad)) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_Cipher(ctx, cipherText, plainText, sizeof(plainText)) <= 0;
+    }
+    if (err == 0) {
+        /* Compute tag. */
+        err = EVP_Cipher(ctx, NULL, NULL, 0) < 0;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG,
+                                  EVP_GCM_TLS_TAG_LEN, tag) != 1;
+    }
+    if (ctx != NULL) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+
+    /* Decrypt with wolfEngine. */
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_aes_128_gcm(), e, key, iv, 0) != 1;
+    }
+    if (err == 0) {
+        /* AAD */
+        err = EVP_Cipher(ctx, NULL, aad, sizeof(aad)) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_Cipher(ctx, decryptedText, cipherText,
+                         sizeof(cipherText)) <= 0;
+    }
+    if (err == 0) {
+        /* Decrypt without tag set, should fail. */
+        err = EVP_Cipher(ctx, NULL, NULL, 0) >= 0;
+    }
+
+    /* Try the same sequence again, but set the tag before the final
+     * EVP_Cipher() call. */
+    if (err == 0) {
+        err = EVP_Cipher(ctx, NULL, aad, sizeof(aad)) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_Cipher(ctx, decryptedText, cipherText,
+                         sizeof(cipherText)) <= 0;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG,
+                                  EVP_GCM_TLS_TAG_LEN, tag) != 1;
+    }
+    if (err == 0) {
+        /* Decrypt with tag set, should succeed. */
+        err = EVP_Cipher(ctx, NULL, NULL, 0) < 0;
+    }
+    if (ctx != NULL) {
+        EVP_CIPHER_CTX_free(ctx);
+    }
+
+    return err;
+}
+
+#endif /* WE_HAVE_AESGCM */
+
+/******************************************************************************/
+
+#ifdef WE_HAVE_AESCCM
+
+int test_aes128_ccm(ENGINE *e, void *data)
+{
+    int err = 0;
+
+    /* test with default length field (L) */
+    err = test_aes_tag(e, data, EVP_aes_128_ccm(), 16, 13, 1, 0);
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+    /* test with modified length field (L) of 7 */
+    if (err == 0) {
+        err = test_aes_tag(e, data, EVP_aes_128_ccm(), 16, 13, 1, 7);
+    }
+#endif
+
+    return err;
+}
+
+/******************************************************************************/
+
+int test_aes192_ccm(ENGINE *e, void *data)
+{
+    int err = 0;
+
+    /* test with default length field (L) */
+    err = test_aes_tag(e, data, EVP_aes_192_ccm(), 24, 13, 1, 0);
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+    /* test with modified length field (L) of 7 */
+    if (err == 0) {
+        err = test_aes_tag(e, data, EVP_aes_192_ccm(), 24, 13, 1, 7);
+    }
+#endif
+
+    return err;
+}
+
+/******************************************************************************/
+
+int test_aes256_ccm(ENGINE *e, void *data)
+{
+    int err = 0;
+
+    /* test with default length field (L) */
+    err = test_aes_tag(e, data, EVP_aes_256_ccm(), 32, 13, 1, 0);
+
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+    /* test with modified length field (L) of 7 */
+    if (err == 0) {
+        err = test_aes_tag(e, data, EVP_aes_256_ccm(), 32, 13, 1, 7);
+    }
+#endif
+
+    return err;
 }
 
 /******************************************************************************/
@@ -792,5 +1639,311 @@ int test_aes128_ccm_tls(ENGINE *e, void *data)
 }
 #endif
 
+int test_aes256_ccm_batch(ENGINE *e, void *data)
+{
+    (void)data;
+
+    return test_aes_tag_batch(e, EVP_aes_256_ccm(), 13, 1);
+}
+
+#if defined(WOLFSSL_AES_DIRECT) && !defined(HAVE_FIPS) && \
+    !defined(HAVE_FIPS_VERSION)
+/* Streaming CCM only available when built on the AES block cipher. */
+
+#define TEST_CCM_STREAM_LEN     1000
+
+/* Encrypt/decrypt in chunks once length set. Returns bytes output. Each chunk
+ * is output into a buffer only big enough for it. */
+static int test_aes_ccm_stream_op(ENGINE *e, unsigned char *key,
+                                  unsigned char *iv, unsigned char *aad,
+                                  unsigned char *in, unsigned char *out,
+                                  int len, unsigned char *tag, int enc)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    int chunks[] = { 1, 15, 17, 100, 3, 500 };
+    unsigned char *chunk;
+    unsigned char fin[AES_BLOCK_SIZE];
+    int outLen;
+    int done = 0;
+    int n;
+    int i;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_aes_128_ccm(), e, NULL, NULL,
+                                enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, 13,
+                                  NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16,
+                                  enc ? NULL : tag) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, NULL, e, key, iv, enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, NULL, len) != 1;
+    }
+    /* AAD passed in two parts after the length. */
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad, 5) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, NULL, &outLen, aad + 5,
+                               (int)strlen((char *)aad) - 5) != 1;
+    }
+    /* Last chunk is the rest of the data. */
+    for (i = 0; (err == 0) && (done < len); i++) {
+        n = len - done;
+        if ((i < (int)(sizeof(chunks) / sizeof(*chunks))) && (chunks[i] < n)) {
+            n = chunks[i];
+        }
+        err = (chunk = (unsigned char *)OPENSSL_malloc(n)) == NULL;
+        if (err == 0) {
+            err = (EVP_CipherUpdate(ctx, chunk, &outLen, in + done,
+                                    n) != 1) || (outLen != n);
+            if (err == 0) {
+                memcpy(out + done, chunk, n);
+                done += n;
+            }
+            OPENSSL_free(chunk);
+        }
+    }
+    if (err == 0) {
+        /* Tag calculated or checked here when no data. */
+        err = (EVP_CipherFinal_ex(ctx, fin, &outLen) != 1) || (outLen != 0);
+    }
+    if ((err == 0) && enc) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) != 1;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return (err == 0) ? done : -1;
+}
+
+/* Only AAD authenticated after length of 0 set. Tag checked against one-shot
+ * wolfCrypt through the batch ctrl. */
+static int test_aes_ccm_stream_aad_only(ENGINE *e, unsigned char *key,
+                                        unsigned char *iv, unsigned char *aad)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char tag[16];
+    unsigned char expTag[16];
+    unsigned char buf[1];
+    wolfEngine_AeadPacket pkt;
+
+    PRINT_MSG("Streaming encrypt AAD only with wolfengine");
+    err = test_aes_ccm_stream_op(e, key, iv, aad, buf, buf, 0, tag, 1) != 0;
+    if (err == 0) {
+        PRINT_MSG("One-shot encrypt AAD only with wolfengine batch");
+        pkt.nonce = iv;
+        pkt.nonceLen = 13;
+        pkt.aad = aad;
+        pkt.aadLen = (unsigned int)strlen((char *)aad);
+        pkt.in = buf;
+        pkt.out = buf;
+        pkt.len = 0;
+        pkt.tag = expTag;
+        pkt.tagLen = sizeof(expTag);
+        pkt.status = 0;
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = (EVP_EncryptInit_ex(ctx, EVP_aes_128_ccm(), e, key, NULL) != 1) ||
+              (EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_AEAD_BATCH, 1,
+                                   &pkt) != 1);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    if (err == 0) {
+        err = memcmp(tag, expTag, sizeof(tag)) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Streaming decrypt AAD only with wolfengine");
+        err = test_aes_ccm_stream_op(e, key, iv, aad, buf, buf, 0, tag, 0) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Streaming decrypt AAD only with bad tag fails");
+        tag[0] ^= 0x01;
+        err = test_aes_ccm_stream_op(e, key, iv, aad, buf, buf, 0, tag,
+                                     0) != -1;
+    }
+
+    return err;
+}
+
+int test_aes128_ccm_stream(ENGINE *e, void *data)
+{
+    int err;
+    unsigned char key[16];
+    unsigned char iv[13];
+    unsigned char aad[] = "Streaming CCM AAD";
+    static unsigned char msg[TEST_CCM_STREAM_LEN];
+    static unsigned char exp[TEST_CCM_STREAM_LEN];
+    static unsigned char enc[TEST_CCM_STREAM_LEN];
+    static unsigned char dec[TEST_CCM_STREAM_LEN];
+    unsigned char expTag[16];
+    unsigned char tag[16];
+
+    (void)data;
+
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes(iv, sizeof(iv)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
+    if (err == 0) {
+        PRINT_MSG("One-shot encrypt with OpenSSL");
+        err = test_aes_tag_enc(NULL, EVP_aes_128_ccm(), key, iv, sizeof(iv),
+                               aad, msg, sizeof(msg), exp, expTag, 1, 0);
+    }
+    if (err == 0) {
+        PRINT_MSG("Streaming encrypt with wolfengine");
+        err = test_aes_ccm_stream_op(e, key, iv, aad, msg, enc,
+                                     TEST_CCM_STREAM_LEN, tag, 1) !=
+              TEST_CCM_STREAM_LEN;
+    }
+    if (err == 0) {
+        err = (memcmp(enc, exp, sizeof(exp)) != 0) ||
+              (memcmp(tag, expTag, sizeof(expTag)) != 0);
+    }
+    if (err == 0) {
+        PRINT_MSG("Streaming decrypt with wolfengine");
+        err = test_aes_ccm_stream_op(e, key, iv, aad, enc, dec,
+                                     TEST_CCM_STREAM_LEN, tag, 0) !=
+              TEST_CCM_STREAM_LEN;
+    }
+    if (err == 0) {
+        err = memcmp(dec, msg, sizeof(msg)) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Streaming decrypt with bad tag fails");
+        tag[0] ^= 0x01;
+        err = test_aes_ccm_stream_op(e, key, iv, aad, enc, dec,
+                                     TEST_CCM_STREAM_LEN, tag, 0) != -1;
+    }
+    if (err == 0) {
+        err = test_aes_ccm_stream_aad_only(e, key, iv, aad);
+    }
+
+    return err;
+}
+#endif
+
 #endif /* WE_HAVE_AESCCM */
 
+/******************************************************************************/
+
+#ifdef WE_HAVE_CHACHA
+
+int test_chacha20_poly1305(ENGINE *e, void *data)
+{
+    int err;
+
+    err = test_aes_tag(e, data, EVP_chacha20_poly1305(), 32, 12, 0, 0);
+    if (err == 0) {
+        /* Short nonces are padded with zeros. */
+        err = test_aes_tag(e, data, EVP_chacha20_poly1305(), 32, 8, 0, 0);
+    }
+
+    return err;
+}
+
+/******************************************************************************/
+
+static int test_chacha20_poly1305_tls_crypt(ENGINE *e, int enc,
+                                            unsigned char *key,
+                                            unsigned char *iv,
+                                            unsigned char *aad,
+                                            unsigned char *buf, int len)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, EVP_chacha20_poly1305(), e, key, NULL,
+                                enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IV_FIXED, 12,
+                                  iv) != 1;
+    }
+    if (err == 0) {
+        /* Length in record header includes tag when decrypting. */
+        aad[11] = (unsigned char)((len - (enc ? 16 : 0)) >> 8);
+        aad[12] = (unsigned char)(len - (enc ? 16 : 0));
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD,
+                                  EVP_AEAD_TLS1_AAD_LEN, aad) != 16;
+    }
+    if (err == 0) {
+        err = EVP_Cipher(ctx, buf, buf, len) < 0;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_chacha20_poly1305_tls(ENGINE *e, void *data)
+{
+    int err = 0;
+    unsigned char aad[EVP_AEAD_TLS1_AAD_LEN] = {0,};
+    unsigned char key[32];
+    unsigned char iv[12];
+    unsigned char msg[40];
+    unsigned char exp[sizeof(msg) + 16];
+    unsigned char buf[sizeof(msg) + 16];
+
+    (void)data;
+
+    aad[6]  = 1;  /* Sequence number */
+    aad[7]  = 2;
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes(iv, sizeof(iv)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
+
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL - TLS");
+        memcpy(exp, msg, sizeof(msg));
+        err = test_chacha20_poly1305_tls_crypt(NULL, 1, key, iv, aad, exp,
+                                               sizeof(exp));
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with wolfengine - TLS");
+        memcpy(buf, msg, sizeof(msg));
+        err = test_chacha20_poly1305_tls_crypt(e, 1, key, iv, aad, buf,
+                                               sizeof(buf));
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Record", buf, sizeof(buf));
+        /* Nonce derived from sequence number so output is the same. */
+        err = memcmp(buf, exp, sizeof(buf)) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with wolfengine - TLS");
+        err = test_chacha20_poly1305_tls_crypt(e, 0, key, iv, aad, buf,
+                                               sizeof(buf));
+    }
+    if (err == 0) {
+        err = memcmp(buf, msg, sizeof(msg)) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt modified record with wolfengine - TLS");
+        memcpy(buf, exp, sizeof(exp));
+        buf[sizeof(buf) - 1] ^= 0x01;
+        err = test_chacha20_poly1305_tls_crypt(e, 0, key, iv, aad, buf,
+                                               sizeof(buf)) == 0;
+    }
+
+    return err;
+}
+
+#endif /* WE_HAVE_CHACHA */
@@ -21,7 +21,8 @@
 
 #include "unit.h"
 
-#if defined(WE_HAVE_DES3CBC) || defined(WE_HAVE_AESCBC)
+#if defined(WE_HAVE_DES3CBC) || defined(WE_HAVE_AESCBC) || \
+    defined(WE_HAVE_CHACHA)
 
 static int test_cipher_enc(ENGINE *e, const EVP_CIPHER *cipher,
                            unsigned char *key, unsigned char *iv,
@@ -316,7 +317,7 @@ static int test_stream_enc_dec(ENGINE *e, void *data, const EVP_CIPHER *cipher,
     return err;
 }
 
-#endif /* WE_HAVE_DES3CBC || WE_HAVE_AESCBC */
+#endif /* WE_HAVE_DES3CBC || WE_HAVE_AESCBC || WE_HAVE_CHACHA */
 
 /******************************************************************************/
 
@@ -471,6 +472,506 @@ int test_aes256_cbc_stream(ENGINE *e, void *data)
     return err;
 }
 
+/******************************************************************************/
+
+#ifdef EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK
+
+#define TEST_MB_RECS        4
+#define TEST_MB_FRAG        1024
+#define TEST_MB_REC_MAX     (5 + 16 + TEST_MB_FRAG + 32 + 16)
+
+/* Check a record by decrypting and MACing with OpenSSL. */
+static int test_cbc_hmac_mb_check(const EVP_MD *md, unsigned char *key,
+                                  unsigned char *macKey, unsigned char *hdr,
+                                  unsigned char *rec, unsigned char *msg,
+                                  int *recLen)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    unsigned char dec[TEST_MB_REC_MAX];
+    unsigned char macData[13 + TEST_MB_FRAG];
+    unsigned char mac[32];
+    unsigned int macLen;
+    int macSz = EVP_MD_size(md);
+    int encLen;
+    int len;
+    int dataLen = 0;
+
+    *recLen = (rec[3] << 8) | rec[4];
+    encLen = *recLen - 16;
+    err = (rec[0] != hdr[8]) || (rec[1] != hdr[9]) || (rec[2] != hdr[10]) ||
+          (encLen <= 0) || (encLen > (int)sizeof(dec)) || ((encLen % 16) != 0);
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        /* Explicit IV starts CBC chain. */
+        err = EVP_DecryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, key,
+                                 rec + 5) != 1;
+        if (err == 0) {
+            EVP_CIPHER_CTX_set_padding(ctx, 0);
+            err = EVP_DecryptUpdate(ctx, dec, &len, rec + 5 + 16,
+                                    encLen) != 1;
+        }
+        EVP_CIPHER_CTX_free(ctx);
+    }
+    if (err == 0) {
+        dataLen = encLen - macSz - dec[encLen - 1] - 1;
+        err = (dataLen != TEST_MB_FRAG) || (memcmp(dec, msg, dataLen) != 0);
+    }
+    if (err == 0) {
+        memcpy(macData, hdr, 11);
+        macData[11] = (unsigned char)(dataLen >> 8);
+        macData[12] = (unsigned char)dataLen;
+        memcpy(macData + 13, msg, dataLen);
+        err = HMAC(md, macKey, 32, macData, 13 + dataLen, mac,
+                   &macLen) == NULL;
+    }
+    if (err == 0) {
+        err = memcmp(mac, dec + dataLen, macSz) != 0;
+    }
+
+    return err;
+}
+
+static int test_cbc_hmac_multiblock(ENGINE *e, int nid, const EVP_MD *md)
+{
+    int err;
+    const EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CTRL_TLS1_1_MULTIBLOCK_PARAM param;
+    unsigned char key[16];
+    unsigned char macKey[32];
+    unsigned char aad[13] = {0,};
+    static unsigned char msg[TEST_MB_RECS * TEST_MB_FRAG];
+    static unsigned char out[TEST_MB_RECS * TEST_MB_REC_MAX];
+    unsigned char *rec;
+    int packLen = 0;
+    int recLen;
+    int i;
+
+    aad[7]  = 5;  /* Sequence number */
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+
+    err = (cipher = ENGINE_get_cipher(e, nid)) == NULL;
+    if (err == 0) {
+        err = (RAND_bytes(key, sizeof(key)) != 1) ||
+              (RAND_bytes(macKey, sizeof(macKey)) != 1) ||
+              (RAND_bytes(msg, sizeof(msg)) != 1);
+    }
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_EncryptInit_ex(ctx, cipher, NULL, key, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_MAC_KEY,
+                                  sizeof(macKey), macKey) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Multi-block encrypt with wolfengine");
+        param.out = NULL;
+        param.inp = aad;
+        param.len = sizeof(msg);
+        param.interleave = TEST_MB_RECS;
+        packLen = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_AAD,
+                                      sizeof(param), &param);
+        err = (packLen <= 0) || (packLen > (int)sizeof(out)) ||
+              (param.interleave != TEST_MB_RECS);
+    }
+    if (err == 0) {
+        param.out = out;
+        param.inp = msg;
+        param.len = sizeof(msg);
+        err = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_TLS1_1_MULTIBLOCK_ENCRYPT,
+                                  sizeof(param), &param) != packLen;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    PRINT_MSG("Check records with OpenSSL");
+    rec = out;
+    for (i = 0; (err == 0) && (i < TEST_MB_RECS); i++) {
+        err = test_cbc_hmac_mb_check(md, key, macKey, aad, rec,
+                                     msg + i * TEST_MB_FRAG, &recLen);
+        rec += 5 + recLen;
+        /* Each record has the next sequence number. */
+        aad[7]++;
+    }
+    if ((err == 0) && (rec != out + packLen)) {
+        err = 1;
+    }
+
+    return err;
+}
+
+int test_aes128_cbc_hmac_multiblock(ENGINE *e, void *data)
+{
+    (void)data;
+
+    return test_cbc_hmac_multiblock(e, NID_aes_128_cbc_hmac_sha256,
+                                    EVP_sha256());
+}
+
+#ifdef WE_HAVE_SHA1
+int test_aes128_cbc_hmac_sha1_multiblock(ENGINE *e, void *data)
+{
+    (void)data;
+
+    return test_cbc_hmac_multiblock(e, NID_aes_128_cbc_hmac_sha1, EVP_sha1());
+}
+#endif
+
+#endif /* EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK */
+
+/******************************************************************************/
+
+#define TEST_TLS_DATA_MAX   10003
+#define TEST_TLS_REC_MAX    (16 + TEST_TLS_DATA_MAX + 32 + 16)
+
+/* Encrypt a TLS v1.2 record with explicit IV. Returns encrypted length. */
+static int test_cbc_hmac_tls_enc(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                 unsigned char *in, int dataLen)
+{
+    unsigned char aad[13] = {0,};
+    int pad;
+
+    aad[7]  = 1;  /* Sequence number */
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+    aad[11] = (unsigned char)((16 + dataLen) >> 8);
+    aad[12] = (unsigned char)(16 + dataLen);
+
+    pad = EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD, sizeof(aad), aad);
+    if ((pad <= 0) ||
+            (EVP_Cipher(ctx, out, in, 16 + dataLen + pad) !=
+             16 + dataLen + pad)) {
+        return -1;
+    }
+
+    return 16 + dataLen + pad;
+}
+
+/* Decrypt a TLS v1.2 record in place. Returns data length or -1. */
+static int test_cbc_hmac_tls_dec(EVP_CIPHER_CTX *ctx, unsigned char *rec,
+                                 int recLen)
+{
+    unsigned char aad[13] = {0,};
+
+    aad[7]  = 1;  /* Sequence number */
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+    aad[11] = (unsigned char)(recLen >> 8);
+    aad[12] = (unsigned char)recLen;
+
+    if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD, sizeof(aad),
+                            aad) <= 0) {
+        return -1;
+    }
+
+    return EVP_Cipher(ctx, rec, rec, recLen);
+}
+
+/* Set TLS v1.2 record header into cipher. Returns ctrl result. */
+static int test_cbc_hmac_tls_aad(EVP_CIPHER_CTX *ctx, int len)
+{
+    unsigned char aad[13] = {0,};
+
+    aad[7]  = 1;  /* Sequence number */
+    aad[8]  = 23; /* Content type */
+    aad[9]  = 3;  /* Protocol major version */
+    aad[10] = 3;  /* Protocol minor version */
+    aad[11] = (unsigned char)(len >> 8);
+    aad[12] = (unsigned char)len;
+
+    return EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_TLS1_AAD, sizeof(aad), aad);
+}
+
+/* Check the record encrypted by wolfengine against OpenSSL's stitched cipher:
+ * same ciphertext and MAC for the same explicit IV, and OpenSSL decrypts and
+ * verifies it. */
+static int test_cbc_hmac_tls_ossl(const EVP_CIPHER *ossl,
+                                  EVP_CIPHER_CTX *encCtx,
+                                  unsigned char *key, unsigned char *macKey,
+                                  unsigned char *rec, int dataLen,
+                                  unsigned char *enc, int encLen)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx = NULL;
+    static unsigned char exp[TEST_TLS_REC_MAX];
+    static unsigned char buf[TEST_TLS_REC_MAX];
+    int pad;
+
+    PRINT_MSG("Encrypt with OpenSSL");
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = (EVP_EncryptInit_ex(ctx, ossl, NULL, key, NULL) != 1) ||
+              (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_MAC_KEY, 32,
+                                   macKey) != 1);
+    }
+    if (err == 0) {
+        memcpy(exp, rec, 16 + dataLen);
+        pad = test_cbc_hmac_tls_aad(ctx, 16 + dataLen);
+        err = (pad <= 0) || (16 + dataLen + pad != encLen);
+    }
+    if (err == 0) {
+        /* OpenSSL's stitched cipher returns 1 on success, not a length. */
+        err = EVP_Cipher(ctx, exp, exp, encLen) <= 0;
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    ctx = NULL;
+    if (err == 0) {
+        PRINT_MSG("Encrypt with wolfengine using OpenSSL's explicit IV");
+        /* OpenSSL enciphers the explicit IV block - use its output. */
+        memcpy(buf, exp, 16);
+        memcpy(buf + 16, rec + 16, dataLen);
+        err = (test_cbc_hmac_tls_enc(encCtx, buf, buf, dataLen) != encLen) ||
+              (memcmp(buf, exp, encLen) != 0);
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Decrypt wolfengine record with OpenSSL");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = (EVP_DecryptInit_ex(ctx, ossl, NULL, key, NULL) != 1) ||
+              (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_MAC_KEY, 32,
+                                   macKey) != 1) ||
+              (test_cbc_hmac_tls_aad(ctx, encLen) <= 0);
+    }
+    if (err == 0) {
+        memcpy(buf, enc, encLen);
+        err = (EVP_Cipher(ctx, buf, buf, encLen) <= 0) ||
+              (memcmp(buf + 16, rec + 16, dataLen) != 0);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+static int test_cbc_hmac_tls(ENGINE *e, int nid, const EVP_CIPHER *ossl,
+                             int dataLen)
+{
+    int err;
+    const EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *encCtx = NULL;
+    EVP_CIPHER_CTX *decCtx = NULL;
+    unsigned char key[16];
+    unsigned char macKey[32];
+    static unsigned char rec[TEST_TLS_REC_MAX];
+    static unsigned char out[TEST_TLS_REC_MAX];
+    static unsigned char inPlace[TEST_TLS_REC_MAX];
+    int encLen = 0;
+
+    err = (cipher = ENGINE_get_cipher(e, nid)) == NULL;
+    if (err == 0) {
+        /* Explicit IV followed by data. */
+        err = (RAND_bytes(key, sizeof(key)) != 1) ||
+              (RAND_bytes(macKey, sizeof(macKey)) != 1) ||
+              (RAND_bytes(rec, 16 + dataLen) != 1);
+    }
+    if (err == 0) {
+        err = ((encCtx = EVP_CIPHER_CTX_new()) == NULL) ||
+              ((decCtx = EVP_CIPHER_CTX_new()) == NULL);
+    }
+    if (err == 0) {
+        err = (EVP_EncryptInit_ex(encCtx, cipher, NULL, key, NULL) != 1) ||
+              (EVP_DecryptInit_ex(decCtx, cipher, NULL, key, NULL) != 1);
+    }
+    if (err == 0) {
+        err = (EVP_CIPHER_CTX_ctrl(encCtx, EVP_CTRL_AEAD_SET_MAC_KEY,
+                                   sizeof(macKey), macKey) != 1) ||
+              (EVP_CIPHER_CTX_ctrl(decCtx, EVP_CTRL_AEAD_SET_MAC_KEY,
+                                   sizeof(macKey), macKey) != 1);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt out of place and in place");
+        encLen = test_cbc_hmac_tls_enc(encCtx, out, rec, dataLen);
+        memcpy(inPlace, rec, 16 + dataLen);
+        err = (encLen <= 0) ||
+              (test_cbc_hmac_tls_enc(encCtx, inPlace, inPlace,
+                                     dataLen) != encLen);
+    }
+    if (err == 0) {
+        err = memcmp(out, inPlace, encLen) != 0;
+    }
+    if ((err == 0) && (ossl != NULL)) {
+        err = test_cbc_hmac_tls_ossl(ossl, encCtx, key, macKey, rec, dataLen,
+                                     out, encLen);
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt in place");
+        err = (test_cbc_hmac_tls_dec(decCtx, inPlace, encLen) != dataLen) ||
+              (memcmp(inPlace + 16, rec + 16, dataLen) != 0);
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt modified record fails");
+        out[encLen / 2] ^= 0x80;
+        err = test_cbc_hmac_tls_dec(decCtx, out, encLen) != -1;
+    }
+
+    EVP_CIPHER_CTX_free(decCtx);
+    EVP_CIPHER_CTX_free(encCtx);
+
+    return err;
+}
+
+int test_aes128_cbc_hmac_tls(ENGINE *e, void *data)
+{
+    int err = 0;
+    int lens[] = { 1, 1000, TEST_TLS_DATA_MAX };
+    int i;
+    /* Not available without CPU support. */
+    const EVP_CIPHER *ossl = EVP_aes_128_cbc_hmac_sha256();
+
+    (void)data;
+
+    if (ossl == NULL) {
+        PRINT_MSG("OpenSSL AES-128-CBC-HMAC-SHA256 not available");
+    }
+    for (i = 0; (err == 0) && (i < (int)(sizeof(lens) / sizeof(*lens)));
+         i++) {
+        err = test_cbc_hmac_tls(e, NID_aes_128_cbc_hmac_sha256, ossl,
+                                lens[i]);
+    }
+
+    return err;
+}
+
+#ifdef EVP_CIPH_FLAG_PIPELINE
+
+#define TEST_PIPE_RECS      4
+#define TEST_PIPE_DATA_MAX  3000
+#define TEST_PIPE_REC_MAX   (16 + TEST_PIPE_DATA_MAX + 32 + 16)
+
+/* Set the records into the pipeline of the cipher and process them in one
+ * call. Returns the total length output. */
+static int test_cbc_hmac_pipeline_op(EVP_CIPHER_CTX *ctx,
+                                     unsigned char **bufs, size_t *lens)
+{
+    int ret = -1;
+
+    if ((EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_SET_PIPELINE_OUTPUT_BUFS,
+                             TEST_PIPE_RECS, bufs) == 1) &&
+            (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_SET_PIPELINE_INPUT_BUFS,
+                                 TEST_PIPE_RECS, bufs) == 1) &&
+            (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_SET_PIPELINE_INPUT_LENS,
+                                 TEST_PIPE_RECS, lens) == 1)) {
+        ret = EVP_Cipher(ctx, bufs[0], bufs[0], (unsigned int)lens[0]);
+    }
+
+    return ret;
+}
+
+int test_aes128_cbc_hmac_pipeline(ENGINE *e, void *data)
+{
+    int err;
+    const EVP_CIPHER *cipher;
+    EVP_CIPHER_CTX *encCtx = NULL;
+    EVP_CIPHER_CTX *decCtx = NULL;
+    unsigned char key[16];
+    unsigned char macKey[32];
+    static const int dataLens[TEST_PIPE_RECS] = { 1, 100, 1000,
+                                                  TEST_PIPE_DATA_MAX };
+    static unsigned char rec[TEST_PIPE_RECS][TEST_PIPE_REC_MAX];
+    static unsigned char exp[TEST_PIPE_RECS][TEST_PIPE_REC_MAX];
+    static unsigned char buf[TEST_PIPE_RECS][TEST_PIPE_REC_MAX];
+    unsigned char *bufs[TEST_PIPE_RECS];
+    size_t lens[TEST_PIPE_RECS];
+    int encLens[TEST_PIPE_RECS];
+    int total = 0;
+    int pad;
+    int i;
+
+    (void)data;
+
+    err = (cipher = ENGINE_get_cipher(e, NID_aes_128_cbc_hmac_sha256)) == NULL;
+    if (err == 0) {
+        /* Explicit IV followed by data. */
+        err = (RAND_bytes(key, sizeof(key)) != 1) ||
+              (RAND_bytes(macKey, sizeof(macKey)) != 1) ||
+              (RAND_bytes(rec[0], sizeof(rec)) != 1);
+    }
+    if (err == 0) {
+        err = ((encCtx = EVP_CIPHER_CTX_new()) == NULL) ||
+              ((decCtx = EVP_CIPHER_CTX_new()) == NULL);
+    }
+    if (err == 0) {
+        err = (EVP_EncryptInit_ex(encCtx, cipher, NULL, key, NULL) != 1) ||
+              (EVP_DecryptInit_ex(decCtx, cipher, NULL, key, NULL) != 1);
+    }
+    if (err == 0) {
+        err = (EVP_CIPHER_CTX_ctrl(encCtx, EVP_CTRL_AEAD_SET_MAC_KEY,
+                                   sizeof(macKey), macKey) != 1) ||
+              (EVP_CIPHER_CTX_ctrl(decCtx, EVP_CTRL_AEAD_SET_MAC_KEY,
+                                   sizeof(macKey), macKey) != 1);
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        PRINT_MSG("Encrypt record without pipeline");
+        encLens[i] = test_cbc_hmac_tls_enc(encCtx, exp[i], rec[i],
+                                           dataLens[i]);
+        err = encLens[i] <= 0;
+        total += encLens[i];
+    }
+
+    if (err == 0) {
+        PRINT_MSG("Encrypt records in one call - TLS pipeline");
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        pad = test_cbc_hmac_tls_aad(encCtx, 16 + dataLens[i]);
+        err = 16 + dataLens[i] + pad != encLens[i];
+        memcpy(buf[i], rec[i], 16 + dataLens[i]);
+        bufs[i] = buf[i];
+        lens[i] = encLens[i];
+    }
+    if (err == 0) {
+        err = test_cbc_hmac_pipeline_op(encCtx, bufs, lens) != total;
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        err = memcmp(buf[i], exp[i], encLens[i]) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt record without pipeline after pipeline");
+        err = (test_cbc_hmac_tls_enc(encCtx, buf[0], rec[0],
+                                     dataLens[0]) != encLens[0]) ||
+              (memcmp(buf[0], exp[0], encLens[0]) != 0);
+    }
+
+    total = 0;
+    if (err == 0) {
+        PRINT_MSG("Decrypt records in one call - TLS pipeline");
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        err = test_cbc_hmac_tls_aad(decCtx, encLens[i]) <= 0;
+        memcpy(buf[i], exp[i], encLens[i]);
+        total += dataLens[i];
+    }
+    if (err == 0) {
+        err = test_cbc_hmac_pipeline_op(decCtx, bufs, lens) != total;
+    }
+    for (i = 0; (err == 0) && (i < TEST_PIPE_RECS); i++) {
+        err = memcmp(buf[i] + 16, rec[i] + 16, dataLens[i]) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt record without pipeline after pipeline");
+        memcpy(buf[0], exp[0], encLens[0]);
+        err = (test_cbc_hmac_tls_dec(decCtx, buf[0],
+                                     encLens[0]) != dataLens[0]) ||
+              (memcmp(buf[0] + 16, rec[0] + 16, dataLens[0]) != 0);
+    }
+
+    EVP_CIPHER_CTX_free(decCtx);
+    EVP_CIPHER_CTX_free(encCtx);
+
+    return err;
+}
+
+#endif /* EVP_CIPH_FLAG_PIPELINE */
+
 #endif /* WE_HAVE_AESCBC */
 
 /******************************************************************************/
@@ -586,3 +1087,585 @@ int test_aes_ctr_iv_init_regression(ENGINE *e, void *data)
 
 #endif /* WE_HAVE_AESCTR */
 
+/******************************************************************************/
+
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC)
+
+#define TEST_BULK_LEN       (1024 * 1024)
+
+/* Encrypt/decrypt in place - a small update and then one very large one. */
+static int test_bulk_crypt(ENGINE *e, const EVP_CIPHER *cipher, int enc,
+                           unsigned char *key, unsigned char *iv,
+                           unsigned char *buf, int len, int first)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    int outLen = 0;
+    int total = 0;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, e, key, iv, enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_set_padding(ctx, 0) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, buf, &outLen, buf, first) != 1;
+        total += outLen;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, buf + total, &outLen, buf + first,
+                               len - first) != 1;
+        total += outLen;
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, buf + total, &outLen) != 1;
+        total += outLen;
+    }
+    if (err == 0) {
+        err = total != len;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+static int test_bulk_cipher(ENGINE *e, const EVP_CIPHER *cipher, int len,
+                            int first)
+{
+    int err;
+    unsigned char key[32];
+    unsigned char iv[AES_BLOCK_SIZE];
+    static unsigned char msg[TEST_BULK_LEN + AES_BLOCK_SIZE];
+    static unsigned char encExp[TEST_BULK_LEN + AES_BLOCK_SIZE];
+    static unsigned char buf[TEST_BULK_LEN + AES_BLOCK_SIZE];
+
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes(iv, sizeof(iv)) != 1) ||
+          (RAND_bytes(msg, len) != 1);
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        memcpy(encExp, msg, len);
+        err = test_bulk_crypt(NULL, cipher, 1, key, iv, encExp, len, first);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with wolfengine");
+        memcpy(buf, msg, len);
+        err = test_bulk_crypt(e, cipher, 1, key, iv, buf, len, first);
+    }
+    if (err == 0) {
+        err = memcmp(buf, encExp, len) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with wolfengine");
+        err = test_bulk_crypt(e, cipher, 0, key, iv, buf, len, first);
+    }
+    if (err == 0) {
+        err = memcmp(buf, msg, len) != 0;
+    }
+
+    return err;
+}
+
+int test_aes_bulk_threads(ENGINE *e, void *data)
+{
+    int err;
+    wolfEngine_Stats before;
+    wolfEngine_Stats after;
+
+    (void)data;
+
+    err = ENGINE_ctrl_cmd(e, "bulk_threads", -1, NULL, NULL, 0) == 1;
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threshold", -1, NULL, NULL, 0) == 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &before, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threads", 3, NULL, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threshold", 256 * 1024, NULL, NULL,
+                              0) != 1;
+    }
+#ifdef WE_HAVE_AESCTR
+    if (err == 0) {
+        /* Partial block of key stream left before the large update. */
+        err = test_bulk_cipher(e, EVP_aes_128_ctr(), TEST_BULK_LEN + 7, 5);
+    }
+    if (err == 0) {
+        err = test_bulk_cipher(e, EVP_aes_256_ctr(), TEST_BULK_LEN, 16);
+    }
+#endif
+#ifdef WE_HAVE_AESECB
+    if (err == 0) {
+        err = test_bulk_cipher(e, EVP_aes_128_ecb(), TEST_BULK_LEN, 16);
+    }
+#endif
+#ifdef WE_HAVE_AESCBC
+    if (err == 0) {
+        err = test_bulk_cipher(e, EVP_aes_128_cbc(), TEST_BULK_LEN + 16, 16);
+    }
+    if (err == 0) {
+        err = test_bulk_cipher(e, EVP_aes_256_cbc(), TEST_BULK_LEN, 32);
+    }
+#endif
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1;
+    }
+#if defined(TEST_BULK_THREADS) && (defined(WE_HAVE_AESCTR) || \
+    defined(WE_HAVE_AESECB) || defined(WE_HAVE_AESCBC))
+    if ((err == 0) && (after.bulkSplits == before.bulkSplits)) {
+        PRINT_ERR_MSG("Large buffers not split across bulk pool");
+        err = 1;
+    }
+#endif
+    if (err == 0) {
+        /* Resizing the running pool. */
+        err = ENGINE_ctrl_cmd(e, "bulk_threads", 1, NULL, NULL, 0) != 1;
+    }
+#ifdef WE_HAVE_AESCBC
+    if (err == 0) {
+        err = test_bulk_cipher(e, EVP_aes_192_cbc(), TEST_BULK_LEN, 16);
+    }
+#endif
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threads", 0, NULL, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threshold", 0, NULL, NULL, 0) != 1;
+    }
+
+    return err;
+}
+
+#define TEST_REUSE_LEN      64
+
+/* Re-initialize an existing context, without a cipher, and check the result
+ * against a fresh OpenSSL operation. */
+static int test_key_reuse_step(ENGINE *e, EVP_CIPHER_CTX *ctx,
+                               const EVP_CIPHER *cipher, unsigned char *key,
+                               unsigned char *iv, int enc,
+                               const unsigned char *in)
+{
+    int err;
+    unsigned char exp[TEST_REUSE_LEN];
+    unsigned char buf[TEST_REUSE_LEN];
+    int outLen = 0;
+    int total = 0;
+
+    memcpy(exp, in, TEST_REUSE_LEN);
+    err = test_bulk_crypt(NULL, cipher, enc, key, iv, exp, TEST_REUSE_LEN,
+                          TEST_REUSE_LEN / 2);
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, NULL, e, key, iv, enc) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, buf, &outLen, in, TEST_REUSE_LEN) != 1;
+        total += outLen;
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, buf + total, &outLen) != 1;
+        total += outLen;
+    }
+    if (err == 0) {
+        err = (total != TEST_REUSE_LEN) ||
+              (memcmp(buf, exp, TEST_REUSE_LEN) != 0);
+    }
+
+    return err;
+}
+
+static int test_key_reuse_cipher(ENGINE *e, const EVP_CIPHER *cipher)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx = NULL;
+    unsigned char key1[32];
+    unsigned char key2[32];
+    unsigned char iv1[AES_BLOCK_SIZE];
+    unsigned char iv2[AES_BLOCK_SIZE];
+    unsigned char msg[TEST_REUSE_LEN];
+    unsigned char enc[TEST_REUSE_LEN];
+
+    err = (RAND_bytes(key1, sizeof(key1)) != 1) ||
+          (RAND_bytes(key2, sizeof(key2)) != 1) ||
+          (RAND_bytes(iv1, sizeof(iv1)) != 1) ||
+          (RAND_bytes(iv2, sizeof(iv2)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, e, NULL, NULL, 1) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_set_padding(ctx, 0) != 1;
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with first key");
+        err = test_key_reuse_step(e, ctx, cipher, key1, iv1, 1, msg);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with same key and new IV");
+        err = test_key_reuse_step(e, ctx, cipher, key1, iv2, 1, msg);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt with new key");
+        err = test_key_reuse_step(e, ctx, cipher, key2, iv2, 1, msg);
+    }
+    if (err == 0) {
+        memcpy(enc, msg, sizeof(enc));
+        err = test_bulk_crypt(NULL, cipher, 1, key2, iv1, enc, sizeof(enc),
+                              AES_BLOCK_SIZE);
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt with same key");
+        err = test_key_reuse_step(e, ctx, cipher, key2, iv1, 0, enc);
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt again with same key");
+        err = test_key_reuse_step(e, ctx, cipher, key2, iv1, 1, msg);
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_aes_key_reuse(ENGINE *e, void *data)
+{
+    int err = 0;
+
+    (void)data;
+
+#ifdef WE_HAVE_AESCTR
+    if (err == 0) {
+        err = test_key_reuse_cipher(e, EVP_aes_128_ctr());
+    }
+#endif
+#ifdef WE_HAVE_AESECB
+    if (err == 0) {
+        err = test_key_reuse_cipher(e, EVP_aes_192_ecb());
+    }
+#endif
+#ifdef WE_HAVE_AESCBC
+    if (err == 0) {
+        err = test_key_reuse_cipher(e, EVP_aes_256_cbc());
+    }
+#endif
+
+    return err;
+}
+
+#endif /* WE_HAVE_AESCTR || WE_HAVE_AESECB || WE_HAVE_AESCBC */
+
+/******************************************************************************/
+
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC) || defined(WE_HAVE_DES3CBC)
+
+#define TEST_COPY_LEN       64
+
+/* Finish an operation - rest of message and final. */
+static int test_copy_finish(EVP_CIPHER_CTX *ctx, const unsigned char *in,
+                            int len, unsigned char *out, int *outLen)
+{
+    int err;
+    int len2 = 0;
+
+    err = EVP_CipherUpdate(ctx, out, outLen, in, len) != 1;
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, out + *outLen, &len2) != 1;
+        *outLen += len2;
+    }
+
+    return err;
+}
+
+/* Clone a keyed template context, free the template and then clone part way
+ * through an operation - each must give the same result as OpenSSL. */
+static int test_cipher_copy_one(ENGINE *e, const EVP_CIPHER *cipher)
+{
+    int err;
+    EVP_CIPHER_CTX *tmpl = NULL;
+    EVP_CIPHER_CTX *ctx = NULL;
+    EVP_CIPHER_CTX *ctx2 = NULL;
+    unsigned char key[32];
+    unsigned char iv[AES_BLOCK_SIZE];
+    unsigned char msg[TEST_COPY_LEN];
+    unsigned char exp[TEST_COPY_LEN];
+    unsigned char buf[TEST_COPY_LEN];
+    unsigned char buf2[TEST_COPY_LEN];
+    int expLen = 0;
+    int outLen = 0;
+    int first = 0;
+    int outLen2 = 0;
+
+    err = (RAND_bytes(key, sizeof(key)) != 1) ||
+          (RAND_bytes(iv, sizeof(iv)) != 1) ||
+          (RAND_bytes(msg, sizeof(msg)) != 1);
+    if (err == 0) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, NULL, key, iv, 1) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_set_padding(ctx, 0) != 1;
+    }
+    if (err == 0) {
+        err = test_copy_finish(ctx, msg, sizeof(msg), exp, &expLen);
+    }
+    EVP_CIPHER_CTX_free(ctx);
+    ctx = NULL;
+
+    if (err == 0) {
+        PRINT_MSG("Copy keyed template context");
+        err = (tmpl = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CipherInit_ex(tmpl, cipher, e, key, iv, 1) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_set_padding(tmpl, 0) != 1;
+    }
+    if (err == 0) {
+        err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_copy(ctx, tmpl) != 1;
+    }
+    /* Copy must not depend on template. */
+    EVP_CIPHER_CTX_free(tmpl);
+
+    if (err == 0) {
+        PRINT_MSG("Copy part way through operation");
+        /* Leave a partial block buffered. */
+        err = EVP_CipherUpdate(ctx, buf, &first, msg, 21) != 1;
+    }
+    if (err == 0) {
+        err = (ctx2 = EVP_CIPHER_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_CIPHER_CTX_copy(ctx2, ctx) != 1;
+    }
+    if (err == 0) {
+        memcpy(buf2, buf, first);
+        err = test_copy_finish(ctx, msg + 21, sizeof(msg) - 21, buf + first,
+                               &outLen);
+    }
+    if (err == 0) {
+        err = (first + outLen != expLen) || (memcmp(buf, exp, expLen) != 0);
+    }
+    if (err == 0) {
+        err = test_copy_finish(ctx2, msg + 21, sizeof(msg) - 21,
+                               buf2 + first, &outLen2);
+    }
+    if (err == 0) {
+        err = (first + outLen2 != expLen) ||
+              (memcmp(buf2, exp, expLen) != 0);
+    }
+
+    EVP_CIPHER_CTX_free(ctx2);
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+int test_cipher_copy(ENGINE *e, void *data)
+{
+    int err = 0;
+
+    (void)data;
+
+#ifdef WE_HAVE_DES3CBC
+    if (err == 0) {
+        err = test_cipher_copy_one(e, EVP_des_ede3_cbc());
+    }
+#endif
+#ifdef WE_HAVE_AESECB
+    if (err == 0) {
+        err = test_cipher_copy_one(e, EVP_aes_128_ecb());
+    }
+#endif
+#ifdef WE_HAVE_AESCBC
+    if (err == 0) {
+        err = test_cipher_copy_one(e, EVP_aes_256_cbc());
+    }
+#endif
+#ifdef WE_HAVE_AESCTR
+    if (err == 0) {
+        err = test_cipher_copy_one(e, EVP_aes_192_ctr());
+    }
+#endif
+
+    return err;
+}
+
+#endif /* WE_HAVE_AESCTR || WE_HAVE_AESECB || WE_HAVE_AESCBC ||
+        * WE_HAVE_DES3CBC */
+
+/******************************************************************************/
+
+#ifdef WE_HAVE_AESXTS
+
+static int test_aes_xts_crypt(ENGINE *e, const EVP_CIPHER *cipher, int enc,
+                              unsigned char *key, unsigned char *iv,
+                              int sectorSz, unsigned char *in, int len,
+                              unsigned char *out)
+{
+    int err;
+    EVP_CIPHER_CTX *ctx;
+    int outLen = 0;
+    int fLen = 0;
+
+    err = (ctx = EVP_CIPHER_CTX_new()) == NULL;
+    if (err == 0) {
+        err = EVP_CipherInit_ex(ctx, cipher, e, key, iv, enc) != 1;
+    }
+    if ((err == 0) && (sectorSz > 0)) {
+        err = EVP_CIPHER_CTX_ctrl(ctx, WOLFENGINE_CTRL_XTS_SECTOR_SIZE,
+                                  sectorSz, NULL) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherUpdate(ctx, out, &outLen, in, len) != 1;
+    }
+    if (err == 0) {
+        err = EVP_CipherFinal_ex(ctx, out + outLen, &fLen) != 1;
+    }
+    if (err == 0) {
+        err = outLen + fLen != len;
+    }
+
+    EVP_CIPHER_CTX_free(ctx);
+
+    return err;
+}
+
+static int test_aes_xts(ENGINE *e, const EVP_CIPHER *cipher, int keyLen)
+{
+    int err;
+    unsigned char key[64];
+    unsigned char iv[AES_BLOCK_SIZE];
+    unsigned char tweak[AES_BLOCK_SIZE];
+    unsigned char msg[4096];
+    unsigned char enc[4096];
+    unsigned char encExp[4096];
+    unsigned char dec[4096];
+    int lens[] = { 16, 17, 31, 512, 4096 };
+    int sectorSz = 512;
+    int sectors = 4;
+    int i;
+    int j;
+
+    err = RAND_bytes(key, keyLen) != 1;
+    /* XTS requires that the two halves of the key differ. */
+    if (err == 0) {
+        key[0] = (unsigned char)~key[keyLen / 2];
+        err = RAND_bytes(iv, sizeof(iv)) != 1;
+    }
+    if (err == 0) {
+        err = RAND_bytes(msg, sizeof(msg)) != 1;
+    }
+
+    for (i = 0; (err == 0) && (i < (int)(sizeof(lens) / sizeof(*lens)));
+         i++) {
+        PRINT_MSG("Encrypt with OpenSSL");
+        err = test_aes_xts_crypt(NULL, cipher, 1, key, iv, 0, msg, lens[i],
+                                 encExp);
+        if (err == 0) {
+            PRINT_MSG("Encrypt with wolfengine");
+            err = test_aes_xts_crypt(e, cipher, 1, key, iv, 0, msg, lens[i],
+                                     enc);
+        }
+        if (err == 0) {
+            PRINT_BUFFER("Encrypted", enc, lens[i]);
+            err = memcmp(enc, encExp, lens[i]) != 0;
+        }
+        if (err == 0) {
+            PRINT_MSG("Decrypt with wolfengine");
+            err = test_aes_xts_crypt(e, cipher, 0, key, iv, 0, enc, lens[i],
+                                     dec);
+        }
+        if (err == 0) {
+            err = memcmp(dec, msg, lens[i]) != 0;
+        }
+    }
+
+    /* Sector-batched call: each sector is encrypted with the tweak
+     * incremented as a little-endian 128-bit number. */
+    memcpy(tweak, iv, sizeof(tweak));
+    for (i = 0; (err == 0) && (i < sectors); i++) {
+        err = test_aes_xts_crypt(NULL, cipher, 1, key, tweak, 0,
+                                 msg + i * sectorSz, sectorSz,
+                                 encExp + i * sectorSz);
+        for (j = 0; j < AES_BLOCK_SIZE; j++) {
+            if (++tweak[j] != 0)
+                break;
+        }
+    }
+    if (err == 0) {
+        PRINT_MSG("Encrypt sectors with wolfengine");
+        err = test_aes_xts_crypt(e, cipher, 1, key, iv, sectorSz, msg,
+                                 sectors * sectorSz, enc);
+    }
+    if (err == 0) {
+        err = memcmp(enc, encExp, sectors * sectorSz) != 0;
+    }
+    if (err == 0) {
+        PRINT_MSG("Decrypt sectors with wolfengine");
+        err = test_aes_xts_crypt(e, cipher, 0, key, iv, sectorSz, enc,
+                                 sectors * sectorSz, dec);
+    }
+    if (err == 0) {
+        err = memcmp(dec, msg, sectors * sectorSz) != 0;
+    }
+
+    return err;
+}
+
+/******************************************************************************/
+
+int test_aes128_xts(ENGINE *e, void *data)
+{
+    (void)data;
+
+    return test_aes_xts(e, EVP_aes_128_xts(), 32);
+}
+
+/******************************************************************************/
+
+int test_aes256_xts(ENGINE *e, void *data)
+{
+    (void)data;
+
+    return test_aes_xts(e, EVP_aes_256_xts(), 64);
+}
+
+#endif /* WE_HAVE_AESXTS */
+
+/******************************************************************************/
+
+#ifdef WE_HAVE_CHACHA
+
+int test_chacha20_stream(ENGINE *e, void *data)
+{
+    int err;
+
+    /* IV is 32-bit block counter and 96-bit nonce. */
+    err = test_stream_enc_dec(e, data, EVP_chacha20(), 32, 16, 16, 0);
+    if (err == 0)
+        err = test_stream_enc_dec(e, data, EVP_chacha20(), 32, 16, 1, 0);
+    if (err == 0)
+        err = test_stream_enc_dec(e, data, EVP_chacha20(), 32, 16, 13, 0);
+
+    return err;
+}
+
+#endif /* WE_HAVE_CHACHA */
+
@@ -143,6 +143,77 @@ int test_sha512(ENGINE *e, void *data)
 
 /******************************************************************************/
 
+#ifdef WE_HAVE_SHA512_224
+int test_sha512_224(ENGINE *e, void *data)
+{
+    return test_create_digest(EVP_sha512_224(), e, data);
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef WE_HAVE_SHA512_256
+int test_sha512_256(ENGINE *e, void *data)
+{
+    return test_create_digest(EVP_sha512_256(), e, data);
+}
+#endif
+
+/******************************************************************************/
+
+#if defined(WE_HAVE_SHA384) || defined(WE_HAVE_SHA512)
+static int test_digest_unaligned_op(const EVP_MD *md, ENGINE *e)
+{
+    int err = 0;
+    static unsigned char msg[8 + 3000 + 127];
+    unsigned char exp[64];
+    size_t len[] = { 3000, 3005, 3127 };
+    unsigned int dLen;
+    unsigned int i;
+    int off;
+
+    RAND_bytes(msg, sizeof(msg));
+
+    /* Message is digested in two updates - the second starts at an odd
+     * address with part of a block held by the hash object. */
+    for (i = 0; (err == 0) && (i < sizeof(len) / sizeof(*len)); i++) {
+        for (off = 1; (err == 0) && (off < 8); off += 3) {
+            dLen = 0;
+            err = test_digest_op(md, NULL, msg + off, len[i], exp, &dLen);
+            if (err == 0) {
+                err = test_digest_op(md, e, msg + off, len[i], exp, &dLen);
+            }
+        }
+    }
+
+    return err;
+}
+
+int test_digest_unaligned(ENGINE *e, void *data)
+{
+    int err = 0;
+
+    (void)data;
+
+#ifdef WE_HAVE_SHA384
+    if (err == 0) {
+        PRINT_MSG("Unaligned SHA-384");
+        err = test_digest_unaligned_op(EVP_sha384(), e);
+    }
+#endif
+#ifdef WE_HAVE_SHA512
+    if (err == 0) {
+        PRINT_MSG("Unaligned SHA-512");
+        err = test_digest_unaligned_op(EVP_sha512(), e);
+    }
+#endif
+
+    return err;
+}
+#endif
+
+/******************************************************************************/
+
 #ifdef WE_HAVE_SHA3_224
 int test_sha3_224(ENGINE *e, void *data)
 {
@@ -179,4 +250,249 @@ int test_sha3_512(ENGINE *e, void *data)
 
 /******************************************************************************/
 
+#if defined(WE_HAVE_SHAKE128) || defined(WE_HAVE_SHAKE256)
+static int test_xof_op(const EVP_MD *md, ENGINE *e, unsigned char *msg,
+                       size_t len, size_t outLen, unsigned char *prev,
+                       size_t *prevLen)
+{
+    int err;
+    EVP_MD_CTX *ctx;
+    unsigned char *out;
+    unsigned int dLen;
+
+    err = (out = (unsigned char *)OPENSSL_zalloc(outLen)) == NULL;
+    if (err == 0) {
+        err = (ctx = EVP_MD_CTX_new()) == NULL;
+    }
+    if (err == 0) {
+        err = EVP_DigestInit_ex(ctx, md, e) != 1;
+        if (err == 0) {
+            err = EVP_DigestUpdate(ctx, msg, len/2) != 1;
+        }
+        if (err == 0) {
+            err = EVP_DigestUpdate(ctx, msg + len/2, len - len/2) != 1;
+        }
+        if (err == 0) {
+            /* Default length of output uses the plain final. */
+            if ((int)outLen == EVP_MD_size(md)) {
+                err = EVP_DigestFinal_ex(ctx, out, &dLen) != 1;
+                if ((err == 0) && (dLen != outLen)) {
+                    PRINT_ERR_MSG("Output length not the default");
+                    err = 1;
+                }
+            }
+            else {
+                err = EVP_DigestFinalXOF(ctx, out, outLen) != 1;
+            }
+        }
+        EVP_MD_CTX_free(ctx);
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Output", out, outLen);
+
+        if (*prevLen == 0) {
+            memcpy(prev, out, outLen);
+            *prevLen = outLen;
+        }
+        else if (memcmp(out, prev, *prevLen) != 0) {
+            PRINT_ERR_MSG("Outputs don't match");
+            err = 1;
+        }
+        else {
+            PRINT_MSG("Outputs match");
+        }
+    }
+
+    OPENSSL_free(out);
+
+    return err;
+}
+
+static int test_create_xof(const EVP_MD *md, ENGINE *e, void *data)
+{
+    int err = 0;
+    unsigned char longMsg[1300];
+    static unsigned char exp[1000];
+    /* Default, short, one block of SHAKE128 and SHAKE256, and many blocks. */
+    size_t outLen[] = { 0, 1, 136, 168, 169, sizeof(exp) };
+    size_t msgLen[] = { 0, 12, sizeof(longMsg) };
+    size_t expLen;
+    unsigned int i;
+    unsigned int j;
+
+    (void)data;
+
+    outLen[0] = EVP_MD_size(md);
+    RAND_bytes(longMsg, sizeof(longMsg));
+
+    for (i = 0; (err == 0) && (i < sizeof(msgLen) / sizeof(*msgLen)); i++) {
+        for (j = 0; (err == 0) && (j < sizeof(outLen) / sizeof(*outLen));
+             j++) {
+            expLen = 0;
+            PRINT_MSG("XOF with OpenSSL");
+            err = test_xof_op(md, NULL, longMsg, msgLen[i], outLen[j], exp,
+                              &expLen);
+            if (err == 0) {
+                PRINT_MSG("XOF With wolfengine");
+                err = test_xof_op(md, e, longMsg, msgLen[i], outLen[j], exp,
+                                  &expLen);
+            }
+        }
+    }
+
+    return err;
+}
+#endif
+
+#ifdef WE_HAVE_SHAKE128
+int test_shake128(ENGINE *e, void *data)
+{
+    return test_create_xof(EVP_shake128(), e, data);
+}
+#endif
+
+#ifdef WE_HAVE_SHAKE256
+int test_shake256(ENGINE *e, void *data)
+{
+    return test_create_xof(EVP_shake256(), e, data);
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef WE_HAVE_BLAKE2B
+int test_blake2b512(ENGINE *e, void *data)
+{
+    return test_create_digest(EVP_blake2b512(), e, data);
+}
+#endif
+
+/******************************************************************************/
+
+#ifdef WE_HAVE_BLAKE2S
+int test_blake2s256(ENGINE *e, void *data)
+{
+    return test_create_digest(EVP_blake2s256(), e, data);
+}
+#endif
+
+/******************************************************************************/
+
+#if defined(WE_HAVE_SHA256) || defined(WE_HAVE_SHA512)
+
+#define TEST_DIGEST_BATCH_CNT   33
+
+static int test_digest_batch_op(ENGINE *e, const EVP_MD *md,
+                                unsigned char *msgs, size_t len)
+{
+    int err = 0;
+    int i;
+    static unsigned char out[TEST_DIGEST_BATCH_CNT][64];
+    unsigned char exp[64];
+    wolfEngine_DigestJob jobs[TEST_DIGEST_BATCH_CNT];
+    wolfEngine_DigestBatch batch;
+
+    /* Messages of different lengths, including empty, from one buffer. */
+    for (i = 0; i < TEST_DIGEST_BATCH_CNT; i++) {
+        jobs[i].data = msgs + i;
+        jobs[i].len = (len * i) / (TEST_DIGEST_BATCH_CNT - 1);
+        jobs[i].out = out[i];
+        jobs[i].status = 0;
+    }
+    batch.nid = EVP_MD_type(md);
+    batch.jobs = jobs;
+    batch.cnt = TEST_DIGEST_BATCH_CNT;
+
+    err = ENGINE_ctrl_cmd(e, "digest_batch", 0, &batch, NULL, 0) != 1;
+    for (i = 0; (err == 0) && (i < TEST_DIGEST_BATCH_CNT); i++) {
+        err = jobs[i].status != 1;
+        if (err == 0) {
+            err = EVP_Digest(jobs[i].data, jobs[i].len, exp, NULL, md,
+                             NULL) != 1;
+        }
+        if ((err == 0) && (memcmp(out[i], exp, EVP_MD_size(md)) != 0)) {
+            PRINT_ERR_MSG("Batched digest doesn't match");
+            err = 1;
+        }
+    }
+
+    if (err == 0) {
+        /* Bad message only fails itself. */
+        jobs[3].out = NULL;
+        err = ENGINE_ctrl_cmd(e, "digest_batch", 0, &batch, NULL, 0) == 1;
+        if (err == 0) {
+            err = (jobs[3].status != 0) || (jobs[2].status != 1) ||
+                  (jobs[4].status != 1);
+        }
+    }
+
+    return err;
+}
+
+static int test_digest_batch_mds(ENGINE *e, unsigned char *msgs, size_t len)
+{
+    int err = 0;
+
+#ifdef WE_HAVE_SHA256
+    if (err == 0) {
+        PRINT_MSG("Batched SHA-256");
+        err = test_digest_batch_op(e, EVP_sha256(), msgs, len);
+    }
+#endif
+#ifdef WE_HAVE_SHA512
+    if (err == 0) {
+        PRINT_MSG("Batched SHA-512");
+        err = test_digest_batch_op(e, EVP_sha512(), msgs, len);
+    }
+#endif
+
+    return err;
+}
+
+int test_digest_batch(ENGINE *e, void *data)
+{
+    int err;
+    static unsigned char msgs[TEST_DIGEST_BATCH_CNT + 16384];
+    wolfEngine_DigestBatch batch;
+
+    (void)data;
+
+    RAND_bytes(msgs, sizeof(msgs));
+
+    /* Unsupported algorithm. */
+    batch.nid = NID_md5;
+    batch.jobs = NULL;
+    batch.cnt = 0;
+    err = ENGINE_ctrl_cmd(e, "digest_batch", 0, &batch, NULL, 0) == 1;
+    if (err == 0) {
+        err = test_digest_batch_mds(e, msgs, 16384);
+    }
+    /* Split across the bulk worker threads. */
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threads", 3, NULL, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threshold", 1024, NULL, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = test_digest_batch_mds(e, msgs, 16384);
+    }
+    if (err == 0) {
+        /* Too little data to split. */
+        err = test_digest_batch_mds(e, msgs, 32);
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threads", 0, NULL, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "bulk_threshold", 0, NULL, NULL, 0) != 1;
+    }
+
+    return err;
+}
+
+#endif /* WE_HAVE_SHA256 || WE_HAVE_SHA512 */
+
+/******************************************************************************/
+
 #endif /* WE_HAVE_DIGEST */
@@ -113,6 +113,39 @@ static int test_hmac_create_helper(ENGINE *e, void *data, const EVP_MD *md,
     return ret;
 }
 
+/* Long message starting at an unaligned address. */
+static int test_hmac_unaligned(ENGINE *e, const EVP_MD *md,
+    unsigned char* pswd, int pswdSz)
+{
+    int ret = 0;
+    static unsigned char msg[3 + 3001];
+    unsigned char exp[128];
+    int expLen;
+    unsigned char mac[128];
+    int macLen;
+    int off;
+
+    RAND_bytes(msg, sizeof(msg));
+
+    for (off = 1; (ret == 0) && (off <= 3); off++) {
+        expLen = sizeof(exp);
+        macLen = sizeof(mac);
+        ret = test_mac_generation(NULL, md, EVP_PKEY_HMAC, pswd, pswdSz,
+                  msg + off, sizeof(msg) - 3, exp, &expLen);
+        if (ret == 0) {
+            ret = test_mac_generation(e, md, EVP_PKEY_HMAC, pswd, pswdSz,
+                      msg + off, sizeof(msg) - 3, mac, &macLen);
+        }
+        if ((ret == 0) && ((macLen != expLen) ||
+                           (memcmp(mac, exp, expLen) != 0))) {
+            PRINT_MSG("generated mac and expected mac differ");
+            ret = -1;
+        }
+    }
+
+    return ret;
+}
+
 int test_hmac_create(ENGINE *e, void *data)
 {
     int ret = 0;
@@ -151,6 +184,14 @@ int test_hmac_create(ENGINE *e, void *data)
         PRINT_MSG("Testing with SHA512");
         ret = test_hmac_create_helper(e, data, EVP_sha512(), pswd, sizeof(pswd));
     }
+    if (ret == 0) {
+        PRINT_MSG("Testing with SHA384, long unaligned message");
+        ret = test_hmac_unaligned(e, EVP_sha384(), pswd, sizeof(pswd));
+    }
+    if (ret == 0) {
+        PRINT_MSG("Testing with SHA512, long unaligned message");
+        ret = test_hmac_unaligned(e, EVP_sha512(), pswd, sizeof(pswd));
+    }
 
 #ifdef WE_HAVE_SHA3_224
     if (ret == 0) {
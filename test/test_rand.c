@@ -21,6 +21,28 @@
 
 #include "unit.h"
 
+#if !defined(WE_SINGLE_THREADED) && !defined(_MSC_VER) && \
+    !defined(__MINGW32__) && !defined(__CYGWIN__) && !defined(_WIN32_WCE)
+    #define TEST_RANDOM_FORK
+#endif
+/* The engine reseeds DRBGs with a worker thread. */
+#if defined(HAVE_PTHREAD) && !defined(WE_SINGLE_THREADED)
+    #define TEST_RESEED_THREAD
+#endif
+/* RAND_bytes() uses a long-lived DRBG per thread when not static. */
+#if defined(TEST_RESEED_THREAD) && !defined(WE_STATIC_WOLFSSL)
+    #define TEST_THREAD_RNG
+#endif
+#if defined(TEST_RANDOM_FORK) || defined(TEST_RESEED_THREAD)
+#include <unistd.h>
+#endif
+#ifdef TEST_THREAD_RNG
+#include <pthread.h>
+#endif
+#ifdef TEST_RANDOM_FORK
+#include <sys/wait.h>
+#endif
+
 #ifdef WE_HAVE_RANDOM
 
 static int test_random_api(void)
@@ -71,6 +93,270 @@ static int test_random_api(void)
     return err;
 }
 
+static int test_random_stats(ENGINE *e)
+{
+    int err;
+    int i;
+    unsigned char buf[16];
+    wolfEngine_Stats before;
+    wolfEngine_Stats after;
+
+    /* Watermark must fit in pool. */
+    err = ENGINE_ctrl_cmd(e, "entropy_watermark", -1, NULL, NULL, 0) == 1;
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "entropy_watermark", 1024, NULL, NULL,
+                              0) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, NULL, NULL, 0) == 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &before, NULL, 0) != 1;
+    }
+    for (i = 0; (err == 0) && (i < 64); i++) {
+        err = RAND_bytes(buf, sizeof(buf)) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1;
+    }
+#ifdef TEST_ENTROPY_POOL
+    if (err == 0) {
+        /* Small requests are served from the pool - reads are amortized. */
+        err = (after.entropyRequests - before.entropyRequests) < 64;
+        if (err == 0) {
+            err = (after.entropyReads - before.entropyReads) * 8 >
+                  (after.entropyRequests - before.entropyRequests);
+        }
+        if (err != 0) {
+            PRINT_ERR_MSG("Entropy reads not amortized over requests");
+        }
+    }
+#endif
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "entropy_watermark", 0, NULL, NULL, 0) != 1;
+    }
+
+    return err;
+}
+
+static int test_random_reseed_thread(ENGINE *e)
+{
+    int err;
+    int i;
+    unsigned char buf[32];
+#ifdef TEST_RESEED_THREAD
+    wolfEngine_Stats before;
+    wolfEngine_Stats after;
+#endif
+
+#ifdef TEST_RESEED_THREAD
+    err = ENGINE_ctrl_cmd(e, "get_stats", 0, &before, NULL, 0) != 1;
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "reseed_thread", 1, NULL, NULL, 0) != 1;
+    }
+#else
+    err = ENGINE_ctrl_cmd(e, "reseed_thread", 1, NULL, NULL, 0) != 1;
+#endif
+    for (i = 0; (err == 0) && (i < 64); i++) {
+        err = RAND_bytes(buf, sizeof(buf)) != 1;
+    }
+#ifdef TEST_RESEED_THREAD
+#ifndef WE_STATIC_WOLFSSL
+    /* Use this thread's DRBG until it is swapped for a spare - the worker
+     * replaces the spare. */
+    for (i = 0; (err == 0) && (i <= 0x10000); i++) {
+        err = RAND_bytes(buf, 1) != 1;
+    }
+#endif
+    /* Wait up to 5 seconds for the worker to have done some work. */
+    for (i = 0; (err == 0) && (i < 500); i++) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1;
+        if ((err == 0) && (after.drbgReseeds > before.drbgReseeds)) {
+            break;
+        }
+        usleep(10000);
+    }
+    if ((err == 0) && (after.drbgReseeds <= before.drbgReseeds)) {
+        PRINT_ERR_MSG("Reseed worker didn't reseed any DRBGs");
+        err = 1;
+    }
+#endif
+    if (err == 0) {
+        /* Changing the period of running worker. */
+        err = ENGINE_ctrl_cmd(e, "reseed_thread", 2, NULL, NULL, 0) != 1;
+    }
+    for (i = 0; (err == 0) && (i < 64); i++) {
+        err = RAND_bytes(buf, sizeof(buf)) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "reseed_thread", 0, NULL, NULL, 0) != 1;
+    }
+    if (err == 0) {
+        /* Stopping when not running. */
+        err = ENGINE_ctrl_cmd(e, "reseed_thread", 0, NULL, NULL, 0) != 1;
+    }
+
+    return err;
+}
+
+#ifdef TEST_THREAD_RNG
+/* Number of threads generating random at the same time. */
+#define TEST_RAND_THREADS    4
+/* Number of uses before a per-thread DRBG is re-instantiated. */
+#define TEST_RAND_RESEED_INTERVAL    0x10000
+
+typedef struct TEST_RAND_THREAD {
+    pthread_t thread;
+    unsigned char buf[32];
+    int err;
+} TEST_RAND_THREAD;
+
+static void* test_random_thread_gen(void *data)
+{
+    TEST_RAND_THREAD *t = (TEST_RAND_THREAD *)data;
+
+    t->err = RAND_bytes(t->buf, sizeof(t->buf)) != 1;
+
+    return NULL;
+}
+
+/* Run threads that each generate random and wait for them to finish. */
+static int test_random_threads_run(TEST_RAND_THREAD *t, int cnt)
+{
+    int err = 0;
+    int i;
+    int started;
+
+    for (started = 0; (err == 0) && (started < cnt); started++) {
+        t[started].err = 1;
+        err = pthread_create(&t[started].thread, NULL, test_random_thread_gen,
+                             &t[started]) != 0;
+    }
+    if (err != 0) {
+        started--;
+    }
+    for (i = 0; i < started; i++) {
+        pthread_join(t[i].thread, NULL);
+        if (t[i].err != 0) {
+            err = 1;
+        }
+    }
+
+    return err;
+}
+
+/* Per-thread DRBGs: each thread's output differs, DRBGs of exited threads are
+ * reused and a DRBG is re-instantiated after its reseed interval. */
+static int test_random_thread_rng(ENGINE *e)
+{
+    int err;
+    int i;
+    int j;
+    unsigned char buf[1];
+    TEST_RAND_THREAD t[TEST_RAND_THREADS];
+    wolfEngine_Stats before;
+    wolfEngine_Stats after;
+
+    PRINT_MSG("Generate random in several threads");
+    err = test_random_threads_run(t, TEST_RAND_THREADS);
+    for (i = 0; (err == 0) && (i < TEST_RAND_THREADS); i++) {
+        for (j = i + 1; (err == 0) && (j < TEST_RAND_THREADS); j++) {
+            err = memcmp(t[i].buf, t[j].buf, sizeof(t[i].buf)) == 0;
+        }
+    }
+    if (err != 0) {
+        PRINT_ERR_MSG("Threads generated the same random");
+    }
+
+    if (err == 0) {
+        PRINT_MSG("DRBGs of exited threads are reused");
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &before, NULL, 0) != 1;
+    }
+    for (i = 0; (err == 0) && (i < TEST_RAND_THREADS); i++) {
+        /* One at a time - at most one DRBG needed. */
+        err = test_random_threads_run(t, 1);
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1;
+    }
+    if ((err == 0) && (after.threadRngs != before.threadRngs)) {
+        PRINT_ERR_MSG("New DRBG allocated when a free one was available");
+        err = 1;
+    }
+
+    if (err == 0) {
+        PRINT_MSG("DRBG re-instantiated after reseed interval");
+        before = after;
+    }
+    for (i = 0; (err == 0) && (i <= TEST_RAND_RESEED_INTERVAL); i++) {
+        err = RAND_bytes(buf, sizeof(buf)) != 1;
+    }
+    if (err == 0) {
+        err = ENGINE_ctrl_cmd(e, "get_stats", 0, &after, NULL, 0) != 1;
+    }
+    if ((err == 0) && (after.threadRngInits <= before.threadRngInits)) {
+        PRINT_ERR_MSG("DRBG not re-instantiated after reseed interval");
+        err = 1;
+    }
+
+    return err;
+}
+#endif
+
+#ifdef TEST_RANDOM_FORK
+/* Parent and child of fork must not generate the same random. */
+static int test_random_fork(void)
+{
+    int err;
+    int fds[2];
+    pid_t pid;
+    int status;
+    unsigned char parent[32];
+    unsigned char child[32];
+
+    /* Make sure cached random state exists before forking. */
+    err = RAND_bytes(parent, sizeof(parent)) != 1;
+    if (err == 0) {
+        err = pipe(fds) != 0;
+    }
+    if (err == 0) {
+        pid = fork();
+        if (pid == 0) {
+            close(fds[0]);
+            status = RAND_bytes(child, sizeof(child)) != 1;
+            if (status == 0) {
+                status = write(fds[1], child, sizeof(child)) !=
+                         (ssize_t)sizeof(child);
+            }
+            close(fds[1]);
+            _exit(status);
+        }
+        close(fds[1]);
+        err = pid < 0;
+        if (err == 0) {
+            err = RAND_bytes(parent, sizeof(parent)) != 1;
+        }
+        if (err == 0) {
+            err = read(fds[0], child, sizeof(child)) != (ssize_t)sizeof(child);
+        }
+        if (pid > 0) {
+            if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) ||
+                    (WEXITSTATUS(status) != 0)) {
+                err = 1;
+            }
+        }
+        close(fds[0]);
+    }
+    if (err == 0) {
+        PRINT_BUFFER("Parent", parent, sizeof(parent));
+        PRINT_BUFFER("Child", child, sizeof(child));
+        err = memcmp(parent, child, sizeof(parent)) == 0;
+    }
+
+    return err;
+}
+#endif
+
 int test_random(ENGINE *e, void *data)
 {
     int err;
@@ -84,6 +370,22 @@ int test_random(ENGINE *e, void *data)
     if (err == 0) {
         err = test_random_api();
     }
+    if (err == 0) {
+        err = test_random_stats(e);
+    }
+    if (err == 0) {
+        err = test_random_reseed_thread(e);
+    }
+#ifdef TEST_THREAD_RNG
+    if (err == 0) {
+        err = test_random_thread_rng(e);
+    }
+#endif
+#ifdef TEST_RANDOM_FORK
+    if (err == 0) {
+        err = test_random_fork();
+    }
+#endif
 
     return err;
 }
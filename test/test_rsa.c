@@ -931,6 +931,14 @@ int test_rsa_sign_verify_pss(ENGINE *e, void *data)
         err = test_rsa_sign_verify_pad(e, RSA_PKCS1_PSS_PADDING, EVP_sha384(),
                                        EVP_sha512()) == 1;
     }
+#ifdef WE_HAVE_SHA512_256
+    if (err == 0) {
+        /* Use SHA-512/256 for MD and MGF1 MD. */
+        err = test_rsa_sign_verify_pad(e, RSA_PKCS1_PSS_PADDING,
+                                       EVP_sha512_256(),
+                                       EVP_sha512_256()) == 1;
+    }
+#endif
 
     return err;
 }
@@ -69,6 +69,16 @@ TEST_CASE test_case[] = {
 #ifdef WE_HAVE_SHA512
     TEST_DECL(test_sha512, NULL),
 #endif
+#ifdef WE_HAVE_SHA512_224
+    TEST_DECL(test_sha512_224, NULL),
+#endif
+#ifdef WE_HAVE_SHA512_256
+    TEST_DECL(test_sha512_256, NULL),
+#endif
+#if defined(WE_HAVE_DIGEST) && \
+    (defined(WE_HAVE_SHA384) || defined(WE_HAVE_SHA512))
+    TEST_DECL(test_digest_unaligned, NULL),
+#endif
 #ifdef WE_HAVE_SHA3_224
     TEST_DECL(test_sha3_224, NULL),
 #endif
@@ -81,6 +91,22 @@ TEST_CASE test_case[] = {
 #ifdef WE_HAVE_SHA3_512
     TEST_DECL(test_sha3_512, NULL),
 #endif
+#ifdef WE_HAVE_SHAKE128
+    TEST_DECL(test_shake128, NULL),
+#endif
+#ifdef WE_HAVE_SHAKE256
+    TEST_DECL(test_shake256, NULL),
+#endif
+#ifdef WE_HAVE_BLAKE2B
+    TEST_DECL(test_blake2b512, NULL),
+#endif
+#ifdef WE_HAVE_BLAKE2S
+    TEST_DECL(test_blake2s256, NULL),
+#endif
+#if defined(WE_HAVE_DIGEST) && \
+    (defined(WE_HAVE_SHA256) || defined(WE_HAVE_SHA512))
+    TEST_DECL(test_digest_batch, NULL),
+#endif
 #ifdef WE_HAVE_HMAC
     TEST_DECL(test_hmac_create, NULL),
 #endif
@@ -112,6 +138,16 @@ TEST_CASE test_case[] = {
     TEST_DECL(test_aes128_cbc_stream, NULL),
     TEST_DECL(test_aes192_cbc_stream, NULL),
     TEST_DECL(test_aes256_cbc_stream, NULL),
+#ifdef EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK
+    TEST_DECL(test_aes128_cbc_hmac_multiblock, NULL),
+#ifdef WE_HAVE_SHA1
+    TEST_DECL(test_aes128_cbc_hmac_sha1_multiblock, NULL),
+#endif
+#endif
+    TEST_DECL(test_aes128_cbc_hmac_tls, NULL),
+#ifdef EVP_CIPH_FLAG_PIPELINE
+    TEST_DECL(test_aes128_cbc_hmac_pipeline, NULL),
+#endif
 #endif
 #ifdef WE_HAVE_AESCTR
     TEST_DECL(test_aes128_ctr_stream, NULL),
@@ -119,12 +155,30 @@ TEST_CASE test_case[] = {
     TEST_DECL(test_aes256_ctr_stream, NULL),
     TEST_DECL(test_aes_ctr_iv_init_regression, NULL),
 #endif
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC)
+    TEST_DECL(test_aes_bulk_threads, NULL),
+    TEST_DECL(test_aes_key_reuse, NULL),
+#endif
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC) || defined(WE_HAVE_DES3CBC)
+    TEST_DECL(test_cipher_copy, NULL),
+#endif
 #ifdef WE_HAVE_AESGCM
     TEST_DECL(test_aes128_gcm, NULL),
     TEST_DECL(test_aes192_gcm, NULL),
     TEST_DECL(test_aes256_gcm, NULL),
     TEST_DECL(test_aes128_gcm_fixed, NULL),
+    TEST_DECL(test_aes128_gcm_iv_gen_threads, NULL),
     TEST_DECL(test_aes128_gcm_tls, NULL),
+    TEST_DECL(test_aes128_gcm_stream, NULL),
+    TEST_DECL(test_aes128_gcm_key_reuse, NULL),
+    TEST_DECL(test_aes128_gcm_copy, NULL),
+    TEST_DECL(test_aes128_gcm_batch, NULL),
+    TEST_DECL(test_aes128_gcm_shared_key, NULL),
+#ifdef EVP_CIPH_FLAG_PIPELINE
+    TEST_DECL(test_aes128_gcm_pipeline, NULL),
+#endif
     TEST_DECL(test_aes_gcm_evp_cipher, NULL),
 #endif
 #ifdef WE_HAVE_AESCCM
@@ -134,6 +188,20 @@ TEST_CASE test_case[] = {
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
     TEST_DECL(test_aes128_ccm_tls, NULL),
 #endif
+    TEST_DECL(test_aes256_ccm_batch, NULL),
+#if defined(WOLFSSL_AES_DIRECT) && !defined(HAVE_FIPS) && \
+    !defined(HAVE_FIPS_VERSION)
+    TEST_DECL(test_aes128_ccm_stream, NULL),
+#endif
+#endif
+#ifdef WE_HAVE_AESXTS
+    TEST_DECL(test_aes128_xts, NULL),
+    TEST_DECL(test_aes256_xts, NULL),
+#endif
+#ifdef WE_HAVE_CHACHA
+    TEST_DECL(test_chacha20_stream, NULL),
+    TEST_DECL(test_chacha20_poly1305, NULL),
+    TEST_DECL(test_chacha20_poly1305_tls, NULL),
 #endif
 #ifdef WE_HAVE_RANDOM
     TEST_DECL(test_random, NULL),
@@ -40,6 +40,42 @@
 #if defined(NO_DES3) && defined(WE_HAVE_DES3CBC)
 #undef WE_HAVE_DES3CBC
 #endif
+/* Likewise for AES-XTS. */
+#if !defined(WOLFSSL_AES_XTS) && defined(WE_HAVE_AESXTS)
+#undef WE_HAVE_AESXTS
+#endif
+/* The engine splits large buffers across a bulk thread pool. */
+#if defined(HAVE_PTHREAD) && !defined(WE_SINGLE_THREADED)
+#define TEST_BULK_THREADS
+#endif
+/* The engine serves RAND_bytes() from an entropy pool when static. */
+#if defined(WE_HAVE_RANDOM) && defined(WE_STATIC_WOLFSSL)
+#define TEST_ENTROPY_POOL
+#endif
+/* Likewise for SHAKE128 and SHAKE256. */
+#if !defined(WOLFSSL_SHAKE128) && defined(WE_HAVE_SHAKE128)
+#undef WE_HAVE_SHAKE128
+#endif
+#if !defined(WOLFSSL_SHAKE256) && defined(WE_HAVE_SHAKE256)
+#undef WE_HAVE_SHAKE256
+#endif
+/* Likewise for BLAKE2b and BLAKE2s. */
+#if !defined(HAVE_BLAKE2) && !defined(HAVE_BLAKE2B) && \
+    defined(WE_HAVE_BLAKE2B)
+#undef WE_HAVE_BLAKE2B
+#endif
+#if !defined(HAVE_BLAKE2S) && defined(WE_HAVE_BLAKE2S)
+#undef WE_HAVE_BLAKE2S
+#endif
+/* Likewise for SHA-512/224 and SHA-512/256. */
+#if (!defined(WOLFSSL_SHA512) || defined(WOLFSSL_NOSHA512_224)) && \
+    defined(WE_HAVE_SHA512_224)
+#undef WE_HAVE_SHA512_224
+#endif
+#if (!defined(WOLFSSL_SHA512) || defined(WOLFSSL_NOSHA512_256)) && \
+    defined(WE_HAVE_SHA512_256)
+#undef WE_HAVE_SHA512_256
+#endif
 
 #include <openssl/engine.h>
 #include <openssl/evp.h>
@@ -50,6 +86,14 @@
 #include <openssl/kdf.h>
 #endif
 
+/* The engine shares AES-GCM key schedules between lean contexts. */
+#if defined(WE_LEAN_CIPHER_CTX) && !defined(WOLFSSL_AESGCM_STREAM) && \
+    (OPENSSL_VERSION_NUMBER >= 0x10100000L) && \
+    (defined(WE_SINGLE_THREADED) || defined(HAVE_PTHREAD))
+#define TEST_AES_GCM_LEAN
+#endif
+
+#include <wolfengine/we_wolfengine.h>
 #include <wolfengine/we_logging.h>
 #include <wolfengine/we_openssl_bc.h>
 
@@ -101,10 +145,22 @@ int test_sha224(ENGINE *e, void *data);
 int test_sha256(ENGINE *e, void *data);
 int test_sha384(ENGINE *e, void *data);
 int test_sha512(ENGINE *e, void *data);
+int test_sha512_224(ENGINE *e, void *data);
+int test_sha512_256(ENGINE *e, void *data);
+#if defined(WE_HAVE_SHA384) || defined(WE_HAVE_SHA512)
+int test_digest_unaligned(ENGINE *e, void *data);
+#endif
 int test_sha3_224(ENGINE *e, void *data);
 int test_sha3_256(ENGINE *e, void *data);
 int test_sha3_384(ENGINE *e, void *data);
 int test_sha3_512(ENGINE *e, void *data);
+int test_shake128(ENGINE *e, void *data);
+int test_shake256(ENGINE *e, void *data);
+int test_blake2b512(ENGINE *e, void *data);
+int test_blake2s256(ENGINE *e, void *data);
+#if defined(WE_HAVE_SHA256) || defined(WE_HAVE_SHA512)
+int test_digest_batch(ENGINE *e, void *data);
+#endif
 
 #endif /* WE_HAVE_DIGEST */
 
@@ -148,6 +204,16 @@ int test_aes256_cbc(ENGINE *e, void *data);
 int test_aes128_cbc_stream(ENGINE *e, void *data);
 int test_aes192_cbc_stream(ENGINE *e, void *data);
 int test_aes256_cbc_stream(ENGINE *e, void *data);
+#ifdef EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK
+int test_aes128_cbc_hmac_multiblock(ENGINE *e, void *data);
+#ifdef WE_HAVE_SHA1
+int test_aes128_cbc_hmac_sha1_multiblock(ENGINE *e, void *data);
+#endif
+#endif
+int test_aes128_cbc_hmac_tls(ENGINE *e, void *data);
+#ifdef EVP_CIPH_FLAG_PIPELINE
+int test_aes128_cbc_hmac_pipeline(ENGINE *e, void *data);
+#endif
 
 #endif
 
@@ -161,13 +227,33 @@ int test_aes_ctr_iv_init_regression(ENGINE *, void *);
 
 #endif
 
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC)
+int test_aes_bulk_threads(ENGINE *e, void *data);
+int test_aes_key_reuse(ENGINE *e, void *data);
+#endif
+
+#if defined(WE_HAVE_AESCTR) || defined(WE_HAVE_AESECB) || \
+    defined(WE_HAVE_AESCBC) || defined(WE_HAVE_DES3CBC)
+int test_cipher_copy(ENGINE *e, void *data);
+#endif
+
 #ifdef WE_HAVE_AESGCM
 
 int test_aes128_gcm(ENGINE *e, void *data);
 int test_aes192_gcm(ENGINE *e, void *data);
 int test_aes256_gcm(ENGINE *e, void *data);
 int test_aes128_gcm_fixed(ENGINE *e, void *data);
+int test_aes128_gcm_iv_gen_threads(ENGINE *e, void *data);
 int test_aes128_gcm_tls(ENGINE *e, void *data);
+int test_aes128_gcm_stream(ENGINE *e, void *data);
+int test_aes128_gcm_key_reuse(ENGINE *e, void *data);
+int test_aes128_gcm_copy(ENGINE *e, void *data);
+int test_aes128_gcm_batch(ENGINE *e, void *data);
+int test_aes128_gcm_shared_key(ENGINE *e, void *data);
+#ifdef EVP_CIPH_FLAG_PIPELINE
+int test_aes128_gcm_pipeline(ENGINE *e, void *data);
+#endif
 int test_aes_gcm_evp_cipher(ENGINE *e, void *data);
 
 #endif /* WE_HAVE_AESGCM */
@@ -178,9 +264,29 @@ int test_aes128_ccm(ENGINE *e, void *data);
 int test_aes192_ccm(ENGINE *e, void *data);
 int test_aes256_ccm(ENGINE *e, void *data);
 int test_aes128_ccm_tls(ENGINE *e, void *data);
+int test_aes256_ccm_batch(ENGINE *e, void *data);
+#if defined(WOLFSSL_AES_DIRECT) && !defined(HAVE_FIPS) && \
+    !defined(HAVE_FIPS_VERSION)
+int test_aes128_ccm_stream(ENGINE *e, void *data);
+#endif
 
 #endif /* WE_HAVE_AESCCM */
 
+#ifdef WE_HAVE_AESXTS
+
+int test_aes128_xts(ENGINE *e, void *data);
+int test_aes256_xts(ENGINE *e, void *data);
+
+#endif /* WE_HAVE_AESXTS */
+
+#ifdef WE_HAVE_CHACHA
+
+int test_chacha20_stream(ENGINE *e, void *data);
+int test_chacha20_poly1305(ENGINE *e, void *data);
+int test_chacha20_poly1305_tls(ENGINE *e, void *data);
+
+#endif /* WE_HAVE_CHACHA */
+
 #ifdef WE_HAVE_RANDOM
 
 int test_random(ENGINE *e, void *data);